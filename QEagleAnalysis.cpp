@@ -0,0 +1,1301 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+//------------------------------------------------------------------------------
+#include "QEagleAnalysis.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+CAirwire::CAirwire(const int signal, const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2)
+{
+ m_Signal = signal;
+ m_X1 = x1; m_Y1 = y1;
+ m_X2 = x2; m_Y2 = y2;
+}
+
+CAirwire::CAirwire(const CAirwire& airwire)
+{
+ assign(airwire);
+}
+
+CAirwire::CAirwire(void)
+{
+ clear();
+}
+
+CAirwire::~CAirwire(void)
+{
+ //
+}
+
+void CAirwire::operator =(const CAirwire& airwire)
+{
+ assign(airwire);
+}
+
+void CAirwire::clear(void)
+{
+ m_Signal = -1;
+ m_X1 = 0.0; m_Y1 = 0.0;
+ m_X2 = 0.0; m_Y2 = 0.0;
+}
+
+void CAirwire::assign(const CAirwire& airwire)
+{
+ m_Signal = airwire.m_Signal;
+ m_X1 = airwire.m_X1; m_Y1 = airwire.m_Y1;
+ m_X2 = airwire.m_X2; m_Y2 = airwire.m_Y2;
+}
+
+TDimension CAirwire::length(void) const
+{
+ return hypot(m_X2-m_X1,m_Y2-m_Y1);
+}
+
+//------------------------------------------------------------------------------
+
+// points where copper of a signal can be connected to: wire ends, vias and
+// pads; pads and vias carry their shape so that a wire ending anywhere
+// within them is connected
+enum TAnchorKind {akWireEnd, akVia, akPad};
+
+class CAnchor
+{
+ public:
+  TCoord x;
+  TCoord y;
+  TLayer first; // copper layers the anchor exists on
+  TLayer last;
+  TAnchorKind kind;
+  int source; // wire, via or pad table index
+  CShape shape; // vias and pads only
+};
+
+class CSignalNetwork
+{
+ public:
+  static const double EPSILON;
+  static const double CELL_SIZE;
+ public:
+  void build(CBoard& board, const int signal, const QVector<CPadInstance>& pads,
+             const QVector<int>& signalPads);
+  void connect(void);
+ protected:
+  void append(const TCoord x, const TCoord y, const TLayer first, const TLayer last,
+              const TAnchorKind kind, const int source);
+  bool touches(const CAnchor& a, const CAnchor& b) const;
+  static bool insidePolygon(CPolygon& polygon, const TCoord x, const TCoord y);
+ public:
+  QVector<CAnchor> anchors;
+  CDisjointSet sets;
+  QList<CPolygon*> polygons;
+  QVector<int> links; // per anchor, other copper it touches
+  QVector<int> covered; // per polygon, an anchor it covers or -1
+};
+
+const double CSignalNetwork::EPSILON = 1e-4;
+const double CSignalNetwork::CELL_SIZE = 1.27;
+
+void CSignalNetwork::append(const TCoord x, const TCoord y, const TLayer first, const TLayer last,
+ const TAnchorKind kind, const int source)
+{
+ CAnchor a;
+ a.x = x;
+ a.y = y;
+ a.first = first;
+ a.last = last;
+ a.kind = kind;
+ a.source = source;
+ a.shape.setCircle(x,y,0.0);
+ anchors.append(a);
+}
+
+void CSignalNetwork::build(CBoard& board, const int signal, const QVector<CPadInstance>& pads,
+ const QVector<int>& signalPads)
+{
+ CSignal *s = board.signal().at(signal);
+ anchors.clear();
+ anchors.reserve(signalPads.size() + 2*s->wires().size() + s->vias().size());
+ // automatic pad and via diameters are estimated with a 25% annular ring
+ for (int i = 0; i < signalPads.size(); i++)
+ {
+  const CPadInstance& p = pads.at(signalPads.at(i));
+  if (CPadInstance::pkSMD==p.kind())
+  {
+   append(p.x(),p.y(),p.layer(),p.layer(),akPad,signalPads.at(i));
+   anchors.last().shape.setRectangle(p.x(),p.y(),p.dx(),p.dy(),p.rotation());
+  }
+  else
+  {
+   append(p.x(),p.y(),CLayer::LAYER_TOP,CLayer::LAYER_BOTTOM,akPad,signalPads.at(i));
+   TDimension d = (p.dx() > 0.0) ? p.dx() : 1.5*p.drill();
+   if (CPad::psSquare==p.shape()) anchors.last().shape.setRectangle(p.x(),p.y(),d,d,p.rotation());
+   else if (CPad::psOctagon==p.shape()) anchors.last().shape.setOctagon(p.x(),p.y(),d,p.rotation());
+   else anchors.last().shape.setCircle(p.x(),p.y(),0.5*d);
+  }
+ }
+ for (int i = 0; i < s->vias().size(); i++)
+ {
+  CVia *v = s->vias().at(i);
+  int first, last;
+  decodeExtent(v->extent(),first,last);
+  append(v->x(),v->y(),first,last,akVia,i);
+  TDimension d = (v->diameter() > 0.0) ? v->diameter() : 1.5*v->drill();
+  anchors.last().shape.setCircle(v->x(),v->y(),0.5*d);
+ }
+ int wires = anchors.size();
+ for (int i = 0; i < s->wires().size(); i++)
+ {
+  // airwires are stored as wires on the unrouted layer
+  CWire *w = s->wires().at(i);
+  if (!CLayer::isCopper(w->layer())) continue;
+  append(w->x1(),w->y1(),w->layer(),w->layer(),akWireEnd,i);
+  append(w->x2(),w->y2(),w->layer(),w->layer(),akWireEnd,i);
+ }
+ polygons.clear();
+ for (int i = 0; i < s->polygons().size(); i++)
+ {
+  if (CLayer::isCopper(s->polygons().at(i)->layer())) polygons.append(s->polygons().at(i));
+ }
+ sets.reset(anchors.size());
+ for (int i = wires; i+1 < anchors.size(); i += 2)
+ {
+  sets.unite(i,i+1);
+ }
+}
+
+bool CSignalNetwork::touches(const CAnchor& a, const CAnchor& b) const
+{
+ if (a.last < b.first || b.last < a.first) return false;
+ if (fabs(a.x-b.x) < EPSILON && fabs(a.y-b.y) < EPSILON) return true;
+ if (akWireEnd!=a.kind && a.shape.contains(b.x,b.y)) return true;
+ if (akWireEnd!=b.kind && b.shape.contains(a.x,a.y)) return true;
+ return false;
+}
+
+bool CSignalNetwork::insidePolygon(CPolygon& polygon, const TCoord x, const TCoord y)
+{
+ // even-odd rule on the vertices, arcs are taken as chords
+ bool result = false;
+ int n = polygon.vertices().size();
+ for (int i = 0, j = n-1; i < n; j = i++)
+ {
+  CVertex *a = polygon.vertices().at(i);
+  CVertex *b = polygon.vertices().at(j);
+  if ((a->y() > y)!=(b->y() > y) &&
+      x < (b->x()-a->x())*(y-a->y())/(b->y()-a->y()) + a->x())
+  {
+   result = !result;
+  }
+ }
+ return result;
+}
+
+static inline qint64 cellKey(const qint64 column, const qint64 row)
+{
+ return (qint64)(((quint64)column << 32) ^ ((quint64)row & 0xFFFFFFFFu));
+}
+
+void CSignalNetwork::connect(void)
+{
+ // anchors are bucketed by position, each one then looks for others
+ // within the reach of its own shape
+ QHash<qint64,QVector<int> > cells;
+ links.fill(0,anchors.size());
+ covered.fill(-1,polygons.size());
+ for (int i = 0; i < anchors.size(); i++)
+ {
+  qint64 cx = (qint64)floor(anchors.at(i).x/CELL_SIZE);
+  qint64 cy = (qint64)floor(anchors.at(i).y/CELL_SIZE);
+  cells[cellKey(cx,cy)].append(i);
+ }
+ for (int i = 0; i < anchors.size(); i++)
+ {
+  const CAnchor& a = anchors.at(i);
+  const CBoundingBox& b = a.shape.boundingBox();
+  qint64 c1 = (qint64)floor((b.left()-EPSILON)/CELL_SIZE);
+  qint64 c2 = (qint64)floor((b.right()+EPSILON)/CELL_SIZE);
+  qint64 r1 = (qint64)floor((b.bottom()-EPSILON)/CELL_SIZE);
+  qint64 r2 = (qint64)floor((b.top()+EPSILON)/CELL_SIZE);
+  for (qint64 cx = c1; cx <= c2; cx++)
+  {
+   for (qint64 cy = r1; cy <= r2; cy++)
+   {
+    QHash<qint64,QVector<int> >::const_iterator c = cells.constFind(cellKey(cx,cy));
+    if (c==cells.constEnd()) continue;
+    const QVector<int>& l = c.value();
+    for (int k = 0; k < l.size(); k++)
+    {
+     int j = l.at(k);
+     const CAnchor& b = anchors.at(j);
+     if (j==i || !touches(a,b)) continue;
+     sets.unite(i,j);
+     // the two ends of one wire do not count as a connection
+     if (akWireEnd!=a.kind || akWireEnd!=b.kind || a.source!=b.source) links[i]++;
+    }
+   }
+  }
+ }
+ // a polygon joins everything of the signal it covers on its layer
+ for (int i = 0; i < polygons.size(); i++)
+ {
+  CPolygon *p = polygons.at(i);
+  CBoundingBox box = p->boundingBox();
+  int first = -1;
+  for (int j = 0; j < anchors.size(); j++)
+  {
+   const CAnchor& a = anchors.at(j);
+   if (p->layer() < a.first || p->layer() > a.last || !box.contains(a.x,a.y)) continue;
+   if (!insidePolygon(*p,a.x,a.y)) continue;
+   if (first < 0) first = j; else sets.unite(first,j);
+   links[j]++;
+  }
+  covered[i] = first;
+ }
+}
+
+// true when airwire i-j is shorter than the best one found so far, ties are
+// broken by anchor indices so that every part agrees on the same airwire
+static inline bool shorter(const double d, const int i, const int j,
+                           const double best, const int from, const int to)
+{
+ if (d!=best) return d < best;
+ int a = std::min(i,j), b = std::min(from,to);
+ return a < b || (a==b && std::max(i,j) < std::max(from,to));
+}
+
+// joins the connected parts by Boruvka's algorithm: every round each part
+// takes its shortest airwire to another part. Anchors are bucketed in a
+// spatial index and searched ring of cells by ring of cells around them, a
+// ring only while it may hold an anchor closer than the best airwire of the
+// part; rings holding nothing but the own part are remembered, as parts only
+// grow, so later rounds start behind them
+static void spanningTree(const int signal, CSignalNetwork& network, QVector<CAirwire>& result)
+{
+ result.clear();
+ const QVector<CAnchor>& anchors = network.anchors;
+ CDisjointSet& sets = network.sets;
+ int n = anchors.size();
+ if (n < 2 || sets.sets() < 2) return;
+ CBoundingBox extent;
+ for (int i = 0; i < n; i++)
+ {
+  extent.include(anchors.at(i).x,anchors.at(i).y);
+ }
+ // about one anchor per cell
+ TDimension size = std::max(extent.width(),extent.height())/ceil(sqrt((double)n));
+ CSpatialIndex index(extent,std::max(size,CSignalNetwork::CELL_SIZE));
+ for (int i = 0; i < n; i++)
+ {
+  index.insert(i,CBoundingBox(anchors.at(i).x,anchors.at(i).y,anchors.at(i).x,anchors.at(i).y));
+ }
+ QVector<double> best(n);
+ QVector<int> from(n);
+ QVector<int> to(n);
+ QVector<int> column(n);
+ QVector<int> row(n);
+ QVector<int> clean(n,0); // rings around the anchor holding its own part only
+ for (int i = 0; i < n; i++)
+ {
+  index.cell(anchors.at(i).x,anchors.at(i).y,column[i],row[i]);
+ }
+ TDimension cell = index.cellSize();
+ while (sets.sets() > 1)
+ {
+  // shortest airwire leaving each part, stored at the root of the part
+  best.fill(std::numeric_limits<double>::max());
+  from.fill(-1);
+  to.fill(-1);
+  for (int i = 0; i < n; i++)
+  {
+   int root = sets.find(i);
+   const CAnchor& a = anchors.at(i);
+   int c = column.at(i), r = row.at(i);
+   for (int k = clean.at(i); ; k++)
+   {
+    // anchors in ring k lie at least k-1 cells away, ties still count
+    if (k > 0 && (k-1)*cell > best.at(root)) break;
+    if (c-k < 0 && r-k < 0 && c+k >= index.columns() && r+k >= index.rows()) break;
+    bool foreign = false;
+    for (int y = std::max(r-k,0); y <= std::min(r+k,index.rows()-1); y++)
+    {
+     // the top and bottom rows of the ring whole, its two ends in between
+     int step = (y==r-k || y==r+k) ? 1 : 2*k;
+     for (int x = c-k; x <= c+k; x += step)
+     {
+      if (x < 0 || x >= index.columns()) continue;
+      const QVector<int>& l = index.items(x,y);
+      for (int m = 0; m < l.size(); m++)
+      {
+       int j = l.at(m);
+       if (sets.find(j)==root) continue;
+       foreign = true;
+       double d = hypot(anchors.at(j).x-a.x,anchors.at(j).y-a.y);
+       if (shorter(d,i,j,best.at(root),from.at(root),to.at(root)))
+       {
+        best[root] = d; from[root] = i; to[root] = j;
+       }
+      }
+     }
+    }
+    if (!foreign && clean.at(i)==k) clean[i] = k+1;
+   }
+  }
+  for (int i = 0; i < n; i++)
+  {
+   if (from.at(i) < 0 || !sets.unite(from.at(i),to.at(i))) continue;
+   const CAnchor& a = anchors.at(from.at(i));
+   const CAnchor& b = anchors.at(to.at(i));
+   result.append(CAirwire(signal,a.x,a.y,b.x,b.y));
+  }
+ }
+}
+
+class CRatsnestJob: public CParallelJob
+{
+ public:
+  CRatsnestJob(CBoard& board, const QVector<CPadInstance>& pads, const QVector<QVector<int> >& signalPads,
+               const QVector<int>& signalIndices, QVector<CAirwire> *airwires):
+   m_Board(board), m_Pads(pads), m_SignalPads(signalPads), m_Signals(signalIndices), m_Airwires(airwires) {}
+  virtual void execute(const int index)
+  {
+   int s = m_Signals.at(index);
+   CSignalNetwork network;
+   network.build(m_Board,s,m_Pads,m_SignalPads.at(s));
+   network.connect();
+   spanningTree(s,network,m_Airwires[s]);
+  }
+ protected:
+  CBoard& m_Board;
+  const QVector<CPadInstance>& m_Pads;
+  const QVector<QVector<int> >& m_SignalPads;
+  const QVector<int>& m_Signals;
+  QVector<CAirwire> *m_Airwires; // one per board signal
+};
+
+//------------------------------------------------------------------------------
+
+CRatsnest::CRatsnest(void)
+{
+ m_ThreadCount = 0;
+}
+
+CRatsnest::~CRatsnest(void)
+{
+ clear();
+}
+
+void CRatsnest::clear(void)
+{
+ m_Airwires.clear();
+}
+
+void CRatsnest::compute(CBoard& board)
+{
+ QVector<int> signalIndices(board.signal().size());
+ for (int i = 0; i < signalIndices.size(); i++)
+ {
+  signalIndices[i] = i;
+ }
+ m_Airwires.clear();
+ m_Airwires.resize(board.signal().size());
+ computeSignals(board,m_PadResolver.resolve(board,m_ThreadCount),signalIndices);
+}
+
+void CRatsnest::update(CBoard& board, const QList<int>& elements)
+{
+ if (m_Airwires.size()!=board.signal().size())
+ {
+  compute(board);
+  return;
+ }
+ // only the pads of the moved elements are placed again
+ const QVector<CPadInstance>& pads = m_PadResolver.update(board,elements,QList<int>(),m_ThreadCount);
+ QSet<int> signalIndices;
+ for (int i = 0; i < elements.size(); i++)
+ {
+  int e = elements.at(i);
+  if (e < 0 || e >= board.elements().size()) continue;
+  for (int j = m_PadResolver.first(e); j < m_PadResolver.first(e) + m_PadResolver.count(e); j++)
+  {
+   if (pads.at(j).signal() >= 0) signalIndices.insert(pads.at(j).signal());
+  }
+ }
+ QVector<int> l;
+ l.reserve(signalIndices.size());
+ for (QSet<int>::const_iterator i = signalIndices.constBegin(); i != signalIndices.constEnd(); ++i)
+ {
+  l.append(*i);
+ }
+ std::sort(l.begin(),l.end());
+ computeSignals(board,pads,l);
+}
+
+void CRatsnest::updateSignals(CBoard& board, const QList<int>& signalIndices)
+{
+ if (m_Airwires.size()!=board.signal().size())
+ {
+  compute(board);
+  return;
+ }
+ QList<int> l;
+ for (int i = 0; i < signalIndices.size(); i++)
+ {
+  if (signalIndices.at(i) >= 0 && signalIndices.at(i) < board.signal().size()) l.append(signalIndices.at(i));
+ }
+ // only the contact references of these signals are resolved again
+ computeSignals(board,m_PadResolver.update(board,QList<int>(),l,m_ThreadCount),l.toVector());
+}
+
+void CRatsnest::computeSignals(CBoard& board, const QVector<CPadInstance>& pads, const QVector<int>& signalIndices)
+{
+ QVector<bool> wanted(board.signal().size(),false);
+ for (int i = 0; i < signalIndices.size(); i++)
+ {
+  wanted[signalIndices.at(i)] = true;
+ }
+ QVector<QVector<int> > signal_pads(board.signal().size());
+ for (int i = 0; i < pads.size(); i++)
+ {
+  int s = pads.at(i).signal();
+  if (s >= 0 && wanted.at(s)) signal_pads[s].append(i);
+ }
+ // detached once here, jobs write to distinct entries
+ CRatsnestJob job(board,pads,signal_pads,signalIndices,m_Airwires.data());
+ parallelFor(signalIndices.size(),job,m_ThreadCount);
+}
+
+int CRatsnest::unroutedCount(void) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Airwires.size(); i++)
+ {
+  result += m_Airwires.at(i).size();
+ }
+ return result;
+}
+
+int CRatsnest::unroutedCount(const int signal) const
+{
+ return m_Airwires.value(signal).size();
+}
+
+TDimension CRatsnest::unroutedLength(void) const
+{
+ TDimension result = 0.0;
+ for (int i = 0; i < m_Airwires.size(); i++)
+ {
+  for (int j = 0; j < m_Airwires.at(i).size(); j++)
+  {
+   result += m_Airwires.at(i).at(j).length();
+  }
+ }
+ return result;
+}
+
+
+//------------------------------------------------------------------------------
+
+CCopperIsland::CCopperIsland(const CCopperIsland& island)
+{
+ assign(island);
+}
+
+CCopperIsland::CCopperIsland(void)
+{
+ clear();
+}
+
+CCopperIsland::~CCopperIsland(void)
+{
+ //
+}
+
+void CCopperIsland::operator =(const CCopperIsland& island)
+{
+ assign(island);
+}
+
+void CCopperIsland::clear(void)
+{
+ m_Signal = -1;
+ m_BoundingBox.clear();
+ m_WireCount = 0;
+ m_ViaCount = 0;
+ m_PolygonCount = 0;
+}
+
+void CCopperIsland::assign(const CCopperIsland& island)
+{
+ m_Signal = island.m_Signal;
+ m_BoundingBox = island.m_BoundingBox;
+ m_WireCount = island.m_WireCount;
+ m_ViaCount = island.m_ViaCount;
+ m_PolygonCount = island.m_PolygonCount;
+}
+
+//------------------------------------------------------------------------------
+
+CCopperStub::CCopperStub(const int signal, const int wire, const TCoord x, const TCoord y, const TLayer layer)
+{
+ m_Signal = signal;
+ m_Wire = wire;
+ m_X = x;
+ m_Y = y;
+ m_Layer = layer;
+}
+
+CCopperStub::CCopperStub(const CCopperStub& stub)
+{
+ assign(stub);
+}
+
+CCopperStub::CCopperStub(void)
+{
+ clear();
+}
+
+CCopperStub::~CCopperStub(void)
+{
+ //
+}
+
+void CCopperStub::operator =(const CCopperStub& stub)
+{
+ assign(stub);
+}
+
+void CCopperStub::clear(void)
+{
+ m_Signal = -1;
+ m_Wire = -1;
+ m_X = 0.0;
+ m_Y = 0.0;
+ m_Layer = CLayer::LAYER__INVALID;
+}
+
+void CCopperStub::assign(const CCopperStub& stub)
+{
+ m_Signal = stub.m_Signal;
+ m_Wire = stub.m_Wire;
+ m_X = stub.m_X;
+ m_Y = stub.m_Y;
+ m_Layer = stub.m_Layer;
+}
+
+//------------------------------------------------------------------------------
+
+class CConnectivityJob: public CParallelJob
+{
+ public:
+  CConnectivityJob(CBoard& board, const QVector<CPadInstance>& pads,
+                   const QVector<QVector<int> >& signalPads):
+   m_Board(board), m_Pads(pads), m_SignalPads(signalPads)
+  {
+   m_Islands.resize(board.signal().size());
+   m_Stubs.resize(board.signal().size());
+  }
+  virtual void execute(const int index)
+  {
+   CSignal *s = m_Board.signal().at(index);
+   CSignalNetwork network;
+   network.build(m_Board,index,m_Pads,m_SignalPads.at(index));
+   network.connect();
+   QList<CCopperStub>& stubs = m_Stubs[index];
+   QHash<int,CCopperIsland> parts;
+   QList<int> order;
+   QSet<int> powered;
+   for (int i = 0; i < network.anchors.size(); i++)
+   {
+    const CAnchor& a = network.anchors.at(i);
+    int root = network.sets.find(i);
+    if (akPad==a.kind)
+    {
+     powered.insert(root);
+     continue;
+    }
+    if (!parts.contains(root))
+    {
+     CCopperIsland island;
+     island.setSignal(index);
+     parts.insert(root,island);
+     order.append(root);
+    }
+    CCopperIsland& island = parts[root];
+    CBoundingBox box = island.boundingBox();
+    if (akVia==a.kind)
+    {
+     box.include(a.shape.boundingBox());
+     island.setViaCount(island.viaCount()+1);
+    }
+    else if (i+1 < network.anchors.size() && network.anchors.at(i+1).source==a.source &&
+             akWireEnd==network.anchors.at(i+1).kind)
+    {
+     // counted once, at the first end of a wire
+     box.include(s->wires().at(a.source)->boundingBox());
+     island.setWireCount(island.wireCount()+1);
+    }
+    island.setBoundingBox(box);
+    if (akWireEnd==a.kind && 0==network.links.at(i))
+    {
+     stubs.append(CCopperStub(index,a.source,a.x,a.y,a.first));
+    }
+   }
+   for (int i = 0; i < network.polygons.size(); i++)
+   {
+    CCopperIsland island;
+    island.setSignal(index);
+    int root = -1;
+    if (network.covered.at(i) >= 0)
+    {
+     root = network.sets.find(network.covered.at(i));
+     island = parts.value(root,island);
+    }
+    CBoundingBox box = island.boundingBox();
+    box.include(network.polygons.at(i)->boundingBox());
+    island.setBoundingBox(box);
+    island.setPolygonCount(island.polygonCount()+1);
+    if (root < 0)
+    {
+     // a polygon that covers nothing of its signal floats on its own
+     m_Islands[index].append(island);
+    }
+    else if (!powered.contains(root))
+    {
+     if (!parts.contains(root)) order.append(root);
+     parts.insert(root,island);
+    }
+   }
+   for (int i = 0; i < order.size(); i++)
+   {
+    if (!powered.contains(order.at(i))) m_Islands[index].append(parts.value(order.at(i)));
+   }
+  }
+ public:
+  QVector<QList<CCopperIsland> > m_Islands;
+  QVector<QList<CCopperStub> > m_Stubs;
+ protected:
+  CBoard& m_Board;
+  const QVector<CPadInstance>& m_Pads;
+  const QVector<QVector<int> >& m_SignalPads;
+};
+
+CConnectivityCheck::CConnectivityCheck(void)
+{
+ m_ThreadCount = 0;
+}
+
+CConnectivityCheck::~CConnectivityCheck(void)
+{
+ clear();
+}
+
+void CConnectivityCheck::clear(void)
+{
+ m_Islands.clear();
+ m_Stubs.clear();
+}
+
+bool CConnectivityCheck::check(CBoard& board)
+{
+ clear();
+ const QVector<CPadInstance>& pads = m_PadResolver.resolve(board,m_ThreadCount);
+ QVector<QVector<int> > signal_pads(board.signal().size());
+ for (int i = 0; i < pads.size(); i++)
+ {
+  if (pads.at(i).signal() >= 0) signal_pads[pads.at(i).signal()].append(i);
+ }
+ CConnectivityJob job(board,pads,signal_pads);
+ parallelFor(board.signal().size(),job,m_ThreadCount);
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  m_Islands.append(job.m_Islands.at(i));
+  m_Stubs.append(job.m_Stubs.at(i));
+ }
+ return m_Islands.isEmpty() && m_Stubs.isEmpty();
+}
+
+
+//------------------------------------------------------------------------------
+
+CRoutingStatistics::CRoutingStatistics(const CRoutingStatistics& statistics)
+{
+ assign(statistics);
+}
+
+CRoutingStatistics::CRoutingStatistics(void)
+{
+ clear();
+}
+
+CRoutingStatistics::~CRoutingStatistics(void)
+{
+ clear();
+}
+
+void CRoutingStatistics::operator =(const CRoutingStatistics& statistics)
+{
+ assign(statistics);
+}
+
+void CRoutingStatistics::clear(void)
+{
+ m_Name.clear();
+ m_Class = 0;
+ m_Length = 0.0;
+ m_WireCount = 0;
+ m_ViaCount = 0;
+ m_LayerLengths.clear();
+ m_WidthCounts.clear();
+}
+
+void CRoutingStatistics::assign(const CRoutingStatistics& statistics)
+{
+ m_Name = statistics.m_Name;
+ m_Class = statistics.m_Class;
+ m_Length = statistics.m_Length;
+ m_WireCount = statistics.m_WireCount;
+ m_ViaCount = statistics.m_ViaCount;
+ m_LayerLengths = statistics.m_LayerLengths;
+ m_WidthCounts = statistics.m_WidthCounts;
+}
+
+void CRoutingStatistics::add(const CRoutingStatistics& statistics)
+{
+ m_Length += statistics.m_Length;
+ m_WireCount += statistics.m_WireCount;
+ m_ViaCount += statistics.m_ViaCount;
+ for (QMap<TLayer,TDimension>::const_iterator i = statistics.m_LayerLengths.constBegin();
+      i!=statistics.m_LayerLengths.constEnd(); i++)
+ {
+  m_LayerLengths[i.key()] += i.value();
+ }
+ for (QMap<int,int>::const_iterator i = statistics.m_WidthCounts.constBegin();
+      i!=statistics.m_WidthCounts.constEnd(); i++)
+ {
+  m_WidthCounts[i.key()] += i.value();
+ }
+}
+
+void CRoutingStatistics::add(CWire& wire)
+{
+ TDimension l = fabs(wire.length());
+ m_Length += l;
+ m_WireCount++;
+ m_LayerLengths[wire.layer()] += l;
+ m_WidthCounts[qRound(wire.width()*1000.0)]++;
+}
+
+// the copper wires of a signal in bulk: chords, curves, layers and widths are
+// gathered into flat arrays first, so the length loop runs over plain
+// numbers the compiler vectorizes, and the maps are updated once per layer
+// and width instead of once per wire
+void CRoutingStatistics::add(const QList<CWire*>& wires)
+{
+ const int layers = CLayer::LAYER_BOTTOM - CLayer::LAYER_TOP + 1;
+ QVector<double> dx(wires.size()), dy(wires.size()), curve(wires.size()), length(wires.size());
+ QVector<int> layer(wires.size()), width(wires.size());
+ int n = 0;
+ for (int i = 0; i < wires.size(); i++)
+ {
+  CWire *w = wires.at(i);
+  // airwires are kept on the unrouted layer
+  if (!CLayer::isCopper(w->layer())) continue;
+  dx[n] = w->x2() - w->x1();
+  dy[n] = w->y2() - w->y1();
+  curve[n] = w->curve();
+  layer[n] = w->layer() - CLayer::LAYER_TOP;
+  width[n] = qRound(w->width()*1000.0);
+  n++;
+ }
+ const double *x = dx.constData(), *y = dy.constData();
+ double *l = length.data();
+ for (int i = 0; i < n; i++)
+ {
+  l[i] = sqrt(x[i]*x[i] + y[i]*y[i]);
+ }
+ // arcs are measured along the arc
+ for (int i = 0; i < n; i++)
+ {
+  if (0.0==curve.at(i)) continue;
+  double a = degtorad(curve.at(i));
+  l[i] = fabs(l[i]*a/(2.0*sin(0.5*a)));
+ }
+ TDimension sums[layers];
+ bool used[layers];
+ for (int k = 0; k < layers; k++)
+ {
+  sums[k] = 0.0;
+  used[k] = false;
+ }
+ for (int i = 0; i < n; i++)
+ {
+  m_Length += l[i];
+  sums[layer.at(i)] += l[i];
+  used[layer.at(i)] = true;
+ }
+ for (int k = 0; k < layers; k++)
+ {
+  if (used[k]) m_LayerLengths[CLayer::LAYER_TOP + k] += sums[k];
+ }
+ m_WireCount += n;
+ std::sort(width.begin(),width.begin() + n);
+ for (int i = 0, j = 0; i < n; i = j)
+ {
+  while (j < n && width.at(j)==width.at(i)) j++;
+  m_WidthCounts[width.at(i)] += j - i;
+ }
+}
+
+void CRoutingStatistics::add(CVia&)
+{
+ m_ViaCount++;
+}
+
+//------------------------------------------------------------------------------
+
+class CRoutingJob: public CParallelJob
+{
+ public:
+  CRoutingJob(CBoard& board, CRoutingStatistics *statistics):
+   m_Board(board), m_Statistics(statistics) {}
+  virtual void execute(const int index)
+  {
+   CSignal *s = m_Board.signal().at(index);
+   CRoutingStatistics& r = m_Statistics[index];
+   r.setName(s->name());
+   r.setSignalClass(s->signalClass());
+   r.add(s->wires());
+   for (int i = 0; i < s->vias().size(); i++)
+   {
+    r.add(*s->vias().at(i));
+   }
+  }
+ protected:
+  CBoard& m_Board;
+  CRoutingStatistics *m_Statistics; // one per board signal
+};
+
+CRoutingReport::CRoutingReport(void)
+{
+ m_ThreadCount = 0;
+}
+
+CRoutingReport::~CRoutingReport(void)
+{
+ clear();
+}
+
+void CRoutingReport::clear(void)
+{
+ m_Signals.clear();
+ m_Classes.clear();
+ m_Total.clear();
+}
+
+void CRoutingReport::compute(CBoard& board)
+{
+ clear();
+ QVector<CRoutingStatistics> statistics(board.signal().size());
+ CRoutingJob job(board,statistics.data());
+ parallelFor(statistics.size(),job,m_ThreadCount);
+ QMap<TClass,CRoutingStatistics> classes;
+ for (int i = 0; i < board.classes().size(); i++)
+ {
+  CClass *c = board.classes().at(i);
+  classes[c->number()].setName(c->name());
+  classes[c->number()].setSignalClass(c->number());
+ }
+ m_Total.setName("total");
+ for (int i = 0; i < statistics.size(); i++)
+ {
+  const CRoutingStatistics& r = statistics.at(i);
+  m_Signals.append(r);
+  if (!classes.contains(r.signalClass())) classes[r.signalClass()].setSignalClass(r.signalClass());
+  classes[r.signalClass()].add(r);
+  m_Total.add(r);
+ }
+ m_Classes = classes.values();
+}
+
+static QString csvField(const QString& value)
+{
+ if (!value.contains(',') && !value.contains('"') && !value.contains('\n')) return value;
+ QString s = value;
+ return "\"" + s.replace("\"","\"\"") + "\"";
+}
+
+static QString jsonString(const QString& value)
+{
+ QString result = "\"";
+ for (int i = 0; i < value.length(); i++)
+ {
+  QChar c = value.at(i);
+  if ('"'==c || '\\'==c) { result += '\\'; result += c; }
+  else if (c.unicode() < 0x20) result += QString("\\u%1").arg((int)c.unicode(),4,16,QChar('0'));
+  else result += c;
+ }
+ return result + "\"";
+}
+
+static void writeCSVRow(QTextStream& out, const QString& kind, const CRoutingStatistics& r)
+{
+ QStringList layers, widths;
+ for (QMap<TLayer,TDimension>::const_iterator i = r.layerLengths().constBegin(); i!=r.layerLengths().constEnd(); i++)
+ {
+  layers.append(QString("%1=%2").arg(i.key()).arg(i.value(),0,'f',4));
+ }
+ for (QMap<int,int>::const_iterator i = r.widthCounts().constBegin(); i!=r.widthCounts().constEnd(); i++)
+ {
+  widths.append(QString("%1=%2").arg(0.001*i.key(),0,'f',3).arg(i.value()));
+ }
+ out<<kind<<","<<csvField(r.name())<<","<<r.signalClass()<<","
+    <<QString::number(r.length(),'f',4)<<","<<r.wireCount()<<","<<r.viaCount()<<","
+    <<layers.join(";")<<","<<widths.join(";")<<"\n";
+}
+
+void CRoutingReport::writeCSV(QTextStream& out) const
+{
+ // lengths in mm, layer lengths as layer=length, widths as width=count
+ out<<"kind,name,class,length,wires,vias,layers,widths\n";
+ for (int i = 0; i < m_Signals.size(); i++)
+ {
+  writeCSVRow(out,"signal",m_Signals.at(i));
+ }
+ for (int i = 0; i < m_Classes.size(); i++)
+ {
+  writeCSVRow(out,"class",m_Classes.at(i));
+ }
+ writeCSVRow(out,"total",m_Total);
+}
+
+static void writeJSONObject(QTextStream& out, const CRoutingStatistics& r, const QString& indent)
+{
+ out<<indent<<"{\"name\": "<<jsonString(r.name())<<", \"class\": "<<r.signalClass()
+    <<", \"length\": "<<QString::number(r.length(),'f',4)
+    <<", \"wires\": "<<r.wireCount()<<", \"vias\": "<<r.viaCount()<<", \"layers\": {";
+ for (QMap<TLayer,TDimension>::const_iterator i = r.layerLengths().constBegin(); i!=r.layerLengths().constEnd(); i++)
+ {
+  if (i!=r.layerLengths().constBegin()) out<<", ";
+  out<<"\""<<i.key()<<"\": "<<QString::number(i.value(),'f',4);
+ }
+ out<<"}, \"widths\": {";
+ for (QMap<int,int>::const_iterator i = r.widthCounts().constBegin(); i!=r.widthCounts().constEnd(); i++)
+ {
+  if (i!=r.widthCounts().constBegin()) out<<", ";
+  out<<"\""<<QString::number(0.001*i.key(),'f',3)<<"\": "<<i.value();
+ }
+ out<<"}}";
+}
+
+void CRoutingReport::writeJSON(QTextStream& out) const
+{
+ out<<"{\n \"signals\": [\n";
+ for (int i = 0; i < m_Signals.size(); i++)
+ {
+  writeJSONObject(out,m_Signals.at(i),"  ");
+  out<<((i+1 < m_Signals.size()) ? ",\n" : "\n");
+ }
+ out<<" ],\n \"classes\": [\n";
+ for (int i = 0; i < m_Classes.size(); i++)
+ {
+  writeJSONObject(out,m_Classes.at(i),"  ");
+  out<<((i+1 < m_Classes.size()) ? ",\n" : "\n");
+ }
+ out<<" ],\n \"total\":\n";
+ writeJSONObject(out,m_Total,"  ");
+ out<<"\n}\n";
+}
+
+bool CRoutingReport::saveToCSV(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeCSV(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+bool CRoutingReport::saveToJSON(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeJSON(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+
+//------------------------------------------------------------------------------
+
+CDifferentialPair::CDifferentialPair(const CDifferentialPair& pair)
+{
+ assign(pair);
+}
+
+CDifferentialPair::CDifferentialPair(void)
+{
+ clear();
+}
+
+CDifferentialPair::~CDifferentialPair(void)
+{
+ clear();
+}
+
+void CDifferentialPair::operator =(const CDifferentialPair& pair)
+{
+ assign(pair);
+}
+
+void CDifferentialPair::clear(void)
+{
+ m_Name.clear();
+ m_Positive = -1;
+ m_Negative = -1;
+ m_Class = 0;
+ m_PositiveLength = 0.0;
+ m_NegativeLength = 0.0;
+ m_CoupledLength = 0.0;
+ m_LengthDelta = 0.0;
+ m_Violations = CDifferentialPair::dvNone;
+}
+
+void CDifferentialPair::assign(const CDifferentialPair& pair)
+{
+ m_Name = pair.m_Name;
+ m_Positive = pair.m_Positive;
+ m_Negative = pair.m_Negative;
+ m_Class = pair.m_Class;
+ m_PositiveLength = pair.m_PositiveLength;
+ m_NegativeLength = pair.m_NegativeLength;
+ m_CoupledLength = pair.m_CoupledLength;
+ m_LengthDelta = pair.m_LengthDelta;
+ m_Violations = pair.m_Violations;
+}
+
+double CDifferentialPair::couplingRatio(void) const
+{
+ if (m_PositiveLength <= 0.0) return 0.0;
+ return std::min(m_CoupledLength/m_PositiveLength,1.0);
+}
+
+//------------------------------------------------------------------------------
+
+class CPairSegment
+{
+ public:
+  CPoint a;
+  CPoint b;
+  TLayer layer;
+};
+
+static TDimension routedLength(CSignal& signal, QVector<CPairSegment>& segments)
+{
+ TDimension result = 0.0;
+ QVector<CPoint> points;
+ for (int i = 0; i < signal.wires().size(); i++)
+ {
+  CWire *w = signal.wires().at(i);
+  if (!CLayer::isCopper(w->layer())) continue;
+  result += fabs(w->length());
+  // arcs are split finely enough for the parallelism test
+  flattenWire(*w,0.005,points);
+  for (int k = 1; k < points.size(); k++)
+  {
+   CPairSegment s;
+   s.a = points.at(k-1);
+   s.b = points.at(k);
+   s.layer = w->layer();
+   segments.append(s);
+  }
+ }
+ return result;
+}
+
+static bool lessByFirst(const QPair<double,double>& a, const QPair<double,double>& b)
+{
+ return a.first < b.first;
+}
+
+// length of the positive segments that run parallel to a negative segment on
+// the same layer no further than gap away
+static TDimension coupledLength(const QVector<CPairSegment>& positive,
+ const QVector<CPairSegment>& negative, const TDimension gap)
+{
+ const double max_sine = sin(degtorad(5.0));
+ TDimension result = 0.0;
+ for (int i = 0; i < positive.size(); i++)
+ {
+  const CPairSegment& p = positive.at(i);
+  double dx = p.b.x()-p.a.x(), dy = p.b.y()-p.a.y();
+  double l = hypot(dx,dy);
+  if (l <= 0.0) continue;
+  double ux = dx/l, uy = dy/l;
+  QList<QPair<double,double> > spans;
+  for (int j = 0; j < negative.size(); j++)
+  {
+   const CPairSegment& n = negative.at(j);
+   if (n.layer!=p.layer) continue;
+   double ex = n.b.x()-n.a.x(), ey = n.b.y()-n.a.y();
+   double m = hypot(ex,ey);
+   if (m <= 0.0 || fabs(ux*ey - uy*ex)/m > max_sine) continue;
+   double mx = 0.5*(n.a.x()+n.b.x()) - p.a.x(), my = 0.5*(n.a.y()+n.b.y()) - p.a.y();
+   if (fabs(ux*my - uy*mx) > gap) continue;
+   double t1 = ux*(n.a.x()-p.a.x()) + uy*(n.a.y()-p.a.y());
+   double t2 = ux*(n.b.x()-p.a.x()) + uy*(n.b.y()-p.a.y());
+   double lo = std::max(std::min(t1,t2),0.0), hi = std::min(std::max(t1,t2),l);
+   if (hi > lo) spans.append(QPair<double,double>(lo,hi));
+  }
+  // overlapping spans are counted once
+  std::sort(spans.begin(),spans.end(),lessByFirst);
+  double end = 0.0;
+  for (int k = 0; k < spans.size(); k++)
+  {
+   double lo = std::max(spans.at(k).first,end);
+   if (spans.at(k).second > lo) { result += spans.at(k).second - lo; end = spans.at(k).second; }
+  }
+ }
+ return result;
+}
+
+class CDifferentialPairJob: public CParallelJob
+{
+ public:
+  CDifferentialPairJob(CBoard& board, CDifferentialPair *pairs, const TDimension gap):
+   m_Board(board), m_Pairs(pairs), m_Gap(gap) {}
+  virtual void execute(const int index)
+  {
+   CDifferentialPair& pair = m_Pairs[index];
+   QVector<CPairSegment> positive, negative;
+   pair.setPositiveLength(routedLength(*m_Board.signal().at(pair.positive()),positive));
+   pair.setNegativeLength(routedLength(*m_Board.signal().at(pair.negative()),negative));
+   pair.setCoupledLength(coupledLength(positive,negative,m_Gap));
+  }
+ protected:
+  CBoard& m_Board;
+  CDifferentialPair *m_Pairs;
+  TDimension m_Gap;
+};
+
+CDifferentialPairAnalysis::CDifferentialPairAnalysis(void)
+{
+ m_Suffixes.append(QPair<QString,QString>("_P","_N"));
+ m_Suffixes.append(QPair<QString,QString>("_p","_n"));
+ m_Suffixes.append(QPair<QString,QString>("+","-"));
+ m_MaxSkew = 0.127;
+ m_MaxGap = 0.5;
+ m_MinCouplingRatio = 0.8;
+ m_MaxLengthDelta = 0.0;
+ m_ThreadCount = 0;
+}
+
+CDifferentialPairAnalysis::~CDifferentialPairAnalysis(void)
+{
+ clear();
+}
+
+void CDifferentialPairAnalysis::clear(void)
+{
+ m_Pairs.clear();
+}
+
+bool CDifferentialPairAnalysis::analyze(CBoard& board)
+{
+ clear();
+ QHash<QString,int> names;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  names.insert(board.signal().at(i)->name(),i);
+ }
+ QVector<CDifferentialPair> pairs;
+ QSet<int> used;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  if (used.contains(i)) continue;
+  if (!m_Classes.isEmpty() && !m_Classes.contains(s->signalClass())) continue;
+  for (int k = 0; k < m_Suffixes.size(); k++)
+  {
+   const QString& p = m_Suffixes.at(k).first;
+   if (!s->name().endsWith(p) || s->name().length()==p.length()) continue;
+   QString base = s->name().left(s->name().length()-p.length());
+   int n = names.value(base + m_Suffixes.at(k).second,-1);
+   if (n < 0 || used.contains(n) || board.signal().at(n)->signalClass()!=s->signalClass()) continue;
+   CDifferentialPair pair;
+   pair.setName(base);
+   pair.setPositive(i);
+   pair.setNegative(n);
+   pair.setSignalClass(s->signalClass());
+   pairs.append(pair);
+   used.insert(i);
+   used.insert(n);
+   break;
+  }
+ }
+ CDifferentialPairJob job(board,pairs.data(),m_MaxGap);
+ parallelFor(pairs.size(),job,m_ThreadCount);
+ // length matching is relative to the longest pair of the class
+ QHash<TClass,TDimension> longest;
+ for (int i = 0; i < pairs.size(); i++)
+ {
+  TClass c = pairs.at(i).signalClass();
+  longest.insert(c,std::max(longest.value(c,0.0),pairs.at(i).length()));
+ }
+ for (int i = 0; i < pairs.size(); i++)
+ {
+  CDifferentialPair& pair = pairs[i];
+  pair.setLengthDelta(longest.value(pair.signalClass()) - pair.length());
+  int v = CDifferentialPair::dvNone;
+  if (pair.skew() > m_MaxSkew) v |= CDifferentialPair::dvSkew;
+  if (pair.positiveLength() > 0.0 && pair.couplingRatio() < m_MinCouplingRatio) v |= CDifferentialPair::dvCoupling;
+  if (m_MaxLengthDelta > 0.0 && pair.lengthDelta() > m_MaxLengthDelta) v |= CDifferentialPair::dvLengthMatch;
+  pair.setViolations(v);
+  m_Pairs.append(pair);
+ }
+ return 0==violationCount();
+}
+
+int CDifferentialPairAnalysis::violationCount(void) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Pairs.size(); i++)
+ {
+  if (CDifferentialPair::dvNone!=m_Pairs.at(i).violations()) result++;
+ }
+ return result;
+}
+
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,338 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEANALYSIS_H
+#define QEAGLEANALYSIS_H
+//------------------------------------------------------------------------------
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements connectivity and routing analysis of boards
+*/
+
+namespace Eagle
+{
+
+// unrouted connection between two pieces of copper of a signal
+class CAirwire
+{
+ public:
+  CAirwire(const int signal, const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2);
+  CAirwire(const CAirwire& airwire);
+  CAirwire(void);
+  virtual ~CAirwire(void);
+ public:
+  void operator =(const CAirwire& airwire);
+  void clear(void);
+  void assign(const CAirwire& airwire);
+  TDimension length(void) const;
+ public:
+  // getters
+  int signal(void) const { return m_Signal; }
+  TCoord x1(void) const { return m_X1; }
+  TCoord y1(void) const { return m_Y1; }
+  TCoord x2(void) const { return m_X2; }
+  TCoord y2(void) const { return m_Y2; }
+ protected:
+  int m_Signal; // index into board signals
+  TCoord m_X1;
+  TCoord m_Y1;
+  TCoord m_X2;
+  TCoord m_Y2;
+};
+
+// airwires of every signal: copper of a signal is split into connected
+// parts and the parts are joined by a minimum spanning tree
+class CRatsnest
+{
+ public:
+  CRatsnest(void);
+  virtual ~CRatsnest(void);
+ public:
+  void clear(void);
+  void compute(CBoard& board);
+  // recomputes only signals connected to the given elements (indices)
+  void update(CBoard& board, const QList<int>& elements);
+  // recomputes only the given signals (indices)
+  void updateSignals(CBoard& board, const QList<int>& signalIndices);
+  int unroutedCount(void) const;
+  int unroutedCount(const int signal) const;
+  TDimension unroutedLength(void) const;
+ public:
+  // getters
+  const QVector<CAirwire>& airwires(const int signal) const { return m_Airwires[signal]; }
+  int signalCount(void) const { return m_Airwires.size(); }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  void computeSignals(CBoard& board, const QVector<CPadInstance>& pads, const QVector<int>& signalIndices);
+ protected:
+  QVector<QVector<CAirwire> > m_Airwires; // per signal
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+};
+
+// connected piece of copper of a signal that reaches none of its pads
+class CCopperIsland
+{
+ public:
+  CCopperIsland(const CCopperIsland& island);
+  CCopperIsland(void);
+  virtual ~CCopperIsland(void);
+ public:
+  void operator =(const CCopperIsland& island);
+  void clear(void);
+  void assign(const CCopperIsland& island);
+ public:
+  // getters
+  int signal(void) const { return m_Signal; }
+  const CBoundingBox& boundingBox(void) const { return m_BoundingBox; }
+  int wireCount(void) const { return m_WireCount; }
+  int viaCount(void) const { return m_ViaCount; }
+  int polygonCount(void) const { return m_PolygonCount; }
+  // setters
+  void setSignal(const int value) { m_Signal = value; }
+  void setBoundingBox(const CBoundingBox& value) { m_BoundingBox = value; }
+  void setWireCount(const int value) { m_WireCount = value; }
+  void setViaCount(const int value) { m_ViaCount = value; }
+  void setPolygonCount(const int value) { m_PolygonCount = value; }
+ protected:
+  int m_Signal; // index into board signals
+  CBoundingBox m_BoundingBox;
+  int m_WireCount;
+  int m_ViaCount;
+  int m_PolygonCount;
+};
+
+// wire end of a signal that is connected to nothing
+class CCopperStub
+{
+ public:
+  CCopperStub(const int signal, const int wire, const TCoord x, const TCoord y, const TLayer layer);
+  CCopperStub(const CCopperStub& stub);
+  CCopperStub(void);
+  virtual ~CCopperStub(void);
+ public:
+  void operator =(const CCopperStub& stub);
+  void clear(void);
+  void assign(const CCopperStub& stub);
+ public:
+  // getters
+  int signal(void) const { return m_Signal; }
+  int wire(void) const { return m_Wire; }
+  TCoord x(void) const { return m_X; }
+  TCoord y(void) const { return m_Y; }
+  TLayer layer(void) const { return m_Layer; }
+ protected:
+  int m_Signal; // index into board signals
+  int m_Wire; // index into signal wires
+  TCoord m_X;
+  TCoord m_Y;
+  TLayer m_Layer;
+};
+
+// finds islands and dangling wire ends of every signal
+class CConnectivityCheck
+{
+ public:
+  CConnectivityCheck(void);
+  virtual ~CConnectivityCheck(void);
+ public:
+  void clear(void);
+  bool check(CBoard& board);
+ public:
+  // getters
+  const QList<CCopperIsland>& islands(void) const { return m_Islands; }
+  const QList<CCopperStub>& stubs(void) const { return m_Stubs; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QList<CCopperIsland> m_Islands;
+  QList<CCopperStub> m_Stubs;
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+};
+
+// routed copper of a signal, or summed over a net class or the board
+class CRoutingStatistics
+{
+ public:
+  CRoutingStatistics(const CRoutingStatistics& statistics);
+  CRoutingStatistics(void);
+  virtual ~CRoutingStatistics(void);
+ public:
+  void operator =(const CRoutingStatistics& statistics);
+  void clear(void);
+  void assign(const CRoutingStatistics& statistics);
+  void add(const CRoutingStatistics& statistics);
+  void add(CWire& wire);
+  void add(const QList<CWire*>& wires);
+  void add(CVia& via);
+ public:
+  // getters
+  QString name(void) const { return m_Name; }
+  TClass signalClass(void) const { return m_Class; }
+  TDimension length(void) const { return m_Length; }
+  int wireCount(void) const { return m_WireCount; }
+  int viaCount(void) const { return m_ViaCount; }
+  const QMap<TLayer,TDimension>& layerLengths(void) const { return m_LayerLengths; }
+  const QMap<int,int>& widthCounts(void) const { return m_WidthCounts; }
+  // setters
+  void setName(const QString& value) { m_Name = value; }
+  void setSignalClass(const TClass value) { m_Class = value; }
+ protected:
+  QString m_Name;
+  TClass m_Class;
+  TDimension m_Length; // arcs are measured along the arc
+  int m_WireCount;
+  int m_ViaCount;
+  QMap<TLayer,TDimension> m_LayerLengths; // routed length per copper layer
+  QMap<int,int> m_WidthCounts; // wire width in micrometers, number of wires
+};
+
+// routing statistics of all signals of a board, per signal, per net class
+// and in total, exportable as CSV or JSON
+class CRoutingReport
+{
+ public:
+  CRoutingReport(void);
+  virtual ~CRoutingReport(void);
+ public:
+  void clear(void);
+  void compute(CBoard& board);
+  void writeCSV(QTextStream& out) const;
+  void writeJSON(QTextStream& out) const;
+  bool saveToCSV(const QString& fileName) const;
+  bool saveToJSON(const QString& fileName) const;
+ public:
+  // getters
+  const QList<CRoutingStatistics>& signalStatistics(void) const { return m_Signals; }
+  const QList<CRoutingStatistics>& classStatistics(void) const { return m_Classes; }
+  const CRoutingStatistics& total(void) const { return m_Total; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QList<CRoutingStatistics> m_Signals; // in board order
+  QList<CRoutingStatistics> m_Classes; // by class number
+  CRoutingStatistics m_Total;
+  int m_ThreadCount; // default = 0, ideal thread count
+};
+
+// two signals routed as a differential pair
+class CDifferentialPair
+{
+ public:
+  enum Violation {dvNone = 0x00, dvSkew = 0x01, dvCoupling = 0x02, dvLengthMatch = 0x04};
+ public:
+  CDifferentialPair(const CDifferentialPair& pair);
+  CDifferentialPair(void);
+  virtual ~CDifferentialPair(void);
+ public:
+  void operator =(const CDifferentialPair& pair);
+  void clear(void);
+  void assign(const CDifferentialPair& pair);
+  TDimension skew(void) const { return fabs(m_PositiveLength - m_NegativeLength); }
+  TDimension length(void) const { return 0.5*(m_PositiveLength + m_NegativeLength); }
+  double couplingRatio(void) const;
+ public:
+  // getters
+  QString name(void) const { return m_Name; }
+  int positive(void) const { return m_Positive; }
+  int negative(void) const { return m_Negative; }
+  TClass signalClass(void) const { return m_Class; }
+  TDimension positiveLength(void) const { return m_PositiveLength; }
+  TDimension negativeLength(void) const { return m_NegativeLength; }
+  TDimension coupledLength(void) const { return m_CoupledLength; }
+  TDimension lengthDelta(void) const { return m_LengthDelta; }
+  int violations(void) const { return m_Violations; }
+  // setters
+  void setName(const QString& value) { m_Name = value; }
+  void setPositive(const int value) { m_Positive = value; }
+  void setNegative(const int value) { m_Negative = value; }
+  void setSignalClass(const TClass value) { m_Class = value; }
+  void setPositiveLength(const TDimension value) { m_PositiveLength = value; }
+  void setNegativeLength(const TDimension value) { m_NegativeLength = value; }
+  void setCoupledLength(const TDimension value) { m_CoupledLength = value; }
+  void setLengthDelta(const TDimension value) { m_LengthDelta = value; }
+  void setViolations(const int value) { m_Violations = value; }
+ protected:
+  QString m_Name; // signal name without the suffix
+  int m_Positive; // index into board signals
+  int m_Negative;
+  TClass m_Class;
+  TDimension m_PositiveLength;
+  TDimension m_NegativeLength;
+  TDimension m_CoupledLength; // length of the pair run side by side
+  TDimension m_LengthDelta; // to the longest pair of the same class
+  int m_Violations;
+};
+
+// pairs signals of the same net class by name suffix, measures their
+// lengths, skew and coupling and checks them against tolerances
+class CDifferentialPairAnalysis
+{
+ public:
+  CDifferentialPairAnalysis(void);
+  virtual ~CDifferentialPairAnalysis(void);
+ public:
+  void clear(void);
+  bool analyze(CBoard& board);
+  int violationCount(void) const;
+ public:
+  // getters
+  const QList<CDifferentialPair>& pairs(void) const { return m_Pairs; }
+  QList<QPair<QString,QString> >& suffixes(void) { return m_Suffixes; }
+  QList<TClass>& classes(void) { return m_Classes; }
+  TDimension maxSkew(void) const { return m_MaxSkew; }
+  TDimension maxGap(void) const { return m_MaxGap; }
+  double minCouplingRatio(void) const { return m_MinCouplingRatio; }
+  TDimension maxLengthDelta(void) const { return m_MaxLengthDelta; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setMaxSkew(const TDimension value) { m_MaxSkew = value; }
+  void setMaxGap(const TDimension value) { m_MaxGap = value; }
+  void setMinCouplingRatio(const double value) { m_MinCouplingRatio = value; }
+  void setMaxLengthDelta(const TDimension value) { m_MaxLengthDelta = value; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QList<CDifferentialPair> m_Pairs;
+  QList<QPair<QString,QString> > m_Suffixes; // default = _P/_N, +/-
+  QList<TClass> m_Classes; // default = empty, any class
+  TDimension m_MaxSkew; // default = 0.127 (5 mil)
+  TDimension m_MaxGap; // default = 0.5, center to center distance of coupled wires
+  double m_MinCouplingRatio; // default = 0.8
+  TDimension m_MaxLengthDelta; // default = 0, not checked
+  int m_ThreadCount; // default = 0, ideal thread count
+};
+
+}
+
+#endif // QEAGLEANALYSIS_H
+//------------------------------------------------------------------------------
@@ -0,0 +1,791 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <iostream>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleDRC.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+CDRCError::CDRCError(const CDRCError::Type type, const TLayer layer, const TCoord x, const TCoord y,
+ const TDimension value, const TDimension limit, const QString& signal1, const QString& signal2)
+{
+ m_Type = type; m_Layer = layer; m_X = x; m_Y = y; m_Value = value; m_Limit = limit;
+ m_Signal1 = signal1; m_Signal2 = signal2; m_Approved = false;
+}
+
+CDRCError::CDRCError(const CDRCError& error)
+{
+ assign(error);
+}
+
+CDRCError::CDRCError(void)
+{
+ clear();
+}
+
+CDRCError::~CDRCError(void)
+{
+ clear();
+}
+
+QString CDRCError::toString(const CDRCError::Type value)
+{
+ switch (value)
+ {
+  case CDRCError::etClearance: return "clearance";
+  case CDRCError::etWidth: return "width";
+  case CDRCError::etDrill: return "drill";
+  case CDRCError::etAnnularRing: return "annularring";
+ }
+ return "";
+}
+
+void CDRCError::operator =(const CDRCError& error)
+{
+ assign(error);
+}
+
+void CDRCError::clear(void)
+{
+ m_Type = CDRCError::etClearance;
+ m_Layer = CLayer::LAYER__INVALID;
+ m_X = 0.0;
+ m_Y = 0.0;
+ m_Value = 0.0;
+ m_Limit = 0.0;
+ m_Signal1.clear();
+ m_Signal2.clear();
+ m_Approved = false;
+}
+
+void CDRCError::assign(const CDRCError& error)
+{
+ m_Type = error.m_Type;
+ m_Layer = error.m_Layer;
+ m_X = error.m_X;
+ m_Y = error.m_Y;
+ m_Value = error.m_Value;
+ m_Limit = error.m_Limit;
+ m_Signal1 = error.m_Signal1;
+ m_Signal2 = error.m_Signal2;
+ m_Approved = error.m_Approved;
+}
+
+void CDRCError::show(std::ostream& out, const int level)
+{
+ CEntity::show(out,level);
+ out<<"DRCError:{Type="<<toString(m_Type).toUtf8().data()
+    <<", Layer="<<m_Layer<<", X="<<m_X<<", Y="<<m_Y
+    <<", Value="<<m_Value<<", Limit="<<m_Limit
+    <<", Signal1='"<<m_Signal1.toUtf8().data()
+    <<"', Signal2='"<<m_Signal2.toUtf8().data()
+    <<"', Approved="<<CEntity::toString(m_Approved).toUtf8().data()
+    <<", Hash='"<<hash().toUtf8().data()<<"'}"<<std::endl;
+}
+
+bool CDRCError::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options)
+{
+ // written the way an approved error is stored in <errors>
+ CApproved *a = createApproved();
+ bool result = a->writeToXML(host,root,options);
+ delete a;
+ return result;
+}
+
+QString CDRCError::hash(void) const
+{
+ // FNV-1a over the describing fields, coordinates rounded to 0.1 um so
+ // that the hash survives a load/save round trip of the board
+ QString s1 = m_Signal1, s2 = m_Signal2;
+ if (s2 < s1) std::swap(s1,s2);
+ QByteArray data = QString("%1;%2;%3;%4;%5;%6")
+  .arg(toString(m_Type)).arg(m_Layer)
+  .arg(qRound64(m_X*10000.0)).arg(qRound64(m_Y*10000.0))
+  .arg(s1).arg(s2).toUtf8();
+ quint64 h = Q_UINT64_C(14695981039346656037);
+ for (int i = 0; i < data.size(); i++)
+ {
+  h ^= (uchar)data.at(i);
+  h *= Q_UINT64_C(1099511628211);
+ }
+ return QString("%1").arg(h,16,16,QChar('0'));
+}
+
+CApproved *CDRCError::createApproved(void) const
+{
+ CApproved *a = new CApproved();
+ a->setHash(hash());
+ return a;
+}
+
+//------------------------------------------------------------------------------
+
+// copper of the board and of packages that belongs to no signal is dkCopper
+enum TDRCKind {dkWire, dkPad, dkVia, dkSmd, dkCopper, dkHole, dkDimension, dk__COUNT};
+
+class CDRCItem
+{
+ public:
+  CShape shape;
+  TLayer layer;
+  int net; // signal index, or a unique number for unconnected objects
+  int source; // originating object, arc pieces share it
+  TDRCKind kind;
+  TClass netClass;
+  int element; // placed element of pads and package copper, -1 otherwise
+};
+
+class CDRCViolation
+{
+ public:
+  int source1;
+  int source2;
+  TLayer layer;
+  TDimension distance;
+  TDimension limit;
+  CPoint location;
+  int net1;
+  int net2;
+};
+
+class CDRCRules: public CPadRules
+{
+ public:
+  CDRCRules(CDesignRule& designRules): CPadRules(designRules)
+  {
+   const CDesignRuleValues& rules = designRules.values();
+   const double mil = 0.0254;
+   TDimension wire_wire = rules.dimension("mdWireWire",8*mil);
+   TDimension wire_pad = rules.dimension("mdWirePad",8*mil);
+   TDimension wire_via = rules.dimension("mdWireVia",8*mil);
+   TDimension pad_pad = rules.dimension("mdPadPad",8*mil);
+   TDimension pad_via = rules.dimension("mdPadVia",8*mil);
+   TDimension via_via = rules.dimension("mdViaVia",8*mil);
+   TDimension smd_pad = rules.dimension("mdSmdPad",8*mil);
+   TDimension smd_via = rules.dimension("mdSmdVia",8*mil);
+   TDimension smd_smd = rules.dimension("mdSmdSmd",8*mil);
+   TDimension copper_dimension = rules.dimension("mdCopperDimension",40*mil);
+   TDimension drill_drill = rules.dimension("mdDrill",8*mil);
+   setClearance(dkWire,dkWire,wire_wire);
+   setClearance(dkWire,dkPad,wire_pad);
+   setClearance(dkWire,dkVia,wire_via);
+   setClearance(dkWire,dkSmd,wire_pad);
+   setClearance(dkPad,dkPad,pad_pad);
+   setClearance(dkPad,dkVia,pad_via);
+   setClearance(dkPad,dkSmd,smd_pad);
+   setClearance(dkVia,dkVia,via_via);
+   setClearance(dkVia,dkSmd,smd_via);
+   setClearance(dkSmd,dkSmd,smd_smd);
+   // copper drawn without a signal keeps the distances of a wire
+   for (int k = 0; k < dkCopper; k++)
+   {
+    setClearance(dkCopper,(TDRCKind)k,clearance[dkWire][k]);
+   }
+   setClearance(dkCopper,dkCopper,wire_wire);
+   // holes are dimension objects as far as copper is concerned
+   for (int k = 0; k < dkHole; k++)
+   {
+    setClearance((TDRCKind)k,dkHole,copper_dimension);
+    setClearance((TDRCKind)k,dkDimension,copper_dimension);
+   }
+   setClearance(dkHole,dkHole,drill_drill);
+   // a negative clearance is not checked
+   setClearance(dkHole,dkDimension,-1.0);
+   setClearance(dkDimension,dkDimension,-1.0);
+   minWidth = rules.dimension("msWidth",10*mil);
+   minDrill = rules.dimension("msDrill",24*mil);
+   maxClearance = 0.0;
+   for (int i = 0; i < dk__COUNT; i++)
+   {
+    for (int j = 0; j < dk__COUNT; j++)
+    {
+     maxClearance = std::max(maxClearance,clearance[i][j]);
+    }
+   }
+  }
+  void setClearance(const TDRCKind a, const TDRCKind b, const TDimension value)
+  {
+   clearance[a][b] = clearance[b][a] = value;
+  }
+ public:
+  TDimension clearance[dk__COUNT][dk__COUNT];
+  TDimension maxClearance;
+  TDimension minWidth;
+  TDimension minDrill;
+};
+
+static bool lessByLeft(const CDRCItem *a, const CDRCItem *b)
+{
+ return a->shape.boundingBox().left() < b->shape.boundingBox().left();
+}
+
+class CDRCTileJob: public CParallelJob
+{
+ public:
+  CDRCTileJob(const QVector<CDRCItem>& items, const CSpatialIndex& index, const CDRCRules& rules,
+              const CClearanceMatrix& classClearances):
+   m_Items(items), m_Index(index), m_Rules(rules), m_ClassClearances(classClearances)
+  {
+   m_Results.resize(index.columns()*index.rows());
+  }
+  virtual void execute(const int index)
+  {
+   int column = index % m_Index.columns();
+   int row = index / m_Index.columns();
+   TDimension size = m_Index.cellSize();
+   CBoundingBox tile(m_Index.extent().left() + column*size,
+                     m_Index.extent().bottom() + row*size,
+                     m_Index.extent().left() + (column+1)*size,
+                     m_Index.extent().bottom() + (row+1)*size);
+   CBoundingBox area = tile;
+   area.inflate(m_Rules.maxClearance);
+   QVector<int> ids;
+   m_Index.query(area,ids);
+   QVector<const CDRCItem*> candidates;
+   candidates.reserve(ids.size());
+   for (int i = 0; i < ids.size(); i++)
+   {
+    candidates.append(&m_Items.at(ids.at(i)));
+   }
+   std::sort(candidates.begin(),candidates.end(),lessByLeft);
+   QList<CDRCViolation>& result = m_Results[index];
+   for (int i = 0; i < candidates.size(); i++)
+   {
+    const CDRCItem *a = candidates.at(i);
+    const CBoundingBox& ba = a->shape.boundingBox();
+    TDimension reach = ba.right() + m_Rules.maxClearance;
+    for (int j = i+1; j < candidates.size(); j++)
+    {
+     const CDRCItem *b = candidates.at(j);
+     const CBoundingBox& bb = b->shape.boundingBox();
+     if (bb.left() > reach) break;
+     if (a->layer!=b->layer || a->net==b->net) continue;
+     // package copper is part of the pads it is drawn with
+     if (a->element>=0 && a->element==b->element && (dkCopper==a->kind || dkCopper==b->kind)) continue;
+     // holes go through all layers, a pair of them is checked on the first
+     bool drills = dkHole==a->kind && dkHole==b->kind;
+     if (drills && a->layer!=m_Rules.layers().first()) continue;
+     TDimension limit = required(a,b);
+     if (limit < 0.0) continue;
+     if (bb.bottom() > ba.top()+limit || ba.bottom() > bb.top()+limit ||
+         bb.left() > ba.right()+limit) continue;
+     // the pair belongs to the tile holding the corner of the overlap,
+     // this way every pair is checked exactly once
+     TCoord rx = std::max(ba.left(),bb.left());
+     TCoord ry = std::max(ba.bottom(),bb.bottom());
+     if (!owns(tile,column,row,rx,ry)) continue;
+     CPoint location;
+     TDimension d = a->shape.distance(b->shape,&location);
+     if (d < limit)
+     {
+      CDRCViolation v;
+      v.source1 = std::min(a->source,b->source);
+      v.source2 = std::max(a->source,b->source);
+      v.layer = drills ? (TLayer)CLayer::LAYER_HOLES : a->layer;
+      v.distance = std::max(d,0.0);
+      v.limit = limit;
+      v.location = location;
+      v.net1 = (a->source < b->source) ? a->net : b->net;
+      v.net2 = (a->source < b->source) ? b->net : a->net;
+      result.append(v);
+     }
+    }
+   }
+  }
+  TDimension required(const CDRCItem *a, const CDRCItem *b) const
+  {
+   TDimension result = m_Rules.clearance[a->kind][b->kind];
+   if (a->kind < dkHole && b->kind < dkHole)
+   {
+    result = std::max(result,m_ClassClearances.specific(a->netClass,b->netClass));
+   }
+   return result;
+  }
+  bool owns(const CBoundingBox& tile, const int column, const int row, const TCoord x, const TCoord y) const
+  {
+   // points outside of the grid belong to the border tiles
+   bool in_x = (x >= tile.left() || 0==column) && (x < tile.right() || m_Index.columns()-1==column);
+   bool in_y = (y >= tile.bottom() || 0==row) && (y < tile.top() || m_Index.rows()-1==row);
+   return in_x && in_y;
+  }
+  QVector<QList<CDRCViolation> >& results(void) { return m_Results; }
+ protected:
+  const QVector<CDRCItem>& m_Items;
+  const CSpatialIndex& m_Index;
+  const CDRCRules& m_Rules;
+  const CClearanceMatrix& m_ClassClearances;
+  QVector<QList<CDRCViolation> > m_Results;
+};
+
+//------------------------------------------------------------------------------
+
+CDesignRuleCheck::CDesignRuleCheck(void)
+{
+ m_Checks = CDesignRuleCheck::dcAll;
+ m_TileSize = 0.0;
+ m_ThreadCount = 0;
+}
+
+CDesignRuleCheck::~CDesignRuleCheck(void)
+{
+ clear();
+}
+
+void CDesignRuleCheck::clear(void)
+{
+ for (int i = 0; i < m_Errors.size(); i++)
+ {
+  if (0!=m_Errors[i]) delete m_Errors[i];
+ }
+ m_Errors.clear();
+}
+
+int CDesignRuleCheck::unapprovedCount(void) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Errors.size(); i++)
+ {
+  if (!m_Errors.at(i)->approved()) result++;
+ }
+ return result;
+}
+
+static void appendShapeItem(QVector<CDRCItem>& items, const CShape& shape, const TLayer layer,
+ const int net, const int source, const TDRCKind kind, const TClass netClass, const int element = -1)
+{
+ CDRCItem item;
+ item.shape = shape;
+ item.layer = layer;
+ item.net = net;
+ item.source = source;
+ item.kind = kind;
+ item.netClass = netClass;
+ item.element = element;
+ items.append(item);
+}
+
+// strokes of a copper text, checked as wires of a net of their own
+static void appendTextItems(QVector<CDRCItem>& items, const CTextGeometry& text, const TLayer layer,
+ const int net, const int source, const int element = -1)
+{
+ for (int i = 0; i < text.strokeCount(); i++)
+ {
+  for (int j = 0; j < std::max(text.count(i)-1,1); j++)
+  {
+   const CPoint& p1 = text.point(i,j);
+   const CPoint& p2 = text.point(i,std::min(j+1,text.count(i)-1));
+   CShape shape;
+   shape.setSegment(p1.x(),p1.y(),p2.x(),p2.y(),0.5*text.width());
+   appendShapeItem(items,shape,layer,net,source,dkCopper,0,element);
+  }
+ }
+}
+
+// polyline of a line width as segments of one source
+static void appendLineItems(QVector<CDRCItem>& items, const QVector<CPoint>& points, const TDimension width,
+ const TLayer layer, const int net, const int source, const int element)
+{
+ for (int k = 1; k < points.size(); k++)
+ {
+  CShape shape;
+  shape.setSegment(points.at(k-1).x(),points.at(k-1).y(),points.at(k).x(),points.at(k).y(),0.5*width);
+  appendShapeItem(items,shape,layer,net,source,dkCopper,0,element);
+ }
+}
+
+// wires, rectangles, circles and polygons drawn on copper by the board or a
+// package, each a net of its own; polygons are checked along their outline
+// like unpoured signal polygons, objects lying wholly inside are not found
+static void appendCopperItems(QVector<CDRCItem>& items, QVector<QString>& netNames, int& source,
+ QList<CWire*>& wires, QList<CRectangle*>& rectangles, QList<CCircle*>& circles,
+ QList<CPolygon*>& polygons, const CTransform& transform, const QList<TLayer>& layers,
+ const int element, const TDimension tolerance)
+{
+ QVector<CPoint> points;
+ for (int i = 0; i < wires.size(); i++)
+ {
+  CWire *w = wires.at(i);
+  TLayer layer = transform.mapLayer(w->layer());
+  if (!layers.contains(layer)) continue;
+  TCoord x1, y1, x2, y2;
+  transform.map(w->x1(),w->y1(),x1,y1);
+  transform.map(w->x2(),w->y2(),x2,y2);
+  flattenArc(x1,y1,x2,y2,transform.mapCurve(w->curve()),tolerance,points);
+  appendLineItems(items,points,w->width(),layer,netNames.size(),source++,element);
+  netNames.append(QString());
+ }
+ for (int i = 0; i < rectangles.size(); i++)
+ {
+  CRectangle *r = rectangles.at(i);
+  TLayer layer = transform.mapLayer(r->layer());
+  if (!layers.contains(layer)) continue;
+  CPoint c = transform.map(CPoint(0.5*(r->x1()+r->x2()),0.5*(r->y1()+r->y2())));
+  CShape shape;
+  shape.setRectangle(c.x(),c.y(),fabs(r->x2()-r->x1()),fabs(r->y2()-r->y1()),
+   transform.mapAngle(r->rotation()));
+  appendShapeItem(items,shape,layer,netNames.size(),source++,dkCopper,0,element);
+  netNames.append(QString());
+ }
+ for (int i = 0; i < circles.size(); i++)
+ {
+  CCircle *c = circles.at(i);
+  TLayer layer = transform.mapLayer(c->layer());
+  if (!layers.contains(layer)) continue;
+  CPoint center = transform.map(CPoint(c->x(),c->y()));
+  if (c->width() <= 0.0)
+  {
+   CShape shape;
+   shape.setCircle(center.x(),center.y(),c->radius());
+   appendShapeItem(items,shape,layer,netNames.size(),source,dkCopper,0,element);
+  }
+  else
+  {
+   // a ring as two half circles
+   for (int k = 0; k < 2; k++)
+   {
+    TDimension r = (0==k) ? c->radius() : -c->radius();
+    flattenArc(center.x()+r,center.y(),center.x()-r,center.y(),180.0,tolerance,points);
+    appendLineItems(items,points,c->width(),layer,netNames.size(),source,element);
+   }
+  }
+  source++;
+  netNames.append(QString());
+ }
+ for (int i = 0; i < polygons.size(); i++)
+ {
+  CPolygon *p = polygons.at(i);
+  TLayer layer = transform.mapLayer(p->layer());
+  if (!layers.contains(layer) || CPolygon::ppCutout==p->pour()) continue;
+  QList<CVertex*>& v = p->vertices();
+  for (int j = 0; j < v.size(); j++)
+  {
+   CVertex *a = v.at(j);
+   CVertex *b = v.at((j+1) % v.size());
+   CPoint p1 = transform.map(CPoint(a->x(),a->y()));
+   CPoint p2 = transform.map(CPoint(b->x(),b->y()));
+   flattenArc(p1.x(),p1.y(),p2.x(),p2.y(),transform.mapCurve(a->curve()),tolerance,points);
+   appendLineItems(items,points,p->width(),layer,netNames.size(),source,element);
+  }
+  source++;
+  netNames.append(QString());
+ }
+}
+
+bool CDesignRuleCheck::check(CBoard& board)
+{
+ clear();
+ CDRCRules rules(board.designRules());
+ QHash<TClass,CClass*> classes;
+ for (int i = 0; i < board.classes().size(); i++)
+ {
+  classes.insert(board.classes().at(i)->number(),board.classes().at(i));
+ }
+ // nets: one per signal, unconnected objects get a number of their own
+ QVector<QString> net_names;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  net_names.append(board.signal().at(i)->name());
+ }
+ QList<CDRCError*> errors;
+ QVector<CDRCItem> items;
+ int source = 0;
+ const TDimension arc_tolerance = 0.001;
+ // signals
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  CClass *c = classes.value(s->signalClass(),0);
+  TDimension min_width = std::max(rules.minWidth,(0!=c) ? c->width() : 0.0);
+  TDimension min_drill = std::max(rules.minDrill,(0!=c) ? c->drill() : 0.0);
+  for (int j = 0; j < s->wires().size(); j++)
+  {
+   CWire *w = s->wires().at(j);
+   if (!CLayer::isCopper(w->layer())) continue;
+   if ((m_Checks & dcWidth) && w->width() < min_width)
+   {
+    errors.append(new CDRCError(CDRCError::etWidth,w->layer(),
+     0.5*(w->x1()+w->x2()),0.5*(w->y1()+w->y2()),w->width(),min_width,s->name(),""));
+   }
+   QVector<CPoint> points;
+   flattenWire(*w,arc_tolerance,points);
+   for (int k = 1; k < points.size(); k++)
+   {
+    CShape shape;
+    shape.setSegment(points.at(k-1).x(),points.at(k-1).y(),
+                     points.at(k).x(),points.at(k).y(),0.5*w->width());
+    appendShapeItem(items,shape,w->layer(),i,source,dkWire,s->signalClass());
+   }
+   source++;
+  }
+  for (int j = 0; j < s->vias().size(); j++)
+  {
+   CVia *v = s->vias().at(j);
+   if ((m_Checks & dcDrill) && v->drill() < min_drill)
+   {
+    errors.append(new CDRCError(CDRCError::etDrill,CLayer::LAYER_VIAS,
+     v->x(),v->y(),v->drill(),min_drill,s->name(),""));
+   }
+   if ((m_Checks & dcAnnularRing) && v->diameter() > 0.0 &&
+       0.5*(v->diameter()-v->drill()) < rules.minViaRing())
+   {
+    errors.append(new CDRCError(CDRCError::etAnnularRing,CLayer::LAYER_VIAS,
+     v->x(),v->y(),0.5*(v->diameter()-v->drill()),rules.minViaRing(),s->name(),""));
+   }
+   int start, stop;
+   decodeExtent(v->extent(),start,stop);
+   for (int k = 0; k < rules.layers().size(); k++)
+   {
+    TLayer l = rules.layers().at(k);
+    if (l < start || l > stop) continue;
+    CShape shape;
+    rules.viaShape(*v,l,shape);
+    appendShapeItem(items,shape,l,i,source,dkVia,s->signalClass());
+   }
+   source++;
+  }
+ }
+ int unconnected = board.signal().size();
+ // element pads and smds
+ const QVector<CPadInstance>& pads = m_PadResolver.resolve(board,m_ThreadCount);
+ for (int i = 0; i < pads.size(); i++)
+ {
+  const CPadInstance& pad = pads.at(i);
+  int net = pad.signal();
+  if (net < 0) { net = unconnected++; net_names.append(QString()); }
+  TClass net_class = (net < board.signal().size()) ? board.signal().at(net)->signalClass() : 0;
+  if (CPadInstance::pkSMD==pad.kind())
+  {
+   if (rules.layers().contains(pad.layer()))
+   {
+    CShape shape;
+    rules.padShape(pad,pad.layer(),shape);
+    appendShapeItem(items,shape,pad.layer(),net,source,dkSmd,net_class,pad.element());
+   }
+   source++;
+   continue;
+  }
+  if ((m_Checks & dcDrill) && pad.drill() < rules.minDrill)
+  {
+   errors.append(new CDRCError(CDRCError::etDrill,CLayer::LAYER_PADS,
+    pad.x(),pad.y(),pad.drill(),rules.minDrill,net_names.at(net),""));
+  }
+  if ((m_Checks & dcAnnularRing) && pad.dx() > 0.0 &&
+      0.5*(pad.dx()-pad.drill()) < rules.minPadRing())
+  {
+   errors.append(new CDRCError(CDRCError::etAnnularRing,CLayer::LAYER_PADS,
+    pad.x(),pad.y(),0.5*(pad.dx()-pad.drill()),rules.minPadRing(),net_names.at(net),""));
+  }
+  for (int k = 0; k < rules.layers().size(); k++)
+  {
+   TLayer layer = rules.layers().at(k);
+   CShape shape;
+   rules.padShape(pad,layer,shape);
+   appendShapeItem(items,shape,layer,net,source,dkPad,net_class,pad.element());
+  }
+  source++;
+ }
+ // package holes
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) continue;
+  CTransform t(*board.elements().at(i));
+  for (int j = 0; j < p->holes().size(); j++)
+  {
+   CHole *h = p->holes().at(j);
+   TCoord x, y;
+   t.map(h->x(),h->y(),x,y);
+   if ((m_Checks & dcDrill) && h->drill() < rules.minDrill)
+   {
+    errors.append(new CDRCError(CDRCError::etDrill,CLayer::LAYER_HOLES,
+     x,y,h->drill(),rules.minDrill,"",""));
+   }
+   int net = unconnected++; net_names.append(QString());
+   for (int k = 0; k < rules.layers().size(); k++)
+   {
+    CShape shape;
+    shape.setCircle(x,y,0.5*h->drill());
+    appendShapeItem(items,shape,rules.layers().at(k),net,source,dkHole,0);
+   }
+   source++;
+  }
+ }
+ // board holes
+ for (int i = 0; i < board.plain().holes().size(); i++)
+ {
+  CHole *h = board.plain().holes().at(i);
+  if ((m_Checks & dcDrill) && h->drill() < rules.minDrill)
+  {
+   errors.append(new CDRCError(CDRCError::etDrill,CLayer::LAYER_HOLES,
+    h->x(),h->y(),h->drill(),rules.minDrill,"",""));
+  }
+  int net = unconnected++; net_names.append(QString());
+  for (int k = 0; k < rules.layers().size(); k++)
+  {
+   CShape shape;
+   shape.setCircle(h->x(),h->y(),0.5*h->drill());
+   appendShapeItem(items,shape,rules.layers().at(k),net,source,dkHole,0);
+  }
+  source++;
+ }
+ // edges of the board outline, all of one net of their own
+ if (m_Checks & dcClearance)
+ {
+  m_Outline.build(board);
+  int net = unconnected++; net_names.append(QString());
+  for (int i = 0; i < m_Outline.contours().size(); i++)
+  {
+   const CContour& c = m_Outline.contours().at(i);
+   for (int j = 0; j+1 < c.points().size(); j++)
+   {
+    // pieces of an arc share the dimension line they come from
+    CShape shape;
+    shape.setSegment(c.points().at(j).x(),c.points().at(j).y(),c.points().at(j+1).x(),c.points().at(j+1).y(),0.0);
+    for (int k = 0; k < rules.layers().size(); k++)
+    {
+     appendShapeItem(items,shape,rules.layers().at(k),net,source + c.lines().at(j),dkDimension,0);
+    }
+   }
+   source += c.count();
+  }
+ }
+ // copper drawn by the board and by packages
+ appendCopperItems(items,net_names,source,board.plain().wires(),board.plain().rectangles(),
+  board.plain().circles(),board.plain().polygons(),CTransform(),rules.layers(),-1,arc_tolerance);
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) continue;
+  appendCopperItems(items,net_names,source,p->wires(),p->rectangles(),p->circles(),p->polygons(),
+   CTransform(*board.elements().at(i)),rules.layers(),i,arc_tolerance);
+ }
+ unconnected = net_names.size();
+ // copper texts of the board and of packages, smashed parts show attributes
+ for (int i = 0; i < board.plain().texts().size(); i++)
+ {
+  CText *x = board.plain().texts().at(i);
+  if (!rules.layers().contains(x->layer())) continue;
+  CTextGeometry g;
+  m_Font.strokes(*x,g);
+  int net = unconnected++; net_names.append(QString());
+  appendTextItems(items,g,x->layer(),net,source++);
+ }
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CElement *e = board.elements().at(i);
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) continue;
+  CTransform t(*e);
+  for (int j = 0; j < p->texts().size(); j++)
+  {
+   CText *x = p->texts().at(j);
+   TLayer layer = t.mapLayer(x->layer());
+   if (!rules.layers().contains(layer)) continue;
+   if (e->smashed() && CVectorFont::isPartPlaceholder(x->text())) continue;
+   CTextGeometry g;
+   m_Font.strokes(*x,t,e->name(),e->value(),g);
+   int net = unconnected++; net_names.append(QString());
+   appendTextItems(items,g,layer,net,source++,i);
+  }
+  if (!e->smashed()) continue;
+  for (int j = 0; j < e->attributes().size(); j++)
+  {
+   CAttribute *a = e->attributes().at(j);
+   if (!rules.layers().contains(a->layer())) continue;
+   CTextGeometry g;
+   m_Font.strokes(*a,CVectorFont::attributeValue(*a,e->name(),e->value()),g);
+   int net = unconnected++; net_names.append(QString());
+   appendTextItems(items,g,a->layer(),net,source++,i);
+  }
+ }
+ // clearance, tile by tile
+ if ((m_Checks & dcClearance) && !items.isEmpty())
+ {
+  CBoundingBox extent;
+  for (int i = 0; i < items.size(); i++)
+  {
+   extent.include(items.at(i).shape.boundingBox());
+  }
+  TDimension tile = m_TileSize;
+  if (tile <= 0.0)
+  {
+   int threads = (m_ThreadCount > 0) ? m_ThreadCount : QThread::idealThreadCount();
+   tile = std::max(extent.width(),extent.height())/ceil(sqrt(4.0*std::max(threads,1)));
+  }
+  tile = std::max(tile,std::max(4.0*rules.maxClearance,0.01));
+  CSpatialIndex index(extent,tile);
+  for (int i = 0; i < items.size(); i++)
+  {
+   CBoundingBox box = items.at(i).shape.boundingBox();
+   index.insert(i,box);
+  }
+  CDRCTileJob job(items,index,rules,board.clearanceMatrix());
+  parallelFor(index.columns()*index.rows(),job,m_ThreadCount);
+  // arc pieces and neighbouring tiles may report the same pair of objects
+  // on a layer
+  QHash<QPair<QPair<int,int>,TLayer>,CDRCViolation> found;
+  QList<QPair<QPair<int,int>,TLayer> > order;
+  for (int i = 0; i < job.results().size(); i++)
+  {
+   const QList<CDRCViolation>& l = job.results().at(i);
+   for (int j = 0; j < l.size(); j++)
+   {
+    const CDRCViolation& v = l.at(j);
+    QPair<QPair<int,int>,TLayer> key(qMakePair(v.source1,v.source2),v.layer);
+    if (!found.contains(key))
+    {
+     found.insert(key,v);
+     order.append(key);
+    }
+    else if (v.distance < found.value(key).distance)
+    {
+     found.insert(key,v);
+    }
+   }
+  }
+  for (int i = 0; i < order.size(); i++)
+  {
+   const CDRCViolation v = found.value(order.at(i));
+   errors.append(new CDRCError(CDRCError::etClearance,v.layer,
+    v.location.x(),v.location.y(),v.distance,v.limit,
+    net_names.at(v.net1),net_names.at(v.net2)));
+  }
+ }
+ // errors already approved in the board are kept but flagged
+ QSet<QString> approved;
+ for (int i = 0; i < board.errors().size(); i++)
+ {
+  approved.insert(board.errors().at(i)->hash());
+ }
+ for (int i = 0; i < errors.size(); i++)
+ {
+  errors[i]->setApproved(approved.contains(errors.at(i)->hash()));
+ }
+ m_Errors = errors;
+ return 0==unapprovedCount();
+}
+
+}
+//------------------------------------------------------------------------------
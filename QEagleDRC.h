@@ -0,0 +1,122 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEDRC_H
+#define QEAGLEDRC_H
+//------------------------------------------------------------------------------
+#include <QList>
+#include <QString>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+#include "QEagleFont.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements a design rule check of a board driven by its <designrules>
+and net <classes>. Results are reported as errors carrying a hash stored in
+<approved> entries, so errors approved through this library are recognized by
+later checks. The hash is computed by this library, it does not match the
+signatures of errors approved in Eagle.
+*/
+
+namespace Eagle
+{
+
+class CDRCError: public CEntity
+{
+ public:
+  enum Type {etClearance, etWidth, etDrill, etAnnularRing};
+ public:
+  CDRCError(const CDRCError::Type type, const TLayer layer, const TCoord x, const TCoord y,
+            const TDimension value, const TDimension limit,
+            const QString& signal1, const QString& signal2);
+  CDRCError(const CDRCError& error);
+  CDRCError(void);
+  virtual ~CDRCError(void);
+ public:
+  static QString toString(const CDRCError::Type value);
+ public:
+  virtual void operator =(const CDRCError& error);
+  virtual void clear(void);
+  virtual void assign(const CDRCError& error);
+  virtual void show(std::ostream& out, const int level = 0);
+  virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  QString hash(void) const;
+  CApproved *createApproved(void) const;
+ public:
+  // getters
+  CDRCError::Type type(void) const { return m_Type; }
+  TLayer layer(void) const { return m_Layer; }
+  TCoord x(void) const { return m_X; }
+  TCoord y(void) const { return m_Y; }
+  TDimension value(void) const { return m_Value; }
+  TDimension limit(void) const { return m_Limit; }
+  QString signal1(void) const { return m_Signal1; }
+  QString signal2(void) const { return m_Signal2; }
+  bool approved(void) const { return m_Approved; }
+  // setters
+  void setApproved(const bool value) { m_Approved = value; }
+ protected:
+  CDRCError::Type m_Type;
+  TLayer m_Layer;
+  TCoord m_X; // location of the violation
+  TCoord m_Y;
+  TDimension m_Value; // measured distance, width, drill or ring
+  TDimension m_Limit; // required minimum
+  QString m_Signal1; // empty for unconnected objects
+  QString m_Signal2; // only for clearance errors
+  bool m_Approved;
+};
+
+class CDesignRuleCheck
+{
+ public:
+  enum Check {dcClearance = 0x01, dcWidth = 0x02, dcDrill = 0x04, dcAnnularRing = 0x08,
+              dcAll = 0x0F};
+ public:
+  CDesignRuleCheck(void);
+  virtual ~CDesignRuleCheck(void);
+ public:
+  void clear(void);
+  bool check(CBoard& board);
+  int unapprovedCount(void) const;
+ public:
+  // getters
+  QList<CDRCError*>& errors(void) { return m_Errors; }
+  int checks(void) const { return m_Checks; }
+  TDimension tileSize(void) const { return m_TileSize; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setChecks(const int value) { m_Checks = value; }
+  void setTileSize(const TDimension value) { m_TileSize = value; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QList<CDRCError*> m_Errors;
+  int m_Checks; // default = all
+  TDimension m_TileSize; // default = 0, chosen from board size and thread count
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver; // reused by consecutive checks of the same board
+  CVectorFont m_Font;
+  CBoardOutline m_Outline;
+};
+
+}
+
+#endif // QEAGLEDRC_H
+//------------------------------------------------------------------------------
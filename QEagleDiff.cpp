@@ -0,0 +1,951 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QPair>
+#include <QSet>
+//------------------------------------------------------------------------------
+#include "QEagleDiff.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+CDiffChange::CDiffChange(const CDiffChange::Kind kind, const QString& path, const QString& field,
+                         const QString& oldValue, const QString& newValue)
+{
+ m_Kind = kind;
+ m_Path = path;
+ m_Field = field;
+ m_OldValue = oldValue;
+ m_NewValue = newValue;
+}
+
+CDiffChange::CDiffChange(const CDiffChange& change)
+{
+ assign(change);
+}
+
+CDiffChange::CDiffChange(void)
+{
+ clear();
+}
+
+CDiffChange::~CDiffChange(void)
+{
+ //
+}
+
+QString CDiffChange::toString(const CDiffChange::Kind value)
+{
+ switch (value)
+ {
+  case CDiffChange::dkAdded: return "added";
+  case CDiffChange::dkRemoved: return "removed";
+  case CDiffChange::dkModified: return "modified";
+ }
+ return QString();
+}
+
+void CDiffChange::operator =(const CDiffChange& change)
+{
+ assign(change);
+}
+
+void CDiffChange::clear(void)
+{
+ m_Kind = CDiffChange::dkModified;
+ m_Path.clear();
+ m_Field.clear();
+ m_OldValue.clear();
+ m_NewValue.clear();
+}
+
+void CDiffChange::assign(const CDiffChange& change)
+{
+ m_Kind = change.m_Kind;
+ m_Path = change.m_Path;
+ m_Field = change.m_Field;
+ m_OldValue = change.m_OldValue;
+ m_NewValue = change.m_NewValue;
+}
+
+QString CDiffChange::toString(void) const
+{
+ switch (m_Kind)
+ {
+  case CDiffChange::dkAdded: return "+ " + m_Path;
+  case CDiffChange::dkRemoved: return "- " + m_Path;
+  case CDiffChange::dkModified:
+   return QString("~ %1 %2: \"%3\" -> \"%4\"").arg(m_Path).arg(m_Field).arg(m_OldValue).arg(m_NewValue);
+ }
+ return QString();
+}
+
+//------------------------------------------------------------------------------
+
+// identity of an object among its siblings of the same tag, following the
+// names Eagle itself uses for references
+static QString identity(const QDomElement& element)
+{
+ QString tag = element.tagName();
+ if (element.hasAttribute("name")) return element.attribute("name");
+ if ("layer"==tag || "class"==tag) return element.attribute("number");
+ if ("contactref"==tag) return element.attribute("element") + "." + element.attribute("pad");
+ if ("pinref"==tag) return element.attribute("part") + "." + element.attribute("gate") + "." + element.attribute("pin");
+ if ("instance"==tag) return element.attribute("part") + "." + element.attribute("gate");
+ if ("connect"==tag) return element.attribute("gate") + "." + element.attribute("pin");
+ if ("approved"==tag) return element.attribute("hash");
+ return QString();
+}
+
+//------------------------------------------------------------------------------
+
+CDocumentDiff::CDocumentDiff(void)
+{
+ clear();
+}
+
+CDocumentDiff::~CDocumentDiff(void)
+{
+ //
+}
+
+void CDocumentDiff::clear(void)
+{
+ m_Changes.clear();
+ m_Before.clear();
+ m_After.clear();
+}
+
+// index of the entity that wrote an element, entities are mostly listed
+// in document order so the search starts after the previous match
+static int findEntity(const QList<QPair<QDomElement,CEntity*> >& entities, const QDomElement& element, int& cursor)
+{
+ for (int k = 0; k < entities.size(); k++)
+ {
+  int i = (cursor + k) % entities.size();
+  if (entities.at(i).first==element)
+  {
+   cursor = i + 1;
+   return i;
+  }
+ }
+ return -1;
+}
+
+int CDocumentDiff::build(const QDomElement& element, const QList<QPair<QDomElement,CEntity*> >& entities,
+                         int& cursor, QVector<CDiffNode>& nodes)
+{
+ // nodes are stored depth first; an entity is taken with its cached
+ // content hash and gets its children once expanded, other elements hash
+ // their tag, attributes, children and text
+ int result = nodes.size();
+ nodes.append(CDiffNode());
+ CDiffNode node;
+ node.tag = element.tagName();
+ node.key = identity(element);
+ QDomNamedNodeMap map = element.attributes();
+ for (int i = 0; i < map.count(); i++)
+ {
+  QDomNode a = map.item(i);
+  node.attributes[a.nodeName()] = a.nodeValue();
+ }
+ int entity = findEntity(entities,element,cursor);
+ if (entity >= 0)
+ {
+  node.entity = entities.at(entity).second;
+  node.hash = node.entity->contentHash();
+  for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+  {
+   if (n.isText()) node.text += n.toText().data();
+  }
+ }
+ else
+ {
+  CContentHash hash;
+  hash.add(node.tag);
+  for (QMap<QString,QString>::const_iterator i = node.attributes.constBegin(); i != node.attributes.constEnd(); ++i)
+  {
+   hash.addAttribute(i.key(),i.value());
+  }
+  node.children = buildChildren(element,entities,nodes,&hash);
+  for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+  {
+   if (n.isText()) node.text += n.toText().data();
+  }
+  hash.add(node.text);
+  node.hash = hash.value();
+  node.expanded = true;
+ }
+ nodes[result] = node;
+ return result;
+}
+
+QVector<int> CDocumentDiff::buildChildren(const QDomElement& element, const QList<QPair<QDomElement,CEntity*> >& entities,
+                                          QVector<CDiffNode>& nodes, CContentHash *hash)
+{
+ QVector<int> result;
+ QHash<QString,int> ordinals;
+ int cursor = 0;
+ for (QDomElement e = element.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+ {
+  int child = build(e,entities,cursor,nodes);
+  nodes[child].index = ordinals[nodes[child].tag]++;
+  result.append(child);
+  if (0!=hash) hash->add(nodes[child].hash);
+ }
+ // the position is only part of the path when the tag repeats
+ for (int i = 0; i < result.size(); i++)
+ {
+  CDiffNode& c = nodes[result.at(i)];
+  if (1 == ordinals.value(c.tag)) c.index = -1;
+ }
+ return result;
+}
+
+void CDocumentDiff::expand(QVector<CDiffNode>& nodes, const int node)
+{
+ if (nodes.at(node).expanded) return;
+ // an entity taking the fields of its root gets one with its own tag
+ QDomDocument host("eagle");
+ QDomElement root = host.createElement(nodes.at(node).tag);
+ QList<QPair<QDomElement,CEntity*> > entities;
+ QDomElement e = nodes.at(node).entity->writeFields(host,root,entities);
+ QVector<int> children;
+ if (!e.isNull()) children = buildChildren(e,entities,nodes,0);
+ nodes[node].children = children;
+ nodes[node].expanded = true;
+}
+
+QString CDocumentDiff::childPath(const QString& path, const CDiffNode& node)
+{
+ if (!node.key.isEmpty()) return QString("%1/%2[%3]").arg(path).arg(node.tag).arg(node.key);
+ if (node.index < 0) return QString("%1/%2").arg(path).arg(node.tag);
+ return QString("%1/%2[#%3]").arg(path).arg(node.tag).arg(node.index);
+}
+
+void CDocumentDiff::report(const CDiffChange::Kind kind, const QVector<CDiffNode>& nodes, const int node,
+                           const QString& path)
+{
+ m_Changes.append(CDiffChange(kind,childPath(path,nodes.at(node))));
+}
+
+void CDocumentDiff::compareNodes(const int a, const int b, const QString& path)
+{
+ // equal subtrees are done with in a single comparison
+ if (m_Before.at(a).hash == m_After.at(b).hash) return;
+ expand(m_Before,a);
+ expand(m_After,b);
+ // copies, comparing the children appends to both node tables
+ const CDiffNode na = m_Before.at(a);
+ const CDiffNode nb = m_After.at(b);
+ // fields, both maps are sorted by name
+ QMap<QString,QString>::const_iterator ia = na.attributes.constBegin();
+ QMap<QString,QString>::const_iterator ib = nb.attributes.constBegin();
+ while (ia != na.attributes.constEnd() || ib != nb.attributes.constEnd())
+ {
+  if (ib == nb.attributes.constEnd() || (ia != na.attributes.constEnd() && ia.key() < ib.key()))
+  {
+   m_Changes.append(CDiffChange(CDiffChange::dkModified,path,ia.key(),ia.value(),QString()));
+   ++ia;
+  }
+  else if (ia == na.attributes.constEnd() || ib.key() < ia.key())
+  {
+   m_Changes.append(CDiffChange(CDiffChange::dkModified,path,ib.key(),QString(),ib.value()));
+   ++ib;
+  }
+  else
+  {
+   if (ia.value() != ib.value())
+    m_Changes.append(CDiffChange(CDiffChange::dkModified,path,ia.key(),ia.value(),ib.value()));
+   ++ia; ++ib;
+  }
+ }
+ if (na.text != nb.text)
+  m_Changes.append(CDiffChange(CDiffChange::dkModified,path,"#text",na.text,nb.text));
+ // children with an identity are matched by tag and identity, a repeated
+ // identity makes the children anonymous
+ QHash<QString,int> keysA, keysB;
+ for (int i = 0; i < na.children.size(); i++)
+ {
+  const CDiffNode& c = m_Before.at(na.children.at(i));
+  if (c.key.isEmpty()) continue;
+  QString k = c.tag + '\n' + c.key;
+  keysA[k] = keysA.contains(k) ? -1 : na.children.at(i);
+ }
+ for (int i = 0; i < nb.children.size(); i++)
+ {
+  const CDiffNode& c = m_After.at(nb.children.at(i));
+  if (c.key.isEmpty()) continue;
+  QString k = c.tag + '\n' + c.key;
+  keysB[k] = keysB.contains(k) ? -1 : nb.children.at(i);
+ }
+ // anonymous children are first matched by content, what remains is
+ // paired by tag in document order
+ QHash<quint64,QList<int> > anonymousA;
+ QSet<int> consumed, paired;
+ QHash<QString,QList<int> > pendingB;
+ QList<int> orderB;
+ for (int i = 0; i < na.children.size(); i++)
+ {
+  int child = na.children.at(i);
+  const CDiffNode& c = m_Before.at(child);
+  if (!c.key.isEmpty() && keysA.value(c.tag + '\n' + c.key) >= 0)
+  {
+   int match = keysB.value(c.tag + '\n' + c.key,-1);
+   if (match >= 0) compareNodes(child,match,childPath(path,c));
+   else report(CDiffChange::dkRemoved,m_Before,child,path);
+  }
+  else anonymousA[c.hash].append(child);
+ }
+ for (int i = 0; i < nb.children.size(); i++)
+ {
+  int child = nb.children.at(i);
+  const CDiffNode& c = m_After.at(child);
+  if (!c.key.isEmpty() && keysB.value(c.tag + '\n' + c.key) >= 0)
+  {
+   if (keysA.value(c.tag + '\n' + c.key,-1) < 0) report(CDiffChange::dkAdded,m_After,child,path);
+  }
+  else
+  {
+   QHash<quint64,QList<int> >::iterator same = anonymousA.find(c.hash);
+   if (same != anonymousA.end() && !same.value().isEmpty()) consumed.insert(same.value().takeFirst());
+   else { pendingB[c.tag].append(child); orderB.append(child); }
+  }
+ }
+ for (int i = 0; i < na.children.size(); i++)
+ {
+  int child = na.children.at(i);
+  const CDiffNode& c = m_Before.at(child);
+  if ((!c.key.isEmpty() && keysA.value(c.tag + '\n' + c.key) >= 0) || consumed.contains(child)) continue;
+  QList<int>& candidates = pendingB[c.tag];
+  if (candidates.isEmpty())
+  {
+   report(CDiffChange::dkRemoved,m_Before,child,path);
+  }
+  else
+  {
+   int match = candidates.takeFirst();
+   compareNodes(child,match,childPath(path,c));
+   paired.insert(match);
+  }
+ }
+ for (int i = 0; i < orderB.size(); i++)
+ {
+  if (!paired.contains(orderB.at(i))) report(CDiffChange::dkAdded,m_After,orderB.at(i),path);
+ }
+}
+
+bool CDocumentDiff::compare(CEagleDocument& before, CEagleDocument& after)
+{
+ // the documents are entities themselves, both are written with the same
+ // default options as they would be to disk
+ clear();
+ m_Before.append(CDiffNode());
+ m_Before[0].tag = "eagle";
+ m_Before[0].entity = &before;
+ m_Before[0].hash = before.contentHash();
+ m_After.append(CDiffNode());
+ m_After[0].tag = "eagle";
+ m_After[0].entity = &after;
+ m_After[0].hash = after.contentHash();
+ compareNodes(0,0,"/eagle");
+ return m_Changes.isEmpty();
+}
+
+int CDocumentDiff::count(const CDiffChange::Kind kind) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Changes.size(); i++)
+ {
+  if (m_Changes.at(i).kind() == kind) result++;
+ }
+ return result;
+}
+
+void CDocumentDiff::writeText(QTextStream& out) const
+{
+ for (int i = 0; i < m_Changes.size(); i++)
+ {
+  out<<m_Changes.at(i).toString()<<"\n";
+ }
+}
+
+
+//------------------------------------------------------------------------------
+
+CDuplicate::CDuplicate(const CDuplicate::Kind kind, const QString& library, const QString& name,
+                       const QString& canonicalLibrary, const QString& canonicalName,
+                       const int fileSize, const int memorySize)
+{
+ m_Kind = kind;
+ m_Library = library;
+ m_Name = name;
+ m_CanonicalLibrary = canonicalLibrary;
+ m_CanonicalName = canonicalName;
+ m_FileSize = fileSize;
+ m_MemorySize = memorySize;
+ m_Removed = false;
+}
+
+CDuplicate::CDuplicate(const CDuplicate& duplicate)
+{
+ assign(duplicate);
+}
+
+CDuplicate::CDuplicate(void)
+{
+ clear();
+}
+
+CDuplicate::~CDuplicate(void)
+{
+ //
+}
+
+void CDuplicate::operator =(const CDuplicate& duplicate)
+{
+ assign(duplicate);
+}
+
+void CDuplicate::clear(void)
+{
+ m_Kind = CDuplicate::ddPackage;
+ m_Library.clear();
+ m_Name.clear();
+ m_CanonicalLibrary.clear();
+ m_CanonicalName.clear();
+ m_FileSize = 0;
+ m_MemorySize = 0;
+ m_Removed = false;
+}
+
+void CDuplicate::assign(const CDuplicate& duplicate)
+{
+ m_Kind = duplicate.m_Kind;
+ m_Library = duplicate.m_Library;
+ m_Name = duplicate.m_Name;
+ m_CanonicalLibrary = duplicate.m_CanonicalLibrary;
+ m_CanonicalName = duplicate.m_CanonicalName;
+ m_FileSize = duplicate.m_FileSize;
+ m_MemorySize = duplicate.m_MemorySize;
+ m_Removed = duplicate.m_Removed;
+}
+
+//------------------------------------------------------------------------------
+
+// the element a package or symbol writes
+static QDomElement definitionElement(CEntity& entity, QDomDocument& host)
+{
+ CEagleDocumentOptions options;
+ QDomElement root = host.createElement("entity");
+ host.appendChild(root);
+ entity.writeToXML(host,root,options);
+ return root.firstChildElement();
+}
+
+// elements agree in tag, attributes, text and child elements
+static bool sameElement(const QDomElement& a, const QDomElement& b)
+{
+ if (a.tagName()!=b.tagName()) return false;
+ QDomNamedNodeMap attributes = a.attributes();
+ if (attributes.count()!=b.attributes().count()) return false;
+ for (int i = 0; i < attributes.count(); i++)
+ {
+  QDomNode n = attributes.item(i);
+  if (!b.hasAttribute(n.nodeName()) || b.attribute(n.nodeName())!=n.nodeValue()) return false;
+ }
+ QDomNode na = a.firstChild(), nb = b.firstChild();
+ for (; !na.isNull() && !nb.isNull(); na = na.nextSibling(), nb = nb.nextSibling())
+ {
+  if (na.isElement()!=nb.isElement() || na.isText()!=nb.isText()) return false;
+  if (na.isElement() && !sameElement(na.toElement(),nb.toElement())) return false;
+  if (na.isText() && na.toText().data()!=nb.toText().data()) return false;
+ }
+ return na.isNull() && nb.isNull();
+}
+
+// definitions of equal hash are only taken for duplicates once they agree
+// field by field without their names, a hash match alone may be a
+// collision; fileSize receives the length of the XML of the duplicate
+static bool sameDefinition(CEntity& canonical, CEntity& duplicate, int& fileSize)
+{
+ QDomDocument a("eagle"), b("eagle");
+ QDomElement ea = definitionElement(canonical,a), eb = definitionElement(duplicate,b);
+ ea.removeAttribute("name");
+ QString xml;
+ QTextStream ts(&xml);
+ eb.save(ts,1);
+ ts.flush();
+ eb.removeAttribute("name");
+ if (!sameElement(ea,eb)) return false;
+ fileSize = xml.toUtf8().size();
+ return true;
+}
+
+static int polygonsSize(QList<CPolygon*>& polygons)
+{
+ int result = polygons.size()*(sizeof(CPolygon) + sizeof(void*));
+ for (int i = 0; i < polygons.size(); i++)
+ {
+  result += polygons[i]->vertices().size()*(sizeof(CVertex) + sizeof(void*));
+ }
+ return result;
+}
+
+static int memorySize(CPackage& p)
+{
+ return sizeof(CPackage) + polygonsSize(p.polygons())
+  + p.wires().size()*(sizeof(CWire) + sizeof(void*))
+  + p.texts().size()*(sizeof(CText) + sizeof(void*))
+  + p.dimensions().size()*(sizeof(CDimension) + sizeof(void*))
+  + p.circles().size()*(sizeof(CCircle) + sizeof(void*))
+  + p.rectangles().size()*(sizeof(CRectangle) + sizeof(void*))
+  + p.frames().size()*(sizeof(CFrame) + sizeof(void*))
+  + p.holes().size()*(sizeof(CHole) + sizeof(void*))
+  + p.pads().size()*(sizeof(CPad) + sizeof(void*))
+  + p.smds().size()*(sizeof(CSMD) + sizeof(void*));
+}
+
+static int memorySize(CSymbol& s)
+{
+ return sizeof(CSymbol) + polygonsSize(s.polygons())
+  + s.wires().size()*(sizeof(CWire) + sizeof(void*))
+  + s.texts().size()*(sizeof(CText) + sizeof(void*))
+  + s.dimensions().size()*(sizeof(CDimension) + sizeof(void*))
+  + s.pins().size()*(sizeof(CPin) + sizeof(void*))
+  + s.circles().size()*(sizeof(CCircle) + sizeof(void*))
+  + s.rectangles().size()*(sizeof(CRectangle) + sizeof(void*))
+  + s.frames().size()*(sizeof(CFrame) + sizeof(void*));
+}
+
+static QString referenceKey(const QString& library, const QString& name)
+{
+ return library + '\n' + name;
+}
+
+CLibraryDeduplication::CLibraryDeduplication(void)
+{
+ m_RewriteReferences = false;
+ clear();
+}
+
+CLibraryDeduplication::~CLibraryDeduplication(void)
+{
+ //
+}
+
+void CLibraryDeduplication::clear(void)
+{
+ m_Duplicates.clear();
+}
+
+void CLibraryDeduplication::find(QList<CLibrary*>& libraries)
+{
+ // the first definition of each content is canonical, those of a hash
+ // are told apart by comparing them
+ QHash<quint64,QList<QPair<CLibrary*,CPackage*> > > packages;
+ QHash<quint64,QList<QPair<CLibrary*,CSymbol*> > > symbols;
+ for (int i = 0; i < libraries.size(); i++)
+ {
+  CLibrary *l = libraries[i];
+  for (int j = 0; j < l->packages().size(); j++)
+  {
+   CPackage *p = l->packages()[j];
+   QList<QPair<CLibrary*,CPackage*> >& canonical = packages[p->definitionHash()];
+   int fileSize = 0, c = 0;
+   while (c < canonical.size() && !sameDefinition(*canonical.at(c).second,*p,fileSize)) c++;
+   if (c < canonical.size())
+   {
+    m_Duplicates.append(CDuplicate(CDuplicate::ddPackage,l->name(),p->name(),canonical.at(c).first->name(),
+                                   canonical.at(c).second->name(),fileSize,memorySize(*p)));
+   }
+   else canonical.append(qMakePair(l,p));
+  }
+  for (int j = 0; j < l->symbols().size(); j++)
+  {
+   CSymbol *s = l->symbols()[j];
+   QList<QPair<CLibrary*,CSymbol*> >& canonical = symbols[s->definitionHash()];
+   int fileSize = 0, c = 0;
+   while (c < canonical.size() && !sameDefinition(*canonical.at(c).second,*s,fileSize)) c++;
+   if (c < canonical.size())
+   {
+    m_Duplicates.append(CDuplicate(CDuplicate::ddSymbol,l->name(),s->name(),canonical.at(c).first->name(),
+                                   canonical.at(c).second->name(),fileSize,memorySize(*s)));
+   }
+   else canonical.append(qMakePair(l,s));
+  }
+ }
+}
+
+void CLibraryDeduplication::rewrite(QList<CLibrary*>& libraries, QList<CElement*> *elements)
+{
+ QHash<QString,int> packages, symbols;
+ for (int i = 0; i < m_Duplicates.size(); i++)
+ {
+  const CDuplicate& d = m_Duplicates.at(i);
+  QHash<QString,int>& index = (CDuplicate::ddPackage==d.kind()) ? packages : symbols;
+  index.insert(referenceKey(d.library(),d.name()),i);
+ }
+ // references inside a library can only go to the same library, elements
+ // name the library of their package
+ QSet<QString> referenced;
+ for (int i = 0; i < libraries.size(); i++)
+ {
+  CLibrary *l = libraries[i];
+  for (int j = 0; j < l->deviceSets().size(); j++)
+  {
+   CDeviceSet *ds = l->deviceSets()[j];
+   for (int k = 0; k < ds->devices().size(); k++)
+   {
+    CDevice *d = ds->devices()[k];
+    int n = packages.value(referenceKey(l->name(),d->package()),-1);
+    if (n >= 0 && m_Duplicates.at(n).canonicalLibrary()==l->name())
+     d->setPackage(m_Duplicates.at(n).canonicalName());
+    referenced.insert("p" + referenceKey(l->name(),d->package()));
+   }
+   for (int k = 0; k < ds->gates().size(); k++)
+   {
+    CGate *g = ds->gates()[k];
+    int n = symbols.value(referenceKey(l->name(),g->symbol()),-1);
+    if (n >= 0 && m_Duplicates.at(n).canonicalLibrary()==l->name())
+     g->setSymbol(m_Duplicates.at(n).canonicalName());
+    referenced.insert("s" + referenceKey(l->name(),g->symbol()));
+   }
+  }
+ }
+ if (0 != elements)
+ {
+  for (int i = 0; i < elements->size(); i++)
+  {
+   CElement *e = elements->at(i);
+   int n = packages.value(referenceKey(e->library(),e->package()),-1);
+   if (n >= 0)
+   {
+    e->setLibrary(m_Duplicates.at(n).canonicalLibrary());
+    e->setPackage(m_Duplicates.at(n).canonicalName());
+   }
+   referenced.insert("p" + referenceKey(e->library(),e->package()));
+  }
+ }
+ // drop what nothing points to any more
+ for (int i = 0; i < libraries.size(); i++)
+ {
+  CLibrary *l = libraries[i];
+  int count = l->packages().size() + l->symbols().size();
+  for (int j = l->packages().size() - 1; j >= 0; j--)
+  {
+   CPackage *p = l->packages()[j];
+   QString key = referenceKey(l->name(),p->name());
+   int n = packages.value(key,-1);
+   if (n < 0 || referenced.contains("p" + key)) continue;
+   m_Duplicates[n].setRemoved(true);
+   l->packages().removeAt(j);
+   delete p;
+  }
+  for (int j = l->symbols().size() - 1; j >= 0; j--)
+  {
+   CSymbol *s = l->symbols()[j];
+   QString key = referenceKey(l->name(),s->name());
+   int n = symbols.value(key,-1);
+   if (n < 0 || referenced.contains("s" + key)) continue;
+   m_Duplicates[n].setRemoved(true);
+   l->symbols().removeAt(j);
+   delete s;
+  }
+  if (count!=l->packages().size() + l->symbols().size()) l->modify();
+ }
+}
+
+int CLibraryDeduplication::deduplicate(CEagleDocument& document)
+{
+ clear();
+ CDrawing& d = document.drawing();
+ if (CDrawing::dmLibrary==d.mode())
+ {
+  return deduplicate(d.library());
+ }
+ // duplicates of a mixed document are those of its board and schematic
+ QList<CDuplicate> duplicates;
+ if (CDrawing::dmSchematic==d.mode() || CDrawing::dmMixed==d.mode())
+ {
+  deduplicate(d.schematic());
+  duplicates += m_Duplicates;
+ }
+ if (CDrawing::dmBoard==d.mode() || CDrawing::dmMixed==d.mode())
+ {
+  deduplicate(d.board());
+  duplicates += m_Duplicates;
+ }
+ m_Duplicates = duplicates;
+ return m_Duplicates.size();
+}
+
+int CLibraryDeduplication::deduplicate(CBoard& board)
+{
+ clear();
+ find(board.libraries());
+ if (m_RewriteReferences && !m_Duplicates.isEmpty()) rewrite(board.libraries(),&board.elements());
+ return m_Duplicates.size();
+}
+
+int CLibraryDeduplication::deduplicate(CSchematic& schematic)
+{
+ clear();
+ find(schematic.libraries());
+ if (m_RewriteReferences && !m_Duplicates.isEmpty()) rewrite(schematic.libraries(),0);
+ return m_Duplicates.size();
+}
+
+int CLibraryDeduplication::deduplicate(CLibrary& library)
+{
+ clear();
+ QList<CLibrary*> libraries;
+ libraries.append(&library);
+ find(libraries);
+ if (m_RewriteReferences && !m_Duplicates.isEmpty()) rewrite(libraries,0);
+ return m_Duplicates.size();
+}
+
+qint64 CLibraryDeduplication::fileSavings(void) const
+{
+ // what was removed, or what could be when only reporting
+ qint64 result = 0;
+ for (int i = 0; i < m_Duplicates.size(); i++)
+ {
+  const CDuplicate& d = m_Duplicates.at(i);
+  if (d.removed() || !m_RewriteReferences) result += d.fileSize();
+ }
+ return result;
+}
+
+qint64 CLibraryDeduplication::memorySavings(void) const
+{
+ qint64 result = 0;
+ for (int i = 0; i < m_Duplicates.size(); i++)
+ {
+  const CDuplicate& d = m_Duplicates.at(i);
+  if (d.removed() || !m_RewriteReferences) result += d.memorySize();
+ }
+ return result;
+}
+
+
+//------------------------------------------------------------------------------
+
+CPrunedItem::CPrunedItem(const CPrunedItem::Kind kind, const QString& library, const QString& owner,
+                         const QString& name)
+{
+ m_Kind = kind;
+ m_Library = library;
+ m_Owner = owner;
+ m_Name = name;
+}
+
+CPrunedItem::CPrunedItem(const CPrunedItem& item)
+{
+ assign(item);
+}
+
+CPrunedItem::CPrunedItem(void)
+{
+ clear();
+}
+
+CPrunedItem::~CPrunedItem(void)
+{
+ //
+}
+
+QString CPrunedItem::toString(const CPrunedItem::Kind value)
+{
+ switch (value)
+ {
+  case CPrunedItem::pkLibrary: return "library";
+  case CPrunedItem::pkDeviceSet: return "deviceset";
+  case CPrunedItem::pkDevice: return "device";
+  case CPrunedItem::pkSymbol: return "symbol";
+  case CPrunedItem::pkPackage: return "package";
+ }
+ return QString();
+}
+
+void CPrunedItem::operator =(const CPrunedItem& item)
+{
+ assign(item);
+}
+
+void CPrunedItem::clear(void)
+{
+ m_Kind = CPrunedItem::pkPackage;
+ m_Library.clear();
+ m_Owner.clear();
+ m_Name.clear();
+}
+
+void CPrunedItem::assign(const CPrunedItem& item)
+{
+ m_Kind = item.m_Kind;
+ m_Library = item.m_Library;
+ m_Owner = item.m_Owner;
+ m_Name = item.m_Name;
+}
+
+//------------------------------------------------------------------------------
+
+CLibraryPruning::CLibraryPruning(void)
+{
+ clear();
+}
+
+CLibraryPruning::~CLibraryPruning(void)
+{
+ //
+}
+
+void CLibraryPruning::clear(void)
+{
+ m_Removed.clear();
+}
+
+void CLibraryPruning::prune(QList<CLibrary*>& libraries, const QSet<QString>& deviceSets,
+                            const QSet<QString>& devices, QSet<QString>& packages)
+{
+ // device sets and devices first, what they keep adds to the symbols and
+ // packages in use
+ QSet<QString> symbols;
+ for (int i = 0; i < libraries.size(); i++)
+ {
+  CLibrary *l = libraries[i];
+  for (int j = l->deviceSets().size() - 1; j >= 0; j--)
+  {
+   CDeviceSet *ds = l->deviceSets()[j];
+   QString key = referenceKey(l->name(),ds->name());
+   if (!deviceSets.contains(key))
+   {
+    m_Removed.append(CPrunedItem(CPrunedItem::pkDeviceSet,l->name(),QString(),ds->name()));
+    l->deviceSets().removeAt(j);
+    delete ds;
+    l->modify();
+    continue;
+   }
+   for (int k = ds->devices().size() - 1; k >= 0; k--)
+   {
+    CDevice *d = ds->devices()[k];
+    if (!devices.contains(referenceKey(key,d->name())))
+    {
+     m_Removed.append(CPrunedItem(CPrunedItem::pkDevice,l->name(),ds->name(),d->name()));
+     ds->devices().removeAt(k);
+     delete d;
+     ds->modify();
+    }
+    else if (!d->package().isEmpty()) packages.insert(referenceKey(l->name(),d->package()));
+   }
+   for (int k = 0; k < ds->gates().size(); k++)
+   {
+    symbols.insert(referenceKey(l->name(),ds->gates()[k]->symbol()));
+   }
+  }
+ }
+ for (int i = libraries.size() - 1; i >= 0; i--)
+ {
+  CLibrary *l = libraries[i];
+  int count = l->deviceSets().size() + l->symbols().size() + l->packages().size();
+  for (int j = l->symbols().size() - 1; j >= 0; j--)
+  {
+   CSymbol *s = l->symbols()[j];
+   if (symbols.contains(referenceKey(l->name(),s->name()))) continue;
+   m_Removed.append(CPrunedItem(CPrunedItem::pkSymbol,l->name(),QString(),s->name()));
+   l->symbols().removeAt(j);
+   delete s;
+  }
+  for (int j = l->packages().size() - 1; j >= 0; j--)
+  {
+   CPackage *p = l->packages()[j];
+   if (packages.contains(referenceKey(l->name(),p->name()))) continue;
+   m_Removed.append(CPrunedItem(CPrunedItem::pkPackage,l->name(),QString(),p->name()));
+   l->packages().removeAt(j);
+   delete p;
+  }
+  if (l->deviceSets().isEmpty() && l->symbols().isEmpty() && l->packages().isEmpty())
+  {
+   m_Removed.append(CPrunedItem(CPrunedItem::pkLibrary,l->name(),QString(),l->name()));
+   CEntity *owner = l->owner();
+   libraries.removeAt(i);
+   delete l;
+   if (0!=owner) owner->modify();
+  }
+  else if (count!=l->deviceSets().size() + l->symbols().size() + l->packages().size()) l->modify();
+ }
+}
+
+int CLibraryPruning::prune(CEagleDocument& document)
+{
+ clear();
+ CDrawing& d = document.drawing();
+ QList<CPrunedItem> removed;
+ if (CDrawing::dmSchematic==d.mode() || CDrawing::dmMixed==d.mode())
+ {
+  prune(d.schematic());
+  removed += m_Removed;
+ }
+ if (CDrawing::dmBoard==d.mode() || CDrawing::dmMixed==d.mode())
+ {
+  prune(d.board());
+  removed += m_Removed;
+ }
+ m_Removed = removed;
+ return m_Removed.size();
+}
+
+int CLibraryPruning::prune(CBoard& board)
+{
+ clear();
+ QSet<QString> deviceSets, devices, packages;
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CElement *e = board.elements()[i];
+  packages.insert(referenceKey(e->library(),e->package()));
+ }
+ prune(board.libraries(),deviceSets,devices,packages);
+ return m_Removed.size();
+}
+
+int CLibraryPruning::prune(CSchematic& schematic)
+{
+ clear();
+ QList<CPart*> parts = schematic.parts();
+ for (int i = 0; i < schematic.modules().size(); i++)
+ {
+  parts += schematic.modules()[i]->parts();
+ }
+ QSet<QString> deviceSets, devices, packages;
+ for (int i = 0; i < parts.size(); i++)
+ {
+  CPart *p = parts[i];
+  QString key = referenceKey(p->library(),p->deviceSet());
+  deviceSets.insert(key);
+  devices.insert(referenceKey(key,p->device()));
+ }
+ prune(schematic.libraries(),deviceSets,devices,packages);
+ return m_Removed.size();
+}
+
+}
+//------------------------------------------------------------------------------
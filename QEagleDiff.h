@@ -0,0 +1,259 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEDIFF_H
+#define QEAGLEDIFF_H
+//------------------------------------------------------------------------------
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements comparison of documents and maintenance of libraries
+*/
+
+namespace Eagle
+{
+
+// one difference between two documents; path names the object as a chain
+// of tags with the identity of each object in brackets, e.g.
+// /eagle/drawing/board/elements/element[R1]
+class CDiffChange
+{
+ public:
+  enum Kind {dkAdded, dkRemoved, dkModified};
+ public:
+  CDiffChange(const CDiffChange::Kind kind, const QString& path, const QString& field = QString(),
+              const QString& oldValue = QString(), const QString& newValue = QString());
+  CDiffChange(const CDiffChange& change);
+  CDiffChange(void);
+  virtual ~CDiffChange(void);
+ public:
+  static QString toString(const CDiffChange::Kind value);
+ public:
+  void operator =(const CDiffChange& change);
+  void clear(void);
+  void assign(const CDiffChange& change);
+  QString toString(void) const;
+ public:
+  // getters
+  CDiffChange::Kind kind(void) const { return m_Kind; }
+  QString path(void) const { return m_Path; }
+  QString field(void) const { return m_Field; }
+  QString oldValue(void) const { return m_OldValue; }
+  QString newValue(void) const { return m_NewValue; }
+ protected:
+  CDiffChange::Kind m_Kind;
+  QString m_Path;
+  QString m_Field; // attribute name, "#text" for text content, empty for whole objects
+  QString m_OldValue;
+  QString m_NewValue;
+};
+
+// node of a document tree as compared by CDocumentDiff; nodes of entities
+// hold their own fields until their children are needed
+class CDiffNode
+{
+ public:
+  CDiffNode(void): index(0), hash(0), entity(0), expanded(false) {}
+ public:
+  QString tag;
+  QString key; // identity among siblings of the same tag, empty if none
+  int index; // position among siblings of the same tag, -1 if the only one
+  QMap<QString,QString> attributes;
+  QString text;
+  QVector<int> children;
+  quint64 hash; // of the whole subtree
+  CEntity *entity; // 0 for elements written by their owner
+  bool expanded; // children of an entity are built
+};
+
+// semantic difference of two documents: objects are matched by identity
+// (names of elements, signals, packages, parts, ..., numbers of layers and
+// classes); the entity trees are walked directly, an entity is written with
+// its own fields only when its content hash differs from its counterpart,
+// so equal subtrees are skipped without being written
+class CDocumentDiff
+{
+ public:
+  CDocumentDiff(void);
+  virtual ~CDocumentDiff(void);
+ public:
+  void clear(void);
+  bool compare(CEagleDocument& before, CEagleDocument& after);
+  int count(const CDiffChange::Kind kind) const;
+  void writeText(QTextStream& out) const;
+ public:
+  // getters
+  const QList<CDiffChange>& changes(void) const { return m_Changes; }
+ protected:
+  static int build(const QDomElement& element, const QList<QPair<QDomElement,CEntity*> >& entities,
+                   int& cursor, QVector<CDiffNode>& nodes);
+  static QVector<int> buildChildren(const QDomElement& element, const QList<QPair<QDomElement,CEntity*> >& entities,
+                                    QVector<CDiffNode>& nodes, CContentHash *hash);
+  static void expand(QVector<CDiffNode>& nodes, const int node);
+  void compareNodes(const int a, const int b, const QString& path);
+  void report(const CDiffChange::Kind kind, const QVector<CDiffNode>& nodes, const int node,
+              const QString& path);
+  static QString childPath(const QString& path, const CDiffNode& node);
+ protected:
+  QList<CDiffChange> m_Changes;
+  QVector<CDiffNode> m_Before;
+  QVector<CDiffNode> m_After;
+};
+
+// a package or symbol whose definition, apart from its name, equals the
+// canonical one found earlier in library order
+class CDuplicate
+{
+ public:
+  enum Kind {ddPackage, ddSymbol};
+ public:
+  CDuplicate(const CDuplicate::Kind kind, const QString& library, const QString& name,
+             const QString& canonicalLibrary, const QString& canonicalName,
+             const int fileSize, const int memorySize);
+  CDuplicate(const CDuplicate& duplicate);
+  CDuplicate(void);
+  virtual ~CDuplicate(void);
+ public:
+  void operator =(const CDuplicate& duplicate);
+  void clear(void);
+  void assign(const CDuplicate& duplicate);
+ public:
+  // getters
+  CDuplicate::Kind kind(void) const { return m_Kind; }
+  QString library(void) const { return m_Library; }
+  QString name(void) const { return m_Name; }
+  QString canonicalLibrary(void) const { return m_CanonicalLibrary; }
+  QString canonicalName(void) const { return m_CanonicalName; }
+  int fileSize(void) const { return m_FileSize; }
+  int memorySize(void) const { return m_MemorySize; }
+  bool removed(void) const { return m_Removed; }
+  // setters
+  void setRemoved(const bool value) { m_Removed = value; }
+ protected:
+  CDuplicate::Kind m_Kind;
+  QString m_Library;
+  QString m_Name;
+  QString m_CanonicalLibrary;
+  QString m_CanonicalName;
+  int m_FileSize; // bytes of its XML
+  int m_MemorySize; // estimated bytes of its objects
+  bool m_Removed;
+};
+
+// finds identical packages and symbols in the libraries of a document; with
+// rewriting enabled, devices, gates and board elements are pointed to the
+// canonical copy and duplicates no longer referenced are removed. Symbols
+// and packages are only referenced inside their own library by a
+// schematic, so copies across libraries of a schematic are only reported;
+// rewriting the elements of a board alone leaves it inconsistent with its
+// schematic
+class CLibraryDeduplication
+{
+ public:
+  CLibraryDeduplication(void);
+  virtual ~CLibraryDeduplication(void);
+ public:
+  void clear(void);
+  int deduplicate(CEagleDocument& document);
+  int deduplicate(CBoard& board);
+  int deduplicate(CSchematic& schematic);
+  int deduplicate(CLibrary& library);
+  qint64 fileSavings(void) const;
+  qint64 memorySavings(void) const;
+ public:
+  // getters
+  const QList<CDuplicate>& duplicates(void) const { return m_Duplicates; }
+  bool rewriteReferences(void) const { return m_RewriteReferences; }
+  // setters
+  void setRewriteReferences(const bool value) { m_RewriteReferences = value; }
+ protected:
+  void find(QList<CLibrary*>& libraries);
+  void rewrite(QList<CLibrary*>& libraries, QList<CElement*> *elements);
+ protected:
+  QList<CDuplicate> m_Duplicates;
+  bool m_RewriteReferences; // default = false, only report
+};
+
+// a library object dropped by CLibraryPruning, owner is the device set of
+// a device and empty otherwise
+class CPrunedItem
+{
+ public:
+  enum Kind {pkLibrary, pkDeviceSet, pkDevice, pkSymbol, pkPackage};
+ public:
+  CPrunedItem(const CPrunedItem::Kind kind, const QString& library, const QString& owner,
+              const QString& name);
+  CPrunedItem(const CPrunedItem& item);
+  CPrunedItem(void);
+  virtual ~CPrunedItem(void);
+ public:
+  static QString toString(const CPrunedItem::Kind value);
+ public:
+  void operator =(const CPrunedItem& item);
+  void clear(void);
+  void assign(const CPrunedItem& item);
+ public:
+  // getters
+  CPrunedItem::Kind kind(void) const { return m_Kind; }
+  QString library(void) const { return m_Library; }
+  QString owner(void) const { return m_Owner; }
+  QString name(void) const { return m_Name; }
+ protected:
+  CPrunedItem::Kind m_Kind;
+  QString m_Library;
+  QString m_Owner;
+  QString m_Name;
+};
+
+// drops the content of embedded libraries not used by the parts of a
+// schematic or the elements of a board: device sets no part refers to,
+// devices of kept device sets no part uses, symbols of no kept gate,
+// packages of no kept device or element, and libraries left empty
+class CLibraryPruning
+{
+ public:
+  CLibraryPruning(void);
+  virtual ~CLibraryPruning(void);
+ public:
+  void clear(void);
+  int prune(CEagleDocument& document);
+  int prune(CBoard& board);
+  int prune(CSchematic& schematic);
+ public:
+  // getters
+  const QList<CPrunedItem>& removed(void) const { return m_Removed; }
+ protected:
+  void prune(QList<CLibrary*>& libraries, const QSet<QString>& deviceSets,
+             const QSet<QString>& devices, QSet<QString>& packages);
+ protected:
+  QList<CPrunedItem> m_Removed;
+};
+
+}
+
+#endif // QEAGLEDIFF_H
+//------------------------------------------------------------------------------
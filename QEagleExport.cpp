@@ -0,0 +1,1691 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+//------------------------------------------------------------------------------
+#include "QEagleExport.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+static bool isRightAngle(const double rotation)
+{
+ double r = fmod(rotation,90.0);
+ if (r < 0.0) r += 90.0;
+ return r < 1e-6 || r > 90.0-1e-6;
+}
+
+static bool isQuarterTurned(const double rotation)
+{
+ // 90 or 270 degrees, axis aligned apertures swap their sizes
+ double r = fmod(rotation,180.0);
+ if (r < 0.0) r += 180.0;
+ return fabs(r-90.0) < 1e-6;
+}
+
+// one outline vertex, curve applies to the edge to the next vertex
+class COutlinePoint
+{
+ public:
+  COutlinePoint(void): x(0.0), y(0.0), curve(0.0) {}
+  COutlinePoint(const TCoord x, const TCoord y, const double curve): x(x), y(y), curve(curve) {}
+ public:
+  TCoord x;
+  TCoord y;
+  double curve;
+};
+
+// Gerber body generator, run twice over the same board: the first pass only
+// collects apertures, the second one streams the drawing after the header
+class CGerberWriter
+{
+ public:
+  CGerberWriter(CBoard& board, const CPadResolver& resolver, const CPadRules& rules,
+                CVectorFont& font, const QList<TLayer>& layers, const CPolygonPour *pour = 0):
+   m_Board(board), m_Resolver(resolver), m_Rules(rules), m_Font(font), m_Pour(pour), m_Out(0)
+  {
+   for (int i = 0; i < layers.size(); i++)
+   {
+    m_Layers.insert(layers.at(i));
+   }
+  }
+  // layers in ascending order, so the output does not follow the hashing
+  QList<TLayer> sortedLayers(void) const
+  {
+   QList<TLayer> result = m_Layers.values();
+   std::sort(result.begin(),result.end());
+   return result;
+  }
+  void write(QTextStream& out)
+  {
+   m_Out = 0;
+   body();
+   QStringList names;
+   QList<TLayer> layers = sortedLayers();
+   for (int i = 0; i < layers.size(); i++)
+   {
+    names.append(QString::number(layers.at(i)));
+   }
+   out<<"G04 QEagleLib Gerber export, layers "<<names.join(",")<<"*\n";
+   out<<"%FSLAX46Y46*%\n";
+   out<<"%MOMM*%\n";
+   out<<"%LPD*%\n";
+   if (m_Macros.contains("RECT"))
+   {
+    // width, height, rotation
+    out<<"%AMRECT*21,1,$1,$2,0,0,$3*%\n";
+   }
+   if (m_Macros.contains("RRECT"))
+   {
+    // width, height, rotation, corner radius
+    out<<"%AMRRECT*21,1,$1,$2-$4-$4,0,0,$3*21,1,$1-$4-$4,$2,0,0,$3*"
+         "1,1,$4+$4,$1/2-$4,$2/2-$4,$3*1,1,$4+$4,$4-$1/2,$2/2-$4,$3*"
+         "1,1,$4+$4,$4-$1/2,$4-$2/2,$3*1,1,$4+$4,$1/2-$4,$4-$2/2,$3*%\n";
+   }
+   for (int i = 0; i < m_Definitions.size(); i++)
+   {
+    out<<"%ADD"<<(10+i)<<m_Definitions.at(i)<<"*%\n";
+   }
+   out<<"G75*\n";
+   m_Out = &out;
+   m_Current = -1;
+   m_Mode = 0;
+   m_HasPoint = false;
+   body();
+   out<<"M02*\n";
+   m_Out = 0;
+  }
+ protected:
+  static QString number(const double value)
+  {
+   return QString::number(value,'f',4);
+  }
+  static qint64 coord(const TCoord value)
+  {
+   return qRound64(value*1000000.0);
+  }
+  void select(const QString& definition)
+  {
+   int n = m_Apertures.value(definition,-1);
+   if (n < 0)
+   {
+    n = m_Definitions.size();
+    m_Definitions.append(definition);
+    m_Apertures.insert(definition,n);
+    int comma = definition.indexOf(',');
+    QString name = definition.left(comma);
+    if ("RECT"==name || "RRECT"==name) m_Macros.insert(name);
+   }
+   if (0!=m_Out && n!=m_Current)
+   {
+    (*m_Out)<<"D"<<(10+n)<<"*\n";
+    m_Current = n;
+   }
+  }
+  void setMode(const int mode)
+  {
+   if (mode!=m_Mode)
+   {
+    (*m_Out)<<"G0"<<mode<<"*\n";
+    m_Mode = mode;
+   }
+  }
+  void moveTo(const TCoord x, const TCoord y)
+  {
+   qint64 ix = coord(x), iy = coord(y);
+   if (m_HasPoint && ix==m_X && iy==m_Y) return;
+   (*m_Out)<<"X"<<ix<<"Y"<<iy<<"D02*\n";
+   m_X = ix; m_Y = iy; m_HasPoint = true;
+  }
+  void lineTo(const TCoord x, const TCoord y)
+  {
+   setMode(1);
+   m_X = coord(x); m_Y = coord(y);
+   (*m_Out)<<"X"<<m_X<<"Y"<<m_Y<<"D01*\n";
+  }
+  void arcTo(const TCoord x, const TCoord y, const TCoord cx, const TCoord cy, const bool ccw)
+  {
+   setMode(ccw ? 3 : 2);
+   qint64 i = coord(cx) - m_X, j = coord(cy) - m_Y;
+   m_X = coord(x); m_Y = coord(y);
+   (*m_Out)<<"X"<<m_X<<"Y"<<m_Y<<"I"<<i<<"J"<<j<<"D01*\n";
+  }
+  void flash(const TCoord x, const TCoord y)
+  {
+   m_X = coord(x); m_Y = coord(y); m_HasPoint = true;
+   (*m_Out)<<"X"<<m_X<<"Y"<<m_Y<<"D03*\n";
+  }
+  void edgeTo(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2, const double curve)
+  {
+   TCoord cx, cy;
+   if (arcCenter(x1,y1,x2,y2,curve,cx,cy)) arcTo(x2,y2,cx,cy,curve > 0.0);
+   else lineTo(x2,y2);
+  }
+  // drawing primitives in board coordinates
+  void wire(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2, const double curve,
+            const TDimension width)
+  {
+   select("C," + number(width));
+   if (0==m_Out) return;
+   moveTo(x1,y1);
+   edgeTo(x1,y1,x2,y2,curve);
+  }
+  void circle(const TCoord x, const TCoord y, const TDimension radius, const TDimension width)
+  {
+   // width 0 fills the circle
+   if (width <= 0.0)
+   {
+    select("C," + number(2.0*radius));
+    if (0!=m_Out) flash(x,y);
+    return;
+   }
+   select("C," + number(width));
+   if (0==m_Out) return;
+   moveTo(x+radius,y);
+   arcTo(x+radius,y,x,y,true);
+  }
+  void region(const QVector<COutlinePoint>& points)
+  {
+   if (0==m_Out || points.size() < 3) return;
+   (*m_Out)<<"G36*\n";
+   m_HasPoint = false;
+   moveTo(points.at(0).x,points.at(0).y);
+   for (int i = 0; i < points.size(); i++)
+   {
+    const COutlinePoint& a = points.at(i);
+    const COutlinePoint& b = points.at((i+1) % points.size());
+    edgeTo(a.x,a.y,b.x,b.y,a.curve);
+   }
+   (*m_Out)<<"G37*\n";
+   m_HasPoint = false;
+  }
+  void outline(const QVector<COutlinePoint>& points, const TDimension width)
+  {
+   if (width <= 0.0 || points.size() < 2) return;
+   select("C," + number(width));
+   if (0==m_Out) return;
+   moveTo(points.at(0).x,points.at(0).y);
+   for (int i = 0; i < points.size(); i++)
+   {
+    const COutlinePoint& a = points.at(i);
+    const COutlinePoint& b = points.at((i+1) % points.size());
+    edgeTo(a.x,a.y,b.x,b.y,a.curve);
+   }
+  }
+  void rectangle(const TCoord x, const TCoord y, const TDimension dx, const TDimension dy,
+                 const double rotation, const TDimension radius)
+  {
+   // axis aligned ones use standard apertures, anything else a macro
+   if (dx <= 0.0 || dy <= 0.0) return;
+   if (radius <= 0.0 && isRightAngle(rotation))
+   {
+    bool swap = isQuarterTurned(rotation);
+    select("R," + number(swap ? dy : dx) + "X" + number(swap ? dx : dy));
+   }
+   else if (radius >= 0.5*std::min(dx,dy) && fabs(dx-dy) < 1e-9)
+   {
+    select("C," + number(dx));
+   }
+   else if (radius <= 0.0)
+   {
+    select("RECT," + number(dx) + "X" + number(dy) + "X" + number(rotation));
+   }
+   else
+   {
+    select("RRECT," + number(dx) + "X" + number(dy) + "X" + number(rotation) + "X" + number(radius));
+   }
+   if (0!=m_Out) flash(x,y);
+  }
+  void octagon(const TCoord x, const TCoord y, const TDimension diameter, const double rotation)
+  {
+   // Eagle sizes octagons across flats, Gerber over corners
+   double d = diameter/cos(degtorad(22.5));
+   double r = fmod(rotation + 22.5,360.0);
+   select("P," + number(d) + "X8X" + number(r));
+   if (0!=m_Out) flash(x,y);
+  }
+  void pad(const CPadInstance& pad, const TLayer copper, const TDimension frame)
+  {
+   TDimension d = m_Rules.padDiameter(pad.drill(),pad.dx(),copper) + 2.0*frame;
+   bool outer = (CLayer::LAYER_TOP==copper || CLayer::LAYER_BOTTOM==copper);
+   CPad::Shape ps = outer ? pad.shape() : CPad::psRound;
+   if (CPad::psSquare==ps)
+   {
+    rectangle(pad.x(),pad.y(),d,d,pad.rotation(),0.0);
+   }
+   else if (CPad::psOctagon==ps)
+   {
+    octagon(pad.x(),pad.y(),d,pad.rotation());
+   }
+   else if (CPad::psLong==ps || CPad::psOffset==ps)
+   {
+    double a = degtorad(pad.rotation());
+    TDimension e = (d - 2.0*frame)*((CPad::psLong==ps) ? m_Rules.elongationLong() : m_Rules.elongationOffset())/100.0;
+    TDimension back = (CPad::psLong==ps) ? 0.5*e : 0.0;
+    TDimension ahead = (CPad::psLong==ps) ? 0.5*e : e;
+    TCoord x1 = pad.x() - back*cos(a), y1 = pad.y() - back*sin(a);
+    TCoord x2 = pad.x() + ahead*cos(a), y2 = pad.y() + ahead*sin(a);
+    if (isRightAngle(pad.rotation()))
+    {
+     bool swap = isQuarterTurned(pad.rotation());
+     select("O," + number(swap ? d : d+e) + "X" + number(swap ? d+e : d));
+     if (0!=m_Out) flash(0.5*(x1+x2),0.5*(y1+y2));
+    }
+    else wire(x1,y1,x2,y2,0.0,d);
+   }
+   else
+   {
+    select("C," + number(d));
+    if (0!=m_Out) flash(pad.x(),pad.y());
+   }
+  }
+  void smd(const CPadInstance& pad, const TDimension frame)
+  {
+   TDimension dx = pad.dx() + 2.0*frame, dy = pad.dy() + 2.0*frame;
+   rectangle(pad.x(),pad.y(),dx,dy,pad.rotation(),0.005*pad.roundness()*std::min(dx,dy));
+  }
+  void via(CVia& via, const TLayer copper, const TDimension frame)
+  {
+   TDimension d = m_Rules.viaDiameter(via.drill(),via.diameter(),copper) + 2.0*frame;
+   bool outer = (CLayer::LAYER_TOP==copper || CLayer::LAYER_BOTTOM==copper);
+   if (outer && CVia::vsSquare==via.shape()) rectangle(via.x(),via.y(),d,d,0.0,0.0);
+   else if (outer && CVia::vsOctagon==via.shape()) octagon(via.x(),via.y(),d,0.0);
+   else
+   {
+    select("C," + number(d));
+    if (0!=m_Out) flash(via.x(),via.y());
+   }
+  }
+  void strokes(const CTextGeometry& text)
+  {
+   if (0==text.strokeCount()) return;
+   select("C," + number(text.width()));
+   if (0==m_Out) return;
+   for (int i = 0; i < text.strokeCount(); i++)
+   {
+    const CPoint& p = text.point(i,0);
+    if (1==text.count(i))
+    {
+     flash(p.x(),p.y());
+     continue;
+    }
+    moveTo(p.x(),p.y());
+    for (int k = 1; k < text.count(i); k++)
+    {
+     lineTo(text.point(i,k).x(),text.point(i,k).y());
+    }
+   }
+  }
+  // texts of the board or a package placed by t, name and value replace
+  // the placeholders of packages
+  void texts(QList<CText*>& texts, const CTransform& t, const QString& name, const QString& value,
+             const bool smashed)
+  {
+   for (int i = 0; i < texts.size(); i++)
+   {
+    CText *x = texts.at(i);
+    if (!m_Layers.contains(t.mapLayer(x->layer()))) continue;
+    if (smashed && CVectorFont::isPartPlaceholder(x->text())) continue;
+    CTextGeometry g;
+    m_Font.strokes(*x,t,name,value,g);
+    strokes(g);
+   }
+  }
+  void attributes(CElement& element)
+  {
+   for (int i = 0; i < element.attributes().size(); i++)
+   {
+    CAttribute *a = element.attributes().at(i);
+    if (!m_Layers.contains(a->layer())) continue;
+    CTextGeometry g;
+    m_Font.strokes(*a,CVectorFont::attributeValue(*a,element.name(),element.value()),g);
+    strokes(g);
+   }
+  }
+  // graphics of the board or a package placed by t
+  void graphics(QList<CWire*>& wires, QList<CCircle*>& circles, QList<CRectangle*>& rectangles,
+                QList<CPolygon*>& polygons, const CTransform& t, const bool copperPolygons)
+  {
+   for (int i = 0; i < wires.size(); i++)
+   {
+    CWire *w = wires.at(i);
+    if (!m_Layers.contains(t.mapLayer(w->layer()))) continue;
+    CPoint p1 = t.map(CPoint(w->x1(),w->y1())), p2 = t.map(CPoint(w->x2(),w->y2()));
+    wire(p1.x(),p1.y(),p2.x(),p2.y(),t.mapCurve(w->curve()),w->width());
+   }
+   for (int i = 0; i < circles.size(); i++)
+   {
+    CCircle *c = circles.at(i);
+    if (!m_Layers.contains(t.mapLayer(c->layer()))) continue;
+    CPoint p = t.map(CPoint(c->x(),c->y()));
+    circle(p.x(),p.y(),c->radius(),c->width());
+   }
+   for (int i = 0; i < rectangles.size(); i++)
+   {
+    CRectangle *r = rectangles.at(i);
+    if (!m_Layers.contains(t.mapLayer(r->layer()))) continue;
+    TCoord cx = 0.5*(r->x1()+r->x2()), cy = 0.5*(r->y1()+r->y2());
+    TCoord hx = 0.5*fabs(r->x2()-r->x1()), hy = 0.5*fabs(r->y2()-r->y1());
+    double a = degtorad(r->rotation()), c = cos(a), s = sin(a);
+    static const int corners[4][2] = {{-1,-1},{1,-1},{1,1},{-1,1}};
+    QVector<COutlinePoint> points;
+    for (int k = 0; k < 4; k++)
+    {
+     TCoord x = corners[k][0]*hx, y = corners[k][1]*hy;
+     CPoint p = t.map(CPoint(cx + x*c - y*s,cy + x*s + y*c));
+     points.append(COutlinePoint(p.x(),p.y(),0.0));
+    }
+    region(points);
+   }
+   for (int i = 0; i < polygons.size(); i++)
+   {
+    CPolygon *p = polygons.at(i);
+    TLayer layer = t.mapLayer(p->layer());
+    if (!m_Layers.contains(layer) || (!copperPolygons && CLayer::isCopper(layer))) continue;
+    QVector<COutlinePoint> points;
+    for (int k = 0; k < p->vertices().size(); k++)
+    {
+     CVertex *v = p->vertices().at(k);
+     CPoint q = t.map(CPoint(v->x(),v->y()));
+     points.append(COutlinePoint(q.x(),q.y(),t.mapCurve(v->curve())));
+    }
+    region(points);
+    outline(points,p->width());
+   }
+  }
+  void body(void)
+  {
+   CTransform identity;
+   const QVector<CPadInstance>& pads = m_Resolver.pads();
+   QList<TLayer> layers = sortedLayers();
+   for (int k = 0; k < layers.size(); k++)
+   {
+    TLayer l = layers.at(k);
+    // stop and cream layers follow the outer copper of their side
+    bool top = (CLayer::LAYER_TSTOP==l || CLayer::LAYER_TCREAM==l);
+    TLayer side = top ? CLayer::LAYER_TOP : CLayer::LAYER_BOTTOM;
+    if (CLayer::isCopper(l))
+    {
+     // poured signal polygons below everything else, holes joined to the
+     // outer rings as regions cannot have any
+     if (0!=m_Pour && 0!=m_Out)
+     {
+      for (int i = 0; i < m_Pour->count(); i++)
+      {
+       if (m_Pour->polygon(i)->layer()!=l) continue;
+       CPolygonSet fill = m_Pour->fill(i);
+       fill.fracture();
+       for (int j = 0; j < fill.count(); j++)
+       {
+        QVector<CPoint> points = fill.points(j);
+        QVector<COutlinePoint> outline;
+        for (int k = 0; k < points.size(); k++)
+        {
+         outline.append(COutlinePoint(points.at(k).x(),points.at(k).y(),0.0));
+        }
+        region(outline);
+       }
+      }
+     }
+     // signals
+     for (int i = 0; i < m_Board.signal().size(); i++)
+     {
+      CSignal *s = m_Board.signal().at(i);
+      for (int j = 0; j < s->wires().size(); j++)
+      {
+       CWire *w = s->wires().at(j);
+       if (w->layer()==l) wire(w->x1(),w->y1(),w->x2(),w->y2(),w->curve(),w->width());
+      }
+      for (int j = 0; j < s->vias().size(); j++)
+      {
+       CVia *v = s->vias().at(j);
+       int start, stop;
+       decodeExtent(v->extent(),start,stop);
+       if (l >= start && l <= stop) via(*v,l,0.0);
+      }
+     }
+     for (int i = 0; i < pads.size(); i++)
+     {
+      const CPadInstance& p = pads.at(i);
+      if (CPadInstance::pkPad==p.kind()) pad(p,l,0.0);
+      else if (p.layer()==l) smd(p,0.0);
+     }
+    }
+    else if (CLayer::LAYER_TSTOP==l || CLayer::LAYER_BSTOP==l)
+    {
+     for (int i = 0; i < m_Board.signal().size(); i++)
+     {
+      CSignal *s = m_Board.signal().at(i);
+      for (int j = 0; j < s->vias().size(); j++)
+      {
+       CVia *v = s->vias().at(j);
+       int start, stop;
+       decodeExtent(v->extent(),start,stop);
+       if (side < start || side > stop || !m_Rules.viaStop(*v)) continue;
+       TDimension d = m_Rules.viaDiameter(v->drill(),v->diameter(),side);
+       via(*v,side,m_Rules.stopFrame(d));
+      }
+     }
+     for (int i = 0; i < pads.size(); i++)
+     {
+      const CPadInstance& p = pads.at(i);
+      if (CPadInstance::pkPad==p.kind())
+      {
+       if (0!=p.pad() && !p.pad()->stop()) continue;
+       TDimension d = m_Rules.padDiameter(p.drill(),p.dx(),side);
+       pad(p,side,m_Rules.stopFrame(d));
+      }
+      else if (p.layer()==side && (0==p.smd() || p.smd()->stop()))
+      {
+       smd(p,m_Rules.stopFrame(std::min(p.dx(),p.dy())));
+      }
+     }
+    }
+    else if (CLayer::LAYER_TCREAM==l || CLayer::LAYER_BCREAM==l)
+    {
+     for (int i = 0; i < pads.size(); i++)
+     {
+      const CPadInstance& p = pads.at(i);
+      if (CPadInstance::pkSMD==p.kind() && p.layer()==side && (0==p.smd() || p.smd()->cream()))
+      {
+       smd(p,-m_Rules.creamFrame(std::min(p.dx(),p.dy())));
+      }
+     }
+    }
+   }
+   // graphics of the board and of every package
+   CPlain& plain = m_Board.plain();
+   graphics(plain.wires(),plain.circles(),plain.rectangles(),plain.polygons(),identity,false);
+   texts(plain.texts(),identity,QString(),QString(),false);
+   for (int i = 0; i < m_Board.elements().size(); i++)
+   {
+    CElement *e = m_Board.elements().at(i);
+    CPackage *p = m_Resolver.package(i);
+    if (0==p) continue;
+    CTransform t(*e);
+    graphics(p->wires(),p->circles(),p->rectangles(),p->polygons(),t,true);
+    texts(p->texts(),t,e->name(),e->value(),e->smashed());
+    if (e->smashed()) attributes(*e);
+   }
+  }
+ protected:
+  CBoard& m_Board;
+  const CPadResolver& m_Resolver;
+  const CPadRules& m_Rules;
+  CVectorFont& m_Font;
+  const CPolygonPour *m_Pour; // 0 when signal polygons are left out
+  QSet<TLayer> m_Layers;
+  QTextStream *m_Out; // 0 while collecting apertures
+  QHash<QString,int> m_Apertures;
+  QStringList m_Definitions; // D10 onwards
+  QSet<QString> m_Macros;
+  int m_Current;
+  int m_Mode; // 1 linear, 2 clockwise, 3 counterclockwise
+  bool m_HasPoint;
+  qint64 m_X;
+  qint64 m_Y;
+};
+
+class CGerberFile
+{
+ public:
+  CGerberFile(void) {}
+  CGerberFile(const QString& suffix, const TLayer layer1, const TLayer layer2 = 0): suffix(suffix)
+  {
+   layers.append(layer1);
+   if (0!=layer2) layers.append(layer2);
+  }
+ public:
+  QString suffix;
+  QList<TLayer> layers;
+};
+
+class CGerberFileJob: public CParallelJob
+{
+ public:
+  CGerberFileJob(CBoard& board, const CPadResolver& resolver, const CPadRules& rules, CVectorFont& font,
+                 const CPolygonPour *pour, const QVector<CGerberFile>& files, const QString& baseName,
+                 bool *results):
+   m_Board(board), m_Resolver(resolver), m_Rules(rules), m_Font(font), m_Pour(pour), m_Files(files),
+   m_BaseName(baseName), m_Results(results) {}
+  virtual void execute(const int index)
+  {
+   const CGerberFile& f = m_Files.at(index);
+   QFile file(m_BaseName + f.suffix);
+   m_Results[index] = false;
+   if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+   {
+    QTextStream ts(&file);
+    CGerberWriter writer(m_Board,m_Resolver,m_Rules,m_Font,f.layers,m_Pour);
+    writer.write(ts);
+    file.close();
+    m_Results[index] = true;
+   }
+  }
+ protected:
+  CBoard& m_Board;
+  const CPadResolver& m_Resolver;
+  const CPadRules& m_Rules;
+  CVectorFont& m_Font; // layouts are shared by all files
+  const CPolygonPour *m_Pour;
+  const QVector<CGerberFile>& m_Files;
+  QString m_BaseName;
+  bool *m_Results; // one per file
+};
+
+//------------------------------------------------------------------------------
+
+CGerberExport::CGerberExport(void)
+{
+ m_ThreadCount = 0;
+ m_PourPolygons = false;
+ clear();
+}
+
+CGerberExport::~CGerberExport(void)
+{
+ //
+}
+
+void CGerberExport::clear(void)
+{
+ m_PadResolver.clear();
+ m_Font.clear();
+ m_Pour.clear();
+}
+
+bool CGerberExport::write(CBoard& board, const QList<TLayer>& layers, QTextStream& out)
+{
+ // cached data of the board is prepared up front, writers only read
+ m_PadResolver.resolve(board,m_ThreadCount);
+ CPadRules rules(board.designRules());
+ CGerberWriter writer(board,m_PadResolver,rules,m_Font,layers,pour(board));
+ writer.write(out);
+ return true;
+}
+
+bool CGerberExport::saveToFile(CBoard& board, const QList<TLayer>& layers, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(board,layers,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+int CGerberExport::saveToFiles(CBoard& board, const QString& baseName)
+{
+ m_PadResolver.resolve(board,m_ThreadCount);
+ CPadRules rules(board.designRules());
+ const CPolygonPour *polygons = pour(board);
+ QVector<CGerberFile> files;
+ for (int i = 0; i < rules.layers().size(); i++)
+ {
+  TLayer l = rules.layers().at(i);
+  if (CLayer::LAYER_TOP==l) files.append(CGerberFile(".GTL",l));
+  else if (CLayer::LAYER_BOTTOM==l) files.append(CGerberFile(".GBL",l));
+  else files.append(CGerberFile(QString(".G%1L").arg(l),l));
+ }
+ files.append(CGerberFile(".GTS",CLayer::LAYER_TSTOP));
+ files.append(CGerberFile(".GBS",CLayer::LAYER_BSTOP));
+ files.append(CGerberFile(".GTP",CLayer::LAYER_TCREAM));
+ files.append(CGerberFile(".GBP",CLayer::LAYER_BCREAM));
+ files.append(CGerberFile(".GTO",CLayer::LAYER_TPLACE,CLayer::LAYER_TNAMES));
+ files.append(CGerberFile(".GBO",CLayer::LAYER_BPLACE,CLayer::LAYER_BNAMES));
+ files.append(CGerberFile(".GKO",CLayer::LAYER_DIMENSION));
+ QVector<bool> results(files.size(),false);
+ bool *written = results.data();
+ CGerberFileJob job(board,m_PadResolver,rules,m_Font,polygons,files,baseName,written);
+ parallelFor(files.size(),job,m_ThreadCount);
+ int result = 0;
+ for (int i = 0; i < files.size(); i++)
+ {
+  if (written[i]) result++;
+ }
+ return result;
+}
+
+const CPolygonPour *CGerberExport::pour(CBoard& board)
+{
+ if (!m_PourPolygons) return 0;
+ m_Pour.setThreadCount(m_ThreadCount);
+ m_Pour.compute(board);
+ return &m_Pour;
+}
+
+
+//------------------------------------------------------------------------------
+
+CDrillTool::CDrillTool(const int number, const TDimension diameter, const bool plated)
+{
+ m_Number = number;
+ m_Diameter = diameter;
+ m_Plated = plated;
+}
+
+CDrillTool::CDrillTool(const CDrillTool& tool)
+{
+ assign(tool);
+}
+
+CDrillTool::CDrillTool(void)
+{
+ clear();
+}
+
+CDrillTool::~CDrillTool(void)
+{
+ //
+}
+
+void CDrillTool::operator =(const CDrillTool& tool)
+{
+ assign(tool);
+}
+
+void CDrillTool::clear(void)
+{
+ m_Number = 0;
+ m_Diameter = 0.0;
+ m_Plated = true;
+ m_Hits.clear();
+}
+
+void CDrillTool::assign(const CDrillTool& tool)
+{
+ m_Number = tool.m_Number;
+ m_Diameter = tool.m_Diameter;
+ m_Plated = tool.m_Plated;
+ m_Hits = tool.m_Hits;
+}
+
+TDimension CDrillTool::travel(void) const
+{
+ TDimension result = 0.0;
+ for (int i = 1; i < m_Hits.size(); i++)
+ {
+  const CPoint& a = m_Hits.at(i-1);
+  const CPoint& b = m_Hits.at(i);
+  result += sqrt((b.x()-a.x())*(b.x()-a.x()) + (b.y()-a.y())*(b.y()-a.y()));
+ }
+ return result;
+}
+
+//------------------------------------------------------------------------------
+
+// reorders hits into a nearest neighbour tour starting next to position,
+// which is moved to the last hit; candidates are searched ring by ring in a
+// grid of about one hit per cell
+static void nearestNeighbourTour(QVector<CPoint>& hits, CPoint& position)
+{
+ int n = hits.size();
+ if (0==n) return;
+ CBoundingBox box;
+ for (int i = 0; i < n; i++)
+ {
+  box.include(hits.at(i).x(),hits.at(i).y());
+ }
+ TDimension cell = std::max(sqrt(std::max(box.width()*box.height(),1e-6)/n),1e-3);
+ int columns = std::min((int)(box.width()/cell) + 1,4096);
+ int rows = std::min((int)(box.height()/cell) + 1,4096);
+ cell = std::max(std::max(box.width()/columns,box.height()/rows),1e-3);
+ QVector<QVector<int> > cells(columns*rows);
+ for (int i = 0; i < n; i++)
+ {
+  int c = std::min((int)((hits.at(i).x()-box.left())/cell),columns-1);
+  int r = std::min((int)((hits.at(i).y()-box.bottom())/cell),rows-1);
+  cells[r*columns+c].append(i);
+ }
+ QVector<CPoint> tour;
+ tour.reserve(n);
+ CPoint current = position;
+ for (int step = 0; step < n; step++)
+ {
+  int c0 = std::min(std::max((int)floor((current.x()-box.left())/cell),0),columns-1);
+  int r0 = std::min(std::max((int)floor((current.y()-box.bottom())/cell),0),rows-1);
+  int best = -1, bestCell = -1, bestSlot = -1;
+  double bestDistance = 0.0;
+  int limit = std::max(columns,rows);
+  for (int ring = 0; ring <= limit; ring++)
+  {
+   for (int r = r0-ring; r <= r0+ring; r++)
+   {
+    if (r < 0 || r >= rows) continue;
+    // whole rows at the top and bottom of the ring, two cells in between
+    int dc = (r==r0-ring || r==r0+ring) ? 1 : std::max(2*ring,1);
+    for (int c = c0-ring; c <= c0+ring; c += dc)
+    {
+     if (c < 0 || c >= columns) continue;
+     const QVector<int>& bucket = cells.at(r*columns+c);
+     for (int k = 0; k < bucket.size(); k++)
+     {
+      const CPoint& p = hits.at(bucket.at(k));
+      double d = (p.x()-current.x())*(p.x()-current.x()) + (p.y()-current.y())*(p.y()-current.y());
+      if (best < 0 || d < bestDistance)
+      {
+       best = bucket.at(k); bestCell = r*columns+c; bestSlot = k; bestDistance = d;
+      }
+     }
+    }
+   }
+   // anything in further rings is at least ring*cell away
+   if (best >= 0 && bestDistance <= (ring*cell)*(ring*cell)) break;
+  }
+  QVector<int>& bucket = cells[bestCell];
+  bucket[bestSlot] = bucket.last();
+  bucket.removeLast();
+  current = hits.at(best);
+  tour.append(current);
+ }
+ hits = tour;
+ position = current;
+}
+
+CDrillExport::CDrillExport(void)
+{
+ m_ThreadCount = 0;
+ clear();
+}
+
+CDrillExport::~CDrillExport(void)
+{
+ //
+}
+
+void CDrillExport::clear(void)
+{
+ m_Tools.clear();
+}
+
+// tools are keyed by plating and diameter in micrometers
+static void addHit(QHash<qint64,int>& index, QList<CDrillTool>& tools,
+                   const TCoord x, const TCoord y, const TDimension drill, const bool plated)
+{
+ if (drill <= 0.0) return;
+ qint64 key = qRound64(drill*1000.0)*2 + (plated ? 1 : 0);
+ int n = index.value(key,-1);
+ if (n < 0)
+ {
+  n = tools.size();
+  tools.append(CDrillTool(0,qRound64(drill*1000.0)/1000.0,plated));
+  index.insert(key,n);
+ }
+ tools[n].hits().append(CPoint(x,y));
+}
+
+static bool lessByDiameter(const CDrillTool& a, const CDrillTool& b)
+{
+ if (a.plated() != b.plated()) return a.plated();
+ return a.diameter() < b.diameter();
+}
+
+int CDrillExport::collect(CBoard& board)
+{
+ clear();
+ QHash<qint64,int> index;
+ QList<CDrillTool> tools;
+ // vias, the class drill stands in for vias without one
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  CClass *c = board.findClassByNumber(s->signalClass());
+  for (int j = 0; j < s->vias().size(); j++)
+  {
+   CVia *v = s->vias().at(j);
+   TDimension drill = v->drill();
+   if (drill <= 0.0 && 0!=c) drill = c->drill();
+   addHit(index,tools,v->x(),v->y(),drill,true);
+  }
+ }
+ // pads and holes of placed packages
+ const QVector<CPadInstance>& pads = m_PadResolver.resolve(board,m_ThreadCount);
+ for (int i = 0; i < pads.size(); i++)
+ {
+  const CPadInstance& p = pads.at(i);
+  if (CPadInstance::pkPad==p.kind()) addHit(index,tools,p.x(),p.y(),p.drill(),true);
+ }
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) continue;
+  CTransform t(*board.elements().at(i));
+  for (int j = 0; j < p->holes().size(); j++)
+  {
+   CHole *h = p->holes().at(j);
+   CPoint q = t.map(CPoint(h->x(),h->y()));
+   addHit(index,tools,q.x(),q.y(),h->drill(),false);
+  }
+ }
+ for (int i = 0; i < board.plain().holes().size(); i++)
+ {
+  CHole *h = board.plain().holes().at(i);
+  addHit(index,tools,h->x(),h->y(),h->drill(),false);
+ }
+ // plated tools first, each by increasing diameter, and the tours
+ std::sort(tools.begin(),tools.end(),lessByDiameter);
+ CPoint position;
+ for (int i = 0; i < tools.size(); i++)
+ {
+  tools[i].setNumber(i+1);
+  nearestNeighbourTour(tools[i].hits(),position);
+ }
+ m_Tools = tools;
+ return m_Tools.size();
+}
+
+int CDrillExport::hitCount(void) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Tools.size(); i++)
+ {
+  result += m_Tools.at(i).hits().size();
+ }
+ return result;
+}
+
+void CDrillExport::write(QTextStream& out, const int holes) const
+{
+ out<<"M48\n";
+ out<<";QEagleLib drill export, "<<(((holes & dhAll)==dhAll) ? "all holes" :
+  ((holes & dhPlated) ? "plated holes" : "non-plated holes"))<<"\n";
+ out<<"FMAT,2\n";
+ out<<"METRIC,TZ\n";
+ for (int i = 0; i < m_Tools.size(); i++)
+ {
+  const CDrillTool& t = m_Tools.at(i);
+  if (!(holes & (t.plated() ? dhPlated : dhNonPlated))) continue;
+  out<<"T"<<t.number()<<"C"<<QString::number(t.diameter(),'f',3)<<"\n";
+ }
+ out<<"%\n";
+ out<<"G90\n";
+ out<<"G05\n";
+ for (int i = 0; i < m_Tools.size(); i++)
+ {
+  const CDrillTool& t = m_Tools.at(i);
+  if (!(holes & (t.plated() ? dhPlated : dhNonPlated))) continue;
+  out<<"T"<<t.number()<<"\n";
+  for (int j = 0; j < t.hits().size(); j++)
+  {
+   const CPoint& p = t.hits().at(j);
+   out<<"X"<<QString::number(p.x(),'f',3)<<"Y"<<QString::number(p.y(),'f',3)<<"\n";
+  }
+ }
+ out<<"M30\n";
+}
+
+void CDrillExport::writeTable(QTextStream& out) const
+{
+ out<<"Tool  Diameter(mm)  Diameter(in)  Plated  Hits  Travel(mm)\n";
+ for (int i = 0; i < m_Tools.size(); i++)
+ {
+  const CDrillTool& t = m_Tools.at(i);
+  out<<QString("T%1").arg(t.number()).leftJustified(6)
+     <<QString::number(t.diameter(),'f',3).rightJustified(12)<<"  "
+     <<QString::number(t.diameter()/25.4,'f',4).rightJustified(12)<<"  "
+     <<QString(t.plated() ? "yes" : "no").rightJustified(6)<<"  "
+     <<QString::number(t.hits().size()).rightJustified(4)<<"  "
+     <<QString::number(t.travel(),'f',1).rightJustified(10)<<"\n";
+ }
+ out<<"Total "<<m_Tools.size()<<" tools, "<<hitCount()<<" hits\n";
+}
+
+bool CDrillExport::saveToFile(const QString& fileName, const int holes) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  write(ts,holes);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+bool CDrillExport::saveTableToFile(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeTable(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+
+//------------------------------------------------------------------------------
+
+CBomLine::CBomLine(const CBomLine& line)
+{
+ assign(line);
+}
+
+CBomLine::CBomLine(void)
+{
+ clear();
+}
+
+CBomLine::~CBomLine(void)
+{
+ //
+}
+
+void CBomLine::operator =(const CBomLine& line)
+{
+ assign(line);
+}
+
+void CBomLine::clear(void)
+{
+ m_Library.clear();
+ m_DeviceSet.clear();
+ m_Device.clear();
+ m_Technology.clear();
+ m_Package.clear();
+ m_Value.clear();
+ m_Attributes.clear();
+ m_Parts.clear();
+}
+
+void CBomLine::assign(const CBomLine& line)
+{
+ m_Library = line.m_Library;
+ m_DeviceSet = line.m_DeviceSet;
+ m_Device = line.m_Device;
+ m_Technology = line.m_Technology;
+ m_Package = line.m_Package;
+ m_Value = line.m_Value;
+ m_Attributes = line.m_Attributes;
+ m_Parts = line.m_Parts;
+}
+
+QString CBomLine::key(void) const
+{
+ // unit separators can not appear in Eagle names or values
+ QString result = m_Library + QChar(0x1F) + m_DeviceSet + QChar(0x1F) + m_Device + QChar(0x1F) +
+                  m_Technology + QChar(0x1F) + m_Package + QChar(0x1F) + m_Value;
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  result += QChar(0x1F) + m_Attributes.at(i);
+ }
+ return result;
+}
+
+//------------------------------------------------------------------------------
+
+CBillOfMaterials::CBillOfMaterials(void)
+{
+ clear();
+}
+
+CBillOfMaterials::~CBillOfMaterials(void)
+{
+ clear();
+}
+
+void CBillOfMaterials::clear(void)
+{
+ m_Lines.clear();
+ m_Index.clear();
+ m_Unpopulated.clear();
+ m_Variant.clear();
+}
+
+static CAttribute *findAttribute(QList<CAttribute*>& attributes, const QString& name)
+{
+ for (int i = 0; i < attributes.size(); i++)
+ {
+  if (name==attributes.at(i)->name()) return attributes.at(i);
+ }
+ return 0;
+}
+
+void CBillOfMaterials::add(const QString& name, const CBomLine& line)
+{
+ QString key = line.key();
+ QHash<QString,int>::const_iterator i = m_Index.constFind(key);
+ if (i==m_Index.constEnd())
+ {
+  i = m_Index.insert(key,m_Lines.size());
+  m_Lines.append(line);
+ }
+ m_Lines[i.value()].parts().append(name);
+}
+
+int CBillOfMaterials::collect(CSchematic& schematic, const QString& variant)
+{
+ clear();
+ m_View.update(schematic);
+ m_View.select(variant);
+ m_Variant = m_View.selected();
+ // devices are looked up once per library, device set and device
+ QHash<QString,CLibrary*> libraries;
+ for (int i = 0; i < schematic.libraries().size(); i++)
+ {
+  libraries.insert(schematic.libraries().at(i)->name(),schematic.libraries().at(i));
+ }
+ QHash<QString,CDevice*> devices;
+ for (int i = 0; i < m_View.count(); i++)
+ {
+  CPart *p = m_View.part(i);
+  QString device_key = p->library() + QChar(0x1F) + p->deviceSet() + QChar(0x1F) + p->device();
+  QHash<QString,CDevice*>::const_iterator d = devices.constFind(device_key);
+  if (d==devices.constEnd())
+  {
+   CDevice *device = 0;
+   CLibrary *l = libraries.value(p->library(),0);
+   CDeviceSet *s = (0!=l) ? l->findDeviceSetByName(p->deviceSet()) : 0;
+   if (0!=s) device = s->findDeviceByName(p->device());
+   d = devices.insert(device_key,device);
+  }
+  CDevice *device = d.value();
+  // frames, supply symbols and the like are not assembled
+  if (0!=device && device->package().isEmpty()) continue;
+  if (!m_View.populate(i))
+  {
+   m_Unpopulated.append(p->name());
+   continue;
+  }
+  CBomLine line;
+  line.setLibrary(p->library());
+  line.setDeviceSet(p->deviceSet());
+  line.setDevice(p->device());
+  line.setTechnology(m_View.technology(i));
+  line.setValue(m_View.value(i));
+  CTechnology *technology = 0;
+  if (0!=device)
+  {
+   line.setPackage(device->package());
+   for (int j = 0; j < device->technologies().size(); j++)
+   {
+    if (line.technology()==device->technologies().at(j)->name()) technology = device->technologies().at(j);
+   }
+  }
+  // values of the part override those of its technology
+  for (int j = 0; j < m_Attributes.size(); j++)
+  {
+   CAttribute *a = findAttribute(p->attributes(),m_Attributes.at(j));
+   if (0==a && 0!=technology) a = findAttribute(technology->attributes(),m_Attributes.at(j));
+   line.attributes().append((0!=a) ? a->value() : QString());
+  }
+  add(p->name(),line);
+ }
+ return m_Lines.size();
+}
+
+int CBillOfMaterials::collect(CBoard& board, const QString& variant)
+{
+ clear();
+ m_View.update(board);
+ m_View.select(variant);
+ m_Variant = m_View.selected();
+ for (int i = 0; i < m_View.count(); i++)
+ {
+  CElement *e = m_View.element(i);
+  if (!m_View.populate(i))
+  {
+   m_Unpopulated.append(e->name());
+   continue;
+  }
+  CBomLine line;
+  line.setLibrary(e->library());
+  line.setTechnology(m_View.technology(i));
+  line.setPackage(e->package());
+  line.setValue(m_View.value(i));
+  for (int j = 0; j < m_Attributes.size(); j++)
+  {
+   CAttribute *a = findAttribute(e->attributes(),m_Attributes.at(j));
+   line.attributes().append((0!=a) ? a->value() : QString());
+  }
+  add(e->name(),line);
+ }
+ return m_Lines.size();
+}
+
+int CBillOfMaterials::partCount(void) const
+{
+ int result = 0;
+ for (int i = 0; i < m_Lines.size(); i++)
+ {
+  result += m_Lines.at(i).quantity();
+ }
+ return result;
+}
+
+static QString csvField(const QString& value)
+{
+ if (!value.contains(',') && !value.contains('"') && !value.contains('\n')) return value;
+ QString s = value;
+ return "\"" + s.replace("\"","\"\"") + "\"";
+}
+
+static QString jsonString(const QString& value)
+{
+ QString result = "\"";
+ for (int i = 0; i < value.length(); i++)
+ {
+  QChar c = value.at(i);
+  if ('"'==c || '\\'==c) { result += '\\'; result += c; }
+  else if (c.unicode() < 0x20) result += QString("\\u%1").arg((int)c.unicode(),4,16,QChar('0'));
+  else result += c;
+ }
+ return result + "\"";
+}
+
+static QString jsonArray(const QStringList& values)
+{
+ QStringList items;
+ for (int i = 0; i < values.size(); i++)
+ {
+  items.append(jsonString(values.at(i)));
+ }
+ return "[" + items.join(", ") + "]";
+}
+
+void CBillOfMaterials::writeCSV(QTextStream& out) const
+{
+ // part names separated by spaces in the last column
+ out<<"quantity,value,library,deviceset,device,technology,package";
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  out<<","<<csvField(m_Attributes.at(i));
+ }
+ out<<",parts\n";
+ for (int i = 0; i < m_Lines.size(); i++)
+ {
+  const CBomLine& l = m_Lines.at(i);
+  out<<l.quantity()<<","<<csvField(l.value())<<","<<csvField(l.library())<<","
+     <<csvField(l.deviceSet())<<","<<csvField(l.device())<<","<<csvField(l.technology())<<","
+     <<csvField(l.package());
+  for (int j = 0; j < l.attributes().size(); j++)
+  {
+   out<<","<<csvField(l.attributes().at(j));
+  }
+  out<<","<<csvField(l.parts().join(" "))<<"\n";
+ }
+}
+
+void CBillOfMaterials::writeJSON(QTextStream& out) const
+{
+ out<<"{\n \"variant\": "<<jsonString(m_Variant)<<",\n \"lines\": [\n";
+ for (int i = 0; i < m_Lines.size(); i++)
+ {
+  const CBomLine& l = m_Lines.at(i);
+  out<<"  {\"quantity\": "<<l.quantity()<<", \"value\": "<<jsonString(l.value())
+     <<", \"library\": "<<jsonString(l.library())<<", \"deviceset\": "<<jsonString(l.deviceSet())
+     <<", \"device\": "<<jsonString(l.device())<<", \"technology\": "<<jsonString(l.technology())
+     <<", \"package\": "<<jsonString(l.package())<<", \"attributes\": {";
+  for (int j = 0; j < l.attributes().size(); j++)
+  {
+   if (j > 0) out<<", ";
+   out<<jsonString(m_Attributes.at(j))<<": "<<jsonString(l.attributes().at(j));
+  }
+  out<<"}, \"parts\": "<<jsonArray(l.parts())<<"}";
+  out<<((i+1 < m_Lines.size()) ? ",\n" : "\n");
+ }
+ out<<" ],\n \"unpopulated\": "<<jsonArray(m_Unpopulated)<<"\n}\n";
+}
+
+bool CBillOfMaterials::saveToCSV(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeCSV(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+bool CBillOfMaterials::saveToJSON(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeJSON(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+
+//------------------------------------------------------------------------------
+
+CPlacement::CPlacement(const CPlacement& placement)
+{
+ assign(placement);
+}
+
+CPlacement::CPlacement(void)
+{
+ clear();
+}
+
+CPlacement::~CPlacement(void)
+{
+ //
+}
+
+void CPlacement::operator =(const CPlacement& placement)
+{
+ assign(placement);
+}
+
+void CPlacement::clear(void)
+{
+ m_Name.clear();
+ m_Value.clear();
+ m_Package.clear();
+ m_X = 0.0;
+ m_Y = 0.0;
+ m_Rotation = 0.0;
+ m_Bottom = false;
+}
+
+void CPlacement::assign(const CPlacement& placement)
+{
+ m_Name = placement.m_Name;
+ m_Value = placement.m_Value;
+ m_Package = placement.m_Package;
+ m_X = placement.m_X;
+ m_Y = placement.m_Y;
+ m_Rotation = placement.m_Rotation;
+ m_Bottom = placement.m_Bottom;
+}
+
+//------------------------------------------------------------------------------
+
+// places the populated elements, centroids are looked up read only
+class CPlacementJob: public CParallelJob
+{
+ public:
+  CPlacementJob(const CVariantView& view, const CPadResolver& resolver, const QHash<CPackage*,CPoint>& centroids,
+                const QVector<int>& elements, CPlacement *results):
+   m_View(view), m_Resolver(resolver), m_Centroids(centroids), m_Elements(elements), m_Results(results) {}
+  virtual void execute(const int index)
+  {
+   int i = m_Elements.at(index);
+   CElement *e = m_View.element(i);
+   CPackage *p = m_Resolver.package(i);
+   CTransform t(*e);
+   CPoint c = t.map((0!=p) ? m_Centroids.value(p) : CPoint());
+   CPlacement& r = m_Results[index];
+   r.setName(e->name());
+   r.setValue(m_View.value(i));
+   r.setPackage(e->package());
+   r.setX(c.x());
+   r.setY(c.y());
+   // seen from below a mirrored element turns the other way
+   double rotation = fmod(e->rotation(),360.0);
+   if (e->reflection()) rotation = 360.0 - rotation;
+   rotation = fmod(rotation,360.0);
+   if (rotation < 0.0) rotation += 360.0;
+   r.setRotation(rotation);
+   r.setBottom(e->reflection());
+  }
+ protected:
+  const CVariantView& m_View;
+  const CPadResolver& m_Resolver;
+  const QHash<CPackage*,CPoint>& m_Centroids;
+  const QVector<int>& m_Elements;
+  CPlacement *m_Results;
+};
+
+CPickAndPlaceExport::CPickAndPlaceExport(void)
+{
+ m_ThreadCount = 0;
+ clear();
+}
+
+CPickAndPlaceExport::~CPickAndPlaceExport(void)
+{
+ clear();
+}
+
+void CPickAndPlaceExport::clear(void)
+{
+ m_Placements.clear();
+}
+
+CPoint CPickAndPlaceExport::centroid(CPackage& package)
+{
+ QHash<CPackage*,CPoint>::const_iterator i = m_Centroids.constFind(&package);
+ if (i!=m_Centroids.constEnd() && m_CentroidRevisions.value(&package)==package.revision()) return i.value();
+ CBoundingBox box;
+ for (int j = 0; j < package.pads().size(); j++)
+ {
+  box.include(package.pads().at(j)->boundingBox());
+ }
+ for (int j = 0; j < package.smds().size(); j++)
+ {
+  box.include(package.smds().at(j)->boundingBox());
+ }
+ CPoint result;
+ if (box.isValid()) result = CPoint(0.5*(box.left()+box.right()),0.5*(box.bottom()+box.top()));
+ m_Centroids.insert(&package,result);
+ m_CentroidRevisions.insert(&package,package.revision());
+ return result;
+}
+
+int CPickAndPlaceExport::collect(CBoard& board, const QString& variant)
+{
+ clear();
+ m_PadResolver.resolve(board,m_ThreadCount);
+ m_View.update(board);
+ m_View.select(variant);
+ // centroids are filled in before the jobs read them
+ QVector<int> elements;
+ for (int i = 0; i < m_View.count(); i++)
+ {
+  if (!m_View.populate(i)) continue;
+  elements.append(i);
+  CPackage *p = m_PadResolver.package(i);
+  if (0!=p) centroid(*p);
+ }
+ m_Placements.resize(elements.size());
+ CPlacementJob job(m_View,m_PadResolver,m_Centroids,elements,m_Placements.data());
+ parallelFor(elements.size(),job,m_ThreadCount);
+ return m_Placements.size();
+}
+
+void CPickAndPlaceExport::writeCSV(QTextStream& out) const
+{
+ // coordinates in mm, rotation in degrees
+ out<<"designator,value,package,x,y,rotation,side\n";
+ for (int i = 0; i < m_Placements.size(); i++)
+ {
+  const CPlacement& p = m_Placements.at(i);
+  out<<csvField(p.name())<<","<<csvField(p.value())<<","<<csvField(p.package())<<","
+     <<QString::number(p.x(),'f',4)<<","<<QString::number(p.y(),'f',4)<<","
+     <<QString::number(p.rotation(),'f',2)<<","<<(p.bottom() ? "bottom" : "top")<<"\n";
+ }
+}
+
+bool CPickAndPlaceExport::saveToCSV(const QString& fileName) const
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  writeCSV(ts);
+  f.close();
+  return true;
+ }
+ return false;
+}
+
+
+//------------------------------------------------------------------------------
+
+// signals an IPC export formats at a time, bounds the records held
+static const int IPC_WINDOW = 256;
+
+// left aligned text cut to its column width
+static QString ipcField(const QString& text, const int width)
+{
+ return text.left(width).leftJustified(width,' ');
+}
+
+// micrometers, coordinates are signed
+static QString ipcNumber(const double value, const int digits, const bool sign)
+{
+ qint64 limit = 1;
+ for (int i = 0; i < digits; i++) limit *= 10;
+ qint64 v = qMin((qint64)qAbs(qRound64(value*1000.0)),limit-1);
+ QString result = QString("%1").arg(v,digits,10,QChar('0'));
+ if (sign) result.prepend((value < 0.0 && v > 0) ? '-' : '+');
+ return result;
+}
+
+class CIpcRecord
+{
+ public:
+  CIpcRecord(void): smt(false), drill(0.0), plated(true), access(0), x(0.0), y(0.0),
+                    sizeX(0.0), sizeY(0.0), rotation(0.0), mask(0) {}
+  // one fixed column test record of 80 characters
+  QString toString(const QString& net) const
+  {
+   QString result = smt ? "327" : "317";
+   result += ipcField(net,14) + "   " + ipcField(reference,6) + "-" + ipcField(pin,4);
+   result += (pin.isEmpty() ? "M" : " ");
+   result += (drill > 0.0) ? "D" + ipcNumber(drill,4,false) + (plated ? "P" : "U") : QString(6,' ');
+   result += QString("A%1").arg(access,2,10,QChar('0'));
+   result += "X" + ipcNumber(x,6,true) + "Y" + ipcNumber(y,6,true);
+   result += "X" + ipcNumber(sizeX,4,false) + "Y" + ipcNumber(sizeY,4,false);
+   double r = fmod(rotation,360.0);
+   if (r < 0.0) r += 360.0;
+   result += QString("R%1").arg(qRound(r) % 360,3,10,QChar('0'));
+   result += QString(" S%1").arg(mask);
+   return result.leftJustified(80,' ');
+  }
+ public:
+  bool smt;
+  QString reference; // element name, VIA for vias
+  QString pin; // empty for vias
+  TDimension drill; // 0 for smds
+  bool plated;
+  int access; // 0 for both sides, else the copper layer counted from the top
+  TCoord x;
+  TCoord y;
+  TDimension sizeX;
+  TDimension sizeY;
+  double rotation;
+  int mask; // sides covered by solder mask: 0 none, 1 top, 2 bottom, 3 both
+};
+
+// records of one signal of a window starting at base, the extra last index
+// takes pads of no signal
+class CIpcNetJob: public CParallelJob
+{
+ public:
+  CIpcNetJob(CBoard& board, const CPadResolver& resolver, const CPadRules& rules, const QVector<int>& first,
+             const QVector<int>& order, const QStringList& nets, const int base, QString *results,
+             QStringList *truncated):
+   m_Board(board), m_Resolver(resolver), m_Rules(rules), m_First(first), m_Order(order), m_Nets(nets),
+   m_Base(base), m_Results(results), m_Truncated(truncated) {}
+  virtual void execute(const int window)
+  {
+   QString& out = m_Results[window];
+   int index = m_Base + window;
+   const QString& net = m_Nets.at(index);
+   const QVector<CPadInstance>& pads = m_Resolver.pads();
+   TLayer top = m_Rules.layers().first(), bottom = m_Rules.layers().last();
+   for (int i = m_First.at(index); i < m_First.at(index+1); i++)
+   {
+    const CPadInstance& p = pads.at(m_Order.at(i));
+    CIpcRecord r;
+    r.reference = m_Board.elements().at(p.element())->name();
+    r.pin = p.name();
+    r.x = p.x();
+    r.y = p.y();
+    r.rotation = p.rotation();
+    if (CPadInstance::pkSMD==p.kind())
+    {
+     if (!m_Rules.layers().contains(p.layer())) continue;
+     r.smt = true;
+     r.access = m_Rules.layers().indexOf(p.layer()) + 1;
+     r.sizeX = p.dx();
+     r.sizeY = p.dy();
+     if (0!=p.smd() && !p.smd()->stop()) r.mask = (p.layer()==top) ? 1 : 2;
+    }
+    else
+    {
+     TDimension d = m_Rules.padDiameter(p.drill(),p.dx(),top);
+     r.drill = p.drill();
+     r.sizeX = d;
+     r.sizeY = d;
+     if (CPad::psLong==p.shape()) r.sizeX = d*(1.0 + 0.01*m_Rules.elongationLong());
+     if (CPad::psOffset==p.shape()) r.sizeX = d*(1.0 + 0.01*m_Rules.elongationOffset());
+     if (0!=p.pad() && !p.pad()->stop()) r.mask = 3;
+    }
+    if (r.reference.length() > 6 || r.pin.length() > 4)
+    {
+     m_Truncated[window].append(r.reference + "-" + r.pin);
+    }
+    out += r.toString(net) + "\n";
+   }
+   if (index >= m_Board.signal().size()) return;
+   CSignal *s = m_Board.signal().at(index);
+   for (int j = 0; j < s->vias().size(); j++)
+   {
+    CVia *v = s->vias().at(j);
+    int start, stop;
+    decodeExtent(v->extent(),start,stop);
+    // buried vias can not be probed
+    bool from_top = (start <= top), from_bottom = (stop >= bottom);
+    if (!from_top && !from_bottom) continue;
+    CIpcRecord r;
+    r.reference = "VIA";
+    r.x = v->x();
+    r.y = v->y();
+    r.drill = v->drill();
+    r.access = (from_top && from_bottom) ? 0 : (from_top ? 1 : m_Rules.layers().size());
+    r.sizeX = m_Rules.viaDiameter(v->drill(),v->diameter(),from_top ? top : bottom);
+    r.sizeY = r.sizeX;
+    if (!m_Rules.viaStop(*v)) r.mask = (from_top ? 1 : 0) | (from_bottom ? 2 : 0);
+    out += r.toString(net) + "\n";
+   }
+  }
+ protected:
+  CBoard& m_Board;
+  const CPadResolver& m_Resolver;
+  const CPadRules& m_Rules;
+  const QVector<int>& m_First;
+  const QVector<int>& m_Order;
+  const QStringList& m_Nets;
+  int m_Base;
+  QString *m_Results; // one per signal of the window
+  QStringList *m_Truncated; // one per signal of the window
+};
+
+CIpcNetlistExport::CIpcNetlistExport(void)
+{
+ clear();
+}
+
+CIpcNetlistExport::~CIpcNetlistExport(void)
+{
+ //
+}
+
+void CIpcNetlistExport::clear(void)
+{
+ m_JobName.clear();
+ m_ThreadCount = 0;
+ m_PadResolver.clear();
+ m_Truncated.clear();
+}
+
+bool CIpcNetlistExport::write(CBoard& board, QTextStream& out)
+{
+ m_Truncated.clear();
+ CPadRules rules(board.designRules());
+ if (rules.layers().isEmpty()) return false;
+ const QVector<CPadInstance>& pads = m_PadResolver.resolve(board,m_ThreadCount);
+ // pads grouped by signal with a counting sort, no signal goes last
+ int count = board.signal().size() + 1;
+ QVector<int> first(count+1,0), order(pads.size());
+ for (int i = 0; i < pads.size(); i++)
+ {
+  int net = (pads.at(i).signal() < 0) ? count-1 : pads.at(i).signal();
+  first[net+1]++;
+ }
+ for (int i = 0; i < count; i++) first[i+1] += first.at(i);
+ QVector<int> next = first;
+ for (int i = 0; i < pads.size(); i++)
+ {
+  int net = (pads.at(i).signal() < 0) ? count-1 : pads.at(i).signal();
+  order[next[net]++] = i;
+ }
+ // names which do not fit their 14 columns or hold blanks get aliases
+ QStringList nets, aliases;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  QString name = board.signal().at(i)->name();
+  if (name.length() > 14 || name.contains(' '))
+  {
+   aliases.append(QString("P  NNAME%1").arg(aliases.size()+1).leftJustified(15,' ') + name);
+   nets.append(QString("NNAME%1").arg(aliases.size()));
+  }
+  else nets.append(name);
+ }
+ nets.append("N/C");
+ out<<"C  IPC-D-356A netlist\n";
+ if (!m_JobName.isEmpty()) out<<"P  JOB   "<<m_JobName<<"\n";
+ out<<"P  CODE  00\n";
+ out<<"P  UNITS CUST 1\n";
+ out<<"P  DIM   N\n";
+ out<<"P  VER   IPC-D-356A\n";
+ out<<"P  IMAGE PRIMARY\n";
+ for (int i = 0; i < aliases.size(); i++)
+ {
+  out<<aliases.at(i)<<"\n";
+ }
+ // a window of signals is formatted in parallel and written in board order
+ // before the next one starts, so only its records are held at a time
+ QVector<QString> records;
+ QVector<QStringList> truncated;
+ for (int base = 0; base < count; base += IPC_WINDOW)
+ {
+  int size = std::min(IPC_WINDOW,count-base);
+  records.fill(QString(),size);
+  truncated.fill(QStringList(),size);
+  CIpcNetJob job(board,m_PadResolver,rules,first,order,nets,base,records.data(),truncated.data());
+  parallelFor(size,job,m_ThreadCount);
+  for (int i = 0; i < size; i++)
+  {
+   out<<records.at(i);
+   m_Truncated.append(truncated.at(i));
+  }
+ }
+ out<<"999\n";
+ return true;
+}
+
+bool CIpcNetlistExport::saveToFile(CBoard& board, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(board,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,334 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEEXPORT_H
+#define QEAGLEEXPORT_H
+//------------------------------------------------------------------------------
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+#include "QEagleFont.h"
+#include "QEaglePolygon.h"
+#include "QEagleVariant.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements manufacturing output of boards and schematics
+*/
+
+namespace Eagle
+{
+
+// Gerber RS-274X output of a set of board layers in millimeters, format 4.6;
+// copper carries signal wires, vias, pads and smds, stop and cream layers
+// the pad, smd and via masks grown or shrunk by the design rule frames, and
+// every layer the wires, circles, rectangles, polygons and texts drawn on it
+// by the board and its packages, texts stroked with the vector font. Copper
+// polygons of the board are poured by Eagle and are left out, unless they
+// are to be poured here: signal polygons then become regions below the rest
+// of the copper. The output depends on nothing but the board, so it can be
+// compared with golden files
+class CGerberExport
+{
+ public:
+  CGerberExport(void);
+  virtual ~CGerberExport(void);
+ public:
+  void clear(void);
+  bool write(CBoard& board, const QList<TLayer>& layers, QTextStream& out);
+  bool saveToFile(CBoard& board, const QList<TLayer>& layers, const QString& fileName);
+  // the usual set of files named baseName plus .GTL, .GBL, .G2L..G15L for
+  // inner layers in use, .GTS, .GBS, .GTP, .GBP, .GTO, .GBO and .GKO,
+  // written in parallel; returns the number of files written
+  int saveToFiles(CBoard& board, const QString& baseName);
+ public:
+  // getters
+  int threadCount(void) const { return m_ThreadCount; }
+  bool pourPolygons(void) const { return m_PourPolygons; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+  void setPourPolygons(const bool value) { m_PourPolygons = value; }
+ protected:
+  const CPolygonPour *pour(CBoard& board);
+ protected:
+  int m_ThreadCount; // default = 0, ideal thread count
+  bool m_PourPolygons; // default = false
+  CPadResolver m_PadResolver; // reused by consecutive exports of the same board
+  CVectorFont m_Font;
+  CPolygonPour m_Pour;
+};
+
+// all hits of one drill diameter, in drilling order
+class CDrillTool
+{
+ public:
+  CDrillTool(const int number, const TDimension diameter, const bool plated);
+  CDrillTool(const CDrillTool& tool);
+  CDrillTool(void);
+  virtual ~CDrillTool(void);
+ public:
+  void operator =(const CDrillTool& tool);
+  void clear(void);
+  void assign(const CDrillTool& tool);
+  TDimension travel(void) const;
+ public:
+  // getters
+  int number(void) const { return m_Number; }
+  TDimension diameter(void) const { return m_Diameter; }
+  bool plated(void) const { return m_Plated; }
+  QVector<CPoint>& hits(void) { return m_Hits; }
+  const QVector<CPoint>& hits(void) const { return m_Hits; }
+  // setters
+  void setNumber(const int value) { m_Number = value; }
+ protected:
+  int m_Number; // T1 onwards
+  TDimension m_Diameter;
+  bool m_Plated; // pads and vias are, holes are not
+  QVector<CPoint> m_Hits;
+};
+
+// drill data of a board: vias, pads of placed packages and holes of the
+// board and its packages are grouped into tools of equal diameter, the hits
+// of each tool are ordered by a nearest neighbour tour continuing where the
+// previous tool ended; written as Excellon in millimeters and as a table
+class CDrillExport
+{
+ public:
+  enum Holes {dhPlated = 0x01, dhNonPlated = 0x02, dhAll = 0x03};
+ public:
+  CDrillExport(void);
+  virtual ~CDrillExport(void);
+ public:
+  void clear(void);
+  int collect(CBoard& board);
+  void write(QTextStream& out, const int holes = dhAll) const;
+  void writeTable(QTextStream& out) const;
+  bool saveToFile(const QString& fileName, const int holes = dhAll) const;
+  bool saveTableToFile(const QString& fileName) const;
+  int hitCount(void) const;
+ public:
+  // getters
+  const QList<CDrillTool>& tools(void) const { return m_Tools; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QList<CDrillTool> m_Tools;
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+};
+
+// parts of one kind in a bill of materials: equal library, device set,
+// device, technology, package, value and selected attributes
+class CBomLine
+{
+ public:
+  CBomLine(const CBomLine& line);
+  CBomLine(void);
+  virtual ~CBomLine(void);
+ public:
+  void operator =(const CBomLine& line);
+  void clear(void);
+  void assign(const CBomLine& line);
+  // grouping key of the line, parts are left out
+  QString key(void) const;
+ public:
+  // getters
+  const QString& library(void) const { return m_Library; }
+  const QString& deviceSet(void) const { return m_DeviceSet; }
+  const QString& device(void) const { return m_Device; }
+  const QString& technology(void) const { return m_Technology; }
+  const QString& package(void) const { return m_Package; }
+  const QString& value(void) const { return m_Value; }
+  QStringList& attributes(void) { return m_Attributes; }
+  const QStringList& attributes(void) const { return m_Attributes; }
+  QStringList& parts(void) { return m_Parts; }
+  const QStringList& parts(void) const { return m_Parts; }
+  int quantity(void) const { return m_Parts.size(); }
+  // setters
+  void setLibrary(const QString& value) { m_Library = value; }
+  void setDeviceSet(const QString& value) { m_DeviceSet = value; }
+  void setDevice(const QString& value) { m_Device = value; }
+  void setTechnology(const QString& value) { m_Technology = value; }
+  void setPackage(const QString& value) { m_Package = value; }
+  void setValue(const QString& value) { m_Value = value; }
+ protected:
+  QString m_Library;
+  QString m_DeviceSet; // empty for board elements
+  QString m_Device; // empty for board elements
+  QString m_Technology;
+  QString m_Package;
+  QString m_Value;
+  QStringList m_Attributes; // values of the selected attributes, in order
+  QStringList m_Parts; // names in document order
+};
+
+// bill of materials of a schematic or a board for one assembly variant:
+// parts are read through a variant view, which is kept between calls so
+// the BOMs of all variants share one index of the overrides, and grouped by
+// a hash of their key, so a BOM is built in time linear in the number of
+// parts. Parts whose device has no
+// package, like frames and supply symbols, are not listed. Lines keep the
+// order in which their first part appears
+class CBillOfMaterials
+{
+ public:
+  CBillOfMaterials(void);
+  virtual ~CBillOfMaterials(void);
+ public:
+  void clear(void);
+  // variant is the name of a <variantdef>, the current one when null and
+  // none when empty; returns the number of lines
+  int collect(CSchematic& schematic, const QString& variant = QString());
+  int collect(CBoard& board, const QString& variant = QString());
+  void writeCSV(QTextStream& out) const;
+  void writeJSON(QTextStream& out) const;
+  bool saveToCSV(const QString& fileName) const;
+  bool saveToJSON(const QString& fileName) const;
+  int partCount(void) const;
+ public:
+  // getters
+  const QList<CBomLine>& lines(void) const { return m_Lines; }
+  const QStringList& unpopulated(void) const { return m_Unpopulated; }
+  const QString& variant(void) const { return m_Variant; }
+  const QStringList& attributes(void) const { return m_Attributes; }
+  // setters
+  void setAttributes(const QStringList& value) { m_Attributes = value; }
+ protected:
+  void add(const QString& name, const CBomLine& line);
+ protected:
+  QList<CBomLine> m_Lines;
+  QHash<QString,int> m_Index; // line key, index into m_Lines
+  QStringList m_Unpopulated; // parts the variant leaves out
+  QString m_Variant; // the variant applied by the last collect()
+  QStringList m_Attributes; // default = none, names of attributes to group by and list
+  CVariantView m_View;
+};
+
+// placement of one element for pick and place machines
+class CPlacement
+{
+ public:
+  CPlacement(const CPlacement& placement);
+  CPlacement(void);
+  virtual ~CPlacement(void);
+ public:
+  void operator =(const CPlacement& placement);
+  void clear(void);
+  void assign(const CPlacement& placement);
+ public:
+  // getters
+  const QString& name(void) const { return m_Name; }
+  const QString& value(void) const { return m_Value; }
+  const QString& package(void) const { return m_Package; }
+  TCoord x(void) const { return m_X; }
+  TCoord y(void) const { return m_Y; }
+  double rotation(void) const { return m_Rotation; }
+  bool bottom(void) const { return m_Bottom; }
+  // setters
+  void setName(const QString& value) { m_Name = value; }
+  void setValue(const QString& value) { m_Value = value; }
+  void setPackage(const QString& value) { m_Package = value; }
+  void setX(const TCoord value) { m_X = value; }
+  void setY(const TCoord value) { m_Y = value; }
+  void setRotation(const double value) { m_Rotation = value; }
+  void setBottom(const bool value) { m_Bottom = value; }
+ protected:
+  QString m_Name;
+  QString m_Value;
+  QString m_Package;
+  TCoord m_X; // centroid in board coordinates
+  TCoord m_Y;
+  double m_Rotation; // degrees counterclockwise as seen from the mounting side, 0 .. 360
+  bool m_Bottom; // mounted on the bottom side, the element is mirrored
+};
+
+// centroid data of the elements an assembly variant populates: the centroid
+// of a package is the center of the extent of its pads and smds, or its
+// origin when it has none, and is computed once per package and kept until
+// the package changes; elements are then placed in parallel. Rotations of
+// bottom side elements are given as seen from below
+class CPickAndPlaceExport
+{
+ public:
+  CPickAndPlaceExport(void);
+  virtual ~CPickAndPlaceExport(void);
+ public:
+  void clear(void);
+  // variant as for CBillOfMaterials::collect(); returns the number of placements
+  int collect(CBoard& board, const QString& variant = QString());
+  void writeCSV(QTextStream& out) const;
+  bool saveToCSV(const QString& fileName) const;
+  CPoint centroid(CPackage& package);
+ public:
+  // getters
+  const QVector<CPlacement>& placements(void) const { return m_Placements; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QVector<CPlacement> m_Placements; // in board order
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+  CVariantView m_View;
+  QHash<CPackage*,CPoint> m_Centroids; // package coordinates
+  QHash<CPackage*,int> m_CentroidRevisions; // package revision of each centroid
+};
+
+// IPC-D-356A netlist of a board for bare board electrical test, metric: every
+// pad, smd and via accessible from an outer layer is listed by signal with
+// its position, drill, feature size, access side and solder mask, pads of
+// no signal as N/C. Signal names too long for the fixed columns are written
+// as NNAME aliases. Reference designators over 6 and pin names over 4
+// characters have no alias in the format; they are cut and listed by
+// truncated(). Records are formatted in parallel a window of signals at a
+// time and streamed in board order, so memory does not grow with the board
+class CIpcNetlistExport
+{
+ public:
+  CIpcNetlistExport(void);
+  virtual ~CIpcNetlistExport(void);
+ public:
+  void clear(void);
+  bool write(CBoard& board, QTextStream& out);
+  bool saveToFile(CBoard& board, const QString& fileName);
+ public:
+  // getters
+  const QString& jobName(void) const { return m_JobName; }
+  int threadCount(void) const { return m_ThreadCount; }
+  const QStringList& truncated(void) const { return m_Truncated; }
+  // setters
+  void setJobName(const QString& value) { m_JobName = value; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QString m_JobName; // default = none
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver; // reused by consecutive exports of the same board
+  QStringList m_Truncated; // reference-pin of the records cut by the last write, in output order
+};
+
+}
+
+#endif // QEAGLEEXPORT_H
+//------------------------------------------------------------------------------
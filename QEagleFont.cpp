@@ -0,0 +1,358 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <QStringList>
+//------------------------------------------------------------------------------
+#include "QEagleFont.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+// glyphs of printable ASCII from 0x20, strokes are separated by spaces and
+// consist of points written as two digits, x from 0 to 4 and y+2 where 2 is
+// the baseline, 6 the top of lowercase and 8 the top of capitals
+static const char *glyphs[] = {
+ "",                                   // space
+ "2824 22",                            // !
+ "1817 3837",                          // "
+ "1218 3238 0444 0646",                // #
+ "473818070615354443321203 2822",      // $
+ "0248 0818170708 3343423233",         // %
+ "4206071827260403122244",             // &
+ "2827",                               // '
+ "38272332",                           // (
+ "18272312",                           // )
+ "2723 0644 0446",                     // *
+ "2723 0545",                          // +
+ "2211",                               // ,
+ "0545",                               // -
+ "22",                                 // .
+ "0248",                               // /
+ "120307183847433212 0347",            // 0
+ "172822 1232",                        // 1
+ "07183847460242",                     // 2
+ "0718384746354443321203 1535",        // 3
+ "32380444",                           // 4
+ "480805354443321203",                 // 5
+ "38180703123243443505",               // 6
+ "084812",                             // 7
+ "15060718384746351504031232434435",   // 8
+ "45150607183847433212",               // 9
+ "26 22",                              // :
+ "26 2211",                            // ;
+ "470543",                             // <
+ "0646 0444",                          // =
+ "074503",                             // >
+ "07183847462524 22",                  // ?
+ "3436161434 344447381807031242",      // @
+ "0206284642 0444",                    // A
+ "02083847463505 3544433202",          // B
+ "4738180703123243",                   // C
+ "02083847433202",                     // D
+ "48080242 0535",                      // E
+ "480802 0535",                        // F
+ "47381807031232434525",               // G
+ "0208 4248 0545",                     // H
+ "1838 2822 1232",                     // I
+ "484332120304",                       // J
+ "0208 4804 1542",                     // K
+ "080242",                             // L
+ "0208254842",                         // M
+ "02084248",                           // N
+ "120307183847433212",                 // O
+ "02083847463505",                     // P
+ "120307183847433212 2442",            // Q
+ "02083847463505 2542",                // R
+ "473818070615354443321203",           // S
+ "0848 2822",                          // T
+ "080312324348",                       // U
+ "082248",                             // V
+ "0812253248",                         // W
+ "0248 0842",                          // X
+ "082548 2522",                        // Y
+ "08480242",                           // Z
+ "38181232",                           // [
+ "0842",                               // backslash
+ "18383212",                           // ]
+ "062846",                             // ^
+ "0141",                               // _
+ "1827",                               // `
+ "16364542 43321203041545",            // a
+ "0802 0516364543321203",              // b
+ "4536160503123243",                   // c
+ "4842 4536160503123243",              // d
+ "04444536160503123243",               // e
+ "12172838 0626",                      // f
+ "4641301001 4536160503123243",        // g
+ "0802 0516364542",                    // h
+ "2622 28",                            // i
+ "3631201001 38",                      // j
+ "0802 4604 1542",                     // k
+ "182822 1232",                        // l
+ "0602 05162522 25364542",             // m
+ "0602 0516364542",                    // n
+ "120305163645433212",                 // o
+ "0600 0516364543321203",              // p
+ "4640 4536160503123243",              // q
+ "0602 042646",                        // r
+ "4616051434433202",                   // s
+ "1813223243 0636",                    // t
+ "0603123243 4642",                    // u
+ "062246",                             // v
+ "0612253246",                         // w
+ "0642 0246",                          // x
+ "0622 4610",                          // y
+ "06460242",                           // z
+ "38272615242332",                     // {
+ "2821",                               // |
+ "18272635242312",                     // }
+ "05163445"                            // ~
+};
+
+// symbols common in values, anything else unknown is drawn as ?
+static const char *extraGlyph(const ushort code)
+{
+ switch (code)
+ {
+  case 0x00B0: return "1828271718";                     // degree
+  case 0x00B1: return "2723 0545 0343";                 // plus-minus
+  case 0x00B5: return "0600 03123243 4642";             // micro
+  case 0x03A9: return "021213050718384745333242";       // ohm
+  case 0x03BC: return "0600 03123243 4642";             // mu
+ }
+ return glyphs['?'-0x20];
+}
+
+static const char *glyph(const QChar c)
+{
+ ushort code = c.unicode();
+ if (code >= 0x20 && code < 0x7F) return glyphs[code-0x20];
+ return extraGlyph(code);
+}
+
+// grid units of a glyph cell: advance, capital height
+static const double GLYPH_ADVANCE = 6.0;
+static const double GLYPH_HEIGHT = 6.0;
+
+//------------------------------------------------------------------------------
+
+CTextGeometry::CTextGeometry(const CTextGeometry& geometry)
+{
+ assign(geometry);
+}
+
+CTextGeometry::CTextGeometry(void)
+{
+ clear();
+}
+
+CTextGeometry::~CTextGeometry(void)
+{
+ //
+}
+
+void CTextGeometry::operator =(const CTextGeometry& geometry)
+{
+ assign(geometry);
+}
+
+void CTextGeometry::clear(void)
+{
+ m_Points.clear();
+ m_First.clear();
+ m_Width = 0.0;
+ m_BoundingBox.clear();
+}
+
+void CTextGeometry::assign(const CTextGeometry& geometry)
+{
+ m_Points = geometry.m_Points;
+ m_First = geometry.m_First;
+ m_Width = geometry.m_Width;
+ m_BoundingBox = geometry.m_BoundingBox;
+}
+
+void CTextGeometry::addStroke(const QVector<CPoint>& points)
+{
+ if (points.isEmpty()) return;
+ if (m_First.isEmpty()) m_First.append(0);
+ for (int i = 0; i < points.size(); i++)
+ {
+  m_Points.append(points.at(i));
+  m_BoundingBox.include(points.at(i).x(),points.at(i).y(),0.5*m_Width);
+ }
+ m_First.append(m_Points.size());
+}
+
+void CTextGeometry::map(const CTransform& transform)
+{
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Points.size(); i++)
+ {
+  m_Points[i] = transform.map(m_Points.at(i));
+  m_BoundingBox.include(m_Points.at(i).x(),m_Points.at(i).y(),0.5*m_Width);
+ }
+}
+
+//------------------------------------------------------------------------------
+
+CVectorFont::CVectorFont(void)
+{
+ clear();
+}
+
+CVectorFont::~CVectorFont(void)
+{
+ //
+}
+
+bool CVectorFont::isPartPlaceholder(const QString& text)
+{
+ QString key = text.toUpper();
+ return ">NAME"==key || ">PART"==key || ">VALUE"==key;
+}
+
+QString CVectorFont::placeholder(const QString& text, const QString& name, const QString& value)
+{
+ if (!text.startsWith('>')) return text;
+ QString key = text.mid(1).toUpper();
+ if ("NAME"==key || "PART"==key) return name;
+ if ("VALUE"==key) return value;
+ return text;
+}
+
+QString CVectorFont::attributeValue(CAttribute& attribute, const QString& name, const QString& value)
+{
+ if ("NAME"==attribute.name()) return name;
+ if ("VALUE"==attribute.name()) return value;
+ return attribute.value();
+}
+
+void CVectorFont::clear(void)
+{
+ QWriteLocker locker(&m_Lock);
+ m_Cache.clear();
+ m_CacheLimit = 10000;
+}
+
+int CVectorFont::cacheSize(void)
+{
+ QReadLocker locker(&m_Lock);
+ return m_Cache.size();
+}
+
+CTextGeometry CVectorFont::layout(const QString& text, const TDimension size, const int ratio,
+                                  const CText::Align align, const int distance)
+{
+ QString key = QString("%1/%2/%3/%4/").arg(size,0,'g',12).arg(ratio).arg((int)align).arg(distance) + text;
+ {
+  QReadLocker locker(&m_Lock);
+  QHash<QString,CTextGeometry>::const_iterator i = m_Cache.constFind(key);
+  if (i!=m_Cache.constEnd()) return i.value();
+ }
+ CTextGeometry result;
+ result.m_Width = size*ratio/100.0;
+ // centerlines of capitals run from half the width to size less half of it
+ double scale = std::max(size - result.m_Width,0.0)/GLYPH_HEIGHT;
+ double margin = 0.5*result.m_Width;
+ QStringList lines = text.split('\n');
+ double step = size*(1.0 + distance/100.0);
+ double height = (lines.size()-1)*step + size;
+ int column = (int)align % 3, row = (int)align / 3;
+ QVector<CPoint> stroke;
+ for (int k = 0; k < lines.size(); k++)
+ {
+  const QString& line = lines.at(k);
+  if (line.isEmpty()) continue;
+  // lines are aligned one by one, as Eagle does
+  double width = (line.size()*GLYPH_ADVANCE - (GLYPH_ADVANCE - 4.0))*scale + result.m_Width;
+  double x0 = -0.5*column*width + margin;
+  double y0 = (lines.size()-1-k)*step - 0.5*row*height + margin;
+  for (int i = 0; i < line.size(); i++)
+  {
+   const char *g = glyph(line.at(i));
+   double cx = x0 + i*GLYPH_ADVANCE*scale;
+   stroke.clear();
+   for (const char *p = g; ; p++)
+   {
+    if (' '==*p || 0==*p)
+    {
+     result.addStroke(stroke);
+     stroke.clear();
+     if (0==*p) break;
+     continue;
+    }
+    int gx = p[0] - '0', gy = p[1] - '0' - 2;
+    stroke.append(CPoint(cx + gx*scale,y0 + gy*scale));
+    p++;
+   }
+  }
+ }
+ QWriteLocker locker(&m_Lock);
+ if (m_Cache.size() >= m_CacheLimit) m_Cache.clear();
+ m_Cache.insert(key,result);
+ return result;
+}
+
+void CVectorFont::strokes(const QString& text, const TCoord x, const TCoord y, const TDimension size,
+                          const int ratio, const double rotation, const bool mirror, const bool spin,
+                          const CText::Align align, const int distance, CTextGeometry& result)
+{
+ // upside down texts are turned by half a turn around the opposite corner
+ double r = fmod(rotation,360.0);
+ if (r < 0.0) r += 360.0;
+ CText::Align a = align;
+ if (!spin && r > 90.0 && r <= 270.0)
+ {
+  r -= 180.0;
+  a = (CText::Align)(CText::taTopRight - align);
+ }
+ result = layout(text,size,ratio,a,distance);
+ result.map(CTransform(x,y,r,mirror));
+}
+
+void CVectorFont::strokes(CText& text, CTextGeometry& result)
+{
+ strokes(text.text(),text.x(),text.y(),text.size(),text.ratio(),text.rotation(),text.reflection(),
+         text.spin(),text.align(),text.distance(),result);
+}
+
+void CVectorFont::strokes(CText& text, const CTransform& transform, const QString& name, const QString& value,
+                          CTextGeometry& result)
+{
+ QString s = (name.isNull() && value.isNull()) ? text.text() : placeholder(text.text(),name,value);
+ CPoint p = transform.map(CPoint(text.x(),text.y()));
+ strokes(s,p.x(),p.y(),text.size(),text.ratio(),transform.mapAngle(text.rotation()),
+         text.reflection()!=transform.mirror(),text.spin(),text.align(),text.distance(),result);
+}
+
+void CVectorFont::strokes(CAttribute& attribute, const QString& value, CTextGeometry& result)
+{
+ QString s = value;
+ if (CAttribute::adName==attribute.display()) s = attribute.name();
+ else if (CAttribute::adBoth==attribute.display()) s = attribute.name() + " = " + value;
+ else if (CAttribute::adOff==attribute.display()) s.clear();
+ strokes(s,attribute.x(),attribute.y(),attribute.size(),attribute.ratio(),attribute.rotation(),
+         attribute.reflection(),attribute.spin(),attribute.align(),CText::DEFAULT_DISTANCE,result);
+}
+
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEFONT_H
+#define QEAGLEFONT_H
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements stroking of texts with a vector font
+*/
+
+namespace Eagle
+{
+
+// centerlines of a stroked text, all strokes share one width; stroke i
+// consists of points first(i)..first(i)+count(i)-1, a single point is a dot
+class CTextGeometry
+{
+ friend class CVectorFont;
+ public:
+  CTextGeometry(const CTextGeometry& geometry);
+  CTextGeometry(void);
+  virtual ~CTextGeometry(void);
+ public:
+  void operator =(const CTextGeometry& geometry);
+  void clear(void);
+  void assign(const CTextGeometry& geometry);
+  void map(const CTransform& transform);
+  const CPoint& point(const int stroke, const int index) const { return m_Points.at(m_First.at(stroke)+index); }
+ public:
+  // getters
+  int strokeCount(void) const { return m_First.isEmpty() ? 0 : m_First.size()-1; }
+  int first(const int stroke) const { return m_First.at(stroke); }
+  int count(const int stroke) const { return m_First.at(stroke+1) - m_First.at(stroke); }
+  const QVector<CPoint>& points(void) const { return m_Points; }
+  TDimension width(void) const { return m_Width; }
+  // of the strokes grown by half their width
+  const CBoundingBox& boundingBox(void) const { return m_BoundingBox; }
+ protected:
+  void addStroke(const QVector<CPoint>& points);
+ protected:
+  QVector<CPoint> m_Points;
+  QVector<int> m_First; // stroke count + 1 entries
+  TDimension m_Width;
+  CBoundingBox m_BoundingBox;
+};
+
+// Eagle's vector font approximated by a stroke font on a 4 x 6 grid: size is
+// the height of capitals including the stroke, ratio the stroke width in
+// percent of it, lines are distance percent of the size apart. Texts turned
+// upside down are kept readable unless they spin, as Eagle does. Layouts at
+// the origin are cached by string, size, ratio, alignment and distance and
+// only placed per call, so repeating names and values are laid out once;
+// the cache is shared safely by parallel jobs
+class CVectorFont
+{
+ public:
+  CVectorFont(void);
+  virtual ~CVectorFont(void);
+ public:
+  // >NAME, >PART and >VALUE of symbols and packages, smashed parts draw
+  // their attributes instead
+  static bool isPartPlaceholder(const QString& text);
+  static QString placeholder(const QString& text, const QString& name, const QString& value);
+  // NAME and VALUE attributes take theirs from the part
+  static QString attributeValue(CAttribute& attribute, const QString& name, const QString& value);
+ public:
+  void clear(void);
+  CTextGeometry layout(const QString& text, const TDimension size, const int ratio,
+                       const CText::Align align = CText::DEFAULT_ALIGN, const int distance = CText::DEFAULT_DISTANCE);
+  void strokes(const QString& text, const TCoord x, const TCoord y, const TDimension size, const int ratio,
+               const double rotation, const bool mirror, const bool spin, const CText::Align align,
+               const int distance, CTextGeometry& result);
+  void strokes(CText& text, CTextGeometry& result);
+  // text of a package or symbol placed by the transform, placeholders are
+  // replaced by name and value unless both are null
+  void strokes(CText& text, const CTransform& transform, const QString& name, const QString& value,
+               CTextGeometry& result);
+  // attribute of a smashed part, value shown as its display asks
+  void strokes(CAttribute& attribute, const QString& value, CTextGeometry& result);
+  int cacheSize(void);
+ public:
+  // getters
+  int cacheLimit(void) const { return m_CacheLimit; }
+  // setters
+  void setCacheLimit(const int value) { m_CacheLimit = value; }
+ protected:
+  QReadWriteLock m_Lock;
+  QHash<QString,CTextGeometry> m_Cache;
+  int m_CacheLimit; // default = 10000 layouts, the cache is emptied when exceeded
+};
+
+}
+
+#endif // QEAGLEFONT_H
+//------------------------------------------------------------------------------
@@ -0,0 +1,1383 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <QAtomicInt>
+#include <QHash>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+//------------------------------------------------------------------------------
+#include "QEagleGeometry.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+class CParallelRunner: public QRunnable
+{
+ public:
+  CParallelRunner(CParallelJob& job, QAtomicInt& next, const int count, QSemaphore& done):
+   m_Job(job), m_Next(next), m_Count(count), m_Done(done) {}
+  virtual ~CParallelRunner(void) {}
+ public:
+  virtual void run(void)
+  {
+   int index = m_Next.fetchAndAddOrdered(1);
+   while (index < m_Count)
+   {
+    m_Job.execute(index);
+    index = m_Next.fetchAndAddOrdered(1);
+   }
+   m_Done.release();
+  }
+ protected:
+  CParallelJob& m_Job;
+  QAtomicInt& m_Next;
+  int m_Count;
+  QSemaphore& m_Done;
+};
+
+void parallelFor(const int count, CParallelJob& job, const int threads)
+{
+ int n = (threads > 0) ? threads : QThread::idealThreadCount();
+ n = std::min(n,count);
+ if (n <= 1)
+ {
+  for (int i = 0; i < count; i++)
+  {
+   job.execute(i);
+  }
+  return;
+ }
+ QAtomicInt next(0);
+ QSemaphore done(0);
+ int started = 0;
+ for (int i = 1; i < n; i++)
+ {
+  CParallelRunner *r = new CParallelRunner(job,next,count,done);
+  r->setAutoDelete(true);
+  if (!QThreadPool::globalInstance()->tryStart(r))
+  {
+   // pool is saturated (e.g. nested call), the caller does the rest
+   delete r;
+   break;
+  }
+  started++;
+ }
+ CParallelRunner self(job,next,count,done);
+ self.run();
+ done.acquire(started+1);
+}
+
+//------------------------------------------------------------------------------
+
+CTransform::CTransform(const TCoord dx, const TCoord dy, const double rotation, const bool mirror)
+{
+ assign(dx,dy,rotation,mirror);
+}
+
+CTransform::CTransform(CElement& element)
+{
+ assign(element.x(),element.y(),element.rotation(),element.reflection());
+}
+
+CTransform::CTransform(const CTransform& transform)
+{
+ assign(transform);
+}
+
+CTransform::CTransform(void)
+{
+ clear();
+}
+
+CTransform::~CTransform(void)
+{
+ //
+}
+
+void CTransform::operator =(const CTransform& transform)
+{
+ assign(transform);
+}
+
+void CTransform::clear(void)
+{
+ assign(0.0,0.0,0.0,false);
+}
+
+void CTransform::assign(const CTransform& transform)
+{
+ m_DX = transform.m_DX;
+ m_DY = transform.m_DY;
+ m_Rotation = transform.m_Rotation;
+ m_Mirror = transform.m_Mirror;
+ m_Cos = transform.m_Cos;
+ m_Sin = transform.m_Sin;
+}
+
+void CTransform::assign(const TCoord dx, const TCoord dy, const double rotation, const bool mirror)
+{
+ m_DX = dx;
+ m_DY = dy;
+ m_Rotation = rotation;
+ m_Mirror = mirror;
+ // keep right angles exact, these are by far the most common
+ if (0.0==rotation) { m_Cos = 1.0; m_Sin = 0.0; }
+ else if (90.0==rotation) { m_Cos = 0.0; m_Sin = 1.0; }
+ else if (180.0==rotation) { m_Cos = -1.0; m_Sin = 0.0; }
+ else if (270.0==rotation) { m_Cos = 0.0; m_Sin = -1.0; }
+ else
+ {
+  m_Cos = cos(degtorad(rotation));
+  m_Sin = sin(degtorad(rotation));
+ }
+}
+
+void CTransform::map(const TCoord x, const TCoord y, TCoord& rx, TCoord& ry) const
+{
+ TCoord mx = m_Mirror ? -x : x;
+ rx = m_DX + mx*m_Cos - y*m_Sin;
+ ry = m_DY + mx*m_Sin + y*m_Cos;
+}
+
+CPoint CTransform::map(const CPoint& point) const
+{
+ TCoord x, y;
+ map(point.x(),point.y(),x,y);
+ return CPoint(x,y);
+}
+
+double CTransform::mapAngle(const double angle) const
+{
+ double result = (m_Mirror ? 180.0-angle : angle) + m_Rotation;
+ result = fmod(result,360.0);
+ if (result < 0.0) result += 360.0;
+ return result;
+}
+
+//------------------------------------------------------------------------------
+
+static inline double cross(const CPoint& o, const CPoint& a, const CPoint& b)
+{
+ return (a.x()-o.x())*(b.y()-o.y()) - (a.y()-o.y())*(b.x()-o.x());
+}
+
+static double pointToSegment(const CPoint& p, const CPoint& a, const CPoint& b, CPoint& closest)
+{
+ double dx = b.x()-a.x();
+ double dy = b.y()-a.y();
+ double l2 = dx*dx + dy*dy;
+ double t = 0.0;
+ if (l2 > 0.0)
+ {
+  t = ((p.x()-a.x())*dx + (p.y()-a.y())*dy)/l2;
+  t = std::min(std::max(t,0.0),1.0);
+ }
+ closest = CPoint(a.x()+t*dx,a.y()+t*dy);
+ return hypot(p.x()-closest.x(),p.y()-closest.y());
+}
+
+static bool segmentsCross(const CPoint& a1, const CPoint& a2, const CPoint& b1, const CPoint& b2)
+{
+ double d1 = cross(b1,b2,a1);
+ double d2 = cross(b1,b2,a2);
+ double d3 = cross(a1,a2,b1);
+ double d4 = cross(a1,a2,b2);
+ return ((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) &&
+        ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0));
+}
+
+// distance between two segments, pa/pb receive the closest points
+static double segmentToSegment(const CPoint& a1, const CPoint& a2,
+                               const CPoint& b1, const CPoint& b2,
+                               CPoint& pa, CPoint& pb)
+{
+ if (segmentsCross(a1,a2,b1,b2))
+ {
+  // any point will do, the segments intersect
+  pa = pb = CPoint(0.5*(a1.x()+a2.x()),0.5*(a1.y()+a2.y()));
+  return 0.0;
+ }
+ CPoint c;
+ double result = pointToSegment(a1,b1,b2,c); pa = a1; pb = c;
+ double d = pointToSegment(a2,b1,b2,c);
+ if (d < result) { result = d; pa = a2; pb = c; }
+ d = pointToSegment(b1,a1,a2,c);
+ if (d < result) { result = d; pa = c; pb = b1; }
+ d = pointToSegment(b2,a1,a2,c);
+ if (d < result) { result = d; pa = c; pb = b2; }
+ return result;
+}
+
+CShape::CShape(const CShape& shape)
+{
+ assign(shape);
+}
+
+CShape::CShape(void)
+{
+ clear();
+}
+
+CShape::~CShape(void)
+{
+ //
+}
+
+void CShape::operator =(const CShape& shape)
+{
+ assign(shape);
+}
+
+void CShape::clear(void)
+{
+ m_Count = 0;
+ m_Radius = 0.0;
+ m_BoundingBox.clear();
+}
+
+void CShape::assign(const CShape& shape)
+{
+ m_Count = shape.m_Count;
+ for (int i = 0; i < m_Count; i++)
+ {
+  m_Vertices[i] = shape.m_Vertices[i];
+ }
+ m_Radius = shape.m_Radius;
+ m_BoundingBox = shape.m_BoundingBox;
+}
+
+void CShape::setCircle(const TCoord x, const TCoord y, const TDimension radius)
+{
+ m_Count = 1;
+ m_Vertices[0] = CPoint(x,y);
+ m_Radius = radius;
+ update();
+}
+
+void CShape::setSegment(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+ const TDimension radius)
+{
+ m_Count = 2;
+ m_Vertices[0] = CPoint(x1,y1);
+ m_Vertices[1] = CPoint(x2,y2);
+ m_Radius = radius;
+ update();
+}
+
+void CShape::setRectangle(const TCoord x, const TCoord y, const TDimension dx, const TDimension dy,
+ const double rotation, const TDimension radius)
+{
+ // the core is the rectangle shrunk by the corner radius
+ double r = std::min(radius,0.5*std::min(dx,dy));
+ double hx = std::max(0.5*dx-r,0.0);
+ double hy = std::max(0.5*dy-r,0.0);
+ double c = cos(degtorad(rotation));
+ double s = sin(degtorad(rotation));
+ const double px[4] = {-hx, hx, hx, -hx};
+ const double py[4] = {-hy, -hy, hy, hy};
+ // fully rounded rectangles degrade to a segment or a point
+ if (0.0==hx || 0.0==hy)
+ {
+  setSegment(x - hx*c + hy*s, y - hx*s - hy*c, x + hx*c - hy*s, y + hx*s + hy*c, r);
+  return;
+ }
+ m_Count = 4;
+ for (int i = 0; i < 4; i++)
+ {
+  m_Vertices[i] = CPoint(x + px[i]*c - py[i]*s, y + px[i]*s + py[i]*c);
+ }
+ m_Radius = r;
+ update();
+}
+
+void CShape::setOctagon(const TCoord x, const TCoord y, const TDimension diameter,
+ const double rotation)
+{
+ // regular octagon with the given distance between opposite edges
+ double r = 0.5*diameter/cos(M_PI/8.0);
+ m_Count = 8;
+ for (int i = 0; i < 8; i++)
+ {
+  double a = degtorad(rotation + 22.5 + 45.0*i);
+  m_Vertices[i] = CPoint(x + r*cos(a), y + r*sin(a));
+ }
+ m_Radius = 0.0;
+ update();
+}
+
+void CShape::update(void)
+{
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Count; i++)
+ {
+  m_BoundingBox.include(m_Vertices[i].x(),m_Vertices[i].y(),m_Radius);
+ }
+}
+
+bool CShape::contains(const TCoord x, const TCoord y) const
+{
+ CPoint p(x,y);
+ if (m_Count >= 3)
+ {
+  bool inside = true;
+  for (int i = 0; i < m_Count && inside; i++)
+  {
+   inside = cross(m_Vertices[i],m_Vertices[(i+1)%m_Count],p) >= 0.0;
+  }
+  if (inside) return true;
+ }
+ CPoint c;
+ for (int i = 0; i < m_Count; i++)
+ {
+  const CPoint& b = m_Vertices[(m_Count > 1) ? (i+1)%m_Count : i];
+  if (pointToSegment(p,m_Vertices[i],b,c) <= m_Radius) return true;
+ }
+ return false;
+}
+
+TDimension CShape::distance(const CShape& shape, CPoint *location) const
+{
+ if (0==m_Count || 0==shape.m_Count) return 0.0;
+ // a vertex of one core lying inside the other core means overlap
+ const CShape *polygons[2] = {this, &shape};
+ for (int k = 0; k < 2; k++)
+ {
+  const CShape *a = polygons[k];
+  const CShape *b = polygons[1-k];
+  if (a->m_Count < 3) continue;
+  for (int j = 0; j < b->m_Count; j++)
+  {
+   bool inside = true;
+   for (int i = 0; i < a->m_Count && inside; i++)
+   {
+    inside = cross(a->m_Vertices[i],a->m_Vertices[(i+1)%a->m_Count],b->m_Vertices[j]) >= 0.0;
+   }
+   if (inside)
+   {
+    if (0!=location) *location = b->m_Vertices[j];
+    return -(m_Radius + shape.m_Radius);
+   }
+  }
+ }
+ int na = (m_Count > 2) ? m_Count : 1;
+ int nb = (shape.m_Count > 2) ? shape.m_Count : 1;
+ double result = -1.0;
+ CPoint best_a, best_b;
+ for (int i = 0; i < na; i++)
+ {
+  const CPoint& a1 = m_Vertices[i];
+  const CPoint& a2 = m_Vertices[(m_Count > 1) ? (i+1)%m_Count : i];
+  for (int j = 0; j < nb; j++)
+  {
+   const CPoint& b1 = shape.m_Vertices[j];
+   const CPoint& b2 = shape.m_Vertices[(shape.m_Count > 1) ? (j+1)%shape.m_Count : j];
+   CPoint pa, pb;
+   double d = segmentToSegment(a1,a2,b1,b2,pa,pb);
+   if (result < 0.0 || d < result)
+   {
+    result = d;
+    best_a = pa;
+    best_b = pb;
+   }
+  }
+ }
+ if (0!=location)
+ {
+  *location = CPoint(0.5*(best_a.x()+best_b.x()),0.5*(best_a.y()+best_b.y()));
+ }
+ return result - m_Radius - shape.m_Radius;
+}
+
+//------------------------------------------------------------------------------
+
+CSpatialIndex::CSpatialIndex(const CBoundingBox& extent, const TDimension cellSize)
+{
+ reset(extent,cellSize);
+}
+
+CSpatialIndex::CSpatialIndex(void)
+{
+ clear();
+}
+
+CSpatialIndex::~CSpatialIndex(void)
+{
+ clear();
+}
+
+void CSpatialIndex::clear(void)
+{
+ m_Extent.clear();
+ m_CellSize = 1.0;
+ m_Columns = 0;
+ m_Rows = 0;
+ m_Cells.clear();
+}
+
+void CSpatialIndex::reset(const CBoundingBox& extent, const TDimension cellSize)
+{
+ clear();
+ m_Extent = extent;
+ m_CellSize = (cellSize > 0.0) ? cellSize : 1.0;
+ if (extent.isValid())
+ {
+  m_Columns = std::max(1,(int)ceil(extent.width()/m_CellSize));
+  m_Rows = std::max(1,(int)ceil(extent.height()/m_CellSize));
+  m_Cells.resize(m_Columns*m_Rows);
+ }
+}
+
+void CSpatialIndex::cellRange(const CBoundingBox& box, int& c1, int& r1, int& c2, int& r2) const
+{
+ c1 = (int)floor((box.left()-m_Extent.left())/m_CellSize);
+ r1 = (int)floor((box.bottom()-m_Extent.bottom())/m_CellSize);
+ c2 = (int)floor((box.right()-m_Extent.left())/m_CellSize);
+ r2 = (int)floor((box.top()-m_Extent.bottom())/m_CellSize);
+ c1 = std::min(std::max(c1,0),m_Columns-1);
+ r1 = std::min(std::max(r1,0),m_Rows-1);
+ c2 = std::min(std::max(c2,0),m_Columns-1);
+ r2 = std::min(std::max(r2,0),m_Rows-1);
+}
+
+void CSpatialIndex::cell(const TCoord x, const TCoord y, int& column, int& row) const
+{
+ int c2, r2;
+ cellRange(CBoundingBox(x,y,x,y),column,row,c2,r2);
+}
+
+void CSpatialIndex::insert(const int id, const CBoundingBox& box)
+{
+ if (m_Cells.isEmpty() || !box.isValid()) return;
+ int c1, r1, c2, r2;
+ cellRange(box,c1,r1,c2,r2);
+ for (int r = r1; r <= r2; r++)
+ {
+  for (int c = c1; c <= c2; c++)
+  {
+   m_Cells[r*m_Columns+c].append(id);
+  }
+ }
+}
+
+void CSpatialIndex::query(const CBoundingBox& box, QVector<int>& result) const
+{
+ result.clear();
+ if (m_Cells.isEmpty() || !box.intersects(m_Extent)) return;
+ int c1, r1, c2, r2;
+ cellRange(box,c1,r1,c2,r2);
+ for (int r = r1; r <= r2; r++)
+ {
+  for (int c = c1; c <= c2; c++)
+  {
+   result += m_Cells.at(r*m_Columns+c);
+  }
+ }
+ // items spanning several cells are reported once
+ std::sort(result.begin(),result.end());
+ result.erase(std::unique(result.begin(),result.end()),result.end());
+}
+
+//------------------------------------------------------------------------------
+
+CPadInstance::CPadInstance(void)
+{
+ m_Kind = CPadInstance::pkPad;
+ m_X = 0.0;
+ m_Y = 0.0;
+ m_Rotation = 0.0;
+ m_Layer = CLayer::LAYER__INVALID;
+ m_DX = 0.0;
+ m_DY = 0.0;
+ m_Drill = 0.0;
+ m_Shape = CPad::psRound;
+ m_Roundness = 0;
+ m_Element = -1;
+ m_Signal = -1;
+ m_Pad = 0;
+ m_SMD = 0;
+}
+
+void CPadInstance::assign(CPad& pad, const CTransform& transform)
+{
+ transform.map(pad.x(),pad.y(),m_X,m_Y);
+ m_Kind = CPadInstance::pkPad;
+ m_Rotation = transform.mapAngle(pad.rotation());
+ m_Layer = CLayer::LAYER_PADS;
+ m_DX = m_DY = pad.diameter();
+ m_Drill = pad.drill();
+ m_Shape = pad.shape();
+ m_Pad = &pad;
+ m_SMD = 0;
+}
+
+void CPadInstance::assign(CSMD& smd, const CTransform& transform)
+{
+ transform.map(smd.x(),smd.y(),m_X,m_Y);
+ m_Kind = CPadInstance::pkSMD;
+ m_Rotation = transform.mapAngle(smd.rotation());
+ m_Layer = transform.mapLayer(smd.layer());
+ m_DX = smd.dx();
+ m_DY = smd.dy();
+ m_Drill = 0.0;
+ m_Roundness = smd.roundness();
+ m_Pad = 0;
+ m_SMD = &smd;
+}
+
+QString CPadInstance::name(void) const
+{
+ if (0!=m_Pad) return m_Pad->name();
+ if (0!=m_SMD) return m_SMD->name();
+ return QString();
+}
+
+class CPadResolverJob: public CParallelJob
+{
+ public:
+  CPadResolverJob(CBoard& board, const QVector<CPackage*>& packages, const QVector<int>& first,
+                  const QHash<QString,int> *nets, const QVector<int> *elements, QVector<CPadInstance>& pads):
+   m_Board(board), m_Packages(packages), m_First(first), m_Nets(nets), m_Elements(elements), m_Pads(pads) {}
+  virtual void execute(const int index)
+  {
+   int element = (0!=m_Elements) ? m_Elements->at(index) : index;
+   CElement *e = m_Board.elements().at(element);
+   CPackage *p = m_Packages.at(element);
+   if (0==p) return;
+   CTransform t(*e);
+   QString prefix = e->name() + QChar(0);
+   CPadInstance *r = m_Pads.data() + m_First.at(element);
+   for (int i = 0; i < p->pads().size(); i++, r++)
+   {
+    CPad *pad = p->pads().at(i);
+    r->assign(*pad,t);
+    r->m_Element = element;
+    if (0!=m_Nets) r->m_Signal = m_Nets->value(prefix + pad->name(),-1);
+   }
+   for (int i = 0; i < p->smds().size(); i++, r++)
+   {
+    CSMD *smd = p->smds().at(i);
+    r->assign(*smd,t);
+    r->m_Element = element;
+    if (0!=m_Nets) r->m_Signal = m_Nets->value(prefix + smd->name(),-1);
+   }
+  }
+ protected:
+  CBoard& m_Board;
+  const QVector<CPackage*>& m_Packages;
+  const QVector<int>& m_First;
+  const QHash<QString,int> *m_Nets; // 0 keeps the signals of the pads
+  const QVector<int> *m_Elements; // 0 for every element
+  QVector<CPadInstance>& m_Pads;
+};
+
+CPadResolver::CPadResolver(void)
+{
+ clear();
+}
+
+CPadResolver::~CPadResolver(void)
+{
+ clear();
+}
+
+void CPadResolver::clear(void)
+{
+ m_Board = 0;
+ m_Revision = 0;
+ m_Pads.clear();
+ m_Packages.clear();
+ m_First.clear();
+ m_ElementIndex.clear();
+}
+
+const QVector<CPadInstance>& CPadResolver::resolve(CBoard& board, const int threads)
+{
+ if (&board==m_Board && board.revision()==m_Revision) return m_Pads;
+ clear();
+ m_Packages.resize(board.elements().size());
+ m_First.resize(board.elements().size()+1);
+ int count = 0;
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CElement *e = board.elements().at(i);
+  CPackage *p = board.findPackage(e->library(),e->package());
+  m_Packages[i] = p;
+  m_First[i] = count;
+  m_ElementIndex.insert(e->name(),i);
+  if (0!=p) count += p->pads().size() + p->smds().size();
+ }
+ m_First[board.elements().size()] = count;
+ QHash<QString,int> nets;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  for (int j = 0; j < s->contactRefs().size(); j++)
+  {
+   CContactRef *r = s->contactRefs().at(j);
+   nets.insert(r->element() + QChar(0) + r->pad(),i);
+  }
+ }
+ m_Pads.resize(count);
+ CPadResolverJob job(board,m_Packages,m_First,&nets,0,m_Pads);
+ parallelFor(board.elements().size(),job,threads);
+ m_Board = &board;
+ m_Revision = board.revision();
+ return m_Pads;
+}
+
+const QVector<CPadInstance>& CPadResolver::update(CBoard& board, const QList<int>& elements,
+ const QList<int>& signalIndices, const int threads)
+{
+ if (&board!=m_Board || m_First.size()!=board.elements().size()+1) return resolve(board,threads);
+ QVector<int> moved;
+ for (int i = 0; i < elements.size(); i++)
+ {
+  int e = elements.at(i);
+  if (e < 0 || e >= board.elements().size()) continue;
+  // another package changes the layout of the pad table
+  CElement *element = board.elements().at(e);
+  if (board.findPackage(element->library(),element->package())!=m_Packages.at(e)) return resolve(board,threads);
+  moved.append(e);
+ }
+ // moved elements keep their connections
+ CPadResolverJob job(board,m_Packages,m_First,0,&moved,m_Pads);
+ parallelFor(moved.size(),job,threads);
+ QSet<int> changed;
+ for (int i = 0; i < signalIndices.size(); i++)
+ {
+  if (signalIndices.at(i) >= 0 && signalIndices.at(i) < board.signal().size()) changed.insert(signalIndices.at(i));
+ }
+ if (!changed.isEmpty())
+ {
+  for (int i = 0; i < m_Pads.size(); i++)
+  {
+   if (changed.contains(m_Pads.at(i).m_Signal)) m_Pads[i].m_Signal = -1;
+  }
+  for (QSet<int>::const_iterator it = changed.constBegin(); it != changed.constEnd(); ++it)
+  {
+   CSignal *s = board.signal().at(*it);
+   for (int j = 0; j < s->contactRefs().size(); j++)
+   {
+    CContactRef *r = s->contactRefs().at(j);
+    int e = m_ElementIndex.value(r->element(),-1);
+    if (e < 0) continue;
+    for (int k = first(e); k < first(e) + count(e); k++)
+    {
+     if (m_Pads.at(k).name()==r->pad()) { m_Pads[k].m_Signal = *it; break; }
+    }
+   }
+  }
+ }
+ m_Revision = board.revision();
+ return m_Pads;
+}
+
+//------------------------------------------------------------------------------
+
+CDisjointSet::CDisjointSet(const int count)
+{
+ reset(count);
+}
+
+CDisjointSet::CDisjointSet(void)
+{
+ clear();
+}
+
+CDisjointSet::~CDisjointSet(void)
+{
+ clear();
+}
+
+void CDisjointSet::clear(void)
+{
+ m_Parent.clear();
+ m_Size.clear();
+ m_Sets = 0;
+}
+
+void CDisjointSet::reset(const int count)
+{
+ m_Parent.resize(count);
+ m_Size.fill(1,count);
+ for (int i = 0; i < count; i++)
+ {
+  m_Parent[i] = i;
+ }
+ m_Sets = count;
+}
+
+int CDisjointSet::find(const int index)
+{
+ int i = index;
+ while (m_Parent.at(i)!=i)
+ {
+  m_Parent[i] = m_Parent.at(m_Parent.at(i));
+  i = m_Parent.at(i);
+ }
+ return i;
+}
+
+bool CDisjointSet::unite(const int a, const int b)
+{
+ int ra = find(a);
+ int rb = find(b);
+ if (ra==rb) return false;
+ if (m_Size.at(ra) < m_Size.at(rb)) std::swap(ra,rb);
+ m_Parent[rb] = ra;
+ m_Size[ra] += m_Size.at(rb);
+ m_Sets--;
+ return true;
+}
+
+//------------------------------------------------------------------------------
+
+CPadRules::CPadRules(CDesignRule& designRules)
+{
+ assign(designRules);
+}
+
+CPadRules::CPadRules(void)
+{
+ clear();
+}
+
+CPadRules::~CPadRules(void)
+{
+ //
+}
+
+void CPadRules::clear(void)
+{
+ // Eagle defaults
+ CDesignRuleValues none;
+ assign(none);
+}
+
+void CPadRules::assign(CDesignRule& designRules)
+{
+ assign(designRules.values());
+}
+
+void CPadRules::assign(const CDesignRuleValues& rules)
+{
+ const double mil = 0.0254;
+ m_PadRatio[0] = rules.number("rvPadTop",0.25);
+ m_PadRatio[1] = rules.number("rvPadInner",0.25);
+ m_PadRatio[2] = rules.number("rvPadBottom",0.25);
+ m_PadMin[0] = rules.dimension("rlMinPadTop",10*mil);
+ m_PadMin[1] = rules.dimension("rlMinPadInner",10*mil);
+ m_PadMin[2] = rules.dimension("rlMinPadBottom",10*mil);
+ m_PadMax[0] = rules.dimension("rlMaxPadTop",20*mil);
+ m_PadMax[1] = rules.dimension("rlMaxPadInner",20*mil);
+ m_PadMax[2] = rules.dimension("rlMaxPadBottom",20*mil);
+ m_ViaRatio[0] = rules.number("rvViaOuter",0.25);
+ m_ViaRatio[1] = rules.number("rvViaInner",0.25);
+ m_ViaMin[0] = rules.dimension("rlMinViaOuter",8*mil);
+ m_ViaMin[1] = rules.dimension("rlMinViaInner",8*mil);
+ m_ViaMax[0] = rules.dimension("rlMaxViaOuter",20*mil);
+ m_ViaMax[1] = rules.dimension("rlMaxViaInner",20*mil);
+ m_ElongationLong = rules.number("psElongationLong",100.0);
+ m_ElongationOffset = rules.number("psElongationOffset",100.0);
+ m_StopRatio = rules.number("mvStopFrame",1.0);
+ m_StopMin = rules.dimension("mlMinStopFrame",4*mil);
+ m_StopMax = rules.dimension("mlMaxStopFrame",4*mil);
+ m_CreamRatio = rules.number("mvCreamFrame",0.0);
+ m_CreamMin = rules.dimension("mlMinCreamFrame",0.0);
+ m_CreamMax = rules.dimension("mlMaxCreamFrame",0.0);
+ m_ViaStopLimit = rules.dimension("mlViaStopLimit",0.0);
+ // "(1*16)", "(1+2*15+16)", ... list the copper layers in use
+ m_Layers.clear();
+ QString setup = rules.text("layerSetup");
+ QString number;
+ for (int i = 0; i <= setup.length(); i++)
+ {
+  if (i < setup.length() && setup.at(i).isDigit())
+  {
+   number.append(setup.at(i));
+  }
+  else if (!number.isEmpty())
+  {
+   TLayer l = number.toInt();
+   if (CLayer::isCopper(l) && !m_Layers.contains(l)) m_Layers.append(l);
+   number.clear();
+  }
+ }
+ if (m_Layers.isEmpty())
+ {
+  m_Layers.append(CLayer::LAYER_TOP);
+  m_Layers.append(CLayer::LAYER_BOTTOM);
+ }
+}
+
+static int padSide(const TLayer layer)
+{
+ return (CLayer::LAYER_TOP==layer) ? 0 : ((CLayer::LAYER_BOTTOM==layer) ? 2 : 1);
+}
+
+TDimension CPadRules::padDiameter(const TDimension drill, const TDimension diameter, const TLayer layer) const
+{
+ int k = padSide(layer);
+ TDimension ring = std::min(std::max(drill*m_PadRatio[k],m_PadMin[k]),m_PadMax[k]);
+ return (diameter > 0.0) ? diameter : drill + 2.0*ring;
+}
+
+TDimension CPadRules::viaDiameter(const TDimension drill, const TDimension diameter, const TLayer layer) const
+{
+ int k = (1==padSide(layer)) ? 1 : 0;
+ TDimension ring = std::min(std::max(drill*m_ViaRatio[k],m_ViaMin[k]),m_ViaMax[k]);
+ return (diameter > 0.0) ? diameter : drill + 2.0*ring;
+}
+
+TDimension CPadRules::stopFrame(const TDimension size) const
+{
+ return std::min(std::max(size*m_StopRatio,m_StopMin),m_StopMax);
+}
+
+TDimension CPadRules::creamFrame(const TDimension size) const
+{
+ return std::min(std::max(size*m_CreamRatio,m_CreamMin),m_CreamMax);
+}
+
+bool CPadRules::viaStop(CVia& via) const
+{
+ return via.alwaysStop() || via.drill() > m_ViaStopLimit;
+}
+
+void CPadRules::padShape(const CPadInstance& pad, const TLayer layer, CShape& shape,
+                         const TDimension frame) const
+{
+ if (CPadInstance::pkSMD==pad.kind())
+ {
+  TDimension dx = std::max(pad.dx() + 2.0*frame,0.0), dy = std::max(pad.dy() + 2.0*frame,0.0);
+  shape.setRectangle(pad.x(),pad.y(),dx,dy,pad.rotation(),0.005*pad.roundness()*std::min(dx,dy));
+  return;
+ }
+ // stop and cream layers take the shape of the outer layer on their side
+ TLayer copper = layer;
+ if (CLayer::LAYER_TSTOP==layer || CLayer::LAYER_TCREAM==layer) copper = CLayer::LAYER_TOP;
+ if (CLayer::LAYER_BSTOP==layer || CLayer::LAYER_BCREAM==layer) copper = CLayer::LAYER_BOTTOM;
+ TDimension d = padDiameter(pad.drill(),pad.dx(),copper) + 2.0*frame;
+ bool outer = (CLayer::LAYER_TOP==copper || CLayer::LAYER_BOTTOM==copper);
+ CPad::Shape ps = outer ? pad.shape() : CPad::psRound;
+ if (CPad::psSquare==ps)
+ {
+  shape.setRectangle(pad.x(),pad.y(),d,d,pad.rotation());
+ }
+ else if (CPad::psOctagon==ps)
+ {
+  shape.setOctagon(pad.x(),pad.y(),d,pad.rotation());
+ }
+ else if (CPad::psLong==ps || CPad::psOffset==ps)
+ {
+  // the elongation is relative to the diameter without frame
+  double a = degtorad(pad.rotation());
+  TDimension e = (d - 2.0*frame)*((CPad::psLong==ps) ? m_ElongationLong : m_ElongationOffset)/100.0;
+  TDimension back = (CPad::psLong==ps) ? 0.5*e : 0.0;
+  TDimension ahead = (CPad::psLong==ps) ? 0.5*e : e;
+  shape.setSegment(pad.x() - back*cos(a),pad.y() - back*sin(a),
+                   pad.x() + ahead*cos(a),pad.y() + ahead*sin(a),0.5*d);
+ }
+ else
+ {
+  shape.setCircle(pad.x(),pad.y(),0.5*d);
+ }
+}
+
+void CPadRules::viaShape(CVia& via, const TLayer layer, CShape& shape, const TDimension frame) const
+{
+ TLayer copper = layer;
+ if (CLayer::LAYER_TSTOP==layer) copper = CLayer::LAYER_TOP;
+ if (CLayer::LAYER_BSTOP==layer) copper = CLayer::LAYER_BOTTOM;
+ TDimension d = viaDiameter(via.drill(),via.diameter(),copper) + 2.0*frame;
+ bool outer = (CLayer::LAYER_TOP==copper || CLayer::LAYER_BOTTOM==copper);
+ if (outer && CVia::vsSquare==via.shape()) shape.setRectangle(via.x(),via.y(),d,d,0.0);
+ else if (outer && CVia::vsOctagon==via.shape()) shape.setOctagon(via.x(),via.y(),d,0.0);
+ else shape.setCircle(via.x(),via.y(),0.5*d);
+}
+
+//------------------------------------------------------------------------------
+
+bool arcCenter(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+               const double curve, TCoord& x, TCoord& y)
+{
+ double c = sqrt((x2-x1)*(x2-x1) + (y2-y1)*(y2-y1));
+ if (0.0!=curve && c>0.0)
+ {
+  double d = 0.5*c/tan(0.5*degtorad(curve));
+  x = 0.5*(x1+x2) - d*(y2-y1)/c;
+  y = 0.5*(y1+y2) + d*(x2-x1)/c;
+  return true;
+ }
+ return false;
+}
+
+void flattenArc(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+                const double curve, const TDimension tolerance, QVector<CPoint>& points)
+{
+ points.clear();
+ TCoord cx, cy;
+ if (!arcCenter(x1,y1,x2,y2,curve,cx,cy))
+ {
+  points.append(CPoint(x1,y1));
+  points.append(CPoint(x2,y2));
+  return;
+ }
+ double r = sqrt((x1-cx)*(x1-cx) + (y1-cy)*(y1-cy));
+ double sweep = degtorad(curve);
+ double step = M_PI/2.0;
+ if (tolerance > 0.0 && tolerance < r)
+ {
+  step = 2.0*acos(1.0 - tolerance/r);
+ }
+ int n = std::min(std::max((int)ceil(fabs(sweep)/step),1),720);
+ double a0 = atan2(y1-cy,x1-cx);
+ points.reserve(n+1);
+ points.append(CPoint(x1,y1));
+ for (int i = 1; i < n; i++)
+ {
+  double a = a0 + sweep*i/n;
+  points.append(CPoint(cx + r*cos(a),cy + r*sin(a)));
+ }
+ points.append(CPoint(x2,y2));
+}
+
+void flattenWire(CWire& wire, const TDimension tolerance, QVector<CPoint>& points)
+{
+ flattenArc(wire.x1(),wire.y1(),wire.x2(),wire.y2(),wire.curve(),tolerance,points);
+}
+
+
+//------------------------------------------------------------------------------
+
+CContour::CContour(const CContour& contour)
+{
+ assign(contour);
+}
+
+CContour::CContour(void)
+{
+ clear();
+}
+
+CContour::~CContour(void)
+{
+ //
+}
+
+void CContour::operator =(const CContour& contour)
+{
+ assign(contour);
+}
+
+void CContour::clear(void)
+{
+ m_Vertices.clear();
+ m_Curves.clear();
+ m_Points.clear();
+ m_Lines.clear();
+ m_BoundingBox.clear();
+ m_Area = 0.0;
+ m_Cutout = false;
+}
+
+void CContour::assign(const CContour& contour)
+{
+ m_Vertices = contour.m_Vertices;
+ m_Curves = contour.m_Curves;
+ m_Points = contour.m_Points;
+ m_Lines = contour.m_Lines;
+ m_BoundingBox = contour.m_BoundingBox;
+ m_Area = contour.m_Area;
+ m_Cutout = contour.m_Cutout;
+}
+
+void CContour::append(const TCoord x, const TCoord y, const double curve)
+{
+ m_Vertices.append(CPoint(x,y));
+ m_Curves.append(curve);
+}
+
+void CContour::reverse(void)
+{
+ // line k of the reversed contour is line n-2-k run backwards
+ int n = m_Vertices.size();
+ QVector<CPoint> vertices(n);
+ QVector<double> curves(n);
+ for (int k = 0; k < n; k++)
+ {
+  vertices[k] = m_Vertices.at(n-1-k);
+  curves[k] = -m_Curves.at((2*n-2-k) % n);
+ }
+ m_Vertices = vertices;
+ m_Curves = curves;
+ // flattened data is made again by flatten()
+ m_Points.clear();
+ m_Lines.clear();
+ m_BoundingBox.clear();
+ m_Area = 0.0;
+}
+
+void CContour::flatten(const TDimension tolerance)
+{
+ m_Points.clear();
+ m_Lines.clear();
+ m_BoundingBox.clear();
+ m_Area = 0.0;
+ int n = m_Vertices.size();
+ if (0==n) return;
+ QVector<CPoint> points;
+ for (int i = 0; i < n; i++)
+ {
+  const CPoint& a = m_Vertices.at(i);
+  const CPoint& b = m_Vertices.at((i+1) % n);
+  flattenArc(a.x(),a.y(),b.x(),b.y(),m_Curves.at(i),tolerance,points);
+  for (int j = 0; j+1 < points.size(); j++)
+  {
+   m_Points.append(points.at(j));
+   m_Lines.append(i);
+  }
+ }
+ m_Points.append(m_Vertices.first());
+ for (int i = 0; i+1 < m_Points.size(); i++)
+ {
+  const CPoint& a = m_Points.at(i);
+  const CPoint& b = m_Points.at(i+1);
+  m_Area += 0.5*(a.x()*b.y() - b.x()*a.y());
+  m_BoundingBox.include(a.x(),a.y());
+ }
+}
+
+bool CContour::contains(const TCoord x, const TCoord y) const
+{
+ if (!m_BoundingBox.contains(x,y)) return false;
+ bool inside = false;
+ for (int i = 0; i+1 < m_Points.size(); i++)
+ {
+  const CPoint& a = m_Points.at(i);
+  const CPoint& b = m_Points.at(i+1);
+  if ((a.y() > y)!=(b.y() > y) && x < a.x() + (y-a.y())*(b.x()-a.x())/(b.y()-a.y())) inside = !inside;
+ }
+ return inside;
+}
+
+//------------------------------------------------------------------------------
+
+CBoardOutline::CBoardOutline(void)
+{
+ m_Tolerance = 0.01;
+ clear();
+}
+
+CBoardOutline::~CBoardOutline(void)
+{
+ clear();
+}
+
+void CBoardOutline::clear(void)
+{
+ m_Board = 0;
+ m_Revision = 0;
+ m_Contours.clear();
+ m_OpenCount = 0;
+ m_BoundingBox.clear();
+ m_Edges.clear();
+ m_Index.clear();
+}
+
+int CBoardOutline::build(CBoard& board)
+{
+ if (&board==m_Board && board.revision()==m_Revision) return m_Contours.size();
+ clear();
+ // dimension lines of the board and of placed packages, circles,
+ // rectangles and polygons are closed by themselves
+ QVector<CPoint> starts, ends;
+ QVector<double> curves;
+ for (int i = -1; i < board.elements().size(); i++)
+ {
+  QList<CWire*> *wires = &board.plain().wires();
+  QList<CCircle*> *circles = &board.plain().circles();
+  QList<CRectangle*> *rectangles = &board.plain().rectangles();
+  QList<CPolygon*> *polygons = &board.plain().polygons();
+  CTransform t;
+  if (i >= 0)
+  {
+   CElement *e = board.elements().at(i);
+   CPackage *p = board.findPackage(e->library(),e->package());
+   if (0==p) continue;
+   wires = &p->wires();
+   circles = &p->circles();
+   rectangles = &p->rectangles();
+   polygons = &p->polygons();
+   t = CTransform(*e);
+  }
+  for (int j = 0; j < wires->size(); j++)
+  {
+   CWire *w = wires->at(j);
+   if (CLayer::LAYER_DIMENSION!=t.mapLayer(w->layer())) continue;
+   CPoint a = t.map(CPoint(w->x1(),w->y1())), b = t.map(CPoint(w->x2(),w->y2()));
+   if (a==b) continue;
+   starts.append(a);
+   ends.append(b);
+   curves.append(t.mapCurve(w->curve()));
+  }
+  for (int j = 0; j < circles->size(); j++)
+  {
+   CCircle *c = circles->at(j);
+   if (CLayer::LAYER_DIMENSION!=t.mapLayer(c->layer()) || c->radius() <= 0.0) continue;
+   CPoint o = t.map(CPoint(c->x(),c->y()));
+   CContour contour;
+   contour.append(o.x()+c->radius(),o.y(),180.0);
+   contour.append(o.x()-c->radius(),o.y(),180.0);
+   m_Contours.append(contour);
+  }
+  for (int j = 0; j < rectangles->size(); j++)
+  {
+   CRectangle *r = rectangles->at(j);
+   if (CLayer::LAYER_DIMENSION!=t.mapLayer(r->layer())) continue;
+   TCoord cx = 0.5*(r->x1()+r->x2()), cy = 0.5*(r->y1()+r->y2());
+   TCoord hx = 0.5*fabs(r->x2()-r->x1()), hy = 0.5*fabs(r->y2()-r->y1());
+   if (hx <= 0.0 || hy <= 0.0) continue;
+   double a = degtorad(r->rotation()), c = cos(a), s = sin(a);
+   static const int corners[4][2] = {{-1,-1},{1,-1},{1,1},{-1,1}};
+   CContour contour;
+   for (int k = 0; k < 4; k++)
+   {
+    TCoord x = corners[k][0]*hx, y = corners[k][1]*hy;
+    CPoint p = t.map(CPoint(cx + x*c - y*s,cy + x*s + y*c));
+    contour.append(p.x(),p.y(),0.0);
+   }
+   m_Contours.append(contour);
+  }
+  // the vertices of a polygon are its outline, the curve of a vertex bends
+  // the edge to the next one
+  for (int j = 0; j < polygons->size(); j++)
+  {
+   CPolygon *p = polygons->at(j);
+   if (CLayer::LAYER_DIMENSION!=t.mapLayer(p->layer()) || p->vertices().size() < 2) continue;
+   CContour contour;
+   for (int k = 0; k < p->vertices().size(); k++)
+   {
+    CVertex *v = p->vertices().at(k);
+    CPoint q = t.map(CPoint(v->x(),v->y()));
+    contour.append(q.x(),q.y(),t.mapCurve(v->curve()));
+   }
+   m_Contours.append(contour);
+  }
+ }
+ chain(starts,ends,curves);
+ classify();
+ index();
+ m_Board = &board;
+ m_Revision = board.revision();
+ return m_Contours.size();
+}
+
+static inline qint64 snapKey(const qint64 column, const qint64 row)
+{
+ return (column << 32) ^ (row & 0xFFFFFFFF);
+}
+
+void CBoardOutline::chain(QVector<CPoint>& starts, QVector<CPoint>& ends, QVector<double>& curves)
+{
+ // end points by snap cell, id 2*i is the start and 2*i+1 the end of line i
+ TDimension tolerance = (m_Tolerance > 0.0) ? m_Tolerance : 1e-6;
+ QHash<qint64,QVector<int> > cells;
+ for (int i = 0; i < starts.size(); i++)
+ {
+  for (int k = 0; k < 2; k++)
+  {
+   const CPoint& p = (0==k) ? starts.at(i) : ends.at(i);
+   cells[snapKey((qint64)floor(p.x()/tolerance),(qint64)floor(p.y()/tolerance))].append(2*i+k);
+  }
+ }
+ QVector<bool> used(starts.size(),false);
+ for (int i = 0; i < starts.size(); i++)
+ {
+  if (used.at(i)) continue;
+  used[i] = true;
+  CContour contour;
+  contour.append(starts.at(i).x(),starts.at(i).y(),curves.at(i));
+  const CPoint first = starts.at(i);
+  CPoint end = ends.at(i);
+  bool closed = false;
+  while (true)
+  {
+   if (contour.count() > 1 && hypot(end.x()-first.x(),end.y()-first.y()) <= tolerance)
+   {
+    closed = true;
+    break;
+   }
+   // an unused line ending in one of the neighbouring cells
+   qint64 column = (qint64)floor(end.x()/tolerance), row = (qint64)floor(end.y()/tolerance);
+   int next = -1;
+   for (int dc = -1; dc <= 1 && next < 0; dc++)
+   {
+    for (int dr = -1; dr <= 1 && next < 0; dr++)
+    {
+     QHash<qint64,QVector<int> >::const_iterator c = cells.constFind(snapKey(column+dc,row+dr));
+     if (c==cells.constEnd()) continue;
+     for (int j = 0; j < c.value().size() && next < 0; j++)
+     {
+      int id = c.value().at(j);
+      if (used.at(id/2)) continue;
+      const CPoint& p = (0==id%2) ? starts.at(id/2) : ends.at(id/2);
+      if (hypot(end.x()-p.x(),end.y()-p.y()) <= tolerance) next = id;
+     }
+    }
+   }
+   if (next < 0) break;
+   int j = next/2;
+   used[j] = true;
+   if (0==next%2)
+   {
+    contour.append(starts.at(j).x(),starts.at(j).y(),curves.at(j));
+    end = ends.at(j);
+   }
+   else
+   {
+    contour.append(ends.at(j).x(),ends.at(j).y(),-curves.at(j));
+    end = starts.at(j);
+   }
+  }
+  if (closed) m_Contours.append(contour);
+  else m_OpenCount++;
+ }
+}
+
+void CBoardOutline::classify(void)
+{
+ for (int i = 0; i < m_Contours.size(); i++)
+ {
+  m_Contours[i].flatten(m_Tolerance);
+ }
+ // nesting depth from the contours around the first point of each
+ QVector<bool> cutouts(m_Contours.size(),false);
+ for (int i = 0; i < m_Contours.size(); i++)
+ {
+  const CContour& c = m_Contours.at(i);
+  const CPoint& p = c.points().first();
+  int depth = 0;
+  for (int j = 0; j < m_Contours.size(); j++)
+  {
+   const CContour& o = m_Contours.at(j);
+   if (j==i || fabs(o.area()) <= fabs(c.area())) continue;
+   if (o.boundingBox().contains(c.boundingBox()) && o.contains(p.x(),p.y())) depth++;
+  }
+  cutouts[i] = (1==depth % 2);
+ }
+ for (int i = 0; i < m_Contours.size(); i++)
+ {
+  CContour& c = m_Contours[i];
+  c.setCutout(cutouts.at(i));
+  if ((c.area() < 0.0)!=c.cutout())
+  {
+   c.reverse();
+   c.flatten(m_Tolerance);
+  }
+ }
+}
+
+void CBoardOutline::index(void)
+{
+ for (int i = 0; i < m_Contours.size(); i++)
+ {
+  const QVector<CPoint>& points = m_Contours.at(i).points();
+  for (int j = 0; j+1 < points.size(); j++)
+  {
+   m_Edges.append(points.at(j));
+   m_Edges.append(points.at(j+1));
+  }
+  m_BoundingBox.include(m_Contours.at(i).boundingBox());
+ }
+ int count = m_Edges.size()/2;
+ if (0==count) return;
+ CBoundingBox extent = m_BoundingBox;
+ extent.inflate(m_Tolerance);
+ TDimension cell = std::max(extent.width(),extent.height())/std::max(1.0,ceil(sqrt((double)count)));
+ m_Index.reset(extent,std::max(cell,10.0*m_Tolerance));
+ for (int i = 0; i < count; i++)
+ {
+  const CPoint& a = m_Edges.at(2*i);
+  const CPoint& b = m_Edges.at(2*i+1);
+  m_Index.insert(i,CBoundingBox(a.x(),a.y(),b.x(),b.y()));
+ }
+}
+
+bool CBoardOutline::contains(const TCoord x, const TCoord y) const
+{
+ if (!m_BoundingBox.contains(x,y)) return false;
+ // crossings of a ray to the right over all contours, even-odd
+ QVector<int> edges;
+ m_Index.query(CBoundingBox(x,y,m_BoundingBox.right(),y),edges);
+ bool inside = false;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  const CPoint& a = m_Edges.at(2*edges.at(i));
+  const CPoint& b = m_Edges.at(2*edges.at(i)+1);
+  if ((a.y() > y)!=(b.y() > y) && x < a.x() + (y-a.y())*(b.x()-a.x())/(b.y()-a.y())) inside = !inside;
+ }
+ return inside;
+}
+
+bool CBoardOutline::contains(const CShape& shape) const
+{
+ if (0==shape.count()) return false;
+ if (!contains(shape.vertex(0).x(),shape.vertex(0).y())) return false;
+ return clearance(shape) > 0.0;
+}
+
+TDimension CBoardOutline::clearance(const CShape& shape, CPoint *location) const
+{
+ if (m_Edges.isEmpty() || 0==shape.count()) return -1.0;
+ // widen the search until an edge closer than the search distance shows up
+ TDimension range = m_Index.cellSize();
+ QVector<int> edges;
+ while (true)
+ {
+  CBoundingBox box = shape.boundingBox();
+  box.inflate(range);
+  m_Index.query(box,edges);
+  double result = -1.0;
+  bool found = false;
+  for (int i = 0; i < edges.size(); i++)
+  {
+   const CPoint& a = m_Edges.at(2*edges.at(i));
+   const CPoint& b = m_Edges.at(2*edges.at(i)+1);
+   CShape edge;
+   edge.setSegment(a.x(),a.y(),b.x(),b.y(),0.0);
+   CPoint p;
+   double d = shape.distance(edge,&p);
+   if (!found || d < result)
+   {
+    result = d;
+    found = true;
+    if (0!=location) *location = p;
+   }
+  }
+  if ((found && result <= range) || box.contains(m_Index.extent())) return found ? result : -1.0;
+  range *= 2.0;
+ }
+}
+
+}
+//------------------------------------------------------------------------------
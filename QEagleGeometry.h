@@ -0,0 +1,406 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEGEOMETRY_H
+#define QEAGLEGEOMETRY_H
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QList>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements geometry helpers shared by the board processing tools
+*/
+
+namespace Eagle
+{
+
+// runs job.execute(0..count-1) on the global thread pool, the calling thread
+// takes part in the work, so nested calls never wait for a busy pool
+class CParallelJob
+{
+ public:
+  virtual ~CParallelJob(void) {}
+  virtual void execute(const int index) = 0;
+};
+
+void parallelFor(const int count, CParallelJob& job, const int threads = 0);
+
+// placement of a package or symbol: optional mirroring about the Y axis,
+// followed by counterclockwise rotation and translation
+class CTransform
+{
+ public:
+  CTransform(const TCoord dx, const TCoord dy, const double rotation, const bool mirror);
+  CTransform(CElement& element);
+  CTransform(const CTransform& transform);
+  CTransform(void);
+  virtual ~CTransform(void);
+ public:
+  void operator =(const CTransform& transform);
+  void clear(void);
+  void assign(const CTransform& transform);
+  void assign(const TCoord dx, const TCoord dy, const double rotation, const bool mirror);
+  void map(const TCoord x, const TCoord y, TCoord& rx, TCoord& ry) const;
+  CPoint map(const CPoint& point) const;
+  double mapAngle(const double angle) const;
+  double mapCurve(const double curve) const { return m_Mirror ? -curve : curve; }
+  TLayer mapLayer(const TLayer layer) const { return m_Mirror ? CLayer::mirrored(layer) : layer; }
+ public:
+  // getters
+  TCoord dx(void) const { return m_DX; }
+  TCoord dy(void) const { return m_DY; }
+  double rotation(void) const { return m_Rotation; }
+  bool mirror(void) const { return m_Mirror; }
+ protected:
+  TCoord m_DX;
+  TCoord m_DY;
+  double m_Rotation; // degrees, counterclockwise
+  bool m_Mirror;
+  double m_Cos;
+  double m_Sin;
+};
+
+// convex core (point, segment or polygon of up to MAX_VERTICES vertices)
+// grown by a radius, this covers wires, vias, pads and smds alike
+class CShape
+{
+ public:
+  static const int MAX_VERTICES = 8;
+ public:
+  CShape(const CShape& shape);
+  CShape(void);
+  virtual ~CShape(void);
+ public:
+  void operator =(const CShape& shape);
+  void clear(void);
+  void assign(const CShape& shape);
+  void setCircle(const TCoord x, const TCoord y, const TDimension radius);
+  void setSegment(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+                  const TDimension radius);
+  void setRectangle(const TCoord x, const TCoord y, const TDimension dx, const TDimension dy,
+                    const double rotation, const TDimension radius = 0.0);
+  void setOctagon(const TCoord x, const TCoord y, const TDimension diameter,
+                  const double rotation);
+  bool contains(const TCoord x, const TCoord y) const;
+  TDimension distance(const CShape& shape, CPoint *location = 0) const;
+ public:
+  // getters
+  int count(void) const { return m_Count; }
+  const CPoint& vertex(const int index) const { return m_Vertices[index]; }
+  TDimension radius(void) const { return m_Radius; }
+  const CBoundingBox& boundingBox(void) const { return m_BoundingBox; }
+ protected:
+  void update(void);
+ protected:
+  int m_Count;
+  CPoint m_Vertices[MAX_VERTICES]; // counterclockwise
+  TDimension m_Radius;
+  CBoundingBox m_BoundingBox;
+};
+
+// uniform grid of buckets, items are referenced by caller supplied ids
+class CSpatialIndex
+{
+ public:
+  CSpatialIndex(const CBoundingBox& extent, const TDimension cellSize);
+  CSpatialIndex(void);
+  virtual ~CSpatialIndex(void);
+ public:
+  void clear(void);
+  void reset(const CBoundingBox& extent, const TDimension cellSize);
+  void insert(const int id, const CBoundingBox& box);
+  void query(const CBoundingBox& box, QVector<int>& result) const;
+  void cell(const TCoord x, const TCoord y, int& column, int& row) const;
+  // ids bucketed in one cell, unsorted
+  const QVector<int>& items(const int column, const int row) const { return m_Cells.at(row*m_Columns+column); }
+ public:
+  // getters
+  const CBoundingBox& extent(void) const { return m_Extent; }
+  TDimension cellSize(void) const { return m_CellSize; }
+  int columns(void) const { return m_Columns; }
+  int rows(void) const { return m_Rows; }
+ protected:
+  void cellRange(const CBoundingBox& box, int& c1, int& r1, int& c2, int& r2) const;
+ protected:
+  CBoundingBox m_Extent;
+  TDimension m_CellSize;
+  int m_Columns;
+  int m_Rows;
+  QVector<QVector<int> > m_Cells;
+};
+
+class CPadResolverJob;
+
+// pad or smd of a placed element in board coordinates
+class CPadInstance
+{
+ friend class CPadResolverJob;
+ friend class CPadResolver;
+ public:
+  enum Kind {pkPad, pkSMD};
+ public:
+  CPadInstance(void);
+ public:
+  // pad or smd of a package placed by the transform
+  void assign(CPad& pad, const CTransform& transform);
+  void assign(CSMD& smd, const CTransform& transform);
+ public:
+  // getters
+  CPadInstance::Kind kind(void) const { return m_Kind; }
+  TCoord x(void) const { return m_X; }
+  TCoord y(void) const { return m_Y; }
+  double rotation(void) const { return m_Rotation; }
+  TLayer layer(void) const { return m_Layer; }
+  TDimension dx(void) const { return m_DX; }
+  TDimension dy(void) const { return m_DY; }
+  TDimension drill(void) const { return m_Drill; }
+  CPad::Shape shape(void) const { return m_Shape; }
+  int roundness(void) const { return m_Roundness; }
+  int element(void) const { return m_Element; }
+  int signal(void) const { return m_Signal; }
+  CPad *pad(void) const { return m_Pad; }
+  CSMD *smd(void) const { return m_SMD; }
+  QString name(void) const;
+ protected:
+  CPadInstance::Kind m_Kind;
+  TCoord m_X;
+  TCoord m_Y;
+  double m_Rotation; // degrees, counterclockwise
+  TLayer m_Layer; // LAYER_PADS for pads
+  TDimension m_DX; // pad diameter, 0 means derived from the design rules
+  TDimension m_DY;
+  TDimension m_Drill; // 0 for smds
+  CPad::Shape m_Shape; // pads only
+  int m_Roundness; // smds only, percent
+  int m_Element; // index into board elements
+  int m_Signal; // index into board signals, -1 when not connected
+  CPad *m_Pad;
+  CSMD *m_SMD;
+};
+
+// resolves all pads and smds of a board into one flat table, the table is
+// kept until the board or anything it holds changes
+class CPadResolver
+{
+ public:
+  CPadResolver(void);
+  virtual ~CPadResolver(void);
+ public:
+  void clear(void);
+  const QVector<CPadInstance>& resolve(CBoard& board, const int threads = 0);
+  // places the pads of the given elements again and reconnects the pads of
+  // the given signals, anything else must be unchanged since the last
+  // resolve(); falls back to resolve() when elements or packages changed
+  const QVector<CPadInstance>& update(CBoard& board, const QList<int>& elements,
+                                      const QList<int>& signalIndices, const int threads = 0);
+ public:
+  // getters, valid after resolve()
+  const QVector<CPadInstance>& pads(void) const { return m_Pads; }
+  // package placed by an element, 0 when its library or package is missing
+  CPackage *package(const int element) const { return m_Packages.value(element,0); }
+  // index of the first pad of an element, pads of an element are contiguous
+  int first(const int element) const { return m_First.value(element,0); }
+  int count(const int element) const { return m_First.value(element+1,0) - first(element); }
+ protected:
+  CBoard *m_Board;
+  int m_Revision;
+  QVector<CPadInstance> m_Pads;
+  QVector<CPackage*> m_Packages;
+  QVector<int> m_First; // element count + 1 entries
+  QHash<QString,int> m_ElementIndex; // element name to index
+};
+
+// pad, via and mask sizes a board derives from its design rules: annular
+// rings of automatic diameters, elongation of long and offset pads, solder
+// stop and cream frames and the copper layers in use
+class CPadRules
+{
+ public:
+  CPadRules(CDesignRule& designRules);
+  CPadRules(void);
+  virtual ~CPadRules(void);
+ public:
+  void clear(void);
+  void assign(CDesignRule& designRules);
+  void assign(const CDesignRuleValues& rules);
+  TDimension padDiameter(const TDimension drill, const TDimension diameter, const TLayer layer) const;
+  TDimension viaDiameter(const TDimension drill, const TDimension diameter, const TLayer layer) const;
+  TDimension stopFrame(const TDimension size) const;
+  TDimension creamFrame(const TDimension size) const;
+  bool viaStop(CVia& via) const;
+  // copper of a pad or via on a layer, inner layers are always round
+  void padShape(const CPadInstance& pad, const TLayer layer, CShape& shape,
+                const TDimension frame = 0.0) const;
+  void viaShape(CVia& via, const TLayer layer, CShape& shape, const TDimension frame = 0.0) const;
+ public:
+  // getters
+  const QList<TLayer>& layers(void) const { return m_Layers; }
+  TDimension minPadRing(void) const { return m_PadMin[0]; }
+  TDimension minViaRing(void) const { return m_ViaMin[0]; }
+  double elongationLong(void) const { return m_ElongationLong; }
+  double elongationOffset(void) const { return m_ElongationOffset; }
+ protected:
+  double m_PadRatio[3]; // top, inner, bottom
+  TDimension m_PadMin[3];
+  TDimension m_PadMax[3];
+  double m_ViaRatio[2]; // outer, inner
+  TDimension m_ViaMin[2];
+  TDimension m_ViaMax[2];
+  double m_ElongationLong; // percent
+  double m_ElongationOffset;
+  double m_StopRatio;
+  TDimension m_StopMin;
+  TDimension m_StopMax;
+  double m_CreamRatio;
+  TDimension m_CreamMin;
+  TDimension m_CreamMax;
+  TDimension m_ViaStopLimit; // vias up to this drill are covered
+  QList<TLayer> m_Layers; // from the layer setup, top and bottom by default
+};
+
+// union-find over 0..count-1 with path halving and union by size
+class CDisjointSet
+{
+ public:
+  CDisjointSet(const int count);
+  CDisjointSet(void);
+  virtual ~CDisjointSet(void);
+ public:
+  void clear(void);
+  void reset(const int count);
+  int find(const int index);
+  bool unite(const int a, const int b);
+ public:
+  // getters
+  int count(void) const { return m_Parent.size(); }
+  int sets(void) const { return m_Sets; }
+ protected:
+  QVector<int> m_Parent;
+  QVector<int> m_Size;
+  int m_Sets;
+};
+
+// center of the arc from (x1,y1) to (x2,y2) spanning curve degrees, false
+// for straight lines, see CWire::center()
+bool arcCenter(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+               const double curve, TCoord& x, TCoord& y);
+
+// approximates a (possibly curved) line by a polyline that deviates from
+// the true arc by no more than tolerance
+void flattenArc(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
+                const double curve, const TDimension tolerance, QVector<CPoint>& points);
+
+// approximates a (possibly curved) wire centerline by a polyline that
+// deviates from the true arc by no more than tolerance
+void flattenWire(CWire& wire, const TDimension tolerance, QVector<CPoint>& points);
+
+// closed chain of (possibly curved) lines, vertex i carries the curve of the
+// line to vertex i+1; arcs are flattened for area and containment tests
+class CContour
+{
+ public:
+  CContour(const CContour& contour);
+  CContour(void);
+  virtual ~CContour(void);
+ public:
+  void operator =(const CContour& contour);
+  void clear(void);
+  void assign(const CContour& contour);
+  void append(const TCoord x, const TCoord y, const double curve);
+  void reverse(void);
+  void flatten(const TDimension tolerance);
+  // crossing rule on the flattened lines
+  bool contains(const TCoord x, const TCoord y) const;
+ public:
+  // getters
+  int count(void) const { return m_Vertices.size(); }
+  const CPoint& vertex(const int index) const { return m_Vertices.at(index); }
+  double curve(const int index) const { return m_Curves.at(index); }
+  // valid after flatten(), the first point is repeated at the end
+  const QVector<CPoint>& points(void) const { return m_Points; }
+  // index of the vertex whose line gave flattened point i
+  const QVector<int>& lines(void) const { return m_Lines; }
+  const CBoundingBox& boundingBox(void) const { return m_BoundingBox; }
+  double area(void) const { return m_Area; }
+  bool cutout(void) const { return m_Cutout; }
+  // setters
+  void setCutout(const bool value) { m_Cutout = value; }
+ protected:
+  QVector<CPoint> m_Vertices;
+  QVector<double> m_Curves;
+  QVector<CPoint> m_Points;
+  QVector<int> m_Lines;
+  CBoundingBox m_BoundingBox;
+  double m_Area; // signed, positive when counterclockwise
+  bool m_Cutout;
+};
+
+// board outline drawn on the Dimension layer by the board and its packages:
+// wires are chained into closed contours by hashing their end points on a
+// grid of the snap tolerance, arcs keep their curve and circles, rectangles
+// and polygons are contours of their own. Contours inside an odd number of others are cutouts; outer
+// contours run counterclockwise, cutouts clockwise. Edges are kept in a
+// spatial index, so containment and edge distance only look at nearby lines.
+// The outline is kept until the board changes
+class CBoardOutline
+{
+ public:
+  CBoardOutline(void);
+  virtual ~CBoardOutline(void);
+ public:
+  void clear(void);
+  // returns the number of contours
+  int build(CBoard& board);
+  bool contains(const TCoord x, const TCoord y) const;
+  // the shape lies inside the board without touching an edge
+  bool contains(const CShape& shape) const;
+  // distance from the shape to the nearest edge, zero or less when it
+  // touches or crosses one, -1 when the board has no outline
+  TDimension clearance(const CShape& shape, CPoint *location = 0) const;
+ public:
+  // getters
+  const QList<CContour>& contours(void) const { return m_Contours; }
+  // chains of dimension lines that do not close
+  int openCount(void) const { return m_OpenCount; }
+  const CBoundingBox& boundingBox(void) const { return m_BoundingBox; }
+  TDimension tolerance(void) const { return m_Tolerance; }
+  // setters, take effect with the next build()
+  void setTolerance(const TDimension value) { m_Tolerance = value; m_Board = 0; }
+ protected:
+  void chain(QVector<CPoint>& starts, QVector<CPoint>& ends, QVector<double>& curves);
+  void classify(void);
+  void index(void);
+ protected:
+  CBoard *m_Board;
+  int m_Revision;
+  TDimension m_Tolerance; // default = 0.01 mm, end points closer than this meet, arcs deviate less
+  QList<CContour> m_Contours;
+  int m_OpenCount;
+  CBoundingBox m_BoundingBox;
+  QVector<CPoint> m_Edges; // flattened edges as start and end points
+  CSpatialIndex m_Index; // edge i is stored under id i
+};
+
+}
+
+#endif // QEAGLEGEOMETRY_H
+//------------------------------------------------------------------------------
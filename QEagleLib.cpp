@@ -16,6 +16,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 //------------------------------------------------------------------------------
+#include <cstring>
 #include <iostream>
 //------------------------------------------------------------------------------
 #include "QEagleLib.h"
@@ -25,10 +26,6 @@
 namespace Eagle
 {
 
-const double M_PI_DIV_180 = M_PI / 180.0;
-inline double degtorad(double x) { return x * M_PI_DIV_180; }
-inline double radtodeg(double x) { return x / M_PI_DIV_180; }
-
 QString escapeXml(const QString &str)
 {
  QString xml = str;
@@ -197,16 +194,192 @@ CVersionNumber& CVersionNumber::operator =(const CVersionNumber& version)
 
 //------------------------------------------------------------------------------
 
+CBoundingBox::CBoundingBox(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2)
+{
+ m_Left = std::min(x1,x2);
+ m_Bottom = std::min(y1,y2);
+ m_Right = std::max(x1,x2);
+ m_Top = std::max(y1,y2);
+}
+
+CBoundingBox::CBoundingBox(const CBoundingBox& box)
+{
+ assign(box);
+}
+
+CBoundingBox::CBoundingBox(void)
+{
+ clear();
+}
+
+CBoundingBox::~CBoundingBox(void)
+{
+ //
+}
+
+void CBoundingBox::operator =(const CBoundingBox& box)
+{
+ assign(box);
+}
+
+void CBoundingBox::clear(void)
+{
+ // an empty box is "inverted", so that the first include() defines it
+ m_Left = 1.0;
+ m_Bottom = 1.0;
+ m_Right = -1.0;
+ m_Top = -1.0;
+}
+
+void CBoundingBox::assign(const CBoundingBox& box)
+{
+ m_Left = box.m_Left;
+ m_Bottom = box.m_Bottom;
+ m_Right = box.m_Right;
+ m_Top = box.m_Top;
+}
+
+void CBoundingBox::include(const TCoord x, const TCoord y)
+{
+ if (isValid())
+ {
+  m_Left = std::min(m_Left,x);
+  m_Bottom = std::min(m_Bottom,y);
+  m_Right = std::max(m_Right,x);
+  m_Top = std::max(m_Top,y);
+ }
+ else
+ {
+  m_Left = m_Right = x;
+  m_Bottom = m_Top = y;
+ }
+}
+
+void CBoundingBox::include(const TCoord x, const TCoord y, const TDimension radius)
+{
+ include(x-radius,y-radius);
+ include(x+radius,y+radius);
+}
+
+void CBoundingBox::include(const CBoundingBox& box)
+{
+ if (box.isValid())
+ {
+  include(box.m_Left,box.m_Bottom);
+  include(box.m_Right,box.m_Top);
+ }
+}
+
+void CBoundingBox::inflate(const TDimension delta)
+{
+ if (isValid())
+ {
+  m_Left -= delta;
+  m_Bottom -= delta;
+  m_Right += delta;
+  m_Top += delta;
+ }
+}
+
+bool CBoundingBox::intersects(const CBoundingBox& box) const
+{
+ return isValid() && box.isValid() &&
+        m_Left<=box.m_Right && box.m_Left<=m_Right &&
+        m_Bottom<=box.m_Top && box.m_Bottom<=m_Top;
+}
+
+bool CBoundingBox::contains(const TCoord x, const TCoord y) const
+{
+ return isValid() && x>=m_Left && x<=m_Right && y>=m_Bottom && y<=m_Top;
+}
+
+bool CBoundingBox::contains(const CBoundingBox& box) const
+{
+ return isValid() && box.isValid() &&
+        box.m_Left>=m_Left && box.m_Right<=m_Right &&
+        box.m_Bottom>=m_Bottom && box.m_Top<=m_Top;
+}
+
+//------------------------------------------------------------------------------
+
+// bounding box helpers shared by the entities below
+
+// curved edge from (x1,y1) to (x2,y2) sweeping curve degrees, grown by radius
+static void includeCurve(CBoundingBox& box, const TCoord x1, const TCoord y1,
+ const TCoord x2, const TCoord y2, const double curve, const TDimension radius)
+{
+ box.include(x1,y1,radius);
+ box.include(x2,y2,radius);
+ double c = hypot(x2-x1,y2-y1);
+ if (0.0==curve || c<=0.0) return;
+ double d = 0.5*c/tan(0.5*degtorad(curve));
+ TCoord cx = 0.5*(x1+x2) - d*(y2-y1)/c;
+ TCoord cy = 0.5*(y1+y2) + d*(x2-x1)/c;
+ double r = hypot(x1-cx,y1-cy);
+ double a0 = radtodeg(atan2(y1-cy,x1-cx));
+ // the arc reaches an extreme wherever it passes a multiple of 90 degrees
+ for (int i = 0; i < 4; i++)
+ {
+  double a = (curve > 0.0) ? (90.0*i - a0) : (a0 - 90.0*i);
+  a = fmod(a,360.0);
+  if (a < 0.0) a += 360.0;
+  if (a <= fabs(curve))
+  {
+   box.include(cx + r*cos(degtorad(90.0*i)),cy + r*sin(degtorad(90.0*i)),radius);
+  }
+ }
+}
+
+// rectangle of the given size centered at (x,y) and rotated about it
+static void includeRectangle(CBoundingBox& box, const TCoord x, const TCoord y,
+ const TDimension dx, const TDimension dy, const double rotation)
+{
+ double c = cos(degtorad(rotation));
+ double s = sin(degtorad(rotation));
+ double hx = 0.5*(fabs(dx*c) + fabs(dy*s));
+ double hy = 0.5*(fabs(dx*s) + fabs(dy*c));
+ box.include(x-hx,y-hy);
+ box.include(x+hx,y+hy);
+}
+
+// extent of a package or symbol placed at (x,y) by its corners, mirrored
+// about the Y axis first and then rotated counterclockwise; the origin alone
+// for an empty extent
+static void includePlaced(CBoundingBox& box, const CBoundingBox& extent, const TCoord x, const TCoord y,
+ const double rotation, const bool mirror)
+{
+ if (!extent.isValid())
+ {
+  box.include(x,y);
+  return;
+ }
+ double c = cos(degtorad(rotation));
+ double s = sin(degtorad(rotation));
+ for (int k = 0; k < 4; k++)
+ {
+  double px = (k & 1) ? extent.right() : extent.left();
+  double py = (k & 2) ? extent.top() : extent.bottom();
+  if (mirror) px = -px;
+  box.include(x + px*c - py*s,y + px*s + py*c);
+ }
+}
+
+//------------------------------------------------------------------------------
+
 CEagleDocumentOptions::CEagleDocumentOptions(const CEagleDocumentOptions& options)
 {
  m_WriteDefaults = options.m_WriteDefaults;
  m_Version = options.m_Version;
+ m_Children = options.m_Children;
+ m_SkipChildren = options.m_SkipChildren;
 }
 
 CEagleDocumentOptions::CEagleDocumentOptions(void)
 {
  m_WriteDefaults = false;
  m_Version = QString((const char*)STRING(EAGLE_DTD_VERSION));
+ m_Children = 0;
+ m_SkipChildren = false;
 }
 
 CEagleDocumentOptions::~CEagleDocumentOptions(void)
@@ -226,8 +399,76 @@ void CEagleDocumentOptions::setVersion(const CVersionNumber& value)
 
 //------------------------------------------------------------------------------
 
+QString CContentHash::toString(const quint64 value)
+{
+ return QString("%1").arg(value,16,16,QChar('0'));
+}
+
+void CContentHash::add(const char *data, const int size)
+{
+ for (int i = 0; i < size; i++)
+ {
+  m_Value ^= (uchar)data[i];
+  m_Value *= Q_UINT64_C(1099511628211);
+ }
+}
+
+void CContentHash::add(const QString& value)
+{
+ QByteArray data = value.toUtf8();
+ char length[4];
+ for (int i = 0; i < 4; i++)
+ {
+  length[i] = (char)((quint32)data.size() >> 8*i);
+ }
+ add(length,sizeof(length));
+ add(data.constData(),data.size());
+}
+
+void CContentHash::add(const quint64 value)
+{
+ char data[8];
+ for (int i = 0; i < 8; i++)
+ {
+  data[i] = (char)(value >> 8*i);
+ }
+ add(data,sizeof(data));
+}
+
+void CContentHash::add(const int value)
+{
+ char data[4];
+ for (int i = 0; i < 4; i++)
+ {
+  data[i] = (char)((quint32)value >> 8*i);
+ }
+ add(data,sizeof(data));
+}
+
+void CContentHash::add(const double value)
+{
+ double v = (0.0==value) ? 0.0 : value;
+ quint64 bits;
+ memcpy(&bits,&v,sizeof(bits));
+ add(bits);
+}
+
+void CContentHash::addAttribute(const QString& name, const QString& value)
+{
+ add(name);
+ if ("-0"==value) add(QString("0")); else add(value);
+}
+
+//------------------------------------------------------------------------------
+
+// source of revision numbers, zero is never handed out
+static QAtomicInt g_Revision(0);
+
 CEntity::CEntity(void)
 {
+ m_Owner = 0;
+ m_Revision.storeRelease(g_Revision.fetchAndAddOrdered(1) + 1);
+ m_ContentHash.store(0);
  clear();
 }
 
@@ -251,6 +492,23 @@ void CEntity::show(std::ostream& out, const int level)
  for (int i = 0; i < level; i++)  out<<"\t";
 }
 
+void CEntity::modify(void)
+{
+ int revision = g_Revision.fetchAndAddOrdered(1) + 1;
+ for (CEntity *e = this; 0!=e; e = e->m_Owner)
+ {
+  e->m_Revision.storeRelease(revision);
+  e->m_ContentHash.storeRelease(0);
+ }
+}
+
+QMutex& CEntity::cacheMutex(void)
+{
+ // getters of an owner fill their caches from those of the entities it holds
+ static QMutex mutex(QMutex::Recursive);
+ return mutex;
+}
+
 bool CEntity::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
  return true;
@@ -261,6 +519,58 @@ bool CEntity::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return (!host.isNull() && !root.isNull());
 }
 
+QDomElement CEntity::writtenElement(CEntity& entity, QDomDocument& host, QDomElement& root,
+ const CEagleDocumentOptions& options)
+{
+ // an entity appends one element to the root, takes the root for its
+ // fields, becomes the document element or writes nothing at all
+ QDomNode last = root.lastChild();
+ QDomElement document = host.documentElement();
+ int attributes = root.attributes().count();
+ entity.writeToXML(host,root,options);
+ if (root.lastChild()!=last && root.lastChild().isElement()) return root.lastChild().toElement();
+ if (host.documentElement()!=document) return host.documentElement();
+ if (root.attributes().count()!=attributes) return root;
+ return QDomElement();
+}
+
+bool CEntity::writeChild(CEntity& child, QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options)
+{
+ if (0==options.m_Children) return child.writeToXML(host,root,options);
+ if (options.m_SkipChildren) return true;
+ CEagleDocumentOptions fields(options);
+ fields.m_SkipChildren = true;
+ QDomElement e = writtenElement(child,host,root,fields);
+ if (!e.isNull()) options.m_Children->append(qMakePair(e,&child));
+ return true;
+}
+
+QDomElement CEntity::writeFields(QDomDocument& host, QDomElement& root, QList<QPair<QDomElement,CEntity*> >& children)
+{
+ CEagleDocumentOptions options;
+ options.m_Children = &children;
+ return writtenElement(*this,host,root,options);
+}
+
+void CEntity::hashFields(CContentHash& hash)
+{
+ //
+}
+
+quint64 CEntity::contentHash(void)
+{
+ // only the entities up the owner chain of an edit hash their fields again,
+ // everything below them keeps its hash; parallel callers may both compute
+ // it, the first one stores it
+ quint64 result = m_ContentHash.loadAcquire();
+ if (0!=result) return result;
+ CContentHash h;
+ hashFields(h);
+ result = h.value();
+ m_ContentHash.testAndSetOrdered(0,result);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CSettings::CSettings(const CSettings& settings)
@@ -295,12 +605,14 @@ void CSettings::operator =(const CSettings& settings)
 
 void CSettings::clear(void)
 {
+ modify();
  m_AlwaysVectorFont = false;
  m_VerticalText = CSettings::vtUp;
 }
 
 void CSettings::assign(const CSettings& settings)
 {
+ modify();
  m_AlwaysVectorFont = settings.m_AlwaysVectorFont;
  m_VerticalText = settings.m_VerticalText;
 }
@@ -314,6 +626,7 @@ void CSettings::show(std::ostream& out, const int level)
 
 bool CSettings::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  int result = 0;
  QDomElement e = root.firstChildElement("setting");
  while (!e.isNull())
@@ -355,6 +668,13 @@ bool CSettings::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDo
  return false;
 }
 
+void CSettings::hashFields(CContentHash& hash)
+{
+ hash.add(QString("settings"));
+ hash.add(m_AlwaysVectorFont);
+ hash.add(m_VerticalText);
+}
+
 //------------------------------------------------------------------------------
 
 CGrid::CGrid(const CGrid& grid)
@@ -395,6 +715,7 @@ QString CGrid::toString(const CGrid::Style value)
 
 void CGrid::clear(void)
 {
+ modify();
  m_Distance = 0.1;
  m_UnitDist = CGrid::guInch;
  m_Unit = CGrid::guInch;
@@ -408,6 +729,7 @@ void CGrid::clear(void)
 
 void CGrid::assign(const CGrid& grid)
 {
+ modify();
  m_Distance = grid.m_Distance;
  m_UnitDist = grid.m_UnitDist;
  m_Unit = grid.m_Unit;
@@ -426,6 +748,7 @@ void CGrid::operator =(const CGrid& grid)
 
 void CGrid::scale(const double factor)
 {
+ modify();
  m_Distance *= factor;
  m_AltDistance *= factor;
 }
@@ -446,6 +769,7 @@ void CGrid::show(std::ostream& out, const int level)
 
 bool CGrid::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  int result = 0;
  QDomElement e = root;
  if (e.nodeName()!="grid") e = e.nextSiblingElement("grid");
@@ -541,6 +865,20 @@ bool CGrid::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CGrid::hashFields(CContentHash& hash)
+{
+ hash.add(QString("grid"));
+ hash.add(m_Distance);
+ hash.add(m_UnitDist);
+ hash.add(m_Unit);
+ hash.add(m_Style);
+ hash.add(m_Multiple);
+ hash.add(m_Display);
+ hash.add(m_AltDistance);
+ hash.add(m_AltUnitDist);
+ hash.add(m_AltUnit);
+}
+
 bool CGrid::stringToUnit(const QString& name, CGrid::Unit& value)
 {
  if (name=="mic") { value = CGrid::guMic; return true; }
@@ -659,6 +997,42 @@ TLayer CLayer::layerNumber(const QString& name)
  return LAYER__INVALID;
 }
 
+TLayer CLayer::mirrored(const TLayer layer)
+{
+ // layer an object is moved to when its element is placed on the other side
+ switch (layer)
+ {
+  default:              return layer;
+  case LAYER_TOP:       return LAYER_BOTTOM;
+  case LAYER_BOTTOM:    return LAYER_TOP;
+  case LAYER_TPLACE:    return LAYER_BPLACE;
+  case LAYER_BPLACE:    return LAYER_TPLACE;
+  case LAYER_TORIGINS:  return LAYER_BORIGINS;
+  case LAYER_BORIGINS:  return LAYER_TORIGINS;
+  case LAYER_TNAMES:    return LAYER_BNAMES;
+  case LAYER_BNAMES:    return LAYER_TNAMES;
+  case LAYER_TVALUES:   return LAYER_BVALUES;
+  case LAYER_BVALUES:   return LAYER_TVALUES;
+  case LAYER_TSTOP:     return LAYER_BSTOP;
+  case LAYER_BSTOP:     return LAYER_TSTOP;
+  case LAYER_TCREAM:    return LAYER_BCREAM;
+  case LAYER_BCREAM:    return LAYER_TCREAM;
+  case LAYER_TFINISH:   return LAYER_BFINISH;
+  case LAYER_BFINISH:   return LAYER_TFINISH;
+  case LAYER_TGLUE:     return LAYER_BGLUE;
+  case LAYER_BGLUE:     return LAYER_TGLUE;
+  case LAYER_TTEST:     return LAYER_BTEST;
+  case LAYER_BTEST:     return LAYER_TTEST;
+  case LAYER_TKEEPOUT:  return LAYER_BKEEPOUT;
+  case LAYER_BKEEPOUT:  return LAYER_TKEEPOUT;
+  case LAYER_TRESTRICT: return LAYER_BRESTRICT;
+  case LAYER_BRESTRICT: return LAYER_TRESTRICT;
+  case LAYER_TDOCU:     return LAYER_BDOCU;
+  case LAYER_BDOCU:     return LAYER_TDOCU;
+ }
+ return layer;
+}
+
 void CLayer::operator =(const CLayer& layer)
 {
  assign(layer);
@@ -666,6 +1040,7 @@ void CLayer::operator =(const CLayer& layer)
 
 void CLayer::clear(void)
 {
+ modify();
  m_Layer = 0;
  m_Name.clear();
  m_Color = 0;
@@ -676,6 +1051,7 @@ void CLayer::clear(void)
 
 void CLayer::assign(const CLayer& layer)
 {
+ modify();
  m_Layer = layer.m_Layer;
  m_Name = layer.m_Name;
  m_Color = layer.m_Color;
@@ -696,6 +1072,7 @@ void CLayer::show(std::ostream& out, const int level)
 
 bool CLayer::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  int result = 0;
  QDomElement e = root;
  if (e.nodeName()!="layer") e = e.nextSiblingElement("layer");
@@ -777,6 +1154,17 @@ bool CLayer::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CLayer::hashFields(CContentHash& hash)
+{
+ hash.add(QString("layer"));
+ hash.add(m_Layer);
+ hash.add(m_Name);
+ hash.add(m_Color);
+ hash.add(m_Fill);
+ hash.add(m_Visible);
+ hash.add(m_Active);
+}
+
 //------------------------------------------------------------------------------
 
 CClearance::CClearance(const CClearance& clearance)
@@ -801,12 +1189,14 @@ void CClearance::operator =(const CClearance& clearance)
 
 void CClearance::clear(void)
 {
+ modify();
  m_Class = 0;
  m_Value = 0.0;
 }
 
 void CClearance::assign(const CClearance& clearance)
 {
+ modify();
  m_Class = clearance.m_Class;
  m_Value = clearance.m_Value;
 }
@@ -819,6 +1209,7 @@ void CClearance::show(std::ostream& out, const int level)
 
 bool CClearance::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="clearance") e = e.nextSiblingElement("clearance");
  if (!e.isNull())
@@ -858,6 +1249,13 @@ bool CClearance::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CClearance::hashFields(CContentHash& hash)
+{
+ hash.add(QString("clearance"));
+ hash.add(m_Class);
+ hash.add(m_Value);
+}
+
 //------------------------------------------------------------------------------
 
 CDescription::CDescription(const CDescription& description)
@@ -882,12 +1280,14 @@ void CDescription::operator =(const CDescription& description)
 
 void CDescription::clear(void)
 {
+ modify();
  m_Description.clear();
  m_Language = "en";
 }
 
 void CDescription::assign(const CDescription& description)
 {
+ modify();
  m_Description = description.m_Description;
  m_Language = description.m_Language;
 }
@@ -901,6 +1301,7 @@ void CDescription::show(std::ostream& out, const int level)
 
 bool CDescription::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="description") e = e.nextSiblingElement("description");
  if (!e.isNull())
@@ -945,6 +1346,16 @@ bool CDescription::writeToXML(QDomDocument& host, QDomElement& root, const CEagl
  return false;
 }
 
+void CDescription::hashFields(CContentHash& hash)
+{
+ if (!m_Description.isEmpty())
+ {
+  hash.add(QString("description"));
+  hash.add(m_Language);
+  hash.add(m_Description);
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CParam::CParam(const CParam& param)
@@ -969,12 +1380,14 @@ void CParam::operator =(const CParam& param)
 
 void CParam::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Value.clear();
 }
 
 void CParam::assign(const CParam& param)
 {
+ modify();
  m_Name = param.m_Name;
  m_Value = param.m_Value;
 }
@@ -988,6 +1401,7 @@ void CParam::show(std::ostream& out, const int level)
 
 bool CParam::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="param") e = e.nextSiblingElement("param");
  if (!e.isNull())
@@ -1020,6 +1434,13 @@ bool CParam::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CParam::hashFields(CContentHash& hash)
+{
+ hash.add(QString("param"));
+ hash.add(m_Name);
+ hash.add(m_Value);
+}
+
 //------------------------------------------------------------------------------
 
 CApproved::CApproved(const CApproved& error)
@@ -1044,11 +1465,13 @@ void CApproved::operator =(const CApproved& error)
 
 void CApproved::clear(void)
 {
+ modify();
  m_Hash.clear();
 }
 
 void CApproved::assign(const CApproved& error)
 {
+ modify();
  m_Hash = error.m_Hash;
 }
 
@@ -1060,6 +1483,7 @@ void CApproved::show(std::ostream& out, const int level)
 
 bool CApproved::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="approved") e = e.nextSiblingElement("approved");
  if (!e.isNull())
@@ -1086,6 +1510,12 @@ bool CApproved::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDo
  return false;
 }
 
+void CApproved::hashFields(CContentHash& hash)
+{
+ hash.add(QString("approved"));
+ hash.add(m_Hash);
+}
+
 //------------------------------------------------------------------------------
 
 CPass::CPass(const CPass& pass)
@@ -1110,6 +1540,7 @@ void CPass::operator =(const CPass& pass)
 
 void CPass::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Params.size(); i++)
  {
   if (0!=m_Params[i]) delete m_Params[i];
@@ -1126,7 +1557,7 @@ void CPass::assign(const CPass& pass)
  for (int i = 0; i < pass.m_Params.size(); i++)
  {
   CParam *p = new CParam(*pass.m_Params.at(i));
-  m_Params.append(p);
+  m_Params.append(link(p));
  }
  m_Name = pass.m_Name;
  m_Refer = pass.m_Refer;
@@ -1147,6 +1578,7 @@ void CPass::show(std::ostream& out, const int level)
 
 bool CPass::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="pass") e = e.nextSiblingElement("pass");
  if (!e.isNull())
@@ -1155,7 +1587,7 @@ bool CPass::readFromXML(const QDomElement& root, const CEagleDocumentOptions& op
   while (!c.isNull())
   {
    CParam *p = new CParam();
-   m_Params.append(p);
+   m_Params.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("param");
   }
@@ -1188,7 +1620,7 @@ bool CPass::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
   //QDomElement c = host.createElement("params");
   for (int i = 0; i < m_Params.size(); i++)
   {
-   m_Params[i]->writeToXML(host,e,options);
+   writeChild(*m_Params[i],host,e,options);
   }
   e.setAttribute("name",m_Name);
   e.setAttribute("refer",m_Refer);
@@ -1203,6 +1635,18 @@ bool CPass::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CPass::hashFields(CContentHash& hash)
+{
+ hash.add(QString("pass"));
+ for (int i = 0; i < m_Params.size(); i++)
+ {
+  hash.add(m_Params[i]->contentHash());
+ }
+ hash.add(m_Name);
+ hash.add(m_Refer);
+ hash.add(m_Active);
+}
+
 //------------------------------------------------------------------------------
 
 CClass::CClass(const CClass& value)
@@ -1227,6 +1671,7 @@ void CClass::operator =(const CClass& value)
 
 void CClass::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Clearances.size(); i++)
  {
   if (0!=m_Clearances[i]) delete m_Clearances[i];
@@ -1244,7 +1689,7 @@ void CClass::assign(const CClass& value)
  for (int i = 0; i < value.m_Clearances.size(); i++)
  {
   CClearance *c = new CClearance(*value.m_Clearances.at(i));
-  m_Clearances.append(c);
+  m_Clearances.append(link(c));
  }
  m_Number = value.m_Number;
  m_Name = value.m_Name;
@@ -1269,6 +1714,7 @@ void CClass::show(std::ostream& out, const int level)
 
 bool CClass::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="class") e = e.nextSiblingElement("class");
  if (!e.isNull())
@@ -1277,7 +1723,7 @@ bool CClass::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CClearance *l = new CClearance();
-   m_Clearances.append(l);
+   m_Clearances.append(link(l));
    l->readFromXML(c,options);
    c = c.nextSiblingElement("clearance");
   }
@@ -1331,7 +1777,7 @@ bool CClass::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
   for (int i = 0; i < m_Clearances.size(); i++)
   {
    //QDomElement c = host.createElement("clearance");
-   m_Clearances[i]->writeToXML(host,e,options);
+   writeChild(*m_Clearances[i],host,e,options);
    //e.appendChild(c);
   }
   return true;
@@ -1339,6 +1785,291 @@ bool CClass::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CClass::hashFields(CContentHash& hash)
+{
+ hash.add(QString("class"));
+ hash.add(m_Number);
+ hash.add(m_Name);
+ hash.add(m_Width);
+ hash.add(m_Drill);
+ for (int i = 0; i < m_Clearances.size(); i++)
+ {
+  hash.add(m_Clearances[i]->contentHash());
+ }
+}
+
+//------------------------------------------------------------------------------
+
+CClearanceMatrix::CClearanceMatrix(const CClearanceMatrix& matrix)
+{
+ assign(matrix);
+}
+
+CClearanceMatrix::CClearanceMatrix(void)
+{
+ clear();
+}
+
+CClearanceMatrix::~CClearanceMatrix(void)
+{
+ clear();
+}
+
+void CClearanceMatrix::operator =(const CClearanceMatrix& matrix)
+{
+ assign(matrix);
+}
+
+void CClearanceMatrix::clear(void)
+{
+ m_Size = 0;
+ m_Values.clear();
+ m_Default = 0.0;
+}
+
+void CClearanceMatrix::assign(const CClearanceMatrix& matrix)
+{
+ m_Size = matrix.m_Size;
+ m_Values = matrix.m_Values;
+ m_Default = matrix.m_Default;
+}
+
+void CClearanceMatrix::build(QList<CClass*>& classes, const TDimension defaultValue)
+{
+ clear();
+ m_Default = defaultValue;
+ for (int i = 0; i < classes.size(); i++)
+ {
+  CClass *c = classes.at(i);
+  m_Size = std::max(m_Size,c->number()+1);
+  for (int j = 0; j < c->clearances().size(); j++)
+  {
+   m_Size = std::max(m_Size,c->clearance(j)->getClass()+1);
+  }
+ }
+ m_Values.fill(0.0,m_Size*m_Size);
+ for (int i = 0; i < classes.size(); i++)
+ {
+  CClass *c = classes.at(i);
+  int a = c->number();
+  if (a < 0) continue;
+  for (int j = 0; j < c->clearances().size(); j++)
+  {
+   int b = c->clearance(j)->getClass();
+   if (b < 0) continue;
+   TDimension v = std::max(m_Values.at(a*m_Size+b),c->clearance(j)->getValue());
+   m_Values[a*m_Size+b] = v;
+   m_Values[b*m_Size+a] = v;
+  }
+ }
+}
+
+//------------------------------------------------------------------------------
+
+CDesignRuleValue::CDesignRuleValue(const QString& text)
+{
+ decode(text);
+}
+
+CDesignRuleValue::CDesignRuleValue(const CDesignRuleValue& value)
+{
+ assign(value);
+}
+
+CDesignRuleValue::CDesignRuleValue(void)
+{
+ clear();
+}
+
+CDesignRuleValue::~CDesignRuleValue(void)
+{
+ clear();
+}
+
+QString CDesignRuleValue::toString(const CDesignRuleValue::Unit value)
+{
+ switch (value)
+ {
+  case CDesignRuleValue::ruNone: return "";
+  case CDesignRuleValue::ruMil: return "mil";
+  case CDesignRuleValue::ruMillimeter: return "mm";
+  case CDesignRuleValue::ruInch: return "inch";
+  case CDesignRuleValue::ruMicron: return "mic";
+ }
+ return "";
+}
+
+double CDesignRuleValue::factor(const CDesignRuleValue::Unit value)
+{
+ switch (value)
+ {
+  case CDesignRuleValue::ruNone: return 1.0;
+  case CDesignRuleValue::ruMil: return 0.0254;
+  case CDesignRuleValue::ruMillimeter: return 1.0;
+  case CDesignRuleValue::ruInch: return 25.4;
+  case CDesignRuleValue::ruMicron: return 0.001;
+ }
+ return 1.0;
+}
+
+void CDesignRuleValue::operator =(const CDesignRuleValue& value)
+{
+ assign(value);
+}
+
+void CDesignRuleValue::clear(void)
+{
+ m_Text.clear();
+ m_Tokens.clear();
+ m_Values.clear();
+ m_Units.clear();
+ m_Numeric = false;
+}
+
+void CDesignRuleValue::assign(const CDesignRuleValue& value)
+{
+ m_Text = value.m_Text;
+ m_Tokens = value.m_Tokens;
+ m_Values = value.m_Values;
+ m_Units = value.m_Units;
+ m_Numeric = value.m_Numeric;
+}
+
+bool CDesignRuleValue::decode(const QString& text)
+{
+ clear();
+ m_Text = text;
+ m_Tokens = text.split(' ',QString::SkipEmptyParts);
+ m_Numeric = !m_Tokens.isEmpty();
+ for (int i = 0; i < m_Tokens.size(); i++)
+ {
+  QString s = m_Tokens.at(i).toLower();
+  CDesignRuleValue::Unit u = CDesignRuleValue::ruNone;
+  // "mil" and "mic" must be tested before the shorter suffixes
+  if (s.endsWith("mil")) { u = CDesignRuleValue::ruMil; s.chop(3); }
+  else if (s.endsWith("mic")) { u = CDesignRuleValue::ruMicron; s.chop(3); }
+  else if (s.endsWith("mm")) { u = CDesignRuleValue::ruMillimeter; s.chop(2); }
+  else if (s.endsWith("inch")) { u = CDesignRuleValue::ruInch; s.chop(4); }
+  bool ok = false;
+  double v = s.toDouble(&ok);
+  if (!ok) { v = 0.0; m_Numeric = false; }
+  m_Values.append(v*factor(u));
+  m_Units.append(u);
+ }
+ return m_Numeric;
+}
+
+QString CDesignRuleValue::encode(void) const
+{
+ return m_Text;
+}
+
+double CDesignRuleValue::value(const int index, const double defaultValue) const
+{
+ if (index >= 0 && index < m_Values.size()) return m_Values.at(index);
+ return defaultValue;
+}
+
+CDesignRuleValue::Unit CDesignRuleValue::unit(const int index) const
+{
+ if (index >= 0 && index < m_Units.size()) return m_Units.at(index);
+ return CDesignRuleValue::ruNone;
+}
+
+void CDesignRuleValue::setValue(const int index, const double value, const CDesignRuleValue::Unit unit)
+{
+ int i = std::max(index,0);
+ if (i >= m_Values.size())
+ {
+  i = m_Values.size();
+  m_Tokens.append(QString());
+  m_Values.append(0.0);
+  m_Units.append(unit);
+ }
+ CDesignRuleValue::Unit u = m_Units.at(i);
+ m_Values[i] = value;
+ m_Tokens[i] = QString::number(value/factor(u),'g',12) + toString(u);
+ m_Text = m_Tokens.join(" ");
+ m_Numeric = true;
+ for (int k = 0; k < m_Tokens.size() && m_Numeric; k++)
+ {
+  bool ok = false;
+  QString s = m_Tokens.at(k);
+  s.chop(toString(m_Units.at(k)).length());
+  s.toDouble(&ok);
+  m_Numeric = ok;
+ }
+}
+
+//------------------------------------------------------------------------------
+
+CDesignRuleValues::CDesignRuleValues(const CDesignRuleValues& values)
+{
+ assign(values);
+}
+
+CDesignRuleValues::CDesignRuleValues(void)
+{
+ clear();
+}
+
+CDesignRuleValues::~CDesignRuleValues(void)
+{
+ clear();
+}
+
+void CDesignRuleValues::operator =(const CDesignRuleValues& values)
+{
+ assign(values);
+}
+
+void CDesignRuleValues::clear(void)
+{
+ m_Values.clear();
+}
+
+void CDesignRuleValues::assign(const CDesignRuleValues& values)
+{
+ m_Values = values.m_Values;
+}
+
+void CDesignRuleValues::decode(const QList<CParam*>& params)
+{
+ clear();
+ m_Values.reserve(params.size());
+ for (int i = 0; i < params.size(); i++)
+ {
+  m_Values.insert(params.at(i)->name(),CDesignRuleValue(params.at(i)->value()));
+ }
+}
+
+const CDesignRuleValue *CDesignRuleValues::find(const QString& name) const
+{
+ QHash<QString,CDesignRuleValue>::const_iterator i = m_Values.constFind(name);
+ if (i!=m_Values.constEnd()) return &i.value();
+ return 0;
+}
+
+double CDesignRuleValues::dimension(const QString& name, const double defaultValue, const int index) const
+{
+ const CDesignRuleValue *v = find(name);
+ if (0!=v && v->isNumeric()) return v->value(index,defaultValue);
+ return defaultValue;
+}
+
+double CDesignRuleValues::number(const QString& name, const double defaultValue, const int index) const
+{
+ // same as dimension, for unit-less params the factor is 1
+ return dimension(name,defaultValue,index);
+}
+
+QString CDesignRuleValues::text(const QString& name, const QString& defaultValue) const
+{
+ const CDesignRuleValue *v = find(name);
+ if (0!=v) return v->text();
+ return defaultValue;
+}
+
 //------------------------------------------------------------------------------
 
 CDesignRule::CDesignRule(const CDesignRule& designRule)
@@ -1363,6 +2094,9 @@ void CDesignRule::operator =(const CDesignRule& designRule)
 
 void CDesignRule::clear(void)
 {
+ modify();
+ m_Values.clear();
+ m_ValuesRevision.store(0);
  for (int i = 0; i < m_Descriptions.size(); i++)
  {
   if (0!=m_Descriptions[i]) delete m_Descriptions[i];
@@ -1382,40 +2116,85 @@ void CDesignRule::assign(const CDesignRule& designRule)
  for (int i = 0; i < designRule.m_Descriptions.size(); i++)
  {
   CDescription *d = new CDescription(*designRule.m_Descriptions.at(i));
-  m_Descriptions.append(d);
+  m_Descriptions.append(link(d));
  }
  for (int i = 0; i < designRule.m_Params.size(); i++)
  {
   CParam *p = new CParam(*designRule.m_Params.at(i));
-  m_Params.append(p);
+  m_Params.append(link(p));
+ }
+ m_Name = designRule.m_Name;
+}
+
+void CDesignRule::show(std::ostream& out, const int level)
+{
+ CEntity::show(out,level); out<<"DesignRule:"<<std::endl;
+ CEntity::show(out,level); out<<"{"<<std::endl;
+ CEntity::show(out,level); out<<"\tName='"<<m_Name.toUtf8().data()<<"'"<<std::endl;
+ CEntity::show(out,level); out<<"\tParams="<<std::endl;
+ CEntity::show(out,level); out<<"\t{"<<std::endl;
+ for (int i = 0; i < m_Params.size(); i++)
+ {
+  m_Params[i]->show(out,level+2);
+ }
+ CEntity::show(out,level); out<<"\t}"<<std::endl;
+ CEntity::show(out,level); out<<"\tDescriptions="<<std::endl;
+ CEntity::show(out,level); out<<"\t{"<<std::endl;
+ for (int i = 0; i < m_Descriptions.size(); i++)
+ {
+  m_Descriptions[i]->show(out,level+2);
+ }
+ CEntity::show(out,level); out<<"\t}"<<std::endl;
+ CEntity::show(out,level); out<<"}"<<std::endl;
+}
+
+CParam* CDesignRule::findParamByName(const QString& name)
+{
+ CParam *result = 0;
+ for (int i = 0; i < m_Params.size(); i++)
+ {
+  CParam *p = m_Params.at(i);
+  if (p->name()==name)
+  {
+   result = p;
+   break;
+  }
  }
- m_Name = designRule.m_Name;
+ return result;
 }
 
-void CDesignRule::show(std::ostream& out, const int level)
+const CDesignRuleValues& CDesignRule::values(void)
 {
- CEntity::show(out,level); out<<"DesignRule:"<<std::endl;
- CEntity::show(out,level); out<<"{"<<std::endl;
- CEntity::show(out,level); out<<"\tName='"<<m_Name.toUtf8().data()<<"'"<<std::endl;
- CEntity::show(out,level); out<<"\tParams="<<std::endl;
- CEntity::show(out,level); out<<"\t{"<<std::endl;
- for (int i = 0; i < m_Params.size(); i++)
+ // params are edited through their setters, any of which advances revision
+ int current = revision();
+ if (m_ValuesRevision.loadAcquire()==current) return m_Values;
+ QMutexLocker lock(&cacheMutex());
+ if (m_ValuesRevision.load()!=current)
  {
-  m_Params[i]->show(out,level+2);
+  m_Values.decode(m_Params);
+  m_ValuesRevision.storeRelease(current);
  }
- CEntity::show(out,level); out<<"\t}"<<std::endl;
- CEntity::show(out,level); out<<"\tDescriptions="<<std::endl;
- CEntity::show(out,level); out<<"\t{"<<std::endl;
- for (int i = 0; i < m_Descriptions.size(); i++)
+ return m_Values;
+}
+
+void CDesignRule::setValue(const QString& name, const int index, const double value,
+ const CDesignRuleValue::Unit unit)
+{
+ CParam *p = findParamByName(name);
+ if (0==p)
  {
-  m_Descriptions[i]->show(out,level+2);
+  p = new CParam();
+  p->setName(name);
+  m_Params.append(link(p));
  }
- CEntity::show(out,level); out<<"\t}"<<std::endl;
- CEntity::show(out,level); out<<"}"<<std::endl;
+ CDesignRuleValue v(p->value());
+ v.setValue(index,value,unit);
+ p->setValue(v.encode());
 }
 
 bool CDesignRule::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="designrules") e = e.nextSiblingElement("designrules");
  if (!e.isNull())
@@ -1424,7 +2203,7 @@ bool CDesignRule::readFromXML(const QDomElement& root, const CEagleDocumentOptio
   while (!c.isNull())
   {
    CDescription *d = new CDescription();
-   m_Descriptions.append(d);
+   m_Descriptions.append(link(d));
    d->readFromXML(c,options);
    c = c.nextSiblingElement("description");
   }
@@ -1432,7 +2211,7 @@ bool CDesignRule::readFromXML(const QDomElement& root, const CEagleDocumentOptio
   while (!c.isNull())
   {
    CParam *p = new CParam();
-   m_Params.append(p);
+   m_Params.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("param");
   }
@@ -1454,13 +2233,13 @@ bool CDesignRule::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
   for (int i = 0; i < m_Descriptions.size(); i++)
   {
    //QDomElement e = host.createElement("description");
-   m_Descriptions[i]->writeToXML(host,root,options);
+   writeChild(*m_Descriptions[i],host,root,options);
    //root.appendChild(e);
   }
   for (int i = 0; i < m_Params.size(); i++)
   {
    //QDomElement e = host.createElement("param");
-   m_Params[i]->writeToXML(host,root,options);
+   writeChild(*m_Params[i],host,root,options);
    //root.appendChild(e);
   }
   return true;
@@ -1468,6 +2247,20 @@ bool CDesignRule::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
  return false;
 }
 
+void CDesignRule::hashFields(CContentHash& hash)
+{
+ hash.add(QString("designrules"));
+ hash.add(m_Name);
+ for (int i = 0; i < m_Descriptions.size(); i++)
+ {
+  hash.add(m_Descriptions[i]->contentHash());
+ }
+ for (int i = 0; i < m_Params.size(); i++)
+ {
+  hash.add(m_Params[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CVariantDef::CVariantDef(const CVariantDef& variantDef)
@@ -1492,12 +2285,14 @@ void CVariantDef::operator =(const CVariantDef& variantDef)
 
 void CVariantDef::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Current = false;
 }
 
 void CVariantDef::assign(const CVariantDef& variantDef)
 {
+ modify();
  m_Name = variantDef.m_Name;
  m_Current = variantDef.m_Current;
 }
@@ -1511,6 +2306,7 @@ void CVariantDef::show(std::ostream& out, const int level)
 
 bool CVariantDef::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="designrule") e = e.nextSiblingElement("designrule");
  if (!e.isNull())
@@ -1547,6 +2343,13 @@ bool CVariantDef::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
  return false;
 }
 
+void CVariantDef::hashFields(CContentHash& hash)
+{
+ hash.add(QString("variantdef"));
+ hash.add(m_Name);
+ hash.add(m_Current);
+}
+
 //------------------------------------------------------------------------------
 
 CVariant::CVariant(const CVariant& variant)
@@ -1571,6 +2374,7 @@ void CVariant::operator =(const CVariant& variant)
 
 void CVariant::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Populate = true;
  m_Value.clear();
@@ -1579,6 +2383,7 @@ void CVariant::clear(void)
 
 void CVariant::assign(const CVariant& variant)
 {
+ modify();
  m_Name = variant.m_Name;
  m_Populate = variant.m_Populate;
  m_Value = variant.m_Value;
@@ -1597,6 +2402,7 @@ void CVariant::show(std::ostream& out, const int level)
 
 bool CVariant::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="variant") e = e.nextSiblingElement("variant");
  if (!e.isNull())
@@ -1645,6 +2451,15 @@ bool CVariant::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CVariant::hashFields(CContentHash& hash)
+{
+ hash.add(QString("variant"));
+ hash.add(m_Name);
+ hash.add(m_Populate);
+ hash.add(m_Value);
+ hash.add(m_Technology);
+}
+
 //------------------------------------------------------------------------------
 
 CGate::CGate(const QString& name, const QString& symbol, const TCoord x,
@@ -1693,6 +2508,7 @@ void CGate::operator =(const CGate& gate)
 
 void CGate::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Symbol.clear();
  m_X = 0.0;
@@ -1703,6 +2519,7 @@ void CGate::clear(void)
 
 void CGate::assign(const CGate& gate)
 {
+ modify();
  m_Name = gate.m_Name;
  m_Symbol = gate.m_Symbol;
  m_X = gate.m_X;
@@ -1713,6 +2530,7 @@ void CGate::assign(const CGate& gate)
 
 void CGate::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
 }
@@ -1728,6 +2546,7 @@ void CGate::show(std::ostream& out, const int level)
 
 bool CGate::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="gate") e = e.nextSiblingElement("gate");
  if (!e.isNull())
@@ -1800,6 +2619,17 @@ bool CGate::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CGate::hashFields(CContentHash& hash)
+{
+ hash.add(QString("gate"));
+ hash.add(m_Name);
+ hash.add(m_Symbol);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_AddLevel);
+ hash.add(m_SwapLevel);
+}
+
 //------------------------------------------------------------------------------
 
 CWire::CWire(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
@@ -1854,6 +2684,7 @@ void CWire::operator =(const CWire& wire)
 
 void CWire::clear(void)
 {
+ modify();
  m_X1 = 0.0;
  m_Y1 = 0.0;
  m_X2 = 1.0;
@@ -1868,6 +2699,7 @@ void CWire::clear(void)
 
 void CWire::assign(const CWire& wire)
 {
+ modify();
  m_X1 = wire.m_X1;
  m_Y1 = wire.m_Y1;
  m_X2 = wire.m_X2;
@@ -1906,8 +2738,24 @@ double CWire::radius(void) const
  return 0.0;
 }
 
+bool CWire::center(TCoord& x, TCoord& y) const
+{
+ // positive curve runs counterclockwise from (x1,y1) to (x2,y2), so the
+ // center lies to the left of the chord, and to the right otherwise
+ double c = chord();
+ if (0.0!=m_Curve && c>0.0)
+ {
+  double d = 0.5*c/tan(0.5*degtorad(m_Curve));
+  x = 0.5*(m_X1+m_X2) - d*(m_Y2-m_Y1)/c;
+  y = 0.5*(m_Y1+m_Y2) + d*(m_X2-m_X1)/c;
+  return true;
+ }
+ return false;
+}
+
 void CWire::scale(const double factor)
 {
+ modify();
  m_X1 *= factor;
  m_Y1 *= factor;
  m_X2 *= factor;
@@ -1928,6 +2776,7 @@ void CWire::show(std::ostream& out, const int level)
 
 bool CWire::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="wire") e = e.nextSiblingElement("wire");
  if (!e.isNull())
@@ -2033,6 +2882,31 @@ bool CWire::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CWire::hashFields(CContentHash& hash)
+{
+ hash.add(QString("wire"));
+ hash.add(m_X1);
+ hash.add(m_Y1);
+ hash.add(m_X2);
+ hash.add(m_Y2);
+ hash.add(m_Width);
+ hash.add(m_Layer);
+ if (!m_Extent.isEmpty())
+ {
+  hash.add(m_Extent);
+ }
+ hash.add(m_Style);
+ hash.add(m_Curve);
+ hash.add(m_Cap);
+}
+
+CBoundingBox CWire::boundingBox(void)
+{
+ CBoundingBox result;
+ includeCurve(result,m_X1,m_Y1,m_X2,m_Y2,m_Curve,0.5*m_Width);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CDimension::CDimension(const CDimension& dimension)
@@ -2071,6 +2945,7 @@ void CDimension::operator =(const CDimension& dimension)
 
 void CDimension::clear(void)
 {
+ modify();
  m_X1 = 0.0;
  m_Y1 = 0.0;
  m_X2 = 0.0;
@@ -2092,6 +2967,7 @@ void CDimension::clear(void)
 
 void CDimension::assign(const CDimension& dimension)
 {
+ modify();
  m_X1 = dimension.m_X1;
  m_Y1 = dimension.m_Y1;
  m_X2 = dimension.m_X2;
@@ -2113,6 +2989,7 @@ void CDimension::assign(const CDimension& dimension)
 
 void CDimension::scale(const double factor)
 {
+ modify();
  m_X1 *= factor;
  m_Y1 *= factor;
  m_X2 *= factor;
@@ -2144,6 +3021,7 @@ void CDimension::show(std::ostream& out, const int level)
 
 bool CDimension::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="dimension") e = e.nextSiblingElement("dimension");
  if (!e.isNull())
@@ -2322,6 +3200,36 @@ bool CDimension::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CDimension::hashFields(CContentHash& hash)
+{
+ hash.add(QString("dimension"));
+ hash.add(m_X1);
+ hash.add(m_Y1);
+ hash.add(m_X2);
+ hash.add(m_Y2);
+ hash.add(m_X3);
+ hash.add(m_Y3);
+ hash.add(m_Layer);
+ hash.add(m_DType);
+ hash.add(m_Width);
+ hash.add(m_ExtWidth);
+ hash.add(m_ExtLength);
+ hash.add(m_ExtOffset);
+ hash.add(m_TextSize);
+ hash.add(m_GridUnit);
+ hash.add(m_Precision);
+ hash.add(m_Visible);
+}
+
+CBoundingBox CDimension::boundingBox(void)
+{
+ CBoundingBox result;
+ result.include(m_X1,m_Y1);
+ result.include(m_X2,m_Y2);
+ result.include(m_X3,m_Y3);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CText::CText(const QString& text, const TCoord x, const TCoord y,
@@ -2407,6 +3315,7 @@ void CText::operator =(const CText& text)
 
 void CText::clear(void)
 {
+ modify();
  m_Text.clear();
  m_X = 0.0;
  m_Y = 0.0;
@@ -2423,6 +3332,7 @@ void CText::clear(void)
 
 void CText::assign(const CText& text)
 {
+ modify();
  m_Text = text.m_Text;
  m_X = text.m_X;
  m_Y = text.m_Y;
@@ -2439,6 +3349,7 @@ void CText::assign(const CText& text)
 
 void CText::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Size *= factor;
@@ -2458,6 +3369,7 @@ void CText::show(std::ostream& out, const int level)
 
 bool CText::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="text") e = e.nextSiblingElement("text");
  if (!e.isNull())
@@ -2578,6 +3490,60 @@ bool CText::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CText::hashFields(CContentHash& hash)
+{
+ hash.add(QString("text"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Size);
+ hash.add(m_Layer);
+ hash.add(m_Font);
+ hash.add(m_Ratio);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ hash.add(m_Spin);
+ hash.add(m_Align);
+ hash.add(m_Distance);
+ hash.add(m_Text);
+}
+
+CBoundingBox CText::boundingBox(void)
+{
+ // estimated from the vector font cell, which is about 0.8 of size wide
+ QStringList lines = m_Text.split('\n');
+ int columns = 0;
+ for (int i = 0; i < lines.size(); i++)
+ {
+  columns = std::max(columns,lines.at(i).length());
+ }
+ double w = 0.8*m_Size*columns;
+ double h = m_Size*(lines.size() + 0.01*m_Distance*(lines.size()-1));
+ double x0 = 0.0, y0 = 0.0;
+ switch (m_Align)
+ {
+  case CText::taBottomCenter: case CText::taCenter: case CText::taTopCenter: x0 = -0.5*w; break;
+  case CText::taBottomRight: case CText::taCenterRight: case CText::taTopRight: x0 = -w; break;
+  default: break;
+ }
+ switch (m_Align)
+ {
+  case CText::taCenterLeft: case CText::taCenter: case CText::taCenterRight: y0 = -0.5*h; break;
+  case CText::taTopLeft: case CText::taTopCenter: case CText::taTopRight: y0 = -h; break;
+  default: break;
+ }
+ double c = cos(degtorad(m_Rotation));
+ double s = sin(degtorad(m_Rotation));
+ CBoundingBox result;
+ for (int i = 0; i < 4; i++)
+ {
+  double x = x0 + ((1==i || 2==i) ? w : 0.0);
+  double y = y0 + ((2==i || 3==i) ? h : 0.0);
+  if (m_Reflection) x = -x;
+  result.include(m_X + x*c - y*s,m_Y + x*s + y*c);
+ }
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CCircle::CCircle(const TCoord x, const TCoord y, const TCoord radius,
@@ -2608,6 +3574,7 @@ void CCircle::operator =(const CCircle& circle)
 
 void CCircle::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
  m_Radius = 1.0;
@@ -2617,6 +3584,7 @@ void CCircle::clear(void)
 
 void CCircle::assign(const CCircle& circle)
 {
+ modify();
  m_X = circle.m_X;
  m_Y = circle.m_Y;
  m_Radius = circle.m_Radius;
@@ -2626,6 +3594,7 @@ void CCircle::assign(const CCircle& circle)
 
 void CCircle::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Radius *= factor;
@@ -2641,6 +3610,7 @@ void CCircle::show(std::ostream& out, const int level)
 
 bool CCircle::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="circle") e = e.nextSiblingElement("circle");
  if (!e.isNull())
@@ -2701,6 +3671,23 @@ bool CCircle::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CCircle::hashFields(CContentHash& hash)
+{
+ hash.add(QString("circle"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Radius);
+ hash.add(m_Width);
+ hash.add(m_Layer);
+}
+
+CBoundingBox CCircle::boundingBox(void)
+{
+ CBoundingBox result;
+ result.include(m_X,m_Y,m_Radius + 0.5*m_Width);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CRectangle::CRectangle(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2,
@@ -2732,6 +3719,7 @@ void CRectangle::operator =(const CRectangle& rectangle)
 
 void CRectangle::clear(void)
 {
+ modify();
  m_X1 = 0.0;
  m_Y1 = 0.0;
  m_X2 = 1.0;
@@ -2742,6 +3730,7 @@ void CRectangle::clear(void)
 
 void CRectangle::assign(const CRectangle& rectangle)
 {
+ modify();
  m_X1 = rectangle.m_X1;
  m_Y1 = rectangle.m_Y1;
  m_X2 = rectangle.m_X2;
@@ -2752,6 +3741,7 @@ void CRectangle::assign(const CRectangle& rectangle)
 
 void CRectangle::scale(const double factor)
 {
+ modify();
  m_X1 *= factor;
  m_Y1 *= factor;
  m_X2 *= factor;
@@ -2767,6 +3757,7 @@ void CRectangle::show(std::ostream& out, const int level)
 
 bool CRectangle::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="rectangle") e = e.nextSiblingElement("rectangle");
  if (!e.isNull())
@@ -2847,6 +3838,25 @@ bool CRectangle::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CRectangle::hashFields(CContentHash& hash)
+{
+ hash.add(QString("rectangle"));
+ hash.add(m_X1);
+ hash.add(m_Y1);
+ hash.add(m_X2);
+ hash.add(m_Y2);
+ hash.add(m_Layer);
+ hash.add(m_Rotation);
+}
+
+CBoundingBox CRectangle::boundingBox(void)
+{
+ // rotation is about the center
+ CBoundingBox result;
+ includeRectangle(result,0.5*(m_X1+m_X2),0.5*(m_Y1+m_Y2),fabs(m_X2-m_X1),fabs(m_Y2-m_Y1),m_Rotation);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CFrame::CFrame(const CFrame& frame)
@@ -2871,6 +3881,7 @@ void CFrame::operator =(const CFrame& frame)
 
 void CFrame::clear(void)
 {
+ modify();
  m_X1 = 0.0;
  m_Y1 = 0.0;
  m_X2 = 1.0;
@@ -2886,6 +3897,7 @@ void CFrame::clear(void)
 
 void CFrame::assign(const CFrame& frame)
 {
+ modify();
  m_X1 = frame.m_X1;
  m_Y1 = frame.m_Y1;
  m_X2 = frame.m_X2;
@@ -2901,6 +3913,7 @@ void CFrame::assign(const CFrame& frame)
 
 void CFrame::scale(const double factor)
 {
+ modify();
  m_X1 *= factor;
  m_Y1 *= factor;
  m_X2 *= factor;
@@ -2921,6 +3934,7 @@ void CFrame::show(std::ostream& out, const int level)
 
 bool CFrame::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="frame") e = e.nextSiblingElement("frame");
  if (!e.isNull())
@@ -3037,6 +4051,30 @@ bool CFrame::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CFrame::hashFields(CContentHash& hash)
+{
+ hash.add(QString("frame"));
+ hash.add(m_X1);
+ hash.add(m_Y1);
+ hash.add(m_X2);
+ hash.add(m_Y2);
+ hash.add(m_Columns);
+ hash.add(m_Rows);
+ hash.add(m_Layer);
+ hash.add(m_BorderLeft);
+ hash.add(m_BorderTop);
+ hash.add(m_BorderRight);
+ hash.add(m_BorderBottom);
+}
+
+CBoundingBox CFrame::boundingBox(void)
+{
+ CBoundingBox result;
+ result.include(m_X1,m_Y1);
+ result.include(m_X2,m_Y2);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CHole::CHole(const TCoord x, const TCoord y, const TDimension drill)
@@ -3068,6 +4106,7 @@ void CHole::operator =(const CHole& hole)
 
 void CHole::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
  m_Drill = 0.1;
@@ -3075,6 +4114,7 @@ void CHole::clear(void)
 
 void CHole::assign(const CHole& hole)
 {
+ modify();
  m_X = hole.m_X;
  m_Y = hole.m_Y;
  m_Drill = hole.m_Drill;
@@ -3082,6 +4122,7 @@ void CHole::assign(const CHole& hole)
 
 void CHole::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Drill *= factor;
@@ -3095,6 +4136,7 @@ void CHole::show(std::ostream& out, const int level)
 
 bool CHole::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="hole") e = e.nextSiblingElement("hole");
  if (!e.isNull())
@@ -3139,6 +4181,21 @@ bool CHole::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CHole::hashFields(CContentHash& hash)
+{
+ hash.add(QString("hole"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Drill);
+}
+
+CBoundingBox CHole::boundingBox(void)
+{
+ CBoundingBox result;
+ result.include(m_X,m_Y,0.5*m_Drill);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CPad::CPad(const CPad& pad)
@@ -3176,6 +4233,7 @@ void CPad::operator =(const CPad& pad)
 
 void CPad::clear(void)
 {
+ modify();
  m_Name = "P$1";
  m_X = 0.0;
  m_Y = 0.0;
@@ -3190,6 +4248,7 @@ void CPad::clear(void)
 
 void CPad::assign(const CPad& pad)
 {
+ modify();
  m_Name = pad.m_Name;
  m_X = pad.m_X;
  m_Y = pad.m_Y;
@@ -3204,6 +4263,7 @@ void CPad::assign(const CPad& pad)
 
 void CPad::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Drill *= factor;
@@ -3222,6 +4282,7 @@ void CPad::show(std::ostream& out, const int level)
 
 bool CPad::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="pad") e = e.nextSiblingElement("pad");
  if (!e.isNull())
@@ -3346,6 +4407,50 @@ bool CPad::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CPad::hashFields(CContentHash& hash)
+{
+ hash.add(QString("pad"));
+ hash.add(m_Name);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Drill);
+ hash.add(m_Diameter);
+ hash.add(m_Shape);
+ hash.add(m_Rotation);
+ hash.add(m_Stop);
+ hash.add(m_Thermals);
+ hash.add(m_First);
+}
+
+CBoundingBox CPad::boundingBox(void)
+{
+ // automatic diameter is estimated with the default 25% annular ring,
+ // elongated shapes with the default 100% elongation
+ TDimension d = (m_Diameter > 0.0) ? m_Diameter : 1.5*m_Drill;
+ double c = cos(degtorad(m_Rotation));
+ double s = sin(degtorad(m_Rotation));
+ CBoundingBox result;
+ switch (m_Shape)
+ {
+  case CPad::psRound:
+   result.include(m_X,m_Y,0.5*d);
+   break;
+  case CPad::psSquare:
+  case CPad::psOctagon:
+   includeRectangle(result,m_X,m_Y,d,d,m_Rotation);
+   break;
+  case CPad::psLong:
+   result.include(m_X - 0.5*d*c,m_Y - 0.5*d*s,0.5*d);
+   result.include(m_X + 0.5*d*c,m_Y + 0.5*d*s,0.5*d);
+   break;
+  case CPad::psOffset:
+   result.include(m_X,m_Y,0.5*d);
+   result.include(m_X + d*c,m_Y + d*s,0.5*d);
+   break;
+ }
+ return result;
+}
+
 
 //------------------------------------------------------------------------------
 
@@ -3389,6 +4494,7 @@ void CSMD::operator =(const CSMD& smd)
 
 void CSMD::clear(void)
 {
+ modify();
  m_Name = "P$1";
  m_X = 0.0;
  m_Y = 0.0;
@@ -3404,6 +4510,7 @@ void CSMD::clear(void)
 
 void CSMD::assign(const CSMD& smd)
 {
+ modify();
  m_Name = smd.m_Name;
  m_X = smd.m_X;
  m_Y = smd.m_Y;
@@ -3419,6 +4526,7 @@ void CSMD::assign(const CSMD& smd)
 
 void CSMD::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_DX *= factor;
@@ -3437,6 +4545,7 @@ void CSMD::show(std::ostream& out, const int level)
 
 bool CSMD::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="smd") e = e.nextSiblingElement("smd");
  if (!e.isNull())
@@ -3564,6 +4673,29 @@ bool CSMD::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CSMD::hashFields(CContentHash& hash)
+{
+ hash.add(QString("smd"));
+ hash.add(m_Name);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_DX);
+ hash.add(m_DY);
+ hash.add(m_Layer);
+ hash.add(m_Roundness);
+ hash.add(m_Rotation);
+ hash.add(m_Stop);
+ hash.add(m_Thermals);
+ hash.add(m_Cream);
+}
+
+CBoundingBox CSMD::boundingBox(void)
+{
+ CBoundingBox result;
+ includeRectangle(result,m_X,m_Y,m_DX,m_DY,m_Rotation);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CVia::CVia(const CVia& via)
@@ -3608,6 +4740,7 @@ void CVia::operator =(const CVia& via)
 
 void CVia::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
  m_Extent.clear();
@@ -3619,6 +4752,7 @@ void CVia::clear(void)
 
 void CVia::assign(const CVia& via)
 {
+ modify();
  m_X = via.m_X;
  m_Y = via.m_Y;
  m_Extent = via.m_Extent;
@@ -3630,6 +4764,7 @@ void CVia::assign(const CVia& via)
 
 void CVia::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Drill *= factor;
@@ -3648,6 +4783,7 @@ void CVia::show(std::ostream& out, const int level)
 
 bool CVia::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="via") e = e.nextSiblingElement("via");
  if (!e.isNull())
@@ -3730,6 +4866,27 @@ bool CVia::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CVia::hashFields(CContentHash& hash)
+{
+ hash.add(QString("via"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Extent);
+ hash.add(m_Drill);
+ hash.add(m_Diameter);
+ hash.add(m_Shape);
+ hash.add(m_AlwaysStop);
+}
+
+CBoundingBox CVia::boundingBox(void)
+{
+ // automatic diameter is estimated with the default 25% annular ring
+ TDimension d = (m_Diameter > 0.0) ? m_Diameter : 1.5*m_Drill;
+ CBoundingBox result;
+ result.include(m_X,m_Y,(CVia::vsRound==m_Shape) ? 0.5*d : M_SQRT1_2*d);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CVertex::CVertex(const TCoord x, const TCoord y, const double curve)
@@ -3762,6 +4919,7 @@ void CVertex::operator =(const CVertex& vertex)
 
 void CVertex::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
  m_Curve = 0.0;
@@ -3769,6 +4927,7 @@ void CVertex::clear(void)
 
 void CVertex::assign(const CVertex& vertex)
 {
+ modify();
  m_X = vertex.m_X;
  m_Y = vertex.m_Y;
  m_Curve = vertex.m_Curve;
@@ -3776,6 +4935,7 @@ void CVertex::assign(const CVertex& vertex)
 
 void CVertex::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
 }
@@ -3788,6 +4948,7 @@ void CVertex::show(std::ostream& out, const int level)
 
 bool CVertex::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="vertex") e = e.nextSiblingElement("vertex");
  if (!e.isNull())
@@ -3835,6 +4996,14 @@ bool CVertex::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CVertex::hashFields(CContentHash& hash)
+{
+ hash.add(QString("vertex"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Curve);
+}
+
 //------------------------------------------------------------------------------
 
 CPin::CPin(const CPin& pin)
@@ -3912,6 +5081,7 @@ void CPin::operator =(const CPin& pin)
 
 void CPin::clear(void)
 {
+ modify();
  m_Name = "";
  m_X = 0.0;
  m_Y = 0.0;
@@ -3925,6 +5095,7 @@ void CPin::clear(void)
 
 void CPin::assign(const CPin& pin)
 {
+ modify();
  m_Name = pin.m_Name;
  m_X = pin.m_X;
  m_Y = pin.m_Y;
@@ -3938,6 +5109,7 @@ void CPin::assign(const CPin& pin)
 
 void CPin::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
 }
@@ -3956,6 +5128,7 @@ void CPin::show(std::ostream& out, const int level)
 
 bool CPin::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="pin") e = e.nextSiblingElement("pin");
  if (!e.isNull())
@@ -4082,6 +5255,37 @@ bool CPin::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CPin::hashFields(CContentHash& hash)
+{
+ hash.add(QString("pin"));
+ hash.add(m_Name);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Visible);
+ hash.add(m_Length);
+ hash.add(m_Direction);
+ hash.add(m_Function);
+ hash.add(m_SwapLevel);
+ hash.add(m_Rotation);
+}
+
+CBoundingBox CPin::boundingBox(void)
+{
+ // 0, 0.1, 0.2 and 0.3 inch
+ double l = 0.0;
+ switch (m_Length)
+ {
+  case CPin::plPoint: l = 0.0; break;
+  case CPin::plShort: l = 2.54; break;
+  case CPin::plMiddle: l = 5.08; break;
+  case CPin::plLong: l = 7.62; break;
+ }
+ CBoundingBox result;
+ result.include(m_X,m_Y);
+ result.include(m_X + l*cos(degtorad(m_Rotation)),m_Y + l*sin(degtorad(m_Rotation)));
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CPort::CPort(const CPort& port)
@@ -4134,6 +5338,7 @@ void CPort::operator =(const CPort& port)
 
 void CPort::clear(void)
 {
+ modify();
  m_Name = "";
  m_Coord = 0.0;
  m_Direction = CPort::DEFAULT_DIRECTION;
@@ -4141,6 +5346,7 @@ void CPort::clear(void)
 
 void CPort::assign(const CPort& port)
 {
+ modify();
  m_Name = port.m_Name;
  m_Coord = port.m_Coord;
  m_Direction = port.m_Direction;
@@ -4148,6 +5354,7 @@ void CPort::assign(const CPort& port)
 
 void CPort::scale(const double factor)
 {
+ modify();
  m_Coord *= factor;
 }
 
@@ -4161,6 +5368,7 @@ void CPort::show(std::ostream& out, const int level)
 
 bool CPort::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="port") e = e.nextSiblingElement("port");
  if (!e.isNull())
@@ -4217,6 +5425,15 @@ bool CPort::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CPort::hashFields(CContentHash& hash)
+{
+ hash.add(QString("port"));
+ hash.add(m_Name);
+ hash.add(m_Side);
+ hash.add(m_Coord);
+ hash.add(m_Direction);
+}
+
 //------------------------------------------------------------------------------
 
 CLabel::CLabel(const CLabel& label)
@@ -4241,6 +5458,7 @@ void CLabel::operator =(const CLabel& label)
 
 void CLabel::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
  m_Size = 0.1;
@@ -4254,6 +5472,7 @@ void CLabel::clear(void)
 
 void CLabel::assign(const CLabel& label)
 {
+ modify();
  m_X = label.m_X;
  m_Y = label.m_Y;
  m_Size = label.m_Size;
@@ -4267,6 +5486,7 @@ void CLabel::assign(const CLabel& label)
 
 void CLabel::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Size *= factor;
@@ -4284,6 +5504,7 @@ void CLabel::show(std::ostream& out, const int level)
 
 bool CLabel::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="label") e = e.nextSiblingElement("label");
  if (!e.isNull())
@@ -4388,8 +5609,23 @@ bool CLabel::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CLabel::hashFields(CContentHash& hash)
+{
+ hash.add(QString("label"));
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Size);
+ hash.add(m_Layer);
+ hash.add(m_Font);
+ hash.add(m_Ratio);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ hash.add(m_XRef);
+}
+
 void CLabel::setRotation(const double value)
 {
+ modify();
  if ((value<45.0) || (value>=315.0)) { m_Rotation = 0.0; }
  else if (value<135.0) { m_Rotation = 90.0; }
  else if (value<225.0) { m_Rotation = 180.0; }
@@ -4420,18 +5656,21 @@ void CJunction::operator =(const CJunction& junction)
 
 void CJunction::clear(void)
 {
+ modify();
  m_X = 0.0;
  m_Y = 0.0;
 }
 
 void CJunction::assign(const CJunction& junction)
 {
+ modify();
  m_X = junction.m_X;
  m_Y = junction.m_Y;
 }
 
 void CJunction::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
 }
@@ -4444,6 +5683,7 @@ void CJunction::show(std::ostream& out, const int level)
 
 bool CJunction::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="junction") e = e.nextSiblingElement("junction");
  if (!e.isNull())
@@ -4480,6 +5720,13 @@ bool CJunction::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDo
  return false;
 }
 
+void CJunction::hashFields(CContentHash& hash)
+{
+ hash.add(QString("junction"));
+ hash.add(m_X);
+ hash.add(m_Y);
+}
+
 //------------------------------------------------------------------------------
 
 CConnect::CConnect(const CConnect& connect)
@@ -4514,6 +5761,7 @@ void CConnect::operator =(const CConnect& connect)
 
 void CConnect::clear(void)
 {
+ modify();
  m_Gate.clear();
  m_Pin.clear();
  m_Pad.clear();
@@ -4522,6 +5770,7 @@ void CConnect::clear(void)
 
 void CConnect::assign(const CConnect& connect)
 {
+ modify();
  m_Gate = connect.m_Gate;
  m_Pin = connect.m_Pin;
  m_Pad = connect.m_Pad;
@@ -4538,6 +5787,7 @@ void CConnect::show(std::ostream& out, const int level)
 
 bool CConnect::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="connect") e = e.nextSiblingElement("connect");
  if (!e.isNull())
@@ -4586,6 +5836,15 @@ bool CConnect::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CConnect::hashFields(CContentHash& hash)
+{
+ hash.add(QString("connect"));
+ hash.add(m_Gate);
+ hash.add(m_Pin);
+ hash.add(m_Pad);
+ hash.add(m_Route);
+}
+
 //------------------------------------------------------------------------------
 
 CAttribute::CAttribute(const CAttribute& attribute)
@@ -4622,6 +5881,7 @@ void CAttribute::operator =(const CAttribute& attribute)
 
 void CAttribute::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Value.clear();
  m_X = 0.0;
@@ -4632,6 +5892,7 @@ void CAttribute::clear(void)
  m_Ratio = 8;
  m_Rotation  = CAttribute::DEFAULT_ROTATION;
  m_Reflection = false;
+ m_Spin = false;
  m_Align = CText::taBottomLeft;
  m_Display = CAttribute::DEFAULT_DISPLAY;
  m_Constant = false;
@@ -4639,6 +5900,7 @@ void CAttribute::clear(void)
 
 void CAttribute::assign(const CAttribute& attribute)
 {
+ modify();
  m_Name = attribute.m_Name;
  m_Value = attribute.m_Value;
  m_X = attribute.m_X;
@@ -4649,12 +5911,15 @@ void CAttribute::assign(const CAttribute& attribute)
  m_Ratio = attribute.m_Ratio;
  m_Rotation  = attribute.m_Rotation;
  m_Reflection = attribute.m_Reflection;
+ m_Spin = attribute.m_Spin;
+ m_Align = attribute.m_Align;
  m_Display = attribute.m_Display;
  m_Constant = attribute.m_Constant;
 }
 
 void CAttribute::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
  m_Size *= factor;
@@ -4674,6 +5939,7 @@ void CAttribute::show(std::ostream& out, const int level)
 
 bool CAttribute::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="attribute") e = e.nextSiblingElement("attribute");
  if (!e.isNull())
@@ -4733,8 +5999,7 @@ bool CAttribute::readFromXML(const QDomElement& root, const CEagleDocumentOption
   s = e.attribute("rot");
   if (!s.isEmpty())
   {
-   bool spin;
-   decodeTransformation(s,m_Rotation,m_Reflection,spin);
+   decodeTransformation(s,m_Rotation,m_Reflection,m_Spin);
    /*
    if (s.at(0)=='R')
    {
@@ -4791,10 +6056,10 @@ bool CAttribute::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
   {
    e.setAttribute("ratio",QString("%1").arg(m_Ratio));
   }
-  if (options.writeDefaults() || CAttribute::DEFAULT_ROTATION!=m_Rotation || m_Reflection)
+  if (options.writeDefaults() || CAttribute::DEFAULT_ROTATION!=m_Rotation || m_Reflection || m_Spin)
   {
    //e.setAttribute("rot",QString("R%1").arg(m_Rotation));
-   e.setAttribute("rot",encodeTransformation(m_Rotation,m_Reflection,false));
+   e.setAttribute("rot",encodeTransformation(m_Rotation,m_Reflection,m_Spin));
   }
   if (options.writeDefaults() || CText::taBottomLeft!=m_Align)
   {
@@ -4814,6 +6079,25 @@ bool CAttribute::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CAttribute::hashFields(CContentHash& hash)
+{
+ hash.add(QString("attribute"));
+ hash.add(m_Name);
+ hash.add(m_Value);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Size);
+ hash.add(m_Layer);
+ hash.add(m_Font);
+ hash.add(m_Ratio);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ hash.add(m_Spin);
+ hash.add(m_Align);
+ hash.add(m_Display);
+ hash.add(m_Constant);
+}
+
 //------------------------------------------------------------------------------
 
 CPinRef::CPinRef(const CPinRef& pinRef)
@@ -4838,6 +6122,7 @@ void CPinRef::operator =(const CPinRef& pinRef)
 
 void CPinRef::clear(void)
 {
+ modify();
  m_Part.clear();
  m_Gate.clear();
  m_Pin.clear();
@@ -4845,6 +6130,7 @@ void CPinRef::clear(void)
 
 void CPinRef::assign(const CPinRef& pinRef)
 {
+ modify();
  m_Part = pinRef.m_Part;
  m_Gate = pinRef.m_Gate;
  m_Pin = pinRef.m_Pin;
@@ -4860,6 +6146,7 @@ void CPinRef::show(std::ostream& out, const int level)
 
 bool CPinRef::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="pinref") e = e.nextSiblingElement("pinref");
  if (!e.isNull())
@@ -4898,6 +6185,14 @@ bool CPinRef::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CPinRef::hashFields(CContentHash& hash)
+{
+ hash.add(QString("pinref"));
+ hash.add(m_Part);
+ hash.add(m_Gate);
+ hash.add(m_Pin);
+}
+
 //------------------------------------------------------------------------------
 
 CPortRef::CPortRef(const CPortRef& portRef)
@@ -4922,12 +6217,14 @@ void CPortRef::operator =(const CPortRef& portRef)
 
 void CPortRef::clear(void)
 {
+ modify();
  m_ModuleInstance.clear();
  m_Port.clear();
 }
 
 void CPortRef::assign(const CPortRef& portRef)
 {
+ modify();
  m_ModuleInstance = portRef.m_ModuleInstance;
  m_Port = portRef.m_Port;
 }
@@ -4942,6 +6239,7 @@ void CPortRef::show(std::ostream& out, const int level)
 
 bool CPortRef::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="portref") e = e.nextSiblingElement("portref");
  if (!e.isNull())
@@ -4974,6 +6272,13 @@ bool CPortRef::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CPortRef::hashFields(CContentHash& hash)
+{
+ hash.add(QString("portref"));
+ hash.add(m_ModuleInstance);
+ hash.add(m_Port);
+}
+
 //------------------------------------------------------------------------------
 
 CContactRef::CContactRef(const CContactRef& contactRef)
@@ -4998,6 +6303,7 @@ void CContactRef::operator =(const CContactRef& contactRef)
 
 void CContactRef::clear(void)
 {
+ modify();
  m_Element.clear();
  m_Pad.clear();
  m_Route = CConnect::crAll;
@@ -5006,6 +6312,7 @@ void CContactRef::clear(void)
 
 void CContactRef::assign(const CContactRef& contactRef)
 {
+ modify();
  m_Element = contactRef.m_Element;
  m_Pad = contactRef.m_Pad;
  m_Route = contactRef.m_Route;
@@ -5024,6 +6331,7 @@ void CContactRef::show(std::ostream& out, const int level)
 
 bool CContactRef::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="contactref") e = e.nextSiblingElement("contactref");
  if (!e.isNull())
@@ -5075,6 +6383,15 @@ bool CContactRef::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
  return false;
 }
 
+void CContactRef::hashFields(CContentHash& hash)
+{
+ hash.add(QString("contactref"));
+ hash.add(m_Element);
+ hash.add(m_Pad);
+ hash.add(m_Route);
+ hash.add(m_RouteTag);
+}
+
 //------------------------------------------------------------------------------
 
 CTechnology::CTechnology(const CTechnology& technology)
@@ -5099,6 +6416,7 @@ void CTechnology::operator =(const CTechnology& technology)
 
 void CTechnology::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   if (0!=m_Attributes[i]) delete m_Attributes[i];
@@ -5113,7 +6431,7 @@ void CTechnology::assign(const CTechnology& technology)
  for (int i = 0; i < technology.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*technology.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  m_Name = technology.m_Name;
 }
@@ -5143,6 +6461,7 @@ void CTechnology::show(std::ostream& out, const int level)
 
 bool CTechnology::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="technology") e = e.nextSiblingElement("technology");
  if (!e.isNull())
@@ -5154,7 +6473,7 @@ bool CTechnology::readFromXML(const QDomElement& root, const CEagleDocumentOptio
    while (!cc.isNull())
    {
     CAttribute *a = new CAttribute();
-    m_Attributes.append(a);
+    m_Attributes.append(link(a));
     a->readFromXML(cc,options);
     cc = cc.nextSiblingElement("attribute");
    }
@@ -5177,7 +6496,7 @@ bool CTechnology::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
   e.setAttribute("name",m_Name);
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,e,options);
+   writeChild(*m_Attributes[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -5185,6 +6504,16 @@ bool CTechnology::writeToXML(QDomDocument& host, QDomElement& root, const CEagle
  return false;
 }
 
+void CTechnology::hashFields(CContentHash& hash)
+{
+ hash.add(QString("technology"));
+ hash.add(m_Name);
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CInstance::CInstance(const CInstance& instance)
@@ -5209,6 +6538,7 @@ void CInstance::operator =(const CInstance& instance)
 
 void CInstance::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   if (0!=m_Attributes[i]) delete m_Attributes[i];
@@ -5230,7 +6560,7 @@ void CInstance::assign(const CInstance& instance)
  for (int i = 0; i < instance.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*instance.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  m_Part = instance.m_Part;
  m_Gate = instance.m_Gate;
@@ -5243,6 +6573,7 @@ void CInstance::assign(const CInstance& instance)
 
 void CInstance::scale(const double factor)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   m_Attributes[i]->scale(factor);
@@ -5269,6 +6600,7 @@ void CInstance::show(std::ostream& out, const int level)
 
 bool CInstance::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="instance") e = e.nextSiblingElement("instance");
  if (!e.isNull())
@@ -5277,7 +6609,7 @@ bool CInstance::readFromXML(const QDomElement& root, const CEagleDocumentOptions
   while (!c.isNull())
   {
    CAttribute *a = new CAttribute();
-   m_Attributes.append(a);
+   m_Attributes.append(link(a));
    a->readFromXML(c,options);
    c = c.nextSiblingElement("attribute");
   }
@@ -5350,7 +6682,7 @@ bool CInstance::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDo
   }
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,e,options);
+   writeChild(*m_Attributes[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -5358,14 +6690,39 @@ bool CInstance::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDo
  return false;
 }
 
+void CInstance::hashFields(CContentHash& hash)
+{
+ hash.add(QString("instance"));
+ hash.add(m_Part);
+ hash.add(m_Gate);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Smashed);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ hash.add(m_Spin);
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+}
+
 void CInstance::setRotation(const double value)
 {
+ modify();
  if ((value<45.0) || (value>=315.0)) { m_Rotation = 0.0; }
  else if (value<135.0) { m_Rotation = 90.0; }
  else if (value<225.0) { m_Rotation = 180.0; }
  else if (value<315.0) { m_Rotation = 270.0; }
 }
 
+CBoundingBox CInstance::boundingBox(CSymbol& symbol)
+{
+ CBoundingBox result;
+ includePlaced(result,symbol.boundingBox(),m_X,m_Y,m_Rotation,m_Reflection);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CModuleInstance::CModuleInstance(const CModuleInstance& instance)
@@ -5390,6 +6747,7 @@ void CModuleInstance::operator =(const CModuleInstance& instance)
 
 void CModuleInstance::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Module.clear();
  m_ModuleVariant.clear();
@@ -5418,6 +6776,7 @@ void CModuleInstance::assign(const CModuleInstance& instance)
 
 void CModuleInstance::scale(const double factor)
 {
+ modify();
  m_X *= factor;
  m_Y *= factor;
 }
@@ -5436,6 +6795,7 @@ void CModuleInstance::show(std::ostream& out, const int level)
 
 bool CModuleInstance::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="moduleinst") e = e.nextSiblingElement("moduleinst");
  if (!e.isNull())
@@ -5533,8 +6893,24 @@ bool CModuleInstance::writeToXML(QDomDocument& host, QDomElement& root, const CE
  return false;
 }
 
+void CModuleInstance::hashFields(CContentHash& hash)
+{
+ hash.add(QString("moduleinst"));
+ hash.add(m_Name);
+ hash.add(m_Module);
+ hash.add(m_ModuleVariant);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Offset);
+ hash.add(m_Smashed);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ hash.add(m_Spin);
+}
+
 void CModuleInstance::setRotation(const double value)
 {
+ modify();
  if ((value<45.0) || (value>=315.0)) { m_Rotation = 0.0; }
  else if (value<135.0) { m_Rotation = 90.0; }
  else if (value<225.0) { m_Rotation = 180.0; }
@@ -5565,6 +6941,7 @@ void CPart::operator =(const CPart& part)
 
 void CPart::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   if (0!=m_Attributes[i]) delete m_Attributes[i];
@@ -5589,12 +6966,12 @@ void CPart::assign(const CPart& part)
  for (int i = 0; i < part.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*part.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  for (int i = 0; i < part.m_Variants.size(); i++)
  {
   CVariant *v = new CVariant(*part.m_Variants.at(i));
-  m_Variants.append(v);
+  m_Variants.append(link(v));
  }
  m_Name = part.m_Name;
  m_Library = part.m_Library;
@@ -5638,6 +7015,7 @@ void CPart::show(std::ostream& out, const int level)
 
 bool CPart::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="part") e = e.nextSiblingElement("part");
  if (!e.isNull())
@@ -5646,7 +7024,7 @@ bool CPart::readFromXML(const QDomElement& root, const CEagleDocumentOptions& op
   while (!c.isNull())
   {
    CAttribute *a = new CAttribute();
-   m_Attributes.append(a);
+   m_Attributes.append(link(a));
    a->readFromXML(c,options);
    c = c.nextSiblingElement("attribute");
   }
@@ -5654,7 +7032,7 @@ bool CPart::readFromXML(const QDomElement& root, const CEagleDocumentOptions& op
   while (!c.isNull())
   {
    CVariant *v = new CVariant();
-   m_Variants.append(v);
+   m_Variants.append(link(v));
    v->readFromXML(c,options);
    c = c.nextSiblingElement("variant");
   }
@@ -5712,11 +7090,11 @@ bool CPart::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
   }
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,e,options);
+   writeChild(*m_Attributes[i],host,e,options);
   }
   for (int i = 0; i < m_Variants.size(); i++)
   {
-   m_Variants[i]->writeToXML(host,e,options);
+   writeChild(*m_Variants[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -5724,6 +7102,25 @@ bool CPart::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CPart::hashFields(CContentHash& hash)
+{
+ hash.add(QString("part"));
+ hash.add(m_Name);
+ hash.add(m_Library);
+ hash.add(m_DeviceSet);
+ hash.add(m_Device);
+ hash.add(m_Technology);
+ hash.add(m_Value);
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+ for (int i = 0; i < m_Variants.size(); i++)
+ {
+  hash.add(m_Variants[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CPolygon::CPolygon(const QList<CVertex*>& vertices, const TDimension width,
@@ -5732,7 +7129,10 @@ CPolygon::CPolygon(const QList<CVertex*>& vertices, const TDimension width,
  const bool orphans, const bool thermals, const int rank)
 {
  clear();
- m_Vertices.append(vertices);
+ for (int i = 0; i < vertices.size(); i++)
+ {
+  m_Vertices.append(link(vertices.at(i)));
+ }
  m_Width = width;
  m_Layer = layer;
  m_Spacing = spacing;
@@ -5776,6 +7176,7 @@ void CPolygon::operator =(const CPolygon& polygon)
 
 void CPolygon::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Vertices.size(); i++)
  {
   if (0!=m_Vertices[i]) delete m_Vertices[i];
@@ -5797,7 +7198,7 @@ void CPolygon::assign(const CPolygon& polygon)
  for (int i = 0; i < polygon.m_Vertices.size(); i++)
  {
   CVertex *v = new CVertex(*polygon.m_Vertices.at(i));
-  m_Vertices.append(v);
+  m_Vertices.append(link(v));
  }
  m_Width = polygon.m_Width;
  m_Layer = polygon.m_Layer;
@@ -5811,6 +7212,7 @@ void CPolygon::assign(const CPolygon& polygon)
 
 void CPolygon::scale(const double factor)
 {
+ modify();
  for (int i = 0; i < m_Vertices.size(); i++)
  {
   m_Vertices[i]->scale(factor);
@@ -5840,6 +7242,7 @@ void CPolygon::show(std::ostream& out, const int level)
 
 bool CPolygon::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="polygon") e = e.nextSiblingElement("polygon");
  if (!e.isNull())
@@ -5848,7 +7251,7 @@ bool CPolygon::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CVertex *v = new CVertex();
-   m_Vertices.append(v);
+   m_Vertices.append(link(v));
    v->readFromXML(c,options);
    c = c.nextSiblingElement("vertex");
   }
@@ -5938,7 +7341,7 @@ bool CPolygon::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
   }
   for (int i = 0; i < m_Vertices.size(); i++)
   {
-   m_Vertices[i]->writeToXML(host,e,options);
+   writeChild(*m_Vertices[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -5946,6 +7349,35 @@ bool CPolygon::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CPolygon::hashFields(CContentHash& hash)
+{
+ hash.add(QString("polygon"));
+ hash.add(m_Width);
+ hash.add(m_Layer);
+ hash.add(m_Spacing);
+ hash.add(m_Pour);
+ hash.add(m_Isolate);
+ hash.add(m_Orphans);
+ hash.add(m_Thermals);
+ hash.add(m_Rank);
+ for (int i = 0; i < m_Vertices.size(); i++)
+ {
+  hash.add(m_Vertices[i]->contentHash());
+ }
+}
+
+CBoundingBox CPolygon::boundingBox(void)
+{
+ CBoundingBox result;
+ for (int i = 0; i < m_Vertices.size(); i++)
+ {
+  CVertex *a = m_Vertices[i];
+  CVertex *b = m_Vertices[(i+1) % m_Vertices.size()];
+  includeCurve(result,a->x(),a->y(),b->x(),b->y(),a->curve(),0.5*m_Width);
+ }
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CElement::CElement(const CElement& element)
@@ -5970,6 +7402,7 @@ void CElement::operator =(const CElement& element)
 
 void CElement::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   if (0!=m_Attributes[i]) delete m_Attributes[i];
@@ -5999,12 +7432,12 @@ void CElement::assign(const CElement& element)
  for (int i = 0; i < element.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*element.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  for (int i = 0; i < element.m_Variants.size(); i++)
  {
   CVariant *v = new CVariant(*element.m_Variants.at(i));
-  m_Variants.append(v);
+  m_Variants.append(link(v));
  }
  m_Name = element.m_Name;
  m_Library = element.m_Library;
@@ -6021,6 +7454,7 @@ void CElement::assign(const CElement& element)
 
 void CElement::scale(const double factor)
 {
+ modify();
  for (int i = 0; i < m_Attributes.size(); i++)
  {
   m_Attributes[i]->scale(factor);
@@ -6060,6 +7494,7 @@ void CElement::show(std::ostream& out, const int level)
 
 bool CElement::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="element") e = e.nextSiblingElement("element");
  if (!e.isNull())
@@ -6068,7 +7503,7 @@ bool CElement::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CAttribute *a = new CAttribute();
-   m_Attributes.append(a);
+   m_Attributes.append(link(a));
    a->readFromXML(c,options);
    c = c.nextSiblingElement("attribute");
   }
@@ -6076,7 +7511,7 @@ bool CElement::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CVariant *v = new CVariant();
-   m_Variants.append(v);
+   m_Variants.append(link(v));
    v->readFromXML(c,options);
    c = c.nextSiblingElement("variant");
   }
@@ -6185,11 +7620,11 @@ bool CElement::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
   }
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,e,options);
+   writeChild(*m_Attributes[i],host,e,options);
   }
   for (int i = 0; i < m_Variants.size(); i++)
   {
-   m_Variants[i]->writeToXML(host,e,options);
+   writeChild(*m_Variants[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -6197,6 +7632,38 @@ bool CElement::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CElement::hashFields(CContentHash& hash)
+{
+ hash.add(QString("element"));
+ hash.add(m_Name);
+ hash.add(m_Library);
+ hash.add(m_Package);
+ hash.add(m_Value);
+ hash.add(m_X);
+ hash.add(m_Y);
+ hash.add(m_Populate);
+ hash.add(m_Locked);
+ hash.add(m_Smashed);
+ hash.add(m_Rotation);
+ hash.add(m_Reflection);
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+ for (int i = 0; i < m_Variants.size(); i++)
+ {
+  hash.add(m_Variants[i]->contentHash());
+ }
+}
+
+CBoundingBox CElement::boundingBox(CBoard& board)
+{
+ CBoundingBox result;
+ CPackage *p = board.findPackage(m_Library,m_Package);
+ includePlaced(result,(0!=p) ? p->boundingBox() : CBoundingBox(),m_X,m_Y,m_Rotation,m_Reflection);
+ return result;
+}
+
 //------------------------------------------------------------------------------
 
 CSignal::CSignal(const CSignal& signal)
@@ -6221,6 +7688,8 @@ void CSignal::operator =(const CSignal& signal)
 
 void CSignal::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
  for (int i = 0; i < m_ContactRefs.size(); i++)
  {
   if (0!=m_ContactRefs[i]) delete m_ContactRefs[i];
@@ -6252,22 +7721,22 @@ void CSignal::assign(const CSignal& signal)
  for (int i = 0; i < signal.m_ContactRefs.size(); i++)
  {
   CContactRef *c = new CContactRef(*signal.m_ContactRefs.at(i));
-  m_ContactRefs.append(c);
+  m_ContactRefs.append(link(c));
  }
  for (int i = 0; i < signal.m_Polygons.size(); i++)
  {
   CPolygon *p = new CPolygon(*signal.m_Polygons.at(i));
-  m_Polygons.append(p);
+  m_Polygons.append(link(p));
  }
  for (int i = 0; i < signal.m_Wires.size(); i++)
  {
   CWire *w = new CWire(*signal.m_Wires.at(i));
-  m_Wires.append(w);
+  m_Wires.append(link(w));
  }
  for (int i = 0; i < signal.m_Vias.size(); i++)
  {
   CVia *v = new CVia(*signal.m_Vias.at(i));
-  m_Vias.append(v);
+  m_Vias.append(link(v));
  }
  m_Name.clear();
  m_Class = 0;
@@ -6331,6 +7800,7 @@ void CSignal::show(std::ostream& out, const int level)
 
 bool CSignal::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="signal") e = e.nextSiblingElement("signal");
  if (!e.isNull())
@@ -6339,7 +7809,7 @@ bool CSignal::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CContactRef *r = new CContactRef();
-   m_ContactRefs.append(r);
+   m_ContactRefs.append(link(r));
    r->readFromXML(c,options);
    c = c.nextSiblingElement("contactref");
   }
@@ -6347,7 +7817,7 @@ bool CSignal::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPolygon *p = new CPolygon();
-   m_Polygons.append(p);
+   m_Polygons.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("polygon");
   }
@@ -6355,7 +7825,7 @@ bool CSignal::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CWire *w = new CWire();
-   m_Wires.append(w);
+   m_Wires.append(link(w));
    w->readFromXML(c,options);
    c = c.nextSiblingElement("wire");
   }
@@ -6363,7 +7833,7 @@ bool CSignal::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CVia *v = new CVia();
-   m_Vias.append(v);
+   m_Vias.append(link(v));
    v->readFromXML(c,options);
    c = c.nextSiblingElement("via");
   }
@@ -6406,19 +7876,19 @@ bool CSignal::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
   }
   for (int i = 0; i < m_ContactRefs.size(); i++)
   {
-   m_ContactRefs[i]->writeToXML(host,e,options);
+   writeChild(*m_ContactRefs[i],host,e,options);
   }
   for (int i = 0; i < m_Polygons.size(); i++)
   {
-   m_Polygons[i]->writeToXML(host,e,options);
+   writeChild(*m_Polygons[i],host,e,options);
   }
   for (int i = 0; i < m_Wires.size(); i++)
   {
-   m_Wires[i]->writeToXML(host,e,options);
+   writeChild(*m_Wires[i],host,e,options);
   }
   for (int i = 0; i < m_Vias.size(); i++)
   {
-   m_Vias[i]->writeToXML(host,e,options);
+   writeChild(*m_Vias[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -6426,6 +7896,53 @@ bool CSignal::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CSignal::hashFields(CContentHash& hash)
+{
+ hash.add(QString("signal"));
+ hash.add(m_Name);
+ hash.add(m_Class);
+ hash.add(m_AirWiresHidden);
+ for (int i = 0; i < m_ContactRefs.size(); i++)
+ {
+  hash.add(m_ContactRefs[i]->contentHash());
+ }
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  hash.add(m_Polygons[i]->contentHash());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  hash.add(m_Wires[i]->contentHash());
+ }
+ for (int i = 0; i < m_Vias.size(); i++)
+ {
+  hash.add(m_Vias[i]->contentHash());
+ }
+}
+
+const CBoundingBox& CSignal::boundingBox(void)
+{
+ int current = revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  m_BoundingBox.include(m_Polygons[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  m_BoundingBox.include(m_Wires[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Vias.size(); i++)
+ {
+  m_BoundingBox.include(m_Vias[i]->boundingBox());
+ }
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
+}
+
 //------------------------------------------------------------------------------
 
 CSegment::CSegment(const CSegment& segment)
@@ -6450,6 +7967,7 @@ void CSegment::operator =(const CSegment& segment)
 
 void CSegment::clear(void)
 {
+ modify();
  for (int i = 0; i < m_PinRefs.size(); i++)
  {
   if (0!=m_PinRefs[i]) delete m_PinRefs[i];
@@ -6483,27 +8001,27 @@ void CSegment::assign(const CSegment& segment)
  for (int i = 0; i < segment.m_PinRefs.size(); i++)
  {
   CPinRef *r = new CPinRef(*segment.m_PinRefs.at(i));
-  m_PinRefs.append(r);
+  m_PinRefs.append(link(r));
  }
  for (int i = 0; i < segment.m_PortRefs.size(); i++)
  {
   CPortRef *r = new CPortRef(*segment.m_PortRefs.at(i));
-  m_PortRefs.append(r);
+  m_PortRefs.append(link(r));
  }
  for (int i = 0; i < segment.m_Wires.size(); i++)
  {
   CWire *w = new CWire(*segment.m_Wires.at(i));
-  m_Wires.append(w);
+  m_Wires.append(link(w));
  }
  for (int i = 0; i < segment.m_Junctions.size(); i++)
  {
   CJunction *j = new CJunction(*segment.m_Junctions.at(i));
-  m_Junctions.append(j);
+  m_Junctions.append(link(j));
  }
  for (int i = 0; i < segment.m_Labels.size(); i++)
  {
   CLabel *l = new CLabel(*segment.m_Labels.at(i));
-  m_Labels.append(l);
+  m_Labels.append(link(l));
  }
 }
 
@@ -6567,6 +8085,7 @@ void CSegment::show(std::ostream& out, const int level)
 
 bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="segment") e = e.nextSiblingElement("segment");
  if (!e.isNull())
@@ -6575,7 +8094,7 @@ bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPinRef *r = new CPinRef();
-   m_PinRefs.append(r);
+   m_PinRefs.append(link(r));
    r->readFromXML(c,options);
    c = c.nextSiblingElement("pinref");
   }
@@ -6585,7 +8104,7 @@ bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!c.isNull())
    {
     CPortRef *r = new CPortRef();
-    m_PortRefs.append(r);
+    m_PortRefs.append(link(r));
     r->readFromXML(c,options);
     c = c.nextSiblingElement("portref");
    }
@@ -6594,7 +8113,7 @@ bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CWire *w = new CWire();
-   m_Wires.append(w);
+   m_Wires.append(link(w));
    w->readFromXML(c,options);
    c = c.nextSiblingElement("wire");
   }
@@ -6602,7 +8121,7 @@ bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CJunction *j = new CJunction();
-   m_Junctions.append(j);
+   m_Junctions.append(link(j));
    j->readFromXML(c,options);
    c = c.nextSiblingElement("junction");
   }
@@ -6610,7 +8129,7 @@ bool CSegment::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CLabel *l = new CLabel();
-   m_Labels.append(l);
+   m_Labels.append(link(l));
    l->readFromXML(c,options);
    c = c.nextSiblingElement("label");
   }
@@ -6626,31 +8145,56 @@ bool CSegment::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
   QDomElement e = host.createElement("segment");
   for (int i = 0; i < m_PinRefs.size(); i++)
   {
-   m_PinRefs[i]->writeToXML(host,e,options);
+   writeChild(*m_PinRefs[i],host,e,options);
   }
   if (options.version()>=CVersionNumber(7,0))
   {
    for (int i = 0; i < m_PortRefs.size(); i++)
    {
-    m_PortRefs[i]->writeToXML(host,e,options);
+    writeChild(*m_PortRefs[i],host,e,options);
    }
   }
   for (int i = 0; i < m_Wires.size(); i++)
   {
-   m_Wires[i]->writeToXML(host,e,options);
+   writeChild(*m_Wires[i],host,e,options);
   }
   for (int i = 0; i < m_Junctions.size(); i++)
   {
-   m_Junctions[i]->writeToXML(host,e,options);
+   writeChild(*m_Junctions[i],host,e,options);
   }
   for (int i = 0; i < m_Labels.size(); i++)
   {
-   m_Labels[i]->writeToXML(host,e,options);
+   writeChild(*m_Labels[i],host,e,options);
   }
   root.appendChild(e);
   return true;
  }
- return false;
+ return false;
+}
+
+void CSegment::hashFields(CContentHash& hash)
+{
+ hash.add(QString("segment"));
+ for (int i = 0; i < m_PinRefs.size(); i++)
+ {
+  hash.add(m_PinRefs[i]->contentHash());
+ }
+ for (int i = 0; i < m_PortRefs.size(); i++)
+ {
+  hash.add(m_PortRefs[i]->contentHash());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  hash.add(m_Wires[i]->contentHash());
+ }
+ for (int i = 0; i < m_Junctions.size(); i++)
+ {
+  hash.add(m_Junctions[i]->contentHash());
+ }
+ for (int i = 0; i < m_Labels.size(); i++)
+ {
+  hash.add(m_Labels[i]->contentHash());
+ }
 }
 
 //------------------------------------------------------------------------------
@@ -6677,6 +8221,7 @@ void CNet::operator =(const CNet& net)
 
 void CNet::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Segments.size(); i++)
  {
   if (0!=m_Segments[i]) delete m_Segments[i];
@@ -6692,7 +8237,7 @@ void CNet::assign(const CNet& net)
  for (int i = 0; i < net.m_Segments.size(); i++)
  {
   CSegment *s = new CSegment(*net.m_Segments.at(i));
-  m_Segments.append(s);
+  m_Segments.append(link(s));
  }
  m_Name = net.m_Name;
  m_Class = net.m_Class;
@@ -6724,6 +8269,7 @@ void CNet::show(std::ostream& out, const int level)
 
 bool CNet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="net") e = e.nextSiblingElement("net");
  if (!e.isNull())
@@ -6732,7 +8278,7 @@ bool CNet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& opt
   while (!c.isNull())
   {
    CSegment *g = new CSegment();
-   m_Segments.append(g);
+   m_Segments.append(link(g));
    g->readFromXML(c,options);
    c = c.nextSiblingElement("segment");
   }
@@ -6765,7 +8311,7 @@ bool CNet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
   }
   for (int i = 0; i < m_Segments.size(); i++)
   {
-   m_Segments[i]->writeToXML(host,e,options);
+   writeChild(*m_Segments[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -6773,6 +8319,17 @@ bool CNet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CNet::hashFields(CContentHash& hash)
+{
+ hash.add(QString("net"));
+ hash.add(m_Name);
+ hash.add(m_Class);
+ for (int i = 0; i < m_Segments.size(); i++)
+ {
+  hash.add(m_Segments[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CBus::CBus(const CBus& bus)
@@ -6797,6 +8354,7 @@ void CBus::operator =(const CBus& bus)
 
 void CBus::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Segments.size(); i++)
  {
   if (0!=m_Segments[i]) delete m_Segments[i];
@@ -6811,7 +8369,7 @@ void CBus::assign(const CBus& bus)
  for (int i = 0; i < bus.m_Segments.size(); i++)
  {
   CSegment *s = new CSegment(*bus.m_Segments.at(i));
-  m_Segments.append(s);
+  m_Segments.append(link(s));
  }
  m_Name = bus.m_Name;
 }
@@ -6840,6 +8398,7 @@ void CBus::show(std::ostream& out, const int level)
 
 bool CBus::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="bus") e = e.nextSiblingElement("bus");
  if (!e.isNull())
@@ -6848,7 +8407,7 @@ bool CBus::readFromXML(const QDomElement& root, const CEagleDocumentOptions& opt
   while (!c.isNull())
   {
    CSegment *g = new CSegment();
-   m_Segments.append(g);
+   m_Segments.append(link(g));
    g->readFromXML(c,options);
    c = c.nextSiblingElement("segment");
   }
@@ -6870,7 +8429,7 @@ bool CBus::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
   e.setAttribute("name",m_Name);
   for (int i = 0; i < m_Segments.size(); i++)
   {
-   m_Segments[i]->writeToXML(host,e,options);
+   writeChild(*m_Segments[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -6878,6 +8437,16 @@ bool CBus::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumen
  return false;
 }
 
+void CBus::hashFields(CContentHash& hash)
+{
+ hash.add(QString("bus"));
+ hash.add(m_Name);
+ for (int i = 0; i < m_Segments.size(); i++)
+ {
+  hash.add(m_Segments[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CDevice::CDevice(const QString& name, const QString& package)
@@ -6908,6 +8477,7 @@ void CDevice::operator =(const CDevice& device)
 
 void CDevice::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Connects.size(); i++)
  {
   if (0!=m_Connects[i]) delete m_Connects[i];
@@ -6928,12 +8498,12 @@ void CDevice::assign(const CDevice& device)
  for (int i = 0; i < device.m_Connects.size(); i++)
  {
   CConnect *c = new CConnect(*device.m_Connects.at(i));
-  m_Connects.append(c);
+  m_Connects.append(link(c));
  }
  for (int i = 0; i < device.m_Technologies.size(); i++)
  {
   CTechnology *t = new CTechnology(*device.m_Technologies.at(i));
-  m_Technologies.append(t);
+  m_Technologies.append(link(t));
  }
  m_Name = device.m_Name;
  m_Package = device.m_Package;
@@ -6972,6 +8542,7 @@ void CDevice::show(std::ostream& out, const int level)
 
 bool CDevice::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="device") e = e.nextSiblingElement("device");
  if (!e.isNull())
@@ -6983,7 +8554,7 @@ bool CDevice::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CConnect *n = new CConnect();
-    m_Connects.append(n);
+    m_Connects.append(link(n));
     n->readFromXML(cc,options);
     cc = cc.nextSiblingElement("connect");
    }
@@ -6995,7 +8566,7 @@ bool CDevice::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CTechnology *t = new CTechnology();
-    m_Technologies.append(t);
+    m_Technologies.append(link(t));
     t->readFromXML(cc,options);
     cc = cc.nextSiblingElement("technology");
    }
@@ -7029,13 +8600,13 @@ bool CDevice::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
   e.appendChild(c);
   for (int i = 0; i < m_Connects.size(); i++)
   {
-   m_Connects[i]->writeToXML(host,c,options);
+   writeChild(*m_Connects[i],host,c,options);
   }
   c = host.createElement("technologies");
   e.appendChild(c);
   for (int i = 0; i < m_Technologies.size(); i++)
   {
-   m_Technologies[i]->writeToXML(host,c,options);
+   writeChild(*m_Technologies[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -7043,10 +8614,28 @@ bool CDevice::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CDevice::hashFields(CContentHash& hash)
+{
+ hash.add(QString("device"));
+ hash.add(m_Name);
+ hash.add(m_Package);
+ hash.add(QString("connects"));
+ for (int i = 0; i < m_Connects.size(); i++)
+ {
+  hash.add(m_Connects[i]->contentHash());
+ }
+ hash.add(QString("technologies"));
+ for (int i = 0; i < m_Technologies.size(); i++)
+ {
+  hash.add(m_Technologies[i]->contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CDeviceSet::CDeviceSet(const QString& name, const QString& prefix, const bool userValue)
 {
+ link(&m_Description);
  setName(name);
  setPrefix(prefix);
  setUserValue(userValue);
@@ -7054,11 +8643,13 @@ CDeviceSet::CDeviceSet(const QString& name, const QString& prefix, const bool us
 
 CDeviceSet::CDeviceSet(const CDeviceSet& deviceSet)
 {
+ link(&m_Description);
  assign(deviceSet);
 }
 
 CDeviceSet::CDeviceSet(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -7074,6 +8665,7 @@ void CDeviceSet::operator =(const CDeviceSet& deviceSet)
 
 void CDeviceSet::clear(void)
 {
+ modify();
  m_Description.clear();
  for (int i = 0; i < m_Gates.size(); i++)
  {
@@ -7092,16 +8684,17 @@ void CDeviceSet::clear(void)
 
 void CDeviceSet::assign(const CDeviceSet& deviceSet)
 {
+ modify();
  m_Description = deviceSet.m_Description;
  for (int i = 0; i < deviceSet.m_Gates.size(); i++)
  {
   CGate *g = new CGate(*deviceSet.m_Gates.at(i));
-  m_Gates.append(g);
+  m_Gates.append(link(g));
  }
  for (int i = 0; i < deviceSet.m_Devices.size(); i++)
  {
   CDevice *d = new CDevice(*deviceSet.m_Devices.at(i));
-  m_Devices.append(d);
+  m_Devices.append(link(d));
  }
  m_Name = deviceSet.m_Name;
  m_Prefix = deviceSet.m_Prefix;
@@ -7148,6 +8741,7 @@ void CDeviceSet::show(std::ostream& out, const int level)
 
 bool CDeviceSet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="deviceset") e = e.nextSiblingElement("deviceset");
  if (!e.isNull())
@@ -7164,7 +8758,7 @@ bool CDeviceSet::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CGate *g = new CGate();
-    m_Gates.append(g);
+    m_Gates.append(link(g));
     g->readFromXML(cc,options);
     cc = cc.nextSiblingElement("gate");
    }
@@ -7176,7 +8770,7 @@ bool CDeviceSet::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CDevice *d = new CDevice();
-    m_Devices.append(d);
+    m_Devices.append(link(d));
     d->readFromXML(cc,options);
     cc = cc.nextSiblingElement("device");
    }
@@ -7215,18 +8809,18 @@ bool CDeviceSet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
   {
    e.setAttribute("uservalue",CEntity::toString(m_UserValue));
   }
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   QDomElement c = host.createElement("gates");
   e.appendChild(c);
   for (int i = 0; i < m_Gates.size(); i++)
   {
-   m_Gates[i]->writeToXML(host,c,options);
+   writeChild(*m_Gates[i],host,c,options);
   }
   c = host.createElement("devices");
   e.appendChild(c);
   for (int i = 0; i < m_Devices.size(); i++)
   {
-   m_Devices[i]->writeToXML(host,c,options);
+   writeChild(*m_Devices[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -7234,6 +8828,25 @@ bool CDeviceSet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CDeviceSet::hashFields(CContentHash& hash)
+{
+ hash.add(QString("deviceset"));
+ hash.add(m_Name);
+ hash.add(m_Prefix);
+ hash.add(m_UserValue);
+ hash.add(m_Description.contentHash());
+ hash.add(QString("gates"));
+ for (int i = 0; i < m_Gates.size(); i++)
+ {
+  hash.add(m_Gates[i]->contentHash());
+ }
+ hash.add(QString("devices"));
+ for (int i = 0; i < m_Devices.size(); i++)
+ {
+  hash.add(m_Devices[i]->contentHash());
+ }
+}
+
 CGate *CDeviceSet::findGateByName(const QString& name)
 {
  CGate *result = 0;
@@ -7269,16 +8882,19 @@ CDevice *CDeviceSet::findDeviceByName(const QString& name)
 
 CSymbol::CSymbol(const QString& name)
 {
+ link(&m_Description);
  m_Name = name;
 }
 
 CSymbol::CSymbol(const CSymbol& symbol)
 {
+ link(&m_Description);
  assign(symbol);
 }
 
 CSymbol::CSymbol(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -7294,6 +8910,8 @@ void CSymbol::operator =(const CSymbol& symbol)
 
 void CSymbol::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
  m_Description.clear();
  for (int i = 0; i < m_Polygons.size(); i++)
  {
@@ -7345,42 +8963,42 @@ void CSymbol::assign(const CSymbol& symbol)
  for (int i = 0; i < symbol.m_Polygons.size(); i++)
  {
   CPolygon *p = new CPolygon(*symbol.m_Polygons.at(i));
-  m_Polygons.append(p);
+  m_Polygons.append(link(p));
  }
  for (int i = 0; i < symbol.m_Wires.size(); i++)
  {
   CWire *w = new CWire(*symbol.m_Wires.at(i));
-  m_Wires.append(w);
+  m_Wires.append(link(w));
  }
  for (int i = 0; i < symbol.m_Texts.size(); i++)
  {
   CText *t = new CText(*symbol.m_Texts.at(i));
-  m_Texts.append(t);
+  m_Texts.append(link(t));
  }
  for (int i = 0; i < symbol.m_Dimensions.size(); i++)
  {
   CDimension *d = new CDimension(*symbol.m_Dimensions.at(i));
-  m_Dimensions.append(d);
+  m_Dimensions.append(link(d));
  }
  for (int i = 0; i < symbol.m_Pins.size(); i++)
  {
   CPin *p = new CPin(*symbol.m_Pins.at(i));
-  m_Pins.append(p);
+  m_Pins.append(link(p));
  }
  for (int i = 0; i < symbol.m_Circles.size(); i++)
  {
   CCircle *c = new CCircle(*symbol.m_Circles.at(i));
-  m_Circles.append(c);
+  m_Circles.append(link(c));
  }
  for (int i = 0; i < symbol.m_Rectangles.size(); i++)
  {
   CRectangle *r = new CRectangle(*symbol.m_Rectangles.at(i));
-  m_Rectangles.append(r);
+  m_Rectangles.append(link(r));
  }
  for (int i = 0; i < symbol.m_Frames.size(); i++)
  {
   CFrame *f = new CFrame(*symbol.m_Frames.at(i));
-  m_Frames.append(f);
+  m_Frames.append(link(f));
  }
  m_Name = symbol.m_Name;
 }
@@ -7489,6 +9107,7 @@ void CSymbol::show(std::ostream& out, const int level)
 
 bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="symbol") e = e.nextSiblingElement("symbol");
  if (!e.isNull())
@@ -7502,7 +9121,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPolygon *p = new CPolygon();
-   m_Polygons.append(p);
+   m_Polygons.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("polygon");
   }
@@ -7510,7 +9129,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CWire *w = new CWire();
-   m_Wires.append(w);
+   m_Wires.append(link(w));
    w->readFromXML(c,options);
    c = c.nextSiblingElement("wire");
   }
@@ -7518,7 +9137,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CText *t = new CText();
-   m_Texts.append(t);
+   m_Texts.append(link(t));
    t->readFromXML(c,options);
    c = c.nextSiblingElement("text");
   }
@@ -7526,7 +9145,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CDimension *d = new CDimension();
-   m_Dimensions.append(d);
+   m_Dimensions.append(link(d));
    d->readFromXML(c,options);
    c = c.nextSiblingElement("dimension");
   }
@@ -7534,7 +9153,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPin *p = new CPin();
-   m_Pins.append(p);
+   m_Pins.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("pin");
   }
@@ -7542,7 +9161,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CCircle *l = new CCircle();
-   m_Circles.append(l);
+   m_Circles.append(link(l));
    l->readFromXML(c,options);
    c = c.nextSiblingElement("circle");
   }
@@ -7550,7 +9169,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CRectangle *r = new CRectangle();
-   m_Rectangles.append(r);
+   m_Rectangles.append(link(r));
    r->readFromXML(c,options);
    c = c.nextSiblingElement("rectangle");
   }
@@ -7558,7 +9177,7 @@ bool CSymbol::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CFrame *f = new CFrame();
-   m_Frames.append(f);
+   m_Frames.append(link(f));
    f->readFromXML(c,options);
    c = c.nextSiblingElement("frame");
   }
@@ -7577,38 +9196,38 @@ bool CSymbol::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  {
   QDomElement e = host.createElement("symbol");
   e.setAttribute("name",m_Name);
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   for (int i = 0; i < m_Polygons.size(); i++)
   {
-   m_Polygons[i]->writeToXML(host,e,options);
+   writeChild(*m_Polygons[i],host,e,options);
   }
   for (int i = 0; i < m_Wires.size(); i++)
   {
-   m_Wires[i]->writeToXML(host,e,options);
+   writeChild(*m_Wires[i],host,e,options);
   }
   for (int i = 0; i < m_Texts.size(); i++)
   {
-   m_Texts[i]->writeToXML(host,e,options);
+   writeChild(*m_Texts[i],host,e,options);
   }
   for (int i = 0; i < m_Dimensions.size(); i++)
   {
-   m_Dimensions[i]->writeToXML(host,e,options);
+   writeChild(*m_Dimensions[i],host,e,options);
   }
   for (int i = 0; i < m_Pins.size(); i++)
   {
-   m_Pins[i]->writeToXML(host,e,options);
+   writeChild(*m_Pins[i],host,e,options);
   }
   for (int i = 0; i < m_Circles.size(); i++)
   {
-   m_Circles[i]->writeToXML(host,e,options);
+   writeChild(*m_Circles[i],host,e,options);
   }
   for (int i = 0; i < m_Rectangles.size(); i++)
   {
-   m_Rectangles[i]->writeToXML(host,e,options);
+   writeChild(*m_Rectangles[i],host,e,options);
   }
   for (int i = 0; i < m_Frames.size(); i++)
   {
-   m_Frames[i]->writeToXML(host,e,options);
+   writeChild(*m_Frames[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -7616,15 +9235,106 @@ bool CSymbol::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+quint64 CSymbol::definitionHash(void)
+{
+ CContentHash hash;
+ hash.add(QString("symbol"));
+ hash.add(m_Description.contentHash());
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  hash.add(m_Polygons[i]->contentHash());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  hash.add(m_Wires[i]->contentHash());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  hash.add(m_Texts[i]->contentHash());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  hash.add(m_Dimensions[i]->contentHash());
+ }
+ for (int i = 0; i < m_Pins.size(); i++)
+ {
+  hash.add(m_Pins[i]->contentHash());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  hash.add(m_Circles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  hash.add(m_Rectangles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  hash.add(m_Frames[i]->contentHash());
+ }
+ return hash.value();
+}
+
+void CSymbol::hashFields(CContentHash& hash)
+{
+ hash.add(definitionHash());
+ hash.add(m_Name);
+}
+
+const CBoundingBox& CSymbol::boundingBox(void)
+{
+ int current = revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  m_BoundingBox.include(m_Polygons[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  m_BoundingBox.include(m_Wires[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  m_BoundingBox.include(m_Texts[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  m_BoundingBox.include(m_Dimensions[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Pins.size(); i++)
+ {
+  m_BoundingBox.include(m_Pins[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  m_BoundingBox.include(m_Circles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  m_BoundingBox.include(m_Rectangles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  m_BoundingBox.include(m_Frames[i]->boundingBox());
+ }
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
+}
+
 //------------------------------------------------------------------------------
 
 CPackage::CPackage(const CPackage& package)
 {
+ link(&m_Description);
  assign(package);
 }
 
 CPackage::CPackage(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -7640,6 +9350,8 @@ void CPackage::operator =(const CPackage& package)
 
 void CPackage::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
  m_Description.clear();
  for (int i = 0; i < m_Polygons.size(); i++)
  {
@@ -7701,52 +9413,52 @@ void CPackage::assign(const CPackage& package)
  for (int i = 0; i < package.m_Polygons.size(); i++)
  {
   CPolygon *p = new CPolygon(*package.m_Polygons.at(i));
-  m_Polygons.append(p);
+  m_Polygons.append(link(p));
  }
  for (int i = 0; i < package.m_Wires.size(); i++)
  {
   CWire *w = new CWire(*package.m_Wires.at(i));
-  m_Wires.append(w);
+  m_Wires.append(link(w));
  }
  for (int i = 0; i < package.m_Texts.size(); i++)
  {
   CText *t = new CText(*package.m_Texts.at(i));
-  m_Texts.append(t);
+  m_Texts.append(link(t));
  }
  for (int i = 0; i < package.m_Dimensions.size(); i++)
  {
   CDimension *d = new CDimension(*package.m_Dimensions.at(i));
-  m_Dimensions.append(d);
+  m_Dimensions.append(link(d));
  }
  for (int i = 0; i < package.m_Circles.size(); i++)
  {
   CCircle *c = new CCircle(*package.m_Circles.at(i));
-  m_Circles.append(c);
+  m_Circles.append(link(c));
  }
  for (int i = 0; i < package.m_Rectangles.size(); i++)
  {
   CRectangle *r = new CRectangle(*package.m_Rectangles.at(i));
-  m_Rectangles.append(r);
+  m_Rectangles.append(link(r));
  }
  for (int i = 0; i < package.m_Frames.size(); i++)
  {
   CFrame *f = new CFrame(*package.m_Frames.at(i));
-  m_Frames.append(f);
+  m_Frames.append(link(f));
  }
  for (int i = 0; i < package.m_Holes.size(); i++)
  {
   CHole *h = new CHole(*package.m_Holes.at(i));
-  m_Holes.append(h);
+  m_Holes.append(link(h));
  }
  for (int i = 0; i < package.m_Pads.size(); i++)
  {
   CPad *p = new CPad(*package.m_Pads.at(i));
-  m_Pads.append(p);
+  m_Pads.append(link(p));
  }
  for (int i = 0; i < package.m_SMDs.size(); i++)
  {
   CSMD *s = new CSMD(*package.m_SMDs.at(i));
-  m_SMDs.append(s);
+  m_SMDs.append(link(s));
  }
  m_Name = package.m_Name;
 }
@@ -7878,6 +9590,7 @@ void CPackage::show(std::ostream& out, const int level)
 
 bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="package") e = e.nextSiblingElement("package");
  if (!e.isNull())
@@ -7891,7 +9604,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPolygon *p = new CPolygon();
-   m_Polygons.append(p);
+   m_Polygons.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("polygon");
   }
@@ -7899,7 +9612,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CWire *w = new CWire();
-   m_Wires.append(w);
+   m_Wires.append(link(w));
    w->readFromXML(c,options);
    c = c.nextSiblingElement("wire");
   }
@@ -7907,7 +9620,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CText *t = new CText();
-   m_Texts.append(t);
+   m_Texts.append(link(t));
    t->readFromXML(c,options);
    c = c.nextSiblingElement("text");
   }
@@ -7915,7 +9628,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CDimension *d = new CDimension();
-   m_Dimensions.append(d);
+   m_Dimensions.append(link(d));
    d->readFromXML(c,options);
    c = c.nextSiblingElement("dimension");
   }
@@ -7923,7 +9636,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CCircle *l = new CCircle();
-   m_Circles.append(l);
+   m_Circles.append(link(l));
    l->readFromXML(c,options);
    c = c.nextSiblingElement("circle");
   }
@@ -7931,7 +9644,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CRectangle *r = new CRectangle();
-   m_Rectangles.append(r);
+   m_Rectangles.append(link(r));
    r->readFromXML(c,options);
    c = c.nextSiblingElement("rectangle");
   }
@@ -7939,7 +9652,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CFrame *f = new CFrame();
-   m_Frames.append(f);
+   m_Frames.append(link(f));
    f->readFromXML(c,options);
    c = c.nextSiblingElement("frame");
   }
@@ -7947,7 +9660,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CHole *h = new CHole();
-   m_Holes.append(h);
+   m_Holes.append(link(h));
    h->readFromXML(c,options);
    c = c.nextSiblingElement("hole");
   }
@@ -7955,7 +9668,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CPad *p = new CPad();
-   m_Pads.append(p);
+   m_Pads.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("pad");
   }
@@ -7963,7 +9676,7 @@ bool CPackage::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
   while (!c.isNull())
   {
    CSMD *s = new CSMD();
-   m_SMDs.append(s);
+   m_SMDs.append(link(s));
    s->readFromXML(c,options);
    c = c.nextSiblingElement("smd");
   }
@@ -7982,46 +9695,46 @@ bool CPackage::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  {
   QDomElement e = host.createElement("package");
   e.setAttribute("name",m_Name);
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   for (int i = 0; i < m_Polygons.size(); i++)
   {
-   m_Polygons[i]->writeToXML(host,e,options);
+   writeChild(*m_Polygons[i],host,e,options);
   }
   for (int i = 0; i < m_Wires.size(); i++)
   {
-   m_Wires[i]->writeToXML(host,e,options);
+   writeChild(*m_Wires[i],host,e,options);
   }
   for (int i = 0; i < m_Texts.size(); i++)
   {
-   m_Texts[i]->writeToXML(host,e,options);
+   writeChild(*m_Texts[i],host,e,options);
   }
   for (int i = 0; i < m_Dimensions.size(); i++)
   {
-   m_Dimensions[i]->writeToXML(host,e,options);
+   writeChild(*m_Dimensions[i],host,e,options);
   }
   for (int i = 0; i < m_Circles.size(); i++)
   {
-   m_Circles[i]->writeToXML(host,e,options);
+   writeChild(*m_Circles[i],host,e,options);
   }
   for (int i = 0; i < m_Rectangles.size(); i++)
   {
-   m_Rectangles[i]->writeToXML(host,e,options);
+   writeChild(*m_Rectangles[i],host,e,options);
   }
   for (int i = 0; i < m_Frames.size(); i++)
   {
-   m_Frames[i]->writeToXML(host,e,options);
+   writeChild(*m_Frames[i],host,e,options);
   }
   for (int i = 0; i < m_Holes.size(); i++)
   {
-   m_Holes[i]->writeToXML(host,e,options);
+   writeChild(*m_Holes[i],host,e,options);
   }
   for (int i = 0; i < m_Pads.size(); i++)
   {
-   m_Pads[i]->writeToXML(host,e,options);
+   writeChild(*m_Pads[i],host,e,options);
   }
   for (int i = 0; i < m_SMDs.size(); i++)
   {
-   m_SMDs[i]->writeToXML(host,e,options);
+   writeChild(*m_SMDs[i],host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -8029,6 +9742,111 @@ bool CPackage::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+quint64 CPackage::definitionHash(void)
+{
+ CContentHash hash;
+ hash.add(QString("package"));
+ hash.add(m_Description.contentHash());
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  hash.add(m_Polygons[i]->contentHash());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  hash.add(m_Wires[i]->contentHash());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  hash.add(m_Texts[i]->contentHash());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  hash.add(m_Dimensions[i]->contentHash());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  hash.add(m_Circles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  hash.add(m_Rectangles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  hash.add(m_Frames[i]->contentHash());
+ }
+ for (int i = 0; i < m_Holes.size(); i++)
+ {
+  hash.add(m_Holes[i]->contentHash());
+ }
+ for (int i = 0; i < m_Pads.size(); i++)
+ {
+  hash.add(m_Pads[i]->contentHash());
+ }
+ for (int i = 0; i < m_SMDs.size(); i++)
+ {
+  hash.add(m_SMDs[i]->contentHash());
+ }
+ return hash.value();
+}
+
+void CPackage::hashFields(CContentHash& hash)
+{
+ hash.add(definitionHash());
+ hash.add(m_Name);
+}
+
+const CBoundingBox& CPackage::boundingBox(void)
+{
+ int current = revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  m_BoundingBox.include(m_Polygons[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  m_BoundingBox.include(m_Wires[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  m_BoundingBox.include(m_Texts[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  m_BoundingBox.include(m_Dimensions[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  m_BoundingBox.include(m_Circles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  m_BoundingBox.include(m_Rectangles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  m_BoundingBox.include(m_Frames[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Holes.size(); i++)
+ {
+  m_BoundingBox.include(m_Holes[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Pads.size(); i++)
+ {
+  m_BoundingBox.include(m_Pads[i]->boundingBox());
+ }
+ for (int i = 0; i < m_SMDs.size(); i++)
+ {
+  m_BoundingBox.include(m_SMDs[i]->boundingBox());
+ }
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
+}
+
 //------------------------------------------------------------------------------
 
 CPlain::CPlain(const CPlain& plain)
@@ -8053,6 +9871,8 @@ void CPlain::operator =(const CPlain& plain)
 
 void CPlain::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
  for (int i = 0; i < m_Polygons.size(); i++)
  {
   if (0!=m_Polygons[i]) delete m_Polygons[i];
@@ -8101,42 +9921,42 @@ void CPlain::assign(const CPlain& plain)
  for (int i = 0; i < plain.m_Polygons.size(); i++)
  {
   CPolygon *p = new CPolygon(*plain.m_Polygons.at(i));
-  m_Polygons.append(p);
+  m_Polygons.append(link(p));
  }
  for (int i = 0; i < plain.m_Wires.size(); i++)
  {
   CWire *w = new CWire(*plain.m_Wires.at(i));
-  m_Wires.append(w);
+  m_Wires.append(link(w));
  }
  for (int i = 0; i < plain.m_Texts.size(); i++)
  {
   CText *t = new CText(*plain.m_Texts.at(i));
-  m_Texts.append(t);
+  m_Texts.append(link(t));
  }
  for (int i = 0; i < plain.m_Dimensions.size(); i++)
  {
   CDimension *d = new CDimension(*plain.m_Dimensions.at(i));
-  m_Dimensions.append(d);
+  m_Dimensions.append(link(d));
  }
  for (int i = 0; i < plain.m_Circles.size(); i++)
  {
   CCircle *c = new CCircle(*plain.m_Circles.at(i));
-  m_Circles.append(c);
+  m_Circles.append(link(c));
  }
  for (int i = 0; i < plain.m_Rectangles.size(); i++)
  {
   CRectangle *r = new CRectangle(*plain.m_Rectangles.at(i));
-  m_Rectangles.append(r);
+  m_Rectangles.append(link(r));
  }
  for (int i = 0; i < plain.m_Frames.size(); i++)
  {
   CFrame *f = new CFrame(*plain.m_Frames.at(i));
-  m_Frames.append(f);
+  m_Frames.append(link(f));
  }
  for (int i = 0; i < plain.m_Holes.size(); i++)
  {
   CHole *h = new CHole(*plain.m_Holes.at(i));
-  m_Holes.append(h);
+  m_Holes.append(link(h));
  }
 }
 
@@ -8248,6 +10068,7 @@ void CPlain::show(std::ostream& out, const int level)
 
 bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="plain") e = e.nextSiblingElement("plain");
  if (!e.isNull())
@@ -8256,7 +10077,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CPolygon *p = new CPolygon();
-   m_Polygons.append(p);
+   m_Polygons.append(link(p));
    p->readFromXML(c,options);
    c = c.nextSiblingElement("polygon");
   }
@@ -8264,7 +10085,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CWire *w = new CWire();
-   m_Wires.append(w);
+   m_Wires.append(link(w));
    w->readFromXML(c,options);
    c = c.nextSiblingElement("wire");
   }
@@ -8272,7 +10093,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CText *t = new CText();
-   m_Texts.append(t);
+   m_Texts.append(link(t));
    t->readFromXML(c,options);
    c = c.nextSiblingElement("text");
   }
@@ -8280,7 +10101,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CDimension *d = new CDimension();
-   m_Dimensions.append(d);
+   m_Dimensions.append(link(d));
    d->readFromXML(c,options);
    c = c.nextSiblingElement("dimension");
   }
@@ -8288,7 +10109,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CCircle *l = new CCircle();
-   m_Circles.append(l);
+   m_Circles.append(link(l));
    l->readFromXML(c,options);
    c = c.nextSiblingElement("circle");
   }
@@ -8296,7 +10117,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CRectangle *r = new CRectangle();
-   m_Rectangles.append(r);
+   m_Rectangles.append(link(r));
    r->readFromXML(c,options);
    c = c.nextSiblingElement("rectangle");
   }
@@ -8304,7 +10125,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CFrame *f = new CFrame();
-   m_Frames.append(f);
+   m_Frames.append(link(f));
    f->readFromXML(c,options);
    c = c.nextSiblingElement("frame");
   }
@@ -8312,7 +10133,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CHole *h = new CHole();
-   m_Holes.append(h);
+   m_Holes.append(link(h));
    h->readFromXML(c,options);
    c = c.nextSiblingElement("hole");
   }
@@ -8320,7 +10141,7 @@ bool CPlain::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
   while (!c.isNull())
   {
    CDimension *d = new CDimension();
-   m_Dimensions.append(d);
+   m_Dimensions.append(link(d));
    d->readFromXML(c,options);
    c = c.nextSiblingElement("dimension");
   }
@@ -8332,58 +10153,142 @@ bool CPlain::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
 {
  if (!host.isNull() && !root.isNull())
  {
-  QDomElement e = host.createElement("plain");
-  for (int i = 0; i < m_Polygons.size(); i++)
-  {
-   m_Polygons[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Wires.size(); i++)
-  {
-   m_Wires[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Texts.size(); i++)
-  {
-   m_Texts[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Dimensions.size(); i++)
-  {
-   m_Dimensions[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Circles.size(); i++)
-  {
-   m_Circles[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Rectangles.size(); i++)
-  {
-   m_Rectangles[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Frames.size(); i++)
-  {
-   m_Frames[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Holes.size(); i++)
-  {
-   m_Holes[i]->writeToXML(host,e,options);
-  }
-  for (int i = 0; i < m_Dimensions.size(); i++)
-  {
-   m_Dimensions[i]->writeToXML(host,e,options);
-  }
-  root.appendChild(e);
-  return true;
+  QDomElement e = host.createElement("plain");
+  for (int i = 0; i < m_Polygons.size(); i++)
+  {
+   writeChild(*m_Polygons[i],host,e,options);
+  }
+  for (int i = 0; i < m_Wires.size(); i++)
+  {
+   writeChild(*m_Wires[i],host,e,options);
+  }
+  for (int i = 0; i < m_Texts.size(); i++)
+  {
+   writeChild(*m_Texts[i],host,e,options);
+  }
+  for (int i = 0; i < m_Dimensions.size(); i++)
+  {
+   writeChild(*m_Dimensions[i],host,e,options);
+  }
+  for (int i = 0; i < m_Circles.size(); i++)
+  {
+   writeChild(*m_Circles[i],host,e,options);
+  }
+  for (int i = 0; i < m_Rectangles.size(); i++)
+  {
+   writeChild(*m_Rectangles[i],host,e,options);
+  }
+  for (int i = 0; i < m_Frames.size(); i++)
+  {
+   writeChild(*m_Frames[i],host,e,options);
+  }
+  for (int i = 0; i < m_Holes.size(); i++)
+  {
+   writeChild(*m_Holes[i],host,e,options);
+  }
+  for (int i = 0; i < m_Dimensions.size(); i++)
+  {
+   writeChild(*m_Dimensions[i],host,e,options);
+  }
+  root.appendChild(e);
+  return true;
+ }
+ return false;
+}
+
+void CPlain::hashFields(CContentHash& hash)
+{
+ hash.add(QString("plain"));
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  hash.add(m_Polygons[i]->contentHash());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  hash.add(m_Wires[i]->contentHash());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  hash.add(m_Texts[i]->contentHash());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  hash.add(m_Dimensions[i]->contentHash());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  hash.add(m_Circles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  hash.add(m_Rectangles[i]->contentHash());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  hash.add(m_Frames[i]->contentHash());
+ }
+ for (int i = 0; i < m_Holes.size(); i++)
+ {
+  hash.add(m_Holes[i]->contentHash());
+ }
+}
+
+const CBoundingBox& CPlain::boundingBox(void)
+{
+ int current = revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ m_BoundingBox.clear();
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  m_BoundingBox.include(m_Polygons[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Wires.size(); i++)
+ {
+  m_BoundingBox.include(m_Wires[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Texts.size(); i++)
+ {
+  m_BoundingBox.include(m_Texts[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Circles.size(); i++)
+ {
+  m_BoundingBox.include(m_Circles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Rectangles.size(); i++)
+ {
+  m_BoundingBox.include(m_Rectangles[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Frames.size(); i++)
+ {
+  m_BoundingBox.include(m_Frames[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Holes.size(); i++)
+ {
+  m_BoundingBox.include(m_Holes[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Dimensions.size(); i++)
+ {
+  m_BoundingBox.include(m_Dimensions[i]->boundingBox());
  }
- return false;
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
 }
 
 //------------------------------------------------------------------------------
 
 CSheet::CSheet(const CSheet& sheet)
 {
+ link(&m_Description);
+ link(&m_Plain);
  assign(sheet);
 }
 
 CSheet::CSheet(void)
 {
+ link(&m_Description);
+ link(&m_Plain);
  clear();
 }
 
@@ -8399,6 +10304,8 @@ void CSheet::operator =(const CSheet& sheet)
 
 void CSheet::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
  m_Description.clear();
  m_Plain.clear();
  for (int i = 0; i < m_Instances.size(); i++)
@@ -8431,22 +10338,22 @@ void CSheet::assign(const CSheet& sheet)
  for (int i = 0; i < sheet.m_Instances.size(); i++)
  {
   CInstance *n = new CInstance(*sheet.m_Instances.at(i));
-  m_Instances.append(n);
+  m_Instances.append(link(n));
  }
  for (int i = 0; i < sheet.m_ModuleInstances.size(); i++)
  {
   CModuleInstance *n = new CModuleInstance(*sheet.m_ModuleInstances.at(i));
-  m_ModuleInstances.append(n);
+  m_ModuleInstances.append(link(n));
  }
  for (int i = 0; i < sheet.m_Busses.size(); i++)
  {
   CBus *b = new CBus(*sheet.m_Busses.at(i));
-  m_Busses.append(b);
+  m_Busses.append(link(b));
  }
  for (int i = 0; i < sheet.m_Nets.size(); i++)
  {
   CNet *n = new CNet(*sheet.m_Nets.at(i));
-  m_Nets.append(n);
+  m_Nets.append(link(n));
  }
 }
 
@@ -8510,6 +10417,7 @@ void CSheet::show(std::ostream& out, const int level)
 
 bool CSheet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="sheet") e = e.nextSiblingElement("sheet");
  if (!e.isNull())
@@ -8531,7 +10439,7 @@ bool CSheet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CInstance *i = new CInstance();
-    m_Instances.append(i);
+    m_Instances.append(link(i));
     i->readFromXML(cc,options);
     cc = cc.nextSiblingElement("instance");
    }
@@ -8545,7 +10453,7 @@ bool CSheet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
     while (!cc.isNull())
     {
      CModuleInstance *mi = new CModuleInstance();
-     m_ModuleInstances.append(mi);
+     m_ModuleInstances.append(link(mi));
      mi->readFromXML(cc,options);
      cc = cc.nextSiblingElement("moduleinst");
     }
@@ -8558,7 +10466,7 @@ bool CSheet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CBus *b = new CBus();
-    m_Busses.append(b);
+    m_Busses.append(link(b));
     b->readFromXML(cc,options);
     cc = cc.nextSiblingElement("bus");
    }
@@ -8570,7 +10478,7 @@ bool CSheet::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CNet *n = new CNet();
-    m_Nets.append(n);
+    m_Nets.append(link(n));
     n->readFromXML(cc,options);
     cc = cc.nextSiblingElement("net");
    }
@@ -8584,13 +10492,13 @@ bool CSheet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  if (!host.isNull() && !root.isNull())
  {
   QDomElement e = host.createElement("sheet");
-  m_Description.writeToXML(host,e,options);
-  m_Plain.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
+  writeChild(m_Plain,host,e,options);
   QDomElement c = host.createElement("instances");
   e.appendChild(c);
   for (int i = 0; i < m_Instances.size(); i++)
   {
-   m_Instances[i]->writeToXML(host,c,options);
+   writeChild(*m_Instances[i],host,c,options);
   }
   if (options.version()>=CVersionNumber(7,0))
   {
@@ -8598,20 +10506,20 @@ bool CSheet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
    e.appendChild(c);
    for (int i = 0; i < m_ModuleInstances.size(); i++)
    {
-    m_ModuleInstances[i]->writeToXML(host,c,options);
+    writeChild(*m_ModuleInstances[i],host,c,options);
    }
   }
   c = host.createElement("busses");
   e.appendChild(c);
   for (int i = 0; i < m_Busses.size(); i++)
   {
-   m_Busses[i]->writeToXML(host,c,options);
+   writeChild(*m_Busses[i],host,c,options);
   }
   c = host.createElement("nets");
   e.appendChild(c);
   for (int i = 0; i < m_Nets.size(); i++)
   {
-   m_Nets[i]->writeToXML(host,c,options);
+   writeChild(*m_Nets[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -8619,14 +10527,126 @@ bool CSheet::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CSheet::hashFields(CContentHash& hash)
+{
+ hash.add(QString("sheet"));
+ hash.add(m_Description.contentHash());
+ hash.add(m_Plain.contentHash());
+ hash.add(QString("instances"));
+ for (int i = 0; i < m_Instances.size(); i++)
+ {
+  hash.add(m_Instances[i]->contentHash());
+ }
+ hash.add(QString("moduleinsts"));
+ for (int i = 0; i < m_ModuleInstances.size(); i++)
+ {
+  hash.add(m_ModuleInstances[i]->contentHash());
+ }
+ hash.add(QString("busses"));
+ for (int i = 0; i < m_Busses.size(); i++)
+ {
+  hash.add(m_Busses[i]->contentHash());
+ }
+ hash.add(QString("nets"));
+ for (int i = 0; i < m_Nets.size(); i++)
+ {
+  hash.add(m_Nets[i]->contentHash());
+ }
+}
+
+const CBoundingBox& CSheet::boundingBox(void)
+{
+ // instances name parts of the module or schematic holding the sheet, the
+ // libraries are those of the schematic, so the box is kept as long as the
+ // schematic does not change
+ CModule *module = dynamic_cast<CModule*>(owner());
+ CSchematic *schematic = dynamic_cast<CSchematic*>((0!=module) ? module->owner() : owner());
+ int current = (0!=schematic) ? schematic->revision() : revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ // symbols by part and gate, device sets looked up once per library
+ QHash<QString,CSymbol*> symbols;
+ if (0!=schematic)
+ {
+  QList<CPart*>& parts = (0!=module) ? module->parts() : schematic->parts();
+  QHash<QString,CPart*> names;
+  for (int i = parts.size() - 1; i >= 0; i--)
+  {
+   names.insert(parts.at(i)->name(),parts.at(i));
+  }
+  QHash<QString,CDeviceSet*> deviceSets;
+  for (int i = 0; i < m_Instances.size(); i++)
+  {
+   CInstance *n = m_Instances[i];
+   QString key = n->part() + QChar(0) + n->gate();
+   if (symbols.contains(key)) continue;
+   CPart *part = names.value(n->part(),0);
+   CLibrary *l = (0!=part) ? schematic->findLibraryByName(part->library()) : 0;
+   CSymbol *symbol = 0;
+   if (0!=l)
+   {
+    QString name = part->library() + QChar(0) + part->deviceSet();
+    if (!deviceSets.contains(name)) deviceSets.insert(name,l->findDeviceSetByName(part->deviceSet()));
+    CDeviceSet *ds = deviceSets.value(name);
+    CGate *g = (0!=ds) ? ds->findGateByName(n->gate()) : 0;
+    if (0!=g) symbol = l->findSymbolByName(g->symbol());
+   }
+   symbols.insert(key,symbol);
+  }
+ }
+ m_BoundingBox.clear();
+ m_BoundingBox.include(m_Plain.boundingBox());
+ for (int i = 0; i < m_Instances.size(); i++)
+ {
+  CInstance *n = m_Instances[i];
+  CSymbol *symbol = symbols.value(n->part() + QChar(0) + n->gate(),0);
+  if (0!=symbol) m_BoundingBox.include(n->boundingBox(*symbol));
+  else m_BoundingBox.include(n->x(),n->y());
+ }
+ for (int i = 0; i < m_ModuleInstances.size(); i++)
+ {
+  m_BoundingBox.include(m_ModuleInstances[i]->x(),m_ModuleInstances[i]->y());
+ }
+ QList<CSegment*> segments;
+ for (int i = 0; i < m_Busses.size(); i++)
+ {
+  segments.append(m_Busses[i]->segments());
+ }
+ for (int i = 0; i < m_Nets.size(); i++)
+ {
+  segments.append(m_Nets[i]->segments());
+ }
+ for (int i = 0; i < segments.size(); i++)
+ {
+  CSegment *s = segments.at(i);
+  for (int j = 0; j < s->wires().size(); j++)
+  {
+   m_BoundingBox.include(s->wires().at(j)->boundingBox());
+  }
+  for (int j = 0; j < s->junctions().size(); j++)
+  {
+   m_BoundingBox.include(s->junctions().at(j)->x(),s->junctions().at(j)->y());
+  }
+  for (int j = 0; j < s->labels().size(); j++)
+  {
+   m_BoundingBox.include(s->labels().at(j)->x(),s->labels().at(j)->y());
+  }
+ }
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
+}
+
 //------------------------------------------------------------------------------
 
 CLibrary::CLibrary(const CLibrary& library)
 {
+ link(&m_Description);
 }
 
 CLibrary::CLibrary(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -8642,6 +10662,7 @@ void CLibrary::operator =(const CLibrary& library)
 
 void CLibrary::clear(void)
 {
+ modify();
  m_Description.clear();
  for (int i = 0; i < m_Packages.size(); i++)
  {
@@ -8668,17 +10689,17 @@ void CLibrary::assign(const CLibrary& library)
  for (int i = 0; i < library.m_Packages.size(); i++)
  {
   CPackage *p = new CPackage(*library.m_Packages.at(i));
-  m_Packages.append(p);
+  m_Packages.append(link(p));
  }
  for (int i = 0; i < library.m_Symbols.size(); i++)
  {
   CSymbol *s = new CSymbol(*library.m_Symbols.at(i));
-  m_Symbols.append(s);
+  m_Symbols.append(link(s));
  }
  for (int i = 0; i < library.m_DeviceSets.size(); i++)
  {
   CDeviceSet *d = new CDeviceSet(*library.m_DeviceSets.at(i));
-  m_DeviceSets.append(d);
+  m_DeviceSets.append(link(d));
  }
  m_Name = library.m_Name;
 }
@@ -8741,6 +10762,7 @@ void CLibrary::show(std::ostream& out, const int level)
 
 bool CLibrary::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  bool result = false;
  QDomElement e = root;
  if (e.nodeName()!="library") e = e.nextSiblingElement("library");
@@ -8759,7 +10781,7 @@ bool CLibrary::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CPackage *p = new CPackage();
-    m_Packages.append(p);
+    m_Packages.append(link(p));
     result &= p->readFromXML(cc,options);
     cc = cc.nextSiblingElement("package");
    }
@@ -8771,7 +10793,7 @@ bool CLibrary::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CSymbol *s = new CSymbol();
-    m_Symbols.append(s);
+    m_Symbols.append(link(s));
     result &= s->readFromXML(cc,options);
     cc = cc.nextSiblingElement("symbol");
    }
@@ -8783,7 +10805,7 @@ bool CLibrary::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CDeviceSet *d = new CDeviceSet();
-    m_DeviceSets.append(d);
+    m_DeviceSets.append(link(d));
     result &= d->readFromXML(cc,options);
     cc = cc.nextSiblingElement("deviceset");
    }
@@ -8803,24 +10825,24 @@ bool CLibrary::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  {
   QDomElement e = host.createElement("library");
   e.setAttribute("name",m_Name);
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   QDomElement c = host.createElement("packages");
   e.appendChild(c);
   for (int i = 0; i < m_Packages.size(); i++)
   {
-   m_Packages[i]->writeToXML(host,c,options);
+   writeChild(*m_Packages[i],host,c,options);
   }
   c = host.createElement("symbols");
   e.appendChild(c);
   for (int i = 0; i < m_Symbols.size(); i++)
   {
-   m_Symbols[i]->writeToXML(host,c,options);
+   writeChild(*m_Symbols[i],host,c,options);
   }
   c = host.createElement("devicesets");
   e.appendChild(c);
   for (int i = 0; i < m_DeviceSets.size(); i++)
   {
-   m_DeviceSets[i]->writeToXML(host,c,options);
+   writeChild(*m_DeviceSets[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -8828,6 +10850,28 @@ bool CLibrary::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CLibrary::hashFields(CContentHash& hash)
+{
+ hash.add(QString("library"));
+ hash.add(m_Name);
+ hash.add(m_Description.contentHash());
+ hash.add(QString("packages"));
+ for (int i = 0; i < m_Packages.size(); i++)
+ {
+  hash.add(m_Packages[i]->contentHash());
+ }
+ hash.add(QString("symbols"));
+ for (int i = 0; i < m_Symbols.size(); i++)
+ {
+  hash.add(m_Symbols[i]->contentHash());
+ }
+ hash.add(QString("devicesets"));
+ for (int i = 0; i < m_DeviceSets.size(); i++)
+ {
+  hash.add(m_DeviceSets[i]->contentHash());
+ }
+}
+
 CPackage *CLibrary::findPackageByName(const QString& name)
 {
  CPackage *result = 0;
@@ -8877,11 +10921,17 @@ CDeviceSet *CLibrary::findDeviceSetByName(const QString& name)
 
 CBoard::CBoard(const CBoard& board)
 {
+ link(&m_Description);
+ link(&m_Plain);
+ link(&m_DesignRules);
  assign(board);
 }
 
 CBoard::CBoard(void)
 {
+ link(&m_Description);
+ link(&m_Plain);
+ link(&m_DesignRules);
  clear();
 }
 
@@ -8897,6 +10947,12 @@ void CBoard::operator =(const CBoard& board)
 
 void CBoard::clear(void)
 {
+ modify();
+ m_BoundingBoxRevision.store(0);
+ m_ClearanceMatrix.clear();
+ m_ClearanceMatrixRevision.store(0);
+ m_PackageIndex.clear();
+ m_PackageIndexRevision.store(0);
  m_Description.clear();
  m_Plain.clear();
  //
@@ -8964,50 +11020,51 @@ void CBoard::assign(const CBoard& board)
  for (int i = 0; i < board.m_Libraries.size(); i++)
  {
   CLibrary *l = new CLibrary(*board.m_Libraries.at(i));
-  m_Libraries.append(l);
+  m_Libraries.append(link(l));
  }
  for (int i = 0; i < board.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*board.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  for (int i = 0; i < board.m_VariantDefs.size(); i++)
  {
   CVariantDef *v = new CVariantDef(*board.m_VariantDefs.at(i));
-  m_VariantDefs.append(v);
+  m_VariantDefs.append(link(v));
  }
  for (int i = 0; i < board.m_Classes.size(); i++)
  {
   CClass *c = new CClass(*board.m_Classes.at(i));
-  m_Classes.append(c);
+  m_Classes.append(link(c));
  }
  // autorouter
  for (int i = 0; i < board.m_Passes.size(); i++)
  {
   CPass *p = new CPass(*board.m_Passes.at(i));
-  m_Passes.append(p);
+  m_Passes.append(link(p));
  }
  //
  for (int i = 0; i < board.m_Elements.size(); i++)
  {
   CElement *e = new CElement(*board.m_Elements.at(i));
-  m_Elements.append(e);
+  m_Elements.append(link(e));
  }
  for (int i = 0; i < board.m_Signals.size(); i++)
  {
   CSignal *s = new CSignal(*board.m_Signals.at(i));
-  m_Signals.append(s);
+  m_Signals.append(link(s));
  }
  for (int i = 0; i < board.m_Errors.size(); i++)
  {
   CApproved *a = new CApproved(*board.m_Errors.at(i));
-  m_Errors.append(a);
+  m_Errors.append(link(a));
  }
  m_LimitedWidth = board.m_LimitedWidth;
 }
 
 void CBoard::scale(const double factor)
 {
+ modify();
  m_Plain.scale(factor);
  //
  for (int i = 0; i < m_Libraries.size(); i++)
@@ -9107,6 +11164,7 @@ void CBoard::show(std::ostream& out, const int level)
 
 bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="board") e = e.nextSiblingElement("board");
  if (!e.isNull())
@@ -9135,7 +11193,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CLibrary *l = new CLibrary();
-    m_Libraries.append(l);
+    m_Libraries.append(link(l));
     l->readFromXML(cc,options);
     cc = cc.nextSiblingElement("library");
    }
@@ -9147,7 +11205,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CAttribute *a = new CAttribute();
-    m_Attributes.append(a);
+    m_Attributes.append(link(a));
     a->readFromXML(cc,options);
     cc = cc.nextSiblingElement("attribute");
    }
@@ -9159,7 +11217,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CVariantDef *v = new CVariantDef();
-    m_VariantDefs.append(v);
+    m_VariantDefs.append(link(v));
     v->readFromXML(cc,options);
     cc = cc.nextSiblingElement("variantdef");
    }
@@ -9171,7 +11229,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CClass *l = new CClass();
-    m_Classes.append(l);
+    m_Classes.append(link(l));
     l->readFromXML(cc,options);
     cc = cc.nextSiblingElement("class");
    }
@@ -9185,7 +11243,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CDesignRule *r = new CDesignRule();
-    m_DesignRules.append(r);
+    m_DesignRules.append(link(r));
     r->readFromXML(cc,options);
     cc = cc.nextSiblingElement("designrule");
    }
@@ -9198,7 +11256,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CPass *p = new CPass();
-    m_Passes.append(p);
+    m_Passes.append(link(p));
     p->readFromXML(cc,options);
     cc = cc.nextSiblingElement("pass");
    }
@@ -9210,7 +11268,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CElement *m = new CElement();
-    m_Elements.append(m);
+    m_Elements.append(link(m));
     m->readFromXML(cc,options);
     cc = cc.nextSiblingElement("element");
    }
@@ -9222,7 +11280,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CSignal *n = new CSignal();
-    m_Signals.append(n);
+    m_Signals.append(link(n));
     n->readFromXML(cc,options);
     cc = cc.nextSiblingElement("signal");
    }
@@ -9234,7 +11292,7 @@ bool CBoard::readFromXML(const QDomElement& root, const CEagleDocumentOptions& o
    while (!cc.isNull())
    {
     CApproved *a = new CApproved();
-    m_Errors.append(a);
+    m_Errors.append(link(a));
     a->readFromXML(cc,options);
     cc = cc.nextSiblingElement("approved");
    }
@@ -9248,64 +11306,64 @@ bool CBoard::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  if (!host.isNull() && !root.isNull())
  {
   QDomElement e = host.createElement("board");
-  m_Description.writeToXML(host,e,options);
-  m_Plain.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
+  writeChild(m_Plain,host,e,options);
   QDomElement c = host.createElement("libraries");
   e.appendChild(c);
   for (int i = 0; i < m_Libraries.size(); i++)
   {
-   m_Libraries[i]->writeToXML(host,c,options);
+   writeChild(*m_Libraries[i],host,c,options);
   }
   c = host.createElement("attributes");
   e.appendChild(c);
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,c,options);
+   writeChild(*m_Attributes[i],host,c,options);
   }
   c = host.createElement("variantdefs");
   e.appendChild(c);
   for (int i = 0; i < m_VariantDefs.size(); i++)
   {
-   m_VariantDefs[i]->writeToXML(host,c,options);
+   writeChild(*m_VariantDefs[i],host,c,options);
   }
   c = host.createElement("classes");
   e.appendChild(c);
   for (int i = 0; i < m_Classes.size(); i++)
   {
-   m_Classes[i]->writeToXML(host,c,options);
+   writeChild(*m_Classes[i],host,c,options);
   }
   c = host.createElement("designrules");
-  m_DesignRules.writeToXML(host,c,options);
+  writeChild(m_DesignRules,host,c,options);
   e.appendChild(c);
   /*
   for (int i = 0; i < m_DesignRules.size(); i++)
   {
-   m_DesignRules[i]->writeToXML(host,c,options);
+   writeChild(*m_DesignRules[i],host,c,options);
   }
   */
   c = host.createElement("autorouter");
   e.appendChild(c);
   for (int i = 0; i < m_Passes.size(); i++)
   {
-   m_Passes[i]->writeToXML(host,c,options);
+   writeChild(*m_Passes[i],host,c,options);
   }
   c = host.createElement("elements");
   e.appendChild(c);
   for (int i = 0; i < m_Elements.size(); i++)
   {
-   m_Elements[i]->writeToXML(host,c,options);
+   writeChild(*m_Elements[i],host,c,options);
   }
   c = host.createElement("signals");
   e.appendChild(c);
   for (int i = 0; i < m_Signals.size(); i++)
   {
-   m_Signals[i]->writeToXML(host,c,options);
+   writeChild(*m_Signals[i],host,c,options);
   }
   c = host.createElement("errors");
   e.appendChild(c);
   for (int i = 0; i < m_Errors.size(); i++)
   {
-   m_Errors[i]->writeToXML(host,c,options);
+   writeChild(*m_Errors[i],host,c,options);
   }
   if (options.version()>=CVersionNumber(7,4))
   {
@@ -9320,15 +11378,187 @@ bool CBoard::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocum
  return false;
 }
 
+void CBoard::hashFields(CContentHash& hash)
+{
+ hash.add(QString("board"));
+ hash.add(m_Description.contentHash());
+ hash.add(m_Plain.contentHash());
+ hash.add(QString("libraries"));
+ for (int i = 0; i < m_Libraries.size(); i++)
+ {
+  hash.add(m_Libraries[i]->contentHash());
+ }
+ hash.add(QString("attributes"));
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+ hash.add(QString("variantdefs"));
+ for (int i = 0; i < m_VariantDefs.size(); i++)
+ {
+  hash.add(m_VariantDefs[i]->contentHash());
+ }
+ hash.add(QString("classes"));
+ for (int i = 0; i < m_Classes.size(); i++)
+ {
+  hash.add(m_Classes[i]->contentHash());
+ }
+ hash.add(QString("designrules"));
+ hash.add(m_DesignRules.contentHash());
+ hash.add(QString("autorouter"));
+ for (int i = 0; i < m_Passes.size(); i++)
+ {
+  hash.add(m_Passes[i]->contentHash());
+ }
+ hash.add(QString("elements"));
+ for (int i = 0; i < m_Elements.size(); i++)
+ {
+  hash.add(m_Elements[i]->contentHash());
+ }
+ hash.add(QString("signals"));
+ for (int i = 0; i < m_Signals.size(); i++)
+ {
+  hash.add(m_Signals[i]->contentHash());
+ }
+ hash.add(QString("errors"));
+ for (int i = 0; i < m_Errors.size(); i++)
+ {
+  hash.add(m_Errors[i]->contentHash());
+ }
+ hash.add(m_LimitedWidth);
+}
+
+const CBoundingBox& CBoard::boundingBox(void)
+{
+ int current = revision();
+ if (m_BoundingBoxRevision.loadAcquire()==current) return m_BoundingBox;
+ QMutexLocker lock(&cacheMutex());
+ if (m_BoundingBoxRevision.load()==current) return m_BoundingBox;
+ m_BoundingBox.clear();
+ m_BoundingBox.include(m_Plain.boundingBox());
+ for (int i = 0; i < m_Signals.size(); i++)
+ {
+  m_BoundingBox.include(m_Signals[i]->boundingBox());
+ }
+ for (int i = 0; i < m_Elements.size(); i++)
+ {
+  m_BoundingBox.include(m_Elements[i]->boundingBox(*this));
+ }
+ m_BoundingBoxRevision.storeRelease(current);
+ return m_BoundingBox;
+}
+
+CLibrary *CBoard::findLibraryByName(const QString& name)
+{
+ CLibrary *result = 0;
+ for (int i = 0; i < m_Libraries.size(); i++)
+ {
+  CLibrary *l = m_Libraries.at(i);
+  if (l->name()==name)
+  {
+   result = l;
+   break;
+  }
+ }
+ return result;
+}
+
+CPackage *CBoard::findPackage(const QString& library, const QString& package)
+{
+ int current = revision();
+ if (m_PackageIndexRevision.loadAcquire()!=current)
+ {
+  QMutexLocker lock(&cacheMutex());
+  if (m_PackageIndexRevision.load()!=current)
+  {
+   // the first library and package of a name win, as with the lookups by name
+   m_PackageIndex.clear();
+   for (int i = m_Libraries.size() - 1; i >= 0; i--)
+   {
+    CLibrary *l = m_Libraries.at(i);
+    for (int j = l->packages().size() - 1; j >= 0; j--)
+    {
+     m_PackageIndex.insert(l->name() + QChar(0) + l->packages().at(j)->name(),l->packages().at(j));
+    }
+   }
+   m_PackageIndexRevision.storeRelease(current);
+  }
+ }
+ return m_PackageIndex.value(library + QChar(0) + package,0);
+}
+
+CElement *CBoard::findElementByName(const QString& name)
+{
+ CElement *result = 0;
+ for (int i = 0; i < m_Elements.size(); i++)
+ {
+  CElement *e = m_Elements.at(i);
+  if (e->name()==name)
+  {
+   result = e;
+   break;
+  }
+ }
+ return result;
+}
+
+CSignal *CBoard::findSignalByName(const QString& name)
+{
+ CSignal *result = 0;
+ for (int i = 0; i < m_Signals.size(); i++)
+ {
+  CSignal *s = m_Signals.at(i);
+  if (s->name()==name)
+  {
+   result = s;
+   break;
+  }
+ }
+ return result;
+}
+
+CClass *CBoard::findClassByNumber(const TClass number)
+{
+ CClass *result = 0;
+ for (int i = 0; i < m_Classes.size(); i++)
+ {
+  CClass *c = m_Classes.at(i);
+  if (c->number()==number)
+  {
+   result = c;
+   break;
+  }
+ }
+ return result;
+}
+
+const CClearanceMatrix& CBoard::clearanceMatrix(void)
+{
+ int current = revision();
+ if (m_ClearanceMatrixRevision.loadAcquire()==current) return m_ClearanceMatrix;
+ QMutexLocker lock(&cacheMutex());
+ if (m_ClearanceMatrixRevision.load()!=current)
+ {
+  // nets without a class specific value fall back to the wire to wire
+  // distance of the design rules
+  TDimension d = m_DesignRules.values().dimension("mdWireWire",8*0.0254);
+  m_ClearanceMatrix.build(m_Classes,d);
+  m_ClearanceMatrixRevision.storeRelease(current);
+ }
+ return m_ClearanceMatrix;
+}
+
 //------------------------------------------------------------------------------
 
 CModule::CModule(const CModule& module)
 {
+ link(&m_Description);
  assign(module);
 }
 
 CModule::CModule(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -9344,6 +11574,7 @@ void CModule::operator =(const CModule& module)
 
 void CModule::clear(void)
 {
+ modify();
  m_Name.clear();
  m_Prefix.clear();
  m_DX = 0.8; m_DY = 0.6; // inch
@@ -9380,22 +11611,22 @@ void CModule::assign(const CModule& module)
  for (int i = 0; i < module.m_Ports.size(); i++)
  {
   CPort *p = new CPort(*module.m_Ports.at(i));
-  m_Ports.append(p);
+  m_Ports.append(link(p));
  }
  for (int i = 0; i < module.m_VariantDefs.size(); i++)
  {
   CVariantDef *v = new CVariantDef(*module.m_VariantDefs.at(i));
-  m_VariantDefs.append(v);
+  m_VariantDefs.append(link(v));
  }
  for (int i = 0; i < module.m_Parts.size(); i++)
  {
   CPart *p = new CPart(*module.m_Parts.at(i));
-  m_Parts.append(p);
+  m_Parts.append(link(p));
  }
  for (int i = 0; i < module.m_Sheets.size(); i++)
  {
   CSheet *s = new CSheet(*module.m_Sheets.at(i));
-  m_Sheets.append(s);
+  m_Sheets.append(link(s));
  }
 }
 
@@ -9449,6 +11680,7 @@ void CModule::show(std::ostream& out, const int level)
 
 bool CModule::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="module") e = e.nextSiblingElement("module");
  if (!e.isNull())
@@ -9490,7 +11722,7 @@ bool CModule::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CPort *p = new CPort();
-    m_Ports.append(p);
+    m_Ports.append(link(p));
     p->readFromXML(cc,options);
     cc = cc.nextSiblingElement("port");
    }
@@ -9502,7 +11734,7 @@ bool CModule::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CVariantDef *v = new CVariantDef();
-    m_VariantDefs.append(v);
+    m_VariantDefs.append(link(v));
     v->readFromXML(cc,options);
     cc = cc.nextSiblingElement("variantdef");
    }
@@ -9514,7 +11746,7 @@ bool CModule::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CPart *p = new CPart();
-    m_Parts.append(p);
+    m_Parts.append(link(p));
     p->readFromXML(cc,options);
     cc = cc.nextSiblingElement("part");
    }
@@ -9526,7 +11758,7 @@ bool CModule::readFromXML(const QDomElement& root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CSheet *h = new CSheet();
-    m_Sheets.append(h);
+    m_Sheets.append(link(h));
     h->readFromXML(cc,options);
     cc = cc.nextSiblingElement("sheet");
    }
@@ -9544,30 +11776,30 @@ bool CModule::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
   e.setAttribute("prefix",m_Prefix);
   e.setAttribute("dx",m_DX);
   e.setAttribute("dy",m_DY);
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   QDomElement c = host.createElement("ports");
   e.appendChild(c);
   for (int i = 0; i < m_Ports.size(); i++)
   {
-   m_Ports[i]->writeToXML(host,c,options);
+   writeChild(*m_Ports[i],host,c,options);
   }
   c = host.createElement("variantdefs");
   e.appendChild(c);
   for (int i = 0; i < m_VariantDefs.size(); i++)
   {
-   m_VariantDefs[i]->writeToXML(host,c,options);
+   writeChild(*m_VariantDefs[i],host,c,options);
   }
   c = host.createElement("parts");
   e.appendChild(c);
   for (int i = 0; i < m_Parts.size(); i++)
   {
-   m_Parts[i]->writeToXML(host,c,options);
+   writeChild(*m_Parts[i],host,c,options);
   }
   c = host.createElement("sheets");
   e.appendChild(c);
   for (int i = 0; i < m_Sheets.size(); i++)
   {
-   m_Sheets[i]->writeToXML(host,c,options);
+   writeChild(*m_Sheets[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -9575,6 +11807,36 @@ bool CModule::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocu
  return false;
 }
 
+void CModule::hashFields(CContentHash& hash)
+{
+ hash.add(QString("module"));
+ hash.add(m_Name);
+ hash.add(m_Prefix);
+ hash.add(m_DX);
+ hash.add(m_DY);
+ hash.add(m_Description.contentHash());
+ hash.add(QString("ports"));
+ for (int i = 0; i < m_Ports.size(); i++)
+ {
+  hash.add(m_Ports[i]->contentHash());
+ }
+ hash.add(QString("variantdefs"));
+ for (int i = 0; i < m_VariantDefs.size(); i++)
+ {
+  hash.add(m_VariantDefs[i]->contentHash());
+ }
+ hash.add(QString("parts"));
+ for (int i = 0; i < m_Parts.size(); i++)
+ {
+  hash.add(m_Parts[i]->contentHash());
+ }
+ hash.add(QString("sheets"));
+ for (int i = 0; i < m_Sheets.size(); i++)
+ {
+  hash.add(m_Sheets[i]->contentHash());
+ }
+}
+
 CPart *CModule::findPartByName(const QString& name)
 {
  CPart *result = 0;
@@ -9594,11 +11856,13 @@ CPart *CModule::findPartByName(const QString& name)
 
 CSchematic::CSchematic(const CSchematic& schematic)
 {
+ link(&m_Description);
  assign(schematic);
 }
 
 CSchematic::CSchematic(void)
 {
+ link(&m_Description);
  clear();
 }
 
@@ -9614,6 +11878,7 @@ void CSchematic::operator =(const CSchematic& schematic)
 
 void CSchematic::clear(void)
 {
+ modify();
  m_Description.clear();
  for (int i = 0; i < m_Libraries.size(); i++)
  {
@@ -9666,42 +11931,42 @@ void CSchematic::assign(const CSchematic& schematic)
  for (int i = 0; i < schematic.m_Libraries.size(); i++)
  {
   CLibrary *l = new CLibrary(*schematic.m_Libraries.at(i));
-  m_Libraries.append(l);
+  m_Libraries.append(link(l));
  }
  for (int i = 0; i < schematic.m_Attributes.size(); i++)
  {
   CAttribute *a = new CAttribute(*schematic.m_Attributes.at(i));
-  m_Attributes.append(a);
+  m_Attributes.append(link(a));
  }
  for (int i = 0; i < schematic.m_VariantDefs.size(); i++)
  {
   CVariantDef *v = new CVariantDef(*schematic.m_VariantDefs.at(i));
-  m_VariantDefs.append(v);
+  m_VariantDefs.append(link(v));
  }
  for (int i = 0; i < schematic.m_Classes.size(); i++)
  {
   CClass *c = new CClass(*schematic.m_Classes.at(i));
-  m_Classes.append(c);
+  m_Classes.append(link(c));
  }
  for (int i = 0; i < schematic.m_Modules.size(); i++)
  {
   CModule *c = new CModule(*schematic.m_Modules.at(i));
-  m_Modules.append(c);
+  m_Modules.append(link(c));
  }
  for (int i = 0; i < schematic.m_Parts.size(); i++)
  {
   CPart *p = new CPart(*schematic.m_Parts.at(i));
-  m_Parts.append(p);
+  m_Parts.append(link(p));
  }
  for (int i = 0; i < schematic.m_Sheets.size(); i++)
  {
   CSheet *s = new CSheet(*schematic.m_Sheets.at(i));
-  m_Sheets.append(s);
+  m_Sheets.append(link(s));
  }
  for (int i = 0; i < schematic.m_Errors.size(); i++)
  {
   CApproved *a = new CApproved(*schematic.m_Errors.at(i));
-  m_Errors.append(a);
+  m_Errors.append(link(a));
  }
  m_XRefLabel = schematic.m_XRefLabel;
  m_XRefPart = schematic.m_XRefPart;
@@ -9807,6 +12072,7 @@ void CSchematic::show(std::ostream& out, const int level)
 
 bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="schematic") e = e.nextSiblingElement("schematic");
  if (!e.isNull())
@@ -9823,7 +12089,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CLibrary *l = new CLibrary();
-    m_Libraries.append(l);
+    m_Libraries.append(link(l));
     l->readFromXML(cc,options);
     cc = cc.nextSiblingElement("library");
    }
@@ -9835,7 +12101,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CAttribute *a = new CAttribute();
-    m_Attributes.append(a);
+    m_Attributes.append(link(a));
     a->readFromXML(cc,options);
     cc = cc.nextSiblingElement("attribute");
    }
@@ -9847,7 +12113,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CVariantDef *v = new CVariantDef();
-    m_VariantDefs.append(v);
+    m_VariantDefs.append(link(v));
     v->readFromXML(cc,options);
     cc = cc.nextSiblingElement("variantdef");
    }
@@ -9859,7 +12125,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CClass *l = new CClass();
-    m_Classes.append(l);
+    m_Classes.append(link(l));
     l->readFromXML(cc,options);
     cc = cc.nextSiblingElement("class");
    }
@@ -9871,7 +12137,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CModule *m = new CModule();
-    m_Modules.append(m);
+    m_Modules.append(link(m));
     m->readFromXML(cc,options);
     cc = cc.nextSiblingElement("module");
    }
@@ -9883,7 +12149,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CPart *p = new CPart();
-    m_Parts.append(p);
+    m_Parts.append(link(p));
     p->readFromXML(cc,options);
     cc = cc.nextSiblingElement("part");
    }
@@ -9895,7 +12161,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CSheet *h = new CSheet();
-    m_Sheets.append(h);
+    m_Sheets.append(link(h));
     h->readFromXML(cc,options);
     cc = cc.nextSiblingElement("sheet");
    }
@@ -9907,7 +12173,7 @@ bool CSchematic::readFromXML(const QDomElement& root, const CEagleDocumentOption
    while (!cc.isNull())
    {
     CApproved *a = new CApproved();
-    m_Errors.append(a);
+    m_Errors.append(link(a));
     a->readFromXML(cc,options);
     cc = cc.nextSiblingElement("approved");
    }
@@ -9933,30 +12199,30 @@ bool CSchematic::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
   QDomElement e = host.createElement("schematic");
   e.setAttribute("xreflabel",m_XRefLabel);
   e.setAttribute("xrefpart",m_XRefPart);
-  m_Description.writeToXML(host,e,options);
+  writeChild(m_Description,host,e,options);
   QDomElement c = host.createElement("libraries");
   e.appendChild(c);
   for (int i = 0; i < m_Libraries.size(); i++)
   {
-   m_Libraries[i]->writeToXML(host,c,options);
+   writeChild(*m_Libraries[i],host,c,options);
   }
   c = host.createElement("attributes");
   e.appendChild(c);
   for (int i = 0; i < m_Attributes.size(); i++)
   {
-   m_Attributes[i]->writeToXML(host,c,options);
+   writeChild(*m_Attributes[i],host,c,options);
   }
   c = host.createElement("variantdefs");
   e.appendChild(c);
   for (int i = 0; i < m_VariantDefs.size(); i++)
   {
-   m_VariantDefs[i]->writeToXML(host,c,options);
+   writeChild(*m_VariantDefs[i],host,c,options);
   }
   c = host.createElement("classes");
   e.appendChild(c);
   for (int i = 0; i < m_Classes.size(); i++)
   {
-   m_Classes[i]->writeToXML(host,c,options);
+   writeChild(*m_Classes[i],host,c,options);
   }
   if (options.version()>=CVersionNumber(7,0))
   {
@@ -9964,26 +12230,26 @@ bool CSchematic::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
    e.appendChild(c);
    for (int i = 0; i < m_Modules.size(); i++)
    {
-    m_Modules[i]->writeToXML(host,c,options);
+    writeChild(*m_Modules[i],host,c,options);
    }
   }
   c = host.createElement("parts");
   e.appendChild(c);
   for (int i = 0; i < m_Parts.size(); i++)
   {
-   m_Parts[i]->writeToXML(host,c,options);
+   writeChild(*m_Parts[i],host,c,options);
   }
   c = host.createElement("sheets");
   e.appendChild(c);
   for (int i = 0; i < m_Sheets.size(); i++)
   {
-   m_Sheets[i]->writeToXML(host,c,options);
+   writeChild(*m_Sheets[i],host,c,options);
   }
   c = host.createElement("errors");
   e.appendChild(c);
   for (int i = 0; i < m_Errors.size(); i++)
   {
-   m_Errors[i]->writeToXML(host,c,options);
+   writeChild(*m_Errors[i],host,c,options);
   }
   root.appendChild(e);
   return true;
@@ -9991,6 +12257,54 @@ bool CSchematic::writeToXML(QDomDocument& host, QDomElement& root, const CEagleD
  return false;
 }
 
+void CSchematic::hashFields(CContentHash& hash)
+{
+ hash.add(QString("schematic"));
+ hash.add(m_XRefLabel);
+ hash.add(m_XRefPart);
+ hash.add(m_Description.contentHash());
+ hash.add(QString("libraries"));
+ for (int i = 0; i < m_Libraries.size(); i++)
+ {
+  hash.add(m_Libraries[i]->contentHash());
+ }
+ hash.add(QString("attributes"));
+ for (int i = 0; i < m_Attributes.size(); i++)
+ {
+  hash.add(m_Attributes[i]->contentHash());
+ }
+ hash.add(QString("variantdefs"));
+ for (int i = 0; i < m_VariantDefs.size(); i++)
+ {
+  hash.add(m_VariantDefs[i]->contentHash());
+ }
+ hash.add(QString("classes"));
+ for (int i = 0; i < m_Classes.size(); i++)
+ {
+  hash.add(m_Classes[i]->contentHash());
+ }
+ hash.add(QString("modules"));
+ for (int i = 0; i < m_Modules.size(); i++)
+ {
+  hash.add(m_Modules[i]->contentHash());
+ }
+ hash.add(QString("parts"));
+ for (int i = 0; i < m_Parts.size(); i++)
+ {
+  hash.add(m_Parts[i]->contentHash());
+ }
+ hash.add(QString("sheets"));
+ for (int i = 0; i < m_Sheets.size(); i++)
+ {
+  hash.add(m_Sheets[i]->contentHash());
+ }
+ hash.add(QString("errors"));
+ for (int i = 0; i < m_Errors.size(); i++)
+ {
+  hash.add(m_Errors[i]->contentHash());
+ }
+}
+
 CLibrary *CSchematic::findLibraryByName(const QString& name)
 {
  CLibrary *result = 0;
@@ -10025,11 +12339,21 @@ CPart *CSchematic::findPartByName(const QString& name)
 
 CDrawing::CDrawing(const CDrawing& drawing)
 {
+ link(&m_Settings);
+ link(&m_Grid);
+ link(&m_Library);
+ link(&m_Schematic);
+ link(&m_Board);
  assign(drawing);
 }
 
 CDrawing::CDrawing(void)
 {
+ link(&m_Settings);
+ link(&m_Grid);
+ link(&m_Library);
+ link(&m_Schematic);
+ link(&m_Board);
  clear();
 }
 
@@ -10045,6 +12369,7 @@ void CDrawing::operator =(const CDrawing& drawing)
 
 void CDrawing::clear(void)
 {
+ modify();
  m_Grid.clear();
  m_Library.clear();
  m_Schematic.clear();
@@ -10075,7 +12400,7 @@ void CDrawing::assign(const CDrawing& drawing)
  for (int i = 0; i < drawing.m_Layers.size(); i++)
  {
   CLayer *l = new CLayer(*drawing.m_Layers.at(i));
-  m_Layers.append(l);
+  m_Layers.append(link(l));
  }
  m_Settings = drawing.m_Settings;
  m_Layers = drawing.m_Layers;
@@ -10085,72 +12410,73 @@ void CDrawing::assign(const CDrawing& drawing)
 
 void CDrawing::initDefaultLayers()
 {
+ modify();
  for (int i = 0; i < m_Layers.size(); i++)
  {
   if (0!=m_Layers[i]) delete m_Layers[i];
  }
  m_Layers.clear();
- m_Layers.append(new CLayer(CLayer::LAYER_TOP,CLayer::layerName(CLayer::LAYER_TOP), 4, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER2,CLayer::layerName(CLayer::LAYER_LAYER2), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER3,CLayer::layerName(CLayer::LAYER_LAYER3), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER4,CLayer::layerName(CLayer::LAYER_LAYER4), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER5,CLayer::layerName(CLayer::LAYER_LAYER5), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER6,CLayer::layerName(CLayer::LAYER_LAYER6), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER7,CLayer::layerName(CLayer::LAYER_LAYER7), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER8,CLayer::layerName(CLayer::LAYER_LAYER8), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER9,CLayer::layerName(CLayer::LAYER_LAYER9), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER10,CLayer::layerName(CLayer::LAYER_LAYER10), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER11,CLayer::layerName(CLayer::LAYER_LAYER11), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER12,CLayer::layerName(CLayer::LAYER_LAYER12), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER13,CLayer::layerName(CLayer::LAYER_LAYER13), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER14,CLayer::layerName(CLayer::LAYER_LAYER14), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_LAYER15,CLayer::layerName(CLayer::LAYER_LAYER15), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BOTTOM,CLayer::layerName(CLayer::LAYER_BOTTOM), 1, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_PADS,CLayer::layerName(CLayer::LAYER_PADS), 2, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_VIAS,CLayer::layerName(CLayer::LAYER_VIAS), 2, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_UNROUTED,CLayer::layerName(CLayer::LAYER_UNROUTED), 6, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_DIMENSION,CLayer::layerName(CLayer::LAYER_DIMENSION), 15, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TPLACE,CLayer::layerName(CLayer::LAYER_TPLACE), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BPLACE,CLayer::layerName(CLayer::LAYER_BPLACE), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TORIGINS,CLayer::layerName(CLayer::LAYER_TORIGINS), 15, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BORIGINS,CLayer::layerName(CLayer::LAYER_BORIGINS), 15, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TNAMES,CLayer::layerName(CLayer::LAYER_TNAMES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BNAMES,CLayer::layerName(CLayer::LAYER_BNAMES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TVALUES,CLayer::layerName(CLayer::LAYER_TVALUES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BVALUES,CLayer::layerName(CLayer::LAYER_BVALUES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TSTOP,CLayer::layerName(CLayer::LAYER_TSTOP), 7, 3, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BSTOP,CLayer::layerName(CLayer::LAYER_BSTOP), 7, 6, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TCREAM,CLayer::layerName(CLayer::LAYER_TCREAM), 7, 4, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BCREAM,CLayer::layerName(CLayer::LAYER_BCREAM), 7, 5, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TFINISH,CLayer::layerName(CLayer::LAYER_TFINISH), 6, 3, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BFINISH,CLayer::layerName(CLayer::LAYER_BFINISH), 6, 6, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TGLUE,CLayer::layerName(CLayer::LAYER_TGLUE), 7, 4, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BGLUE,CLayer::layerName(CLayer::LAYER_BGLUE), 7, 5, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TTEST,CLayer::layerName(CLayer::LAYER_TTEST), 7, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BTEST,CLayer::layerName(CLayer::LAYER_BTEST), 7, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TKEEPOUT,CLayer::layerName(CLayer::LAYER_TKEEPOUT), 4, 11, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BKEEPOUT,CLayer::layerName(CLayer::LAYER_BKEEPOUT), 1, 11, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TRESTRICT,CLayer::layerName(CLayer::LAYER_TRESTRICT), 4, 10, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BRESTRICT,CLayer::layerName(CLayer::LAYER_BRESTRICT), 1, 10, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_VRESTRICT,CLayer::layerName(CLayer::LAYER_VRESTRICT), 2, 10, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_DRILLS,CLayer::layerName(CLayer::LAYER_DRILLS), 7, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_HOLES,CLayer::layerName(CLayer::LAYER_HOLES), 7, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_MILLING,CLayer::layerName(CLayer::LAYER_MILLING), 3, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_MEASURES,CLayer::layerName(CLayer::LAYER_MEASURES), 7, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_DOCUMENT,CLayer::layerName(CLayer::LAYER_DOCUMENT), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_REFERENCE,CLayer::layerName(CLayer::LAYER_REFERENCE), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_TDOCU,CLayer::layerName(CLayer::LAYER_TDOCU), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BDOCU,CLayer::layerName(CLayer::LAYER_BDOCU), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_MODULES,CLayer::layerName(CLayer::LAYER_MODULES), 5, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_NETS,CLayer::layerName(CLayer::LAYER_NETS), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_BUSSES,CLayer::layerName(CLayer::LAYER_BUSSES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_PINS,CLayer::layerName(CLayer::LAYER_PINS), 2, 1, false, true));
- m_Layers.append(new CLayer(CLayer::LAYER_SYMBOLS,CLayer::layerName(CLayer::LAYER_SYMBOLS), 4, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_NAMES,CLayer::layerName(CLayer::LAYER_NAMES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_VALUES,CLayer::layerName(CLayer::LAYER_VALUES), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_INFO,CLayer::layerName(CLayer::LAYER_INFO), 7, 1, true, true));
- m_Layers.append(new CLayer(CLayer::LAYER_GUIDE,CLayer::layerName(CLayer::LAYER_GUIDE), 6, 1, true, true));
- //m_Layers.append(new CLayer(CLayer::LAYER_,CLayer::layerName(CLayer::LAYER_), 1, 1, true, true));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TOP,CLayer::layerName(CLayer::LAYER_TOP), 4, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER2,CLayer::layerName(CLayer::LAYER_LAYER2), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER3,CLayer::layerName(CLayer::LAYER_LAYER3), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER4,CLayer::layerName(CLayer::LAYER_LAYER4), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER5,CLayer::layerName(CLayer::LAYER_LAYER5), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER6,CLayer::layerName(CLayer::LAYER_LAYER6), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER7,CLayer::layerName(CLayer::LAYER_LAYER7), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER8,CLayer::layerName(CLayer::LAYER_LAYER8), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER9,CLayer::layerName(CLayer::LAYER_LAYER9), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER10,CLayer::layerName(CLayer::LAYER_LAYER10), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER11,CLayer::layerName(CLayer::LAYER_LAYER11), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER12,CLayer::layerName(CLayer::LAYER_LAYER12), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER13,CLayer::layerName(CLayer::LAYER_LAYER13), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER14,CLayer::layerName(CLayer::LAYER_LAYER14), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_LAYER15,CLayer::layerName(CLayer::LAYER_LAYER15), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BOTTOM,CLayer::layerName(CLayer::LAYER_BOTTOM), 1, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_PADS,CLayer::layerName(CLayer::LAYER_PADS), 2, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_VIAS,CLayer::layerName(CLayer::LAYER_VIAS), 2, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_UNROUTED,CLayer::layerName(CLayer::LAYER_UNROUTED), 6, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_DIMENSION,CLayer::layerName(CLayer::LAYER_DIMENSION), 15, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TPLACE,CLayer::layerName(CLayer::LAYER_TPLACE), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BPLACE,CLayer::layerName(CLayer::LAYER_BPLACE), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TORIGINS,CLayer::layerName(CLayer::LAYER_TORIGINS), 15, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BORIGINS,CLayer::layerName(CLayer::LAYER_BORIGINS), 15, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TNAMES,CLayer::layerName(CLayer::LAYER_TNAMES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BNAMES,CLayer::layerName(CLayer::LAYER_BNAMES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TVALUES,CLayer::layerName(CLayer::LAYER_TVALUES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BVALUES,CLayer::layerName(CLayer::LAYER_BVALUES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TSTOP,CLayer::layerName(CLayer::LAYER_TSTOP), 7, 3, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BSTOP,CLayer::layerName(CLayer::LAYER_BSTOP), 7, 6, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TCREAM,CLayer::layerName(CLayer::LAYER_TCREAM), 7, 4, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BCREAM,CLayer::layerName(CLayer::LAYER_BCREAM), 7, 5, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TFINISH,CLayer::layerName(CLayer::LAYER_TFINISH), 6, 3, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BFINISH,CLayer::layerName(CLayer::LAYER_BFINISH), 6, 6, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TGLUE,CLayer::layerName(CLayer::LAYER_TGLUE), 7, 4, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BGLUE,CLayer::layerName(CLayer::LAYER_BGLUE), 7, 5, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TTEST,CLayer::layerName(CLayer::LAYER_TTEST), 7, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BTEST,CLayer::layerName(CLayer::LAYER_BTEST), 7, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TKEEPOUT,CLayer::layerName(CLayer::LAYER_TKEEPOUT), 4, 11, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BKEEPOUT,CLayer::layerName(CLayer::LAYER_BKEEPOUT), 1, 11, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TRESTRICT,CLayer::layerName(CLayer::LAYER_TRESTRICT), 4, 10, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BRESTRICT,CLayer::layerName(CLayer::LAYER_BRESTRICT), 1, 10, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_VRESTRICT,CLayer::layerName(CLayer::LAYER_VRESTRICT), 2, 10, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_DRILLS,CLayer::layerName(CLayer::LAYER_DRILLS), 7, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_HOLES,CLayer::layerName(CLayer::LAYER_HOLES), 7, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_MILLING,CLayer::layerName(CLayer::LAYER_MILLING), 3, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_MEASURES,CLayer::layerName(CLayer::LAYER_MEASURES), 7, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_DOCUMENT,CLayer::layerName(CLayer::LAYER_DOCUMENT), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_REFERENCE,CLayer::layerName(CLayer::LAYER_REFERENCE), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_TDOCU,CLayer::layerName(CLayer::LAYER_TDOCU), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BDOCU,CLayer::layerName(CLayer::LAYER_BDOCU), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_MODULES,CLayer::layerName(CLayer::LAYER_MODULES), 5, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_NETS,CLayer::layerName(CLayer::LAYER_NETS), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_BUSSES,CLayer::layerName(CLayer::LAYER_BUSSES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_PINS,CLayer::layerName(CLayer::LAYER_PINS), 2, 1, false, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_SYMBOLS,CLayer::layerName(CLayer::LAYER_SYMBOLS), 4, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_NAMES,CLayer::layerName(CLayer::LAYER_NAMES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_VALUES,CLayer::layerName(CLayer::LAYER_VALUES), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_INFO,CLayer::layerName(CLayer::LAYER_INFO), 7, 1, true, true)));
+ m_Layers.append(link(new CLayer(CLayer::LAYER_GUIDE,CLayer::layerName(CLayer::LAYER_GUIDE), 6, 1, true, true)));
+ //m_Layers.append(link(new CLayer(CLayer::LAYER_,CLayer::layerName(CLayer::LAYER_), 1, 1, true, true)));
 }
 
 CLayer *CDrawing::findLayerByID(const TLayer layer)
@@ -10192,6 +12518,7 @@ void CDrawing::show(std::ostream& out, const int level)
 
 bool CDrawing::readFromXML(const QDomElement &root, const CEagleDocumentOptions& options)
 {
+ modify();
  bool result = true;
  QDomElement e = root;
  if (e.nodeName()!="drawing") e = e.nextSiblingElement("drawing");
@@ -10214,7 +12541,7 @@ bool CDrawing::readFromXML(const QDomElement &root, const CEagleDocumentOptions&
    while (!cc.isNull())
    {
     CLayer *l = new CLayer();
-    m_Layers.append(l);
+    m_Layers.append(link(l));
     result &= l->readFromXML(cc,options);
     cc = cc.nextSiblingElement("layer");
    }
@@ -10253,26 +12580,26 @@ bool CDrawing::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  if (!host.isNull() && !root.isNull())
  {
   QDomElement e = host.createElement("drawing");
-  m_Settings.writeToXML(host,e,options);
-  m_Grid.writeToXML(host,e,options);
+  writeChild(m_Settings,host,e,options);
+  writeChild(m_Grid,host,e,options);
   QDomElement c = host.createElement("layers");
   e.appendChild(c);
   for (int i = 0; i < m_Layers.size(); i++)
   {
    if ((CLayer::LAYER_MODULES==m_Layers[i]->layer()) && options.version()<CVersionNumber(7,0)) continue;
-   m_Layers[i]->writeToXML(host,c,options);
+   writeChild(*m_Layers[i],host,c,options);
   }
   if ((CDrawing::dmLibrary==m_Mode) || (CDrawing::dmMixed==m_Mode))
   {
-   m_Library.writeToXML(host,e,options);
+   writeChild(m_Library,host,e,options);
   }
   if ((CDrawing::dmSchematic==m_Mode) || (CDrawing::dmMixed==m_Mode))
   {
-   m_Schematic.writeToXML(host,e,options);
+   writeChild(m_Schematic,host,e,options);
   }
   if ((CDrawing::dmBoard==m_Mode) || (CDrawing::dmMixed==m_Mode))
   {
-   m_Board.writeToXML(host,e,options);
+   writeChild(m_Board,host,e,options);
   }
   root.appendChild(e);
   return true;
@@ -10280,6 +12607,30 @@ bool CDrawing::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDoc
  return false;
 }
 
+void CDrawing::hashFields(CContentHash& hash)
+{
+ hash.add(QString("drawing"));
+ hash.add(m_Settings.contentHash());
+ hash.add(m_Grid.contentHash());
+ hash.add(QString("layers"));
+ for (int i = 0; i < m_Layers.size(); i++)
+ {
+  hash.add(m_Layers[i]->contentHash());
+ }
+ if ((CDrawing::dmLibrary==m_Mode) || (CDrawing::dmMixed==m_Mode))
+ {
+  hash.add(m_Library.contentHash());
+ }
+ if ((CDrawing::dmSchematic==m_Mode) || (CDrawing::dmMixed==m_Mode))
+ {
+  hash.add(m_Schematic.contentHash());
+ }
+ if ((CDrawing::dmBoard==m_Mode) || (CDrawing::dmMixed==m_Mode))
+ {
+  hash.add(m_Board.contentHash());
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CNote::CNote(const CNote& note)
@@ -10315,6 +12666,7 @@ void CNote::operator =(const CNote& note)
 
 void CNote::clear(void)
 {
+ modify();
  m_Note.clear();
  m_Version = EAGLE_DTD_VERSION;
  m_Severity = CNote::nsInfo;
@@ -10322,6 +12674,7 @@ void CNote::clear(void)
 \
 void CNote::assign(const CNote& note)
 {
+ modify();
  m_Note = note.m_Note;
  m_Version = note.m_Version;
  m_Severity = note.m_Severity;
@@ -10338,6 +12691,7 @@ void CNote::show(std::ostream& out, const int level)
 
 bool CNote::readFromXML(const QDomElement &root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="note") e = e.nextSiblingElement("note");
  if (!e.isNull())
@@ -10386,6 +12740,14 @@ bool CNote::writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocume
  return false;
 }
 
+void CNote::hashFields(CContentHash& hash)
+{
+ hash.add(QString("note"));
+ hash.add(m_Version);
+ hash.add(m_Severity);
+ hash.add(m_Note);
+}
+
 
 //------------------------------------------------------------------------------
 
@@ -10411,6 +12773,7 @@ void CCompatibility::operator =(const CCompatibility& compatibility)
 
 void CCompatibility::clear(void)
 {
+ modify();
  for (int i = 0; i < m_Notes.size(); i++)
  {
   if (0!=m_Notes[i]) delete m_Notes[i];
@@ -10424,7 +12787,7 @@ void CCompatibility::assign(const CCompatibility& compatibility)
  for (int i = 0; i < compatibility.m_Notes.size(); i++)
  {
   CNote *n = new CNote(*compatibility.m_Notes.at(i));
-  m_Notes.append(n);
+  m_Notes.append(link(n));
  }
  m_Notes = compatibility.m_Notes;
 }
@@ -10443,6 +12806,7 @@ void CCompatibility::show(std::ostream& out, const int level)
 
 bool CCompatibility::readFromXML(const QDomElement &root, const CEagleDocumentOptions& options)
 {
+ modify();
  QDomElement e = root;
  if (e.nodeName()!="compatibility") e = e.nextSiblingElement("compatibility");
  if (!e.isNull())
@@ -10451,7 +12815,7 @@ bool CCompatibility::readFromXML(const QDomElement &root, const CEagleDocumentOp
   while (!c.isNull())
   {
    CNote *n = new CNote();
-   m_Notes.append(n);
+   m_Notes.append(link(n));
    n->readFromXML(c,options);
    c = c.nextSiblingElement("note");
   }
@@ -10469,7 +12833,7 @@ bool CCompatibility::writeToXML(QDomDocument& host, QDomElement& root, const CEa
    QDomElement e = host.createElement("compatibility");
    for (int i = 0; i < m_Notes.size(); i++)
    {
-    m_Notes[i]->writeToXML(host,e,options);
+    writeChild(*m_Notes[i],host,e,options);
    }
    root.appendChild(e);
   }
@@ -10478,15 +12842,33 @@ bool CCompatibility::writeToXML(QDomDocument& host, QDomElement& root, const CEa
  return false;
 }
 
+void CCompatibility::hashFields(CContentHash& hash)
+{
+ if (m_Notes.size()>0)
+ {
+  hash.add(QString("compatibility"));
+  for (int i = 0; i < m_Notes.size(); i++)
+  {
+   hash.add(m_Notes[i]->contentHash());
+  }
+ }
+}
+
 //------------------------------------------------------------------------------
 
 CEagleDocument::CEagleDocument(const CEagleDocument& document)
 {
+ link(&m_PreNotes);
+ link(&m_Drawing);
+ link(&m_PostNotes);
  assign(document);
 }
 
 CEagleDocument::CEagleDocument(void)
 {
+ link(&m_PreNotes);
+ link(&m_Drawing);
+ link(&m_PostNotes);
  clear();
 }
 
@@ -10502,6 +12884,7 @@ void CEagleDocument::operator =(const CEagleDocument& document)
 
 void CEagleDocument::clear(void)
 {
+ modify();
  m_PreNotes.clear();
  m_Drawing.clear();
  m_PostNotes.clear();
@@ -10514,6 +12897,7 @@ void CEagleDocument::clear(void)
 
 void CEagleDocument::assign(const CEagleDocument& document)
 {
+ modify();
  m_PreNotes = document.m_PreNotes;
  m_Drawing = document.m_Drawing;
  m_PostNotes = document.m_PostNotes;
@@ -10591,6 +12975,7 @@ bool CEagleDocument::saveToFile(const QString& fileName)
 
 bool CEagleDocument::readFromXML(const QDomElement& root, const CEagleDocumentOptions& options)
 {
+ modify();
  bool result = false;
  QDomElement e = root;
  do
@@ -10625,11 +13010,19 @@ bool CEagleDocument::writeToXML(QDomDocument& host, QDomElement& root, const CEa
  QDomElement e = host.createElement("eagle");
  e.setAttribute("version",QString("%1").arg(options.version().toString()));
  host.appendChild(e);
- m_PreNotes.writeToXML(host,e,options);
- m_Drawing.writeToXML(host,e,options);
- m_PostNotes.writeToXML(host,e,options);
+ writeChild(m_PreNotes,host,e,options);
+ writeChild(m_Drawing,host,e,options);
+ writeChild(m_PostNotes,host,e,options);
  return true;
 }
 
+void CEagleDocument::hashFields(CContentHash& hash)
+{
+ hash.add(QString("eagle"));
+ hash.add(m_PreNotes.contentHash());
+ hash.add(m_Drawing.contentHash());
+ hash.add(m_PostNotes.contentHash());
+}
+
 }
 //------------------------------------------------------------------------------
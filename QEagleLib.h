@@ -19,8 +19,14 @@
 #ifndef QEAGLELIB_H
 #define QEAGLELIB_H
 //------------------------------------------------------------------------------
+#include <QAtomicInt>
+#include <QHash>
 #include <QList>
+#include <QMutex>
+#include <QPair>
 #include <QString>
+#include <QStringList>
+#include <QVector>
 #include <QtXml>
 //------------------------------------------------------------------------------
 //#include ""
@@ -42,9 +48,67 @@ typedef int TClass;
 typedef double TCoord; // coordinates, given in millimeters
 typedef double TDimension; // dimensions, given in millimeters
 
+const double M_PI_DIV_180 = M_PI / 180.0;
+inline double degtorad(double x) { return x * M_PI_DIV_180; }
+inline double radtodeg(double x) { return x / M_PI_DIV_180; }
+
 QString encodeExtent(const int startLayer, const int stopLayer);
 void decodeExtent(const QString& value, int& startLayer, int& stopLayer);
 
+class CPoint
+{
+ public:
+  CPoint(void): m_X(0.0), m_Y(0.0) {}
+  CPoint(const TCoord x, const TCoord y): m_X(x), m_Y(y) {}
+ public:
+  // getters
+  TCoord x(void) const { return m_X; }
+  TCoord y(void) const { return m_Y; }
+  // setters
+  void setX(const TCoord value) { m_X = value; }
+  void setY(const TCoord value) { m_Y = value; }
+  //
+  bool operator ==(const CPoint& point) const { return m_X==point.m_X && m_Y==point.m_Y; }
+  bool operator !=(const CPoint& point) const { return m_X!=point.m_X || m_Y!=point.m_Y; }
+ protected:
+  TCoord m_X;
+  TCoord m_Y;
+};
+
+class CBoundingBox
+{
+ public:
+  CBoundingBox(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2);
+  CBoundingBox(const CBoundingBox& box);
+  CBoundingBox(void);
+  virtual ~CBoundingBox(void);
+ public:
+  void operator =(const CBoundingBox& box);
+  void clear(void);
+  void assign(const CBoundingBox& box);
+  void include(const TCoord x, const TCoord y);
+  void include(const TCoord x, const TCoord y, const TDimension radius);
+  void include(const CBoundingBox& box);
+  void inflate(const TDimension delta);
+  bool intersects(const CBoundingBox& box) const;
+  bool contains(const TCoord x, const TCoord y) const;
+  bool contains(const CBoundingBox& box) const;
+ public:
+  // getters
+  bool isValid(void) const { return m_Left<=m_Right && m_Bottom<=m_Top; }
+  TCoord left(void) const { return m_Left; }
+  TCoord bottom(void) const { return m_Bottom; }
+  TCoord right(void) const { return m_Right; }
+  TCoord top(void) const { return m_Top; }
+  TDimension width(void) const { return isValid() ? m_Right-m_Left : 0.0; }
+  TDimension height(void) const { return isValid() ? m_Top-m_Bottom : 0.0; }
+ protected:
+  TCoord m_Left;
+  TCoord m_Bottom;
+  TCoord m_Right;
+  TCoord m_Top;
+};
+
 class CVersionNumber
 {
  public:
@@ -74,10 +138,15 @@ class CVersionNumber
   unsigned int m_Minor;
 };
 
+class CBoard;
 class CEagleDocument;
+class CSymbol;
+class CEntity;
+
 class CEagleDocumentOptions
 {
  friend class CEagleDocument;
+ friend class CEntity;
  public:
   CEagleDocumentOptions(const CEagleDocumentOptions& options);
   CEagleDocumentOptions(void);
@@ -91,6 +160,31 @@ class CEagleDocumentOptions
  private:
   bool m_WriteDefaults;
   CVersionNumber m_Version;
+  QList<QPair<QDomElement,CEntity*> > *m_Children; // default = 0, see CEntity::writeFields()
+  bool m_SkipChildren; // default = false
+};
+
+// 64 bit FNV-1a over canonical document content; strings are taken as
+// UTF-8 prefixed by their length and numbers in little endian byte order so
+// that hashes agree between hosts, attributes are taken in name order and
+// "-0" counts as "0", as does -0.0
+class CContentHash
+{
+ public:
+  CContentHash(void): m_Value(Q_UINT64_C(14695981039346656037)) {}
+ public:
+  static QString toString(const quint64 value);
+ public:
+  void add(const char *data, const int size);
+  void add(const QString& value);
+  void add(const quint64 value);
+  void add(const int value);
+  void add(const double value);
+  void addAttribute(const QString& name, const QString& value);
+  // getters
+  quint64 value(void) const { return m_Value; }
+ protected:
+  quint64 m_Value;
 };
 
 class CEntity
@@ -105,6 +199,48 @@ class CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  // adds the kind and the fields of the entity as written to a file and the
+  // content hashes of the entities it holds, in the order they are written
+  virtual void hashFields(CContentHash& hash);
+  // edit counter of the entity and everything it owns: setters, clear() and
+  // readFromXML() draw a new number and hand it up to the document, so
+  // caches derived from an entity store the revision they were built at
+  // and are rebuilt once it differs, edits of other documents leave them
+  // alone. Numbers are unique for the process, an entity built at the same
+  // address never repeats a revision. Code editing the entity lists directly
+  // puts new entities in through adopt() and calls modify() on the owner
+  // after removing some; an entity taken out of a list has to be adopted
+  // again before its old owner is destroyed
+  int revision(void) const { return m_Revision.loadAcquire(); }
+  void modify(void);
+  template <class T> T *adopt(T *entity) { link(entity); modify(); return entity; }
+  // hash of the content as written to a file, equal entities of the same
+  // kind hash equal wherever they reside; taken from hashFields(), so the
+  // entities held count by their own cached hash, and kept until the entity
+  // or one of them is modified
+  quint64 contentHash(void);
+  // writes the entity like writeToXML() does but the entities it holds only
+  // with their own fields, these are listed with the element each of them
+  // wrote (the root itself when it took their fields); returns the element
+  // of the entity, a null one when it wrote nothing
+  QDomElement writeFields(QDomDocument& host, QDomElement& root, QList<QPair<QDomElement,CEntity*> >& children);
+ public:
+  // getters
+  CEntity *owner(void) const { return m_Owner; }
+ protected:
+  // writes an entity held by this one, call from writeToXML()
+  static bool writeChild(CEntity& child, QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  static QDomElement writtenElement(CEntity& entity, QDomDocument& host, QDomElement& root,
+                                    const CEagleDocumentOptions& options);
+  // links an entity held by this one without counting it as an edit
+  template <class T> T *link(T *entity) { static_cast<CEntity*>(entity)->m_Owner = this; return entity; }
+  // serializes fills of the caches kept by entities, parallel jobs reach
+  // them through shared getters
+  static QMutex& cacheMutex(void);
+ private:
+  CEntity *m_Owner;
+  QAtomicInteger<quint64> m_ContentHash; // 0 until computed, cleared by modify()
+  QAtomicInt m_Revision;
 };
 
 // miscellaneous objects
@@ -126,13 +262,14 @@ class CSettings: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   bool alwaysVectorFont(void) { return m_AlwaysVectorFont; }
   CSettings::VerticalText verticalText(void) { return m_VerticalText; }
   // setters
-  void setAlwaysVectorFont(const bool value) { m_AlwaysVectorFont = value; }
-  void setVerticalText(const CSettings::VerticalText value) { m_VerticalText = value; }
+  void setAlwaysVectorFont(const bool value) { m_AlwaysVectorFont = value; modify(); }
+  void setVerticalText(const CSettings::VerticalText value) { m_VerticalText = value; modify(); }
  protected:
   bool m_AlwaysVectorFont; // implied
   CSettings::VerticalText m_VerticalText; // default = up
@@ -159,6 +296,7 @@ class CGrid: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   double distance(void) { return m_Distance; }
@@ -171,15 +309,15 @@ class CGrid: public CEntity
   CGrid::Unit altUnitDist(void) { return m_AltUnitDist; }
   CGrid::Unit altUnit(void) { return m_AltUnit; }
   // setters
-  void setDistance(const double value) { m_Distance = value; }
-  void setUnitDist(const CGrid::Unit value) { m_UnitDist = value; }
-  void setUnit(const CGrid::Unit value) { m_Unit = value; }
-  void setStyle(const CGrid::Style value) { m_Style = value; }
-  void setMultiple(const int value) { m_Multiple = value; }
-  void setDisplay(const bool value) { m_Display = value; }
-  void setAltDistance(const double value) { m_AltDistance = value; }
-  void setAltUnitDist(const CGrid::Unit value) { m_AltUnitDist = value; }
-  void setAltUnit(const CGrid::Unit value) { m_AltUnit = value; }
+  void setDistance(const double value) { m_Distance = value; modify(); }
+  void setUnitDist(const CGrid::Unit value) { m_UnitDist = value; modify(); }
+  void setUnit(const CGrid::Unit value) { m_Unit = value; modify(); }
+  void setStyle(const CGrid::Style value) { m_Style = value; modify(); }
+  void setMultiple(const int value) { m_Multiple = value; modify(); }
+  void setDisplay(const bool value) { m_Display = value; modify(); }
+  void setAltDistance(const double value) { m_AltDistance = value; modify(); }
+  void setAltUnitDist(const CGrid::Unit value) { m_AltUnitDist = value; modify(); }
+  void setAltUnit(const CGrid::Unit value) { m_AltUnit = value; modify(); }
  protected:
   double m_Distance; // implied
   CGrid::Unit m_UnitDist; // implied
@@ -268,12 +406,15 @@ class CLayer: public CEntity
  public:
   static QString layerName(const TLayer layer);
   static TLayer layerNumber(const QString& name);
+  static TLayer mirrored(const TLayer layer);
+  static bool isCopper(const TLayer layer) { return layer>=LAYER_TOP && layer<=LAYER_BOTTOM; }
   virtual void operator =(const CLayer& layer);
   virtual void clear(void);
   virtual void assign(const CLayer& layer);
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   TLayer layer(void) { return m_Layer; }
@@ -283,12 +424,12 @@ class CLayer: public CEntity
   bool visible(void) { return m_Visible; }
   bool active(void) { return m_Active; }
   // setters
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setName(const QString& value) { m_Name = value; }
-  void setColor(const int value) { m_Color = value; }
-  void setFill(const int value) { m_Fill = value; }
-  void setVisible(const bool value) { m_Visible = value; }
-  void setActive(const bool value) { m_Active = value; }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setColor(const int value) { m_Color = value; modify(); }
+  void setFill(const int value) { m_Fill = value; modify(); }
+  void setVisible(const bool value) { m_Visible = value; modify(); }
+  void setActive(const bool value) { m_Active = value; modify(); }
  protected:
   TLayer m_Layer; // required
   QString m_Name; // required
@@ -311,13 +452,14 @@ class CClearance: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   TClass getClass(void) { return m_Class; }
   TDimension getValue(void) { return m_Value; }
   // setters
-  void setClass(const TClass value) { m_Class = value; }
-  void setValue(const TDimension value) { m_Value = value; }
+  void setClass(const TClass value) { m_Class = value; modify(); }
+  void setValue(const TDimension value) { m_Value = value; modify(); }
  protected:
   TClass m_Class; // required
   TDimension m_Value; // default = 0
@@ -336,13 +478,14 @@ class CDescription: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString description(void) { return m_Description; }
   QString language(void) { return m_Language; }
   // setters
-  void setDescription(const QString& value) { m_Description = value; }
-  void setLanguage(const QString& value) { m_Language = value; }
+  void setDescription(const QString& value) { m_Description = value; modify(); }
+  void setLanguage(const QString& value) { m_Language = value; modify(); }
  protected:
   QString m_Description;
   QString m_Language; // default = "en"
@@ -361,13 +504,14 @@ class CParam: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString name(void) { return m_Name; }
   QString value(void) { return m_Value; }
   // setters
-  void setName(const QString value) { m_Name = value; }
-  void setValue(const QString value) { m_Value = value; }
+  void setName(const QString value) { m_Name = value; modify(); }
+  void setValue(const QString value) { m_Value = value; modify(); }
  protected:
   QString m_Name; // required
   QString m_Value; // required
@@ -386,11 +530,12 @@ class CApproved: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString hash(void) { return m_Hash; }
   // setters
-  void setHash(const QString& value) { m_Hash = value; }
+  void setHash(const QString& value) { m_Hash = value; modify(); }
  protected:
   QString m_Hash; // required
 };
@@ -408,6 +553,7 @@ class CPass: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QList<CParam*>& params(void) { return m_Params; }
@@ -416,9 +562,9 @@ class CPass: public CEntity
   QString refer(void) { return m_Refer; }
   bool active(void) { return m_Active; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setRefer(const QString& value) { m_Refer = value; }
-  void setActive(const bool value) { m_Active = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setRefer(const QString& value) { m_Refer = value; modify(); }
+  void setActive(const bool value) { m_Active = value; modify(); }
  protected:
   QList<CParam*> m_Params;
   QString m_Name; // required
@@ -439,6 +585,7 @@ class CClass: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QList<CClearance*>& clearances(void) { return m_Clearances; }
@@ -448,10 +595,10 @@ class CClass: public CEntity
   TDimension width(void) { return m_Width; }
   TDimension drill(void) { return m_Drill; }
   // setters
-  void setNumber(const TClass value) { m_Number = value; }
-  void setName(const QString& value) { m_Name = value; }
-  void setWidth(const TDimension value) { m_Width = value; }
-  void setDrill(const TDimension value) { m_Drill = value; }
+  void setNumber(const TClass value) { m_Number = value; modify(); }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setWidth(const TDimension value) { m_Width = value; modify(); }
+  void setDrill(const TDimension value) { m_Drill = value; modify(); }
  protected:
   QList<CClearance*> m_Clearances;
   TClass m_Number; // required
@@ -460,6 +607,102 @@ class CClass: public CEntity
   TDimension m_Drill; // default = 0
 };
 
+// clearance between any two net classes as a flat table, built from the
+// <clearance> entries of all classes, a pair listed by both classes takes
+// the larger value, pairs not listed at all take the default
+class CClearanceMatrix
+{
+ public:
+  CClearanceMatrix(const CClearanceMatrix& matrix);
+  CClearanceMatrix(void);
+  virtual ~CClearanceMatrix(void);
+ public:
+  void operator =(const CClearanceMatrix& matrix);
+  void clear(void);
+  void assign(const CClearanceMatrix& matrix);
+  void build(QList<CClass*>& classes, const TDimension defaultValue);
+ public:
+  // getters
+  int size(void) const { return m_Size; }
+  TDimension defaultValue(void) const { return m_Default; }
+  // value given by the classes, 0 when they do not specify one
+  TDimension specific(const TClass a, const TClass b) const
+  {
+   return ((unsigned)a < (unsigned)m_Size && (unsigned)b < (unsigned)m_Size) ?
+    m_Values[a*m_Size+b] : 0.0;
+  }
+  // value given by the classes, or the default
+  TDimension value(const TClass a, const TClass b) const
+  {
+   TDimension v = specific(a,b);
+   return (v > 0.0) ? v : m_Default;
+  }
+ protected:
+  int m_Size; // highest class number + 1
+  QVector<TDimension> m_Values; // m_Size x m_Size, symmetric
+  TDimension m_Default;
+};
+
+// decoded <param> value: a space separated list of numbers, each with an
+// optional unit; dimensions are kept in millimeters, untouched values are
+// written back exactly as they were read
+class CDesignRuleValue
+{
+ public:
+  enum Unit {ruNone, ruMil, ruMillimeter, ruInch, ruMicron};
+ public:
+  CDesignRuleValue(const QString& text);
+  CDesignRuleValue(const CDesignRuleValue& value);
+  CDesignRuleValue(void);
+  virtual ~CDesignRuleValue(void);
+ public:
+  static QString toString(const CDesignRuleValue::Unit value);
+  static double factor(const CDesignRuleValue::Unit value);
+ public:
+  void operator =(const CDesignRuleValue& value);
+  void clear(void);
+  void assign(const CDesignRuleValue& value);
+  bool decode(const QString& text);
+  QString encode(void) const;
+ public:
+  // getters
+  int count(void) const { return m_Values.size(); }
+  double value(const int index = 0, const double defaultValue = 0.0) const;
+  CDesignRuleValue::Unit unit(const int index = 0) const;
+  bool isNumeric(void) const { return m_Numeric; }
+  QString text(void) const { return encode(); }
+  // setters, an existing token keeps its unit, unit applies to new ones
+  void setValue(const int index, const double value,
+                const CDesignRuleValue::Unit unit = CDesignRuleValue::ruMillimeter);
+ protected:
+  QString m_Text; // source text, returned as is until a value is changed
+  QStringList m_Tokens;
+  QVector<double> m_Values; // millimeters for dimensions
+  QVector<CDesignRuleValue::Unit> m_Units;
+  bool m_Numeric; // all tokens are numbers
+};
+
+// all params of a design rule set decoded once, looked up by name
+class CDesignRuleValues
+{
+ public:
+  CDesignRuleValues(const CDesignRuleValues& values);
+  CDesignRuleValues(void);
+  virtual ~CDesignRuleValues(void);
+ public:
+  void operator =(const CDesignRuleValues& values);
+  void clear(void);
+  void assign(const CDesignRuleValues& values);
+  void decode(const QList<CParam*>& params);
+  bool contains(const QString& name) const { return m_Values.contains(name); }
+  const CDesignRuleValue *find(const QString& name) const;
+  double dimension(const QString& name, const double defaultValue, const int index = 0) const;
+  double number(const QString& name, const double defaultValue, const int index = 0) const;
+  QString text(const QString& name, const QString& defaultValue = QString()) const;
+ protected:
+  QHash<QString,CDesignRuleValue> m_Values;
+};
+
 class CDesignRule: public CEntity
 {
  public:
@@ -473,19 +716,26 @@ class CDesignRule: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QList<CDescription*>& description(void) { return m_Descriptions; }
   CDescription* description(const int index) { return m_Descriptions[index]; }
   QList<CParam*>& param(void) { return m_Params; }
   CParam* param(const int index) { return m_Params[index]; }
+  CParam* findParamByName(const QString& name);
+  const CDesignRuleValues& values(void);
   QString name(void) { return m_Name; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setValue(const QString& name, const int index, const double value,
+                const CDesignRuleValue::Unit unit = CDesignRuleValue::ruMillimeter);
  protected:
   QList<CDescription*> m_Descriptions;
   QList<CParam*> m_Params;
   QString m_Name; // required
+  CDesignRuleValues m_Values; // implied, decoded from m_Params
+  QAtomicInt m_ValuesRevision; // implied, 0 until built
 };
 
 // basic objects
@@ -503,13 +753,14 @@ class CVariantDef: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString name(void) { return m_Name; }
   bool current(void) { return m_Current; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setValue(const bool value) { m_Current = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setValue(const bool value) { m_Current = value; modify(); }
  protected:
   QString m_Name; // required
   bool m_Current; // default = false
@@ -528,6 +779,7 @@ class CVariant: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString name(void) { return m_Name; }
@@ -535,10 +787,10 @@ class CVariant: public CEntity
   QString value(void) { return m_Value; }
   QString technology(void) { return m_Technology; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setPopulate(const bool value) { m_Populate = value; }
-  void setValue(const QString& value) { m_Value = value; }
-  void setTechnology(const QString& value) { m_Technology = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setPopulate(const bool value) { m_Populate = value; modify(); }
+  void setValue(const QString& value) { m_Value = value; modify(); }
+  void setTechnology(const QString& value) { m_Technology = value; modify(); }
  protected:
   QString m_Name; // required
   bool m_Populate; // default = true
@@ -566,6 +818,7 @@ class CGate: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString name(void) { return m_Name; }
@@ -575,12 +828,12 @@ class CGate: public CEntity
   CGate::AddLevel addLevel(void) { return m_AddLevel; }
   int swapLevel(void) { return m_SwapLevel; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setSymbol(const QString& value) { m_Symbol = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setAddLevel(const CGate::AddLevel value) { m_AddLevel = value; }
-  void setSwapLevel(const int value) { m_SwapLevel = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setSymbol(const QString& value) { m_Symbol = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setAddLevel(const CGate::AddLevel value) { m_AddLevel = value; modify(); }
+  void setSwapLevel(const int value) { m_SwapLevel = value; modify(); }
  protected:
   QString m_Name; // required
   QString m_Symbol; // required
@@ -613,6 +866,8 @@ class CWire: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   // getters
   TCoord x1(void) { return m_X1; }
@@ -626,20 +881,21 @@ class CWire: public CEntity
   double curve(void) { return m_Curve; }
   CWire::Cap cap(void) { return m_Cap; }
   // setters
-  void setX1(const TCoord value) { m_X1 = value; }
-  void setY1(const TCoord value) { m_Y1 = value; }
-  void setX2(const TCoord value) { m_X2 = value; }
-  void setY2(const TCoord value) { m_Y2 = value; }
-  void setWidth(const TDimension value) { m_Width = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setExtent(const QString& value) { m_Extent = value; }
-  void setStyle(const CWire::Style value) { m_Style = value; }
-  void setCurve(const double value) { m_Curve = value; }
-  void setCap(const CWire::Cap value) { m_Cap = value; }
+  void setX1(const TCoord value) { m_X1 = value; modify(); }
+  void setY1(const TCoord value) { m_Y1 = value; modify(); }
+  void setX2(const TCoord value) { m_X2 = value; modify(); }
+  void setY2(const TCoord value) { m_Y2 = value; modify(); }
+  void setWidth(const TDimension value) { m_Width = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setExtent(const QString& value) { m_Extent = value; modify(); }
+  void setStyle(const CWire::Style value) { m_Style = value; modify(); }
+  void setCurve(const double value) { m_Curve = value; modify(); }
+  void setCap(const CWire::Cap value) { m_Cap = value; modify(); }
   //
   double chord(void) const;
   double length(void) const;
   double radius(void) const;
+  bool center(TCoord& x, TCoord& y) const;
  protected:
   TCoord m_X1; // required
   TCoord m_Y1; // required
@@ -671,6 +927,8 @@ class CDimension: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const int DEFAULT_EXT_WIDTH = 0;
   static const int DEFAULT_EXT_LENGTH = 0;
@@ -698,23 +956,23 @@ class CDimension: public CEntity
   int precision(void) { return m_Precision; }
   bool visible(void) { return m_Visible; }
   // setters
-  void setX1(const TCoord value) { m_X1 = value; }
-  void setY1(const TCoord value) { m_Y1 = value; }
-  void setX2(const TCoord value) { m_X2 = value; }
-  void setY2(const TCoord value) { m_Y2 = value; }
-  void setX3(const TCoord value) { m_X3 = value; }
-  void setY3(const TCoord value) { m_Y3 = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setDimType(const CDimension::Type value) { m_DType = value; }
-  void setWidth(const TDimension value) { m_Width = value; }
-  void setExtWidth(const TDimension value) { m_ExtWidth = value; }
-  void setExtLength(const TDimension value) { m_ExtLength = value; }
-  void setExtOffset(const TDimension value) { m_ExtOffset = value; }
-  void setTextSize(const TDimension value) { m_TextSize = value; }
-  void setTextRatio(const int value) { m_TextRatio = value; }
-  void setGridUnit(const CGrid::Unit value) { m_GridUnit = value; }
-  void setPrecision(const int value) { m_Precision = value; }
-  void setVisible(const bool value) { m_Visible = value; }
+  void setX1(const TCoord value) { m_X1 = value; modify(); }
+  void setY1(const TCoord value) { m_Y1 = value; modify(); }
+  void setX2(const TCoord value) { m_X2 = value; modify(); }
+  void setY2(const TCoord value) { m_Y2 = value; modify(); }
+  void setX3(const TCoord value) { m_X3 = value; modify(); }
+  void setY3(const TCoord value) { m_Y3 = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setDimType(const CDimension::Type value) { m_DType = value; modify(); }
+  void setWidth(const TDimension value) { m_Width = value; modify(); }
+  void setExtWidth(const TDimension value) { m_ExtWidth = value; modify(); }
+  void setExtLength(const TDimension value) { m_ExtLength = value; modify(); }
+  void setExtOffset(const TDimension value) { m_ExtOffset = value; modify(); }
+  void setTextSize(const TDimension value) { m_TextSize = value; modify(); }
+  void setTextRatio(const int value) { m_TextRatio = value; modify(); }
+  void setGridUnit(const CGrid::Unit value) { m_GridUnit = value; modify(); }
+  void setPrecision(const int value) { m_Precision = value; modify(); }
+  void setVisible(const bool value) { m_Visible = value; modify(); }
  protected:
   TCoord m_X1; // required
   TCoord m_Y1; // required
@@ -767,6 +1025,8 @@ class CText: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const CText::Font DEFAULT_FONT = CText::tfProportional;
   static const int DEFAULT_RATIO = 8;
@@ -788,18 +1048,18 @@ class CText: public CEntity
   CText::Align align(void) const { return m_Align; }
   int distance(void) const { return m_Distance; }
   // setters
-  void setText(const QString& value) { m_Text = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setSize(const TDimension value) { m_Size = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setFont(const CText::Font value) { m_Font = value; }
-  void setRatio(const int value) { m_Ratio = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
-  void setReflection(const bool value) { m_Reflection = value; }
-  void setSpin(const bool value) { m_Spin = value; }
-  void setAlign(const CText::Align value) { m_Align = value; }
-  void setDistance(const int value) { m_Distance = value; }
+  void setText(const QString& value) { m_Text = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setSize(const TDimension value) { m_Size = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setFont(const CText::Font value) { m_Font = value; modify(); }
+  void setRatio(const int value) { m_Ratio = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
+  void setReflection(const bool value) { m_Reflection = value; modify(); }
+  void setSpin(const bool value) { m_Spin = value; modify(); }
+  void setAlign(const CText::Align value) { m_Align = value; modify(); }
+  void setDistance(const int value) { m_Distance = value; modify(); }
  protected:
   QString m_Text;
   TCoord m_X; // required
@@ -831,6 +1091,8 @@ class CCircle: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   // getters
   TCoord x(void) { return m_X; }
@@ -839,11 +1101,11 @@ class CCircle: public CEntity
   TDimension width(void) { return m_Width; }
   TLayer layer(void) { return m_Layer; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setRadius(const TCoord value) { m_Radius = value; }
-  void setWidth(const TDimension value) { m_Width = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setRadius(const TCoord value) { m_Radius = value; modify(); }
+  void setWidth(const TDimension value) { m_Width = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -868,6 +1130,8 @@ class CRectangle: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const double DEFAULT_ROTATION = 0.0;
  public:
@@ -879,12 +1143,12 @@ class CRectangle: public CEntity
   TLayer layer(void) { return m_Layer; }
   double rotation(void) { return m_Rotation; }
   // setters
-  void setX1(const TCoord value) { m_X1 = value; }
-  void setY1(const TCoord value) { m_Y1 = value; }
-  void setX2(const TCoord value) { m_X2 = value; }
-  void setY2(const TCoord value) { m_Y2 = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
+  void setX1(const TCoord value) { m_X1 = value; modify(); }
+  void setY1(const TCoord value) { m_Y1 = value; modify(); }
+  void setX2(const TCoord value) { m_X2 = value; modify(); }
+  void setY2(const TCoord value) { m_Y2 = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
  protected:
   TCoord m_X1; // required
   TCoord m_Y1; // required
@@ -908,6 +1172,8 @@ class CFrame: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   // getters
   TCoord x1(void) { return m_X1; }
@@ -922,17 +1188,17 @@ class CFrame: public CEntity
   bool borderRight(void) { return m_BorderRight; }
   bool borderBottom(void) { return m_BorderBottom; }
   // setters
-  void setX1(const TCoord value) { m_X1 = value; }
-  void setY1(const TCoord value) { m_Y1 = value; }
-  void setX2(const TCoord value) { m_X2 = value; }
-  void setY2(const TCoord value) { m_Y2 = value; }
-  void setColumns(const int value) { m_Columns = value; }
-  void setRows(const int value) { m_Rows = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setBorderLeft(const bool value) { m_BorderLeft = value; }
-  void setBorderTop(const bool value) { m_BorderTop = value; }
-  void setBorderRight(const bool value) { m_BorderRight = value; }
-  void setBorderBottom(const bool value) { m_BorderBottom = value; }
+  void setX1(const TCoord value) { m_X1 = value; modify(); }
+  void setY1(const TCoord value) { m_Y1 = value; modify(); }
+  void setX2(const TCoord value) { m_X2 = value; modify(); }
+  void setY2(const TCoord value) { m_Y2 = value; modify(); }
+  void setColumns(const int value) { m_Columns = value; modify(); }
+  void setRows(const int value) { m_Rows = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setBorderLeft(const bool value) { m_BorderLeft = value; modify(); }
+  void setBorderTop(const bool value) { m_BorderTop = value; modify(); }
+  void setBorderRight(const bool value) { m_BorderRight = value; modify(); }
+  void setBorderBottom(const bool value) { m_BorderBottom = value; modify(); }
  protected:
   TCoord m_X1; // required
   TCoord m_Y1; // required
@@ -962,15 +1228,17 @@ class CHole: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   // getters
   TCoord x(void) { return m_X; }
   TCoord y(void) { return m_Y; }
   TDimension drill(void) { return m_Drill; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setDrill(const TDimension value) { m_Drill = value; }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setDrill(const TDimension value) { m_Drill = value; modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -995,6 +1263,8 @@ class CPad: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const TDimension DEFAULT_DIAMETER = 0.0;
   static const CPad::Shape DEFAULT_SHAPE = CPad::psRound;
@@ -1012,16 +1282,16 @@ class CPad: public CEntity
   bool thermals(void) { return m_Thermals; }
   bool first(void) { return m_First; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setDrill(const TDimension value) { m_Drill = value; }
-  void setDiameter(const TDimension value) { m_Diameter = value; }
-  void setShape(const CPad::Shape value) { m_Shape = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
-  void setStop(const bool value) { m_Stop = value; }
-  void setThermals(const bool value) { m_Thermals = value; }
-  void setFirst(const bool value) { m_First = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setDrill(const TDimension value) { m_Drill = value; modify(); }
+  void setDiameter(const TDimension value) { m_Diameter = value; modify(); }
+  void setShape(const CPad::Shape value) { m_Shape = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
+  void setStop(const bool value) { m_Stop = value; modify(); }
+  void setThermals(const bool value) { m_Thermals = value; modify(); }
+  void setFirst(const bool value) { m_First = value; modify(); }
  protected:
   QString m_Name; // required
   TCoord m_X; // required
@@ -1053,6 +1323,8 @@ class CSMD: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const int DEFAULT_ROUNDNESS = 0;
   static const double DEFAULT_ROTATION = 0.0;
@@ -1070,17 +1342,17 @@ class CSMD: public CEntity
   bool thermals(void) { return m_Thermals; }
   bool cream(void) { return m_Cream; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setDX(const TDimension value) { m_DX = value; }
-  void setDY(const TDimension value) { m_DY = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setRoundness(const int value) { m_Roundness = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
-  void setStop(const bool value) { m_Stop = value; }
-  void setThermals(const bool value) { m_Thermals = value; }
-  void setCream(const bool value) { m_Cream = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setDX(const TDimension value) { m_DX = value; modify(); }
+  void setDY(const TDimension value) { m_DY = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setRoundness(const int value) { m_Roundness = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
+  void setStop(const bool value) { m_Stop = value; modify(); }
+  void setThermals(const bool value) { m_Thermals = value; modify(); }
+  void setCream(const bool value) { m_Cream = value; modify(); }
  protected:
   QString m_Name; // required
   TCoord m_X; // required
@@ -1116,6 +1388,8 @@ class CVia: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const TDimension DEFAULT_DIAMETER = 0.0;
   static const CVia::Shape DEFAULT_SHAPE = CVia::vsRound;
@@ -1129,13 +1403,13 @@ class CVia: public CEntity
   CVia::Shape shape(void) { return m_Shape; }
   bool alwaysStop(void) { return m_AlwaysStop; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setExtent(const QString value) { m_Extent = value; }
-  void setDrill(const TDimension value) { m_Drill = value; }
-  void setDiameter(const TDimension value) { m_Diameter = value; }
-  void setShape(const CVia::Shape value) { m_Shape = value; }
-  void setAlwaysStop(const bool value) { m_AlwaysStop = value; }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setExtent(const QString value) { m_Extent = value; modify(); }
+  void setDrill(const TDimension value) { m_Drill = value; modify(); }
+  void setDiameter(const TDimension value) { m_Diameter = value; modify(); }
+  void setShape(const CVia::Shape value) { m_Shape = value; modify(); }
+  void setAlwaysStop(const bool value) { m_AlwaysStop = value; modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -1161,6 +1435,7 @@ class CVertex: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const double DEFAULT_CURVE = 0.0;
  public:
@@ -1169,9 +1444,9 @@ class CVertex: public CEntity
   TCoord y(void) { return m_Y; }
   double curve(void) { return m_Curve; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setCurve(const double value) { m_Curve = std::min(std::max(value,-359.999),359.999); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setCurve(const double value) { m_Curve = std::min(std::max(value,-359.999),359.999); modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -1202,6 +1477,8 @@ class CPin: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const CPin::Visible DEFAULT_VISIBLE = CPin::pvBoth;
   static const CPin::Length DEFAULT_LENGTH = CPin::plLong;
@@ -1221,15 +1498,15 @@ class CPin: public CEntity
   int swapLevel(void) { return m_SwapLevel; }
   double rotation(void) { return m_Rotation; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setVisible(const CPin::Visible value) { m_Visible = value; }
-  void setLength(const CPin::Length value) { m_Length = value; }
-  void setDirection(const CPin::Direction value) { m_Direction = value; }
-  void setFunction(const CPin::Function value) { m_Function = value; }
-  void setSwapLevel(const int value) { m_SwapLevel = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setVisible(const CPin::Visible value) { m_Visible = value; modify(); }
+  void setLength(const CPin::Length value) { m_Length = value; modify(); }
+  void setDirection(const CPin::Direction value) { m_Direction = value; modify(); }
+  void setFunction(const CPin::Function value) { m_Function = value; modify(); }
+  void setSwapLevel(const int value) { m_SwapLevel = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
  protected:
   QString m_Name; // required
   TCoord m_X; // required
@@ -1262,6 +1539,7 @@ class CPort: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const CPort::Direction DEFAULT_DIRECTION = CPort::pdIO;
  public:
@@ -1270,9 +1548,9 @@ class CPort: public CEntity
   TCoord coord(void) { return m_Coord; }
   CPort::Direction direction(void) { return m_Direction; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setCoord(const TCoord value) { m_Coord = value; }
-  void setDirection(const CPort::Direction value) { m_Direction = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setCoord(const TCoord value) { m_Coord = value; modify(); }
+  void setDirection(const CPort::Direction value) { m_Direction = value; modify(); }
  protected:
   QString m_Name; // required
   TCoord m_Coord; // required, offset from module center
@@ -1294,6 +1572,7 @@ class CLabel: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const CText::Font DEFAULT_FONT = CText::tfProportional;
   static const int DEFAULT_RATIO = 8;
@@ -1309,14 +1588,14 @@ class CLabel: public CEntity
   double rotation(void) { return m_Rotation; }
   bool xref(void) { return m_XRef; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setSize(const TDimension value) { m_Size = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setFont(const CText::Font value) { m_Font = value; }
-  void setRatio(const int value) { m_Ratio = value; }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setSize(const TDimension value) { m_Size = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setFont(const CText::Font value) { m_Font = value; modify(); }
+  void setRatio(const int value) { m_Ratio = value; modify(); }
   void setRotation(const double value);
-  void setXRef(const bool value) { m_XRef = value; }
+  void setXRef(const bool value) { m_XRef = value; modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -1343,13 +1622,14 @@ class CJunction: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   TCoord x(void) { return m_X; }
   TCoord y(void) { return m_Y; }
   // setters
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
  protected:
   TCoord m_X; // required
   TCoord m_Y; // required
@@ -1372,6 +1652,7 @@ class CConnect: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const CConnect::Route DEFAULT_ROUTE = crAll;
  public:
@@ -1381,10 +1662,10 @@ class CConnect: public CEntity
   QString pad(void) { return m_Pad; }
   CConnect::Route route(void) { return m_Route; }
   // setters
-  void setGate(const QString& value) { m_Gate = value; }
-  void setPin(const QString& value) { m_Pin = value; }
-  void setPad(const QString& value) { m_Pad = value; }
-  void setRoute(const CConnect::Route& value) { m_Route = value; }
+  void setGate(const QString& value) { m_Gate = value; modify(); }
+  void setPin(const QString& value) { m_Pin = value; modify(); }
+  void setPad(const QString& value) { m_Pad = value; modify(); }
+  void setRoute(const CConnect::Route& value) { m_Route = value; modify(); }
  protected:
   QString m_Gate; // required
   QString m_Pin; // required
@@ -1410,6 +1691,7 @@ class CAttribute: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const double DEFAULT_ROTATION = 0.0;
   static const CAttribute::Display DEFAULT_DISPLAY = CAttribute::adValue;
@@ -1424,20 +1706,26 @@ class CAttribute: public CEntity
   CText::Font font(void) { return m_Font; }
   int ratio(void) { return m_Ratio; }
   double rotation(void) { return m_Rotation; }
+  bool reflection(void) { return m_Reflection; }
+  bool spin(void) { return m_Spin; }
+  CText::Align align(void) { return m_Align; }
   CAttribute::Display display(void) { return m_Display; }
   bool constant(void) { return m_Constant; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setValue(const QString& value) { m_Value = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setSize(const TDimension value) { m_Size = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setFont(const CText::Font value) { m_Font = value; }
-  void setRatio(const int value) {  m_Ratio = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
-  void setDisplay(const CAttribute::Display value) { m_Display = value; }
-  void setConstant(const bool value) { m_Constant = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setValue(const QString& value) { m_Value = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setSize(const TDimension value) { m_Size = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setFont(const CText::Font value) { m_Font = value; modify(); }
+  void setRatio(const int value) {  m_Ratio = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
+  void setReflection(const bool value) { m_Reflection = value; modify(); }
+  void setSpin(const bool value) { m_Spin = value; modify(); }
+  void setAlign(const CText::Align value) { m_Align = value; modify(); }
+  void setDisplay(const CAttribute::Display value) { m_Display = value; modify(); }
+  void setConstant(const bool value) { m_Constant = value; modify(); }
  protected:
   QString m_Name; // required
   QString m_Value; // implied
@@ -1448,8 +1736,9 @@ class CAttribute: public CEntity
   CText::Font m_Font; // implied
   int m_Ratio; // implied
   double m_Rotation; // default = 0, valid 0 .. 359.9(9)
-  bool m_Reflection;
-  CText::Align m_Align;
+  bool m_Reflection; // default = false
+  bool m_Spin; // default = false
+  CText::Align m_Align; // default = bottom-left
   CAttribute::Display m_Display; // default = value
   bool m_Constant; // default = false
 };
@@ -1467,15 +1756,16 @@ class CPinRef: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString part(void) const { return m_Part; }
   QString gate(void) const { return m_Gate; }
   QString pin(void) const { return m_Pin; }
   // setters
-  void part(const QString& value) { m_Part = value; }
-  void gate(const QString& value) { m_Gate = value; }
-  void pin(const QString& value) { m_Pin = value; }
+  void setPart(const QString& value) { m_Part = value; modify(); }
+  void setGate(const QString& value) { m_Gate = value; modify(); }
+  void setPin(const QString& value) { m_Pin = value; modify(); }
  protected:
   QString m_Part; // required
   QString m_Gate; // required
@@ -1495,13 +1785,14 @@ class CPortRef: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString moduleInstance(void) const { return m_ModuleInstance; }
   QString port(void) const { return m_Port; }
   // setters
-  void moduleInstance(const QString& value) { m_ModuleInstance = value; }
-  void port(const QString& value) { m_Port = value; }
+  void setModuleInstance(const QString& value) { m_ModuleInstance = value; modify(); }
+  void setPort(const QString& value) { m_Port = value; modify(); }
  protected:
   QString m_ModuleInstance; // required
   QString m_Port; // required
@@ -1520,6 +1811,7 @@ class CContactRef: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const CConnect::Route DEFAULT_ROUTE = CConnect::crAll;
  public:
@@ -1529,10 +1821,10 @@ class CContactRef: public CEntity
   CConnect::Route route(void) { return m_Route; }
   QString routeTag(void) { return m_RouteTag; }
   // setters
-  void setEelement(const QString& value) { m_Element = value; }
-  void setPad(const QString& value) { m_Pad = value; }
-  void setRoute(const CConnect::Route value) { m_Route = value; }
-  void routeTag(const QString& value) { m_RouteTag = value; }
+  void setEelement(const QString& value) { m_Element = value; modify(); }
+  void setPad(const QString& value) { m_Pad = value; modify(); }
+  void setRoute(const CConnect::Route value) { m_Route = value; modify(); }
+  void setRouteTag(const QString& value) { m_RouteTag = value; modify(); }
  protected:
   QString m_Element; // required
   QString m_Pad; // required
@@ -1554,12 +1846,13 @@ class CTechnology: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QList<CAttribute*>& attributes(void) { return m_Attributes; }
   QString name(void) { return m_Name; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
  protected:
   QList<CAttribute*> m_Attributes;
   QString m_Name; // required
@@ -1579,6 +1872,9 @@ class CInstance: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  // extent of the symbol of its gate placed like the instance
+  CBoundingBox boundingBox(CSymbol& symbol);
  public:
   static const double DEFAULT_ROTATION = 0.0;
  public:
@@ -1593,14 +1889,14 @@ class CInstance: public CEntity
   bool reflection(void) { return m_Reflection; }
   bool spin(void) { return m_Spin; }
   // setters
-  void setPart(const QString& value) { m_Part = value; }
-  void setGate(const QString& value) { m_Gate = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setSmashed(const bool value) { m_Smashed = value; }
+  void setPart(const QString& value) { m_Part = value; modify(); }
+  void setGate(const QString& value) { m_Gate = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setSmashed(const bool value) { m_Smashed = value; modify(); }
   void setRotation(const double value);
-  void setReflection(const bool value) { m_Reflection = value; }
-  void setSpin(const bool value) { m_Spin = value; }
+  void setReflection(const bool value) { m_Reflection = value; modify(); }
+  void setSpin(const bool value) { m_Spin = value; modify(); }
  protected:
   QList<CAttribute*> m_Attributes;
   QString m_Part; // required
@@ -1627,6 +1923,7 @@ class CModuleInstance: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const double DEFAULT_ROTATION = 0.0;
   static const double DEFAULT_OFFSET = 0;
@@ -1643,16 +1940,16 @@ class CModuleInstance: public CEntity
   bool reflection(void) { return m_Reflection; }
   bool spin(void) { return m_Spin; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setModule(const QString& value) { m_Module = value; }
-  void setModuleVariant(const QString& value) { m_ModuleVariant = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setOffset(const int value) { m_Offset = value; }
-  void setSmashed(const bool value) { m_Smashed = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setModule(const QString& value) { m_Module = value; modify(); }
+  void setModuleVariant(const QString& value) { m_ModuleVariant = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setOffset(const int value) { m_Offset = value; modify(); }
+  void setSmashed(const bool value) { m_Smashed = value; modify(); }
   void setRotation(const double value);
-  void setReflection(const bool value) { m_Reflection = value; }
-  void setSpin(const bool value) { m_Spin = value; }
+  void setReflection(const bool value) { m_Reflection = value; modify(); }
+  void setSpin(const bool value) { m_Spin = value; modify(); }
  protected:
   QString m_Name; // required
   QString m_Module; // required
@@ -1680,6 +1977,7 @@ class CPart: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QList<CAttribute*>& attributes(void) { return m_Attributes; }
@@ -1691,12 +1989,12 @@ class CPart: public CEntity
   QString technology(void) { return m_Technology; }
   QString value(void) { return m_Value; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setLibrary(const QString& value) { m_Library = value; }
-  void setDeviceSet(const QString& value) { m_DeviceSet = value; }
-  void setDevice(const QString& value) { m_Device = value; }
-  void setTechnology(const QString& value) { m_Technology = value; }
-  void setValue(const QString& value) { m_Value = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setLibrary(const QString& value) { m_Library = value; modify(); }
+  void setDeviceSet(const QString& value) { m_DeviceSet = value; modify(); }
+  void setDevice(const QString& value) { m_Device = value; modify(); }
+  void setTechnology(const QString& value) { m_Technology = value; modify(); }
+  void setValue(const QString& value) { m_Value = value; modify(); }
  protected:
   QList<CAttribute*> m_Attributes;
   QList<CVariant*> m_Variants;
@@ -1730,6 +2028,8 @@ class CPolygon: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  CBoundingBox boundingBox(void);
  public:
   static const CPolygon::Pour DEFAULT_POUR = CPolygon::ppSolid;
   static const int DEFAULT_RANK = 0;
@@ -1745,14 +2045,14 @@ class CPolygon: public CEntity
   bool thermals(void) { return m_Thermals; }
   int rank(void) { return m_Rank; }
   // setters
-  void setWidth(const TDimension value) { m_Width = value; }
-  void setLayer(const TLayer value) { m_Layer = value; }
-  void setSpacing(const TDimension value) { m_Spacing = value; }
-  void setPour(const CPolygon::Pour value) { m_Pour = value; }
-  void setIsolate(const TDimension value) { m_Isolate = value; }
-  void setOrphans(const bool value) { m_Orphans = value; }
-  void setThermals(const bool value) { m_Thermals = value; }
-  void setRank(const int value) { m_Rank = value; }
+  void setWidth(const TDimension value) { m_Width = value; modify(); }
+  void setLayer(const TLayer value) { m_Layer = value; modify(); }
+  void setSpacing(const TDimension value) { m_Spacing = value; modify(); }
+  void setPour(const CPolygon::Pour value) { m_Pour = value; modify(); }
+  void setIsolate(const TDimension value) { m_Isolate = value; modify(); }
+  void setOrphans(const bool value) { m_Orphans = value; modify(); }
+  void setThermals(const bool value) { m_Thermals = value; modify(); }
+  void setRank(const int value) { m_Rank = value; modify(); }
  protected:
   QList<CVertex*> m_Vertices;
   TDimension m_Width; // required
@@ -1779,6 +2079,10 @@ class CElement: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  // extent of its package placed like the element, the origin when the
+  // package is missing
+  CBoundingBox boundingBox(CBoard& board);
  public:
   static const double DEFAULT_ROTATION = 0.0;
  public:
@@ -1797,17 +2101,17 @@ class CElement: public CEntity
   bool reflection(void) { return m_Reflection; }
   bool populate(void) { return m_Populate; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
-  void setLibrary(const QString& value) { m_Library = value; }
-  void setPackage(const QString& value) { m_Package = value; }
-  void setValue(const QString& value) { m_Value = value; }
-  void setX(const TCoord value) { m_X = value; }
-  void setY(const TCoord value) { m_Y = value; }
-  void setLocked(const bool value) { m_Locked = value; }
-  void setSmashed(const bool value) { m_Smashed = value; }
-  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); }
-  void setReflection(const bool value) { m_Reflection; }
-  void setPopulate(const bool value) { m_Populate; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setLibrary(const QString& value) { m_Library = value; modify(); }
+  void setPackage(const QString& value) { m_Package = value; modify(); }
+  void setValue(const QString& value) { m_Value = value; modify(); }
+  void setX(const TCoord value) { m_X = value; modify(); }
+  void setY(const TCoord value) { m_Y = value; modify(); }
+  void setLocked(const bool value) { m_Locked = value; modify(); }
+  void setSmashed(const bool value) { m_Smashed = value; modify(); }
+  void setRotation(const double value) { m_Rotation = std::min(std::max(value,0.0),359.999); modify(); }
+  void setReflection(const bool value) { m_Reflection = value; modify(); }
+  void setPopulate(const bool value) { m_Populate = value; modify(); }
  protected:
   QList<CAttribute*> m_Attributes;
   QList<CVariant*> m_Variants;
@@ -1840,6 +2144,8 @@ class CSignal: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  const CBoundingBox& boundingBox(void);
  public:
   static const int DEFAULT_CLASS = 0;
  public:
@@ -1850,9 +2156,9 @@ class CSignal: public CEntity
   QString name(void) { return m_Name; }
   int signalClass(void) { return m_Class; }
   bool airWiresHidden(void) { return m_AirWiresHidden; }
-  void setName(const QString& value) { m_Name = value; }
-  void setSignalClass(const int value) { m_Class = value; }
-  void setAirWiresHidden(const bool value) { m_AirWiresHidden = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setSignalClass(const int value) { m_Class = value; modify(); }
+  void setAirWiresHidden(const bool value) { m_AirWiresHidden = value; modify(); }
  protected:
   QList<CContactRef*> m_ContactRefs;
   QList<CPolygon*> m_Polygons;
@@ -1861,6 +2167,8 @@ class CSignal: public CEntity
   QString m_Name; // required
   int m_Class; // default = 0
   bool m_AirWiresHidden; // default = false
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
 };
 
 class CSegment: public CEntity
@@ -1877,6 +2185,7 @@ class CSegment: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   QList<CPinRef*>& pinRefs(void) { return m_PinRefs; }
   QList<CPortRef*>& portRefs(void) { return m_PortRefs; }
@@ -1905,14 +2214,15 @@ class CNet: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   static const int DEFAULT_CLASS = 0;
  public:
   QList<CSegment*>& segments(void) { return m_Segments; }
   QString name(void) { return m_Name; }
   int netClass(void) { return m_Class; }
-  void setName(const QString& value) { m_Name = value; }
-  void setNetClass(const int& value) { m_Class = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setNetClass(const int& value) { m_Class = value; modify(); }
  protected:
   QList<CSegment*> m_Segments;
   QString m_Name; // required
@@ -1933,10 +2243,11 @@ class CBus: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   QList<CSegment*>& segments(void) { return m_Segments; }
   QString name(void) { return m_Name; }
-  void setName(const QString& value) { m_Name = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
  protected:
   QList<CSegment*> m_Segments;
   QString m_Name; // required
@@ -1957,13 +2268,14 @@ class CDevice: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   QList<CConnect*>& connects(void) { return m_Connects; }
   QList<CTechnology*>& technologies(void) { return m_Technologies; }
   QString name(void) { return m_Name; }
   QString package(void) { return m_Package; }
-  void setName(const QString& value) { m_Name = value; }
-  void setPackage(const QString& value) { m_Package = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setPackage(const QString& value) { m_Package = value; modify(); }
  protected:
   QList<CConnect*> m_Connects;
   QList<CTechnology*> m_Technologies;
@@ -1986,6 +2298,7 @@ class CDeviceSet: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   CDescription& description(void) { return m_Description; }
   QList<CGate*>& gates(void) { return m_Gates; }
@@ -1993,9 +2306,9 @@ class CDeviceSet: public CEntity
   QString name(void) const { return m_Name; }
   QString prefix(void) const { return m_Prefix; }
   bool userValue(void) const { return m_UserValue; }
-  void setName(const QString& value) { m_Name = value; }
-  void setPrefix(const QString& value) { m_Prefix = value; }
-  void setUserValue(const bool value) { m_UserValue = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
+  void setPrefix(const QString& value) { m_Prefix = value; modify(); }
+  void setUserValue(const bool value) { m_UserValue = value; modify(); }
  public:
   CGate *findGateByName(const QString& name);
   CDevice *findDeviceByName(const QString& name);
@@ -2023,6 +2336,11 @@ class CSymbol: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  // content hash leaving out the name, identical definitions stored under
+  // different names hash equal
+  quint64 definitionHash(void);
+  const CBoundingBox& boundingBox(void);
  public:
   // getters
   CDescription& description(void) { return m_Description; }
@@ -2036,7 +2354,7 @@ class CSymbol: public CEntity
   QList<CFrame*>& frames(void) { return m_Frames; }
   QString name(void) { return m_Name; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
  protected:
   CDescription m_Description;
   QList<CPolygon*> m_Polygons;
@@ -2048,6 +2366,8 @@ class CSymbol: public CEntity
   QList<CRectangle*> m_Rectangles;
   QList<CFrame*> m_Frames;
   QString m_Name; // required
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
 };
 
 class CPackage: public CEntity
@@ -2064,6 +2384,11 @@ class CPackage: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  // content hash leaving out the name, identical definitions stored under
+  // different names hash equal
+  quint64 definitionHash(void);
+  const CBoundingBox& boundingBox(void);
  public:
   // getters
   CDescription& description(void) { return m_Description; }
@@ -2079,7 +2404,7 @@ class CPackage: public CEntity
   QList<CSMD*>& smds(void) { return m_SMDs; }
   QString name(void) { return m_Name; }
   // setters
-  void setName(const QString& value) { m_Name = value; }
+  void setName(const QString& value) { m_Name = value; modify(); }
  protected:
   CDescription m_Description;
   QList<CPolygon*> m_Polygons;
@@ -2093,6 +2418,8 @@ class CPackage: public CEntity
   QList<CPad*> m_Pads;
   QList<CSMD*> m_SMDs;
   QString m_Name; // required
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
 };
 
 class CPlain: public CEntity
@@ -2109,6 +2436,8 @@ class CPlain: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  const CBoundingBox& boundingBox(void);
  public:
   QList<CPolygon*>& polygons(void) { return m_Polygons; }
   QList<CWire*>& wires(void) { return m_Wires; }
@@ -2127,6 +2456,8 @@ class CPlain: public CEntity
   QList<CFrame*> m_Frames;
   QList<CHole*> m_Holes;
   QList<CDimension*> m_Dimensions;
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
 };
 
 class CSheet: public CEntity
@@ -2143,6 +2474,11 @@ class CSheet: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  // instances count with the symbols of their gates, looked up through the
+  // module or schematic holding the sheet, a sheet of neither only knows
+  // their origins
+  const CBoundingBox& boundingBox(void);
  public:
   CDescription& description(void) { return m_Description; }
   CPlain& plain(void) { return m_Plain; }
@@ -2157,6 +2493,8 @@ class CSheet: public CEntity
   QList<CModuleInstance*> m_ModuleInstances; // since 7.0
   QList<CBus*> m_Busses;
   QList<CNet*> m_Nets;
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
 };
 
 // drawing definitions
@@ -2177,6 +2515,7 @@ class CLibrary: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   CDescription& description(void) { return m_Description; }
   QList<CPackage*>& packages(void) { return m_Packages; }
@@ -2209,6 +2548,8 @@ class CBoard: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
+  const CBoundingBox& boundingBox(void);
  public:
   CDescription& description(void) { return m_Description; }
   CPlain& plain(void) { return m_Plain; }
@@ -2221,6 +2562,15 @@ class CBoard: public CEntity
   QList<CElement*>& elements(void) { return m_Elements; }
   QList<CSignal*>& signal(void) { return m_Signals; }
   QList<CApproved*>& errors(void) { return m_Errors; }
+ public:
+  CLibrary *findLibraryByName(const QString& name);
+  CElement *findElementByName(const QString& name);
+  CSignal *findSignalByName(const QString& name);
+  CClass *findClassByNumber(const TClass number);
+  // package of a library by name, looked up in an index of all library
+  // packages that is kept until the board changes
+  CPackage *findPackage(const QString& library, const QString& package);
+  const CClearanceMatrix& clearanceMatrix(void);
  protected:
   CDescription m_Description;
   CPlain m_Plain;
@@ -2237,6 +2587,12 @@ class CBoard: public CEntity
   QList<CSignal*> m_Signals;
   QList<CApproved*> m_Errors;
   TDimension m_LimitedWidth; // since 7.4
+  CClearanceMatrix m_ClearanceMatrix; // implied, built from m_Classes
+  QAtomicInt m_ClearanceMatrixRevision; // implied, 0 until built
+  CBoundingBox m_BoundingBox; // implied
+  QAtomicInt m_BoundingBoxRevision; // implied, 0 until built
+  QHash<QString,CPackage*> m_PackageIndex; // implied, library and package name
+  QAtomicInt m_PackageIndexRevision; // implied, 0 until built
 };
 
 class CModule: public CEntity
@@ -2253,6 +2609,7 @@ class CModule: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   QString& name(void) { return m_Name; }
   QString& prefix(void) { return m_Prefix; }
@@ -2292,6 +2649,7 @@ class CSchematic: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   CDescription& description(void) { return m_Description; }
   QList<CLibrary*>& libraries(void) { return m_Libraries; }
@@ -2339,6 +2697,7 @@ class CDrawing: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement &root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   CSettings& settings(void) { return m_Settings; }
   CGrid& grid(void) { return m_Grid; }
@@ -2375,13 +2734,14 @@ class CNote: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement &root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   QString note(void) { return m_Note; }
   CNote::Severity severity(void) { return m_Severity; }
   // setters
-  void setNote(const QString& value) { m_Note = value; }
-  void setSeverity(const CNote::Severity value) { m_Severity = value; }
+  void setNote(const QString& value) { m_Note = value; modify(); }
+  void setSeverity(const CNote::Severity value) { m_Severity = value; modify(); }
  protected:
   QString m_Note;
   double m_Version; // required
@@ -2401,6 +2761,7 @@ class CCompatibility: public CEntity
   virtual void show(std::ostream& out, const int level = 0);
   virtual bool readFromXML(const QDomElement &root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   QList<CNote*>& notes(void) { return m_Notes; }
  protected:
@@ -2423,6 +2784,7 @@ class CEagleDocument: public CEntity
  //protected:
   virtual bool readFromXML(const QDomElement& root, const CEagleDocumentOptions& options);
   virtual bool writeToXML(QDomDocument& host, QDomElement& root, const CEagleDocumentOptions& options);
+  virtual void hashFields(CContentHash& hash);
  public:
   // getters
   CCompatibility& preNotes(void) { return m_PreNotes; }
@@ -2436,9 +2798,9 @@ class CEagleDocument: public CEntity
   bool validDocType(void) const { return m_ValidDocType; }
   bool validXMLdata(void) const { return m_ValidXMLdata; }
   // setters
-  void setVerifyDocType(const bool value) { m_VerifyDocType = value; }
-  void setIndentation(const int value) { m_Indentation = value; }
-  void setWriteDefaults(const bool value) { m_WriteDefaults = value; }
+  void setVerifyDocType(const bool value) { m_VerifyDocType = value; modify(); }
+  void setIndentation(const int value) { m_Indentation = value; modify(); }
+  void setWriteDefaults(const bool value) { m_WriteDefaults = value; modify(); }
  protected:
   CCompatibility m_PreNotes;
   CDrawing m_Drawing;
@@ -0,0 +1,1290 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <QSet>
+//------------------------------------------------------------------------------
+#include "QEaglePolygon.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+// grid steps per millimeter
+static const double GRID = 10000.0;
+
+static qint64 cross(const CGridPoint& o, const CGridPoint& a, const CGridPoint& b)
+{
+ return (a.x-o.x)*(b.y-o.y) - (a.y-o.y)*(b.x-o.x);
+}
+
+static int sign(const qint64 value)
+{
+ return (value > 0) ? 1 : ((value < 0) ? -1 : 0);
+}
+
+static CBoundingBox edgeBox(const CGridPoint& a, const CGridPoint& b)
+{
+ // half a step around, so horizontal and vertical edges have an area
+ CBoundingBox box(CPolygonSet::fromGrid(a.x),CPolygonSet::fromGrid(a.y),
+                  CPolygonSet::fromGrid(b.x),CPolygonSet::fromGrid(b.y));
+ box.inflate(0.5/GRID);
+ return box;
+}
+
+// twice the signed area in grid steps, positive when counterclockwise
+static double ringArea(const QVector<CGridPoint>& ring)
+{
+ double result = 0.0;
+ for (int i = 0; i < ring.size(); i++)
+ {
+  const CGridPoint& a = ring.at(i);
+  const CGridPoint& b = ring.at((i+1) % ring.size());
+  result += (double)a.x*b.y - (double)b.x*a.y;
+ }
+ return result;
+}
+
+// winding number of a ring around a point given in grid steps
+static int ringWinding(const QVector<CGridPoint>& ring, const double x, const double y)
+{
+ int result = 0;
+ for (int i = 0; i < ring.size(); i++)
+ {
+  const CGridPoint& a = ring.at(i);
+  const CGridPoint& b = ring.at((i+1) % ring.size());
+  if ((a.y <= y) == (b.y <= y)) continue;
+  double cx = a.x + (y - a.y)*(b.x - a.x)/(double)(b.y - a.y);
+  if (cx > x) result += (b.y > a.y) ? 1 : -1;
+ }
+ return result;
+}
+
+// corners of a regular polygon around a circle, deviating from it by no more
+// than tolerance
+static int circleSteps(const TDimension radius, const TDimension tolerance)
+{
+ int n = 8;
+ if (tolerance > 0.0 && tolerance < radius)
+ {
+  n = (int)ceil(M_PI/acos(radius/(radius + tolerance)));
+ }
+ // a multiple of four keeps the extremes on the axes
+ n = (n + 3)/4*4;
+ return std::min(std::max(n,8),720);
+}
+
+// counterclockwise without collinear points, monotone chain
+static QVector<CGridPoint> convexHull(QVector<CGridPoint> points)
+{
+ std::sort(points.begin(),points.end());
+ points.erase(std::unique(points.begin(),points.end()),points.end());
+ if (points.size() < 3) return QVector<CGridPoint>();
+ QVector<CGridPoint> hull(2*points.size());
+ int k = 0;
+ for (int i = 0; i < points.size(); i++)
+ {
+  while (k >= 2 && cross(hull.at(k-2),hull.at(k-1),points.at(i)) <= 0) k--;
+  hull[k++] = points.at(i);
+ }
+ for (int i = points.size()-2, t = k+1; i >= 0; i--)
+ {
+  while (k >= t && cross(hull.at(k-2),hull.at(k-1),points.at(i)) <= 0) k--;
+  hull[k++] = points.at(i);
+ }
+ hull.resize(k-1);
+ return hull;
+}
+
+// drops repeated and collinear points until none are left
+static void removeCollinear(QVector<CGridPoint>& ring)
+{
+ bool changed = true;
+ while (changed && ring.size() >= 3)
+ {
+  changed = false;
+  QVector<CGridPoint> result;
+  result.reserve(ring.size());
+  for (int i = 0; i < ring.size(); i++)
+  {
+   const CGridPoint& p = result.isEmpty() ? ring.last() : result.last();
+   const CGridPoint& q = ring.at(i);
+   const CGridPoint& r = ring.at((i+1) % ring.size());
+   if (q==p || q==r || 0==cross(p,q,r)) changed = true;
+   else result.append(q);
+  }
+  ring = result;
+ }
+ if (ring.size() < 3) ring.clear();
+}
+
+// piece of a ring edge running from a to b with a < b, counts sum up the
+// directions of the rings of either operand running along it
+class CClipEdge
+{
+ public:
+  CClipEdge(void) { count[0] = 0; count[1] = 0; }
+  CClipEdge(const CGridPoint& p, const CGridPoint& q, const int operand)
+  {
+   count[0] = 0;
+   count[1] = 0;
+   if (p < q) { a = p; b = q; count[operand] = 1; }
+   else { a = q; b = p; count[operand] = -1; }
+  }
+  bool operator <(const CClipEdge& edge) const
+  {
+   return a < edge.a || (a==edge.a && b < edge.b);
+  }
+ public:
+  CGridPoint a;
+  CGridPoint b;
+  int count[2];
+};
+
+// result edge with the area on its left
+class CDirectedEdge
+{
+ public:
+  CDirectedEdge(void) {}
+  CDirectedEdge(const CGridPoint& from, const CGridPoint& to): from(from), to(to) {}
+  bool operator <(const CDirectedEdge& edge) const { return from < edge.from; }
+ public:
+  CGridPoint from;
+  CGridPoint to;
+};
+
+static void collectEdges(const CPolygonSet& polygons, const int operand, QVector<CClipEdge>& edges)
+{
+ for (int i = 0; i < polygons.count(); i++)
+ {
+  const QVector<CGridPoint>& ring = polygons.ring(i);
+  for (int j = 0; j < ring.size(); j++)
+  {
+   const CGridPoint& p = ring.at(j);
+   const CGridPoint& q = ring.at((j+1) % ring.size());
+   if (p!=q) edges.append(CClipEdge(p,q,operand));
+  }
+ }
+}
+
+static CSpatialIndex edgeIndex(const QVector<CClipEdge>& edges)
+{
+ CBoundingBox extent;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  extent.include(edgeBox(edges.at(i).a,edges.at(i).b));
+ }
+ double cell = std::max(extent.width(),extent.height())/ceil(sqrt((double)edges.size()));
+ CSpatialIndex index(extent,std::max(cell,1.0/GRID));
+ for (int i = 0; i < edges.size(); i++)
+ {
+  index.insert(i,edgeBox(edges.at(i).a,edges.at(i).b));
+ }
+ return index;
+}
+
+// edge from a to b meets the closed pixel of one grid step around h
+static bool throughPixel(const CGridPoint& a, const CGridPoint& b, const CGridPoint& h)
+{
+ // coordinates are doubled, which puts the pixel borders on odd values
+ qint64 x1 = 2*h.x-1, x2 = 2*h.x+1, y1 = 2*h.y-1, y2 = 2*h.y+1;
+ if (2*std::max(a.x,b.x) < x1 || 2*std::min(a.x,b.x) > x2) return false;
+ if (2*std::max(a.y,b.y) < y1 || 2*std::min(a.y,b.y) > y2) return false;
+ CGridPoint p(2*a.x,2*a.y), q(2*b.x,2*b.y);
+ int s1 = sign(cross(p,q,CGridPoint(x1,y1))), s2 = sign(cross(p,q,CGridPoint(x2,y1)));
+ int s3 = sign(cross(p,q,CGridPoint(x1,y2))), s4 = sign(cross(p,q,CGridPoint(x2,y2)));
+ return !(s1==s2 && s2==s3 && s3==s4 && 0!=s1);
+}
+
+// cuts edges where they cross or touch others. Crossings are snap rounded:
+// the pixels around the vertices and the rounded crossings are hot, and every
+// edge passing through a hot pixel is routed through its middle, so the
+// rounding cannot make the pieces cross anew; overlapping pieces are merged
+// and their counts added up
+static void splitEdges(QVector<CClipEdge>& edges)
+{
+ CSpatialIndex index = edgeIndex(edges);
+ QVector<CGridPoint> hot;
+ hot.reserve(2*edges.size());
+ QVector<int> near;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  const CGridPoint& a = edges.at(i).a;
+  const CGridPoint& b = edges.at(i).b;
+  hot.append(a);
+  hot.append(b);
+  index.query(edgeBox(a,b),near);
+  for (int k = 0; k < near.size(); k++)
+  {
+   int j = near.at(k);
+   if (j <= i) continue;
+   const CGridPoint& c = edges.at(j).a;
+   const CGridPoint& d = edges.at(j).b;
+   qint64 d1 = cross(a,b,c), d2 = cross(a,b,d), d3 = cross(c,d,a), d4 = cross(c,d,b);
+   if (sign(d1)*sign(d2) < 0 && sign(d3)*sign(d4) < 0)
+   {
+    double t = (double)d3/((double)d3 - (double)d4);
+    hot.append(CGridPoint(qRound64(a.x + t*(b.x-a.x)),qRound64(a.y + t*(b.y-a.y))));
+   }
+  }
+ }
+ std::sort(hot.begin(),hot.end());
+ hot.erase(std::unique(hot.begin(),hot.end()),hot.end());
+ // vertices lying on other edges are hot pixels these pass, so touching
+ // edges are cut there as well
+ QVector<QVector<CGridPoint> > splits(edges.size());
+ for (int i = 0; i < hot.size(); i++)
+ {
+  const CGridPoint& h = hot.at(i);
+  index.query(edgeBox(h,h),near);
+  for (int k = 0; k < near.size(); k++)
+  {
+   const CClipEdge& e = edges.at(near.at(k));
+   if (h!=e.a && h!=e.b && throughPixel(e.a,e.b,h)) splits[near.at(k)].append(h);
+  }
+ }
+ QVector<CClipEdge> pieces;
+ pieces.reserve(edges.size());
+ QVector<QPair<qint64,int> > order;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  const CClipEdge& e = edges.at(i);
+  const QVector<CGridPoint>& s = splits.at(i);
+  if (s.isEmpty())
+  {
+   pieces.append(e);
+   continue;
+  }
+  // along the edge from a to b
+  order.clear();
+  for (int k = 0; k < s.size(); k++)
+  {
+   order.append(qMakePair((s.at(k).x-e.a.x)*(e.b.x-e.a.x) + (s.at(k).y-e.a.y)*(e.b.y-e.a.y),k));
+  }
+  std::sort(order.begin(),order.end());
+  CGridPoint p = e.a;
+  for (int k = 0; k <= order.size(); k++)
+  {
+   CGridPoint q = (k < order.size()) ? s.at(order.at(k).second) : e.b;
+   if (q==p) continue;
+   CClipEdge piece(p,q,0);
+   int direction = (piece.a==p) ? 1 : -1;
+   piece.count[0] = direction*e.count[0];
+   piece.count[1] = direction*e.count[1];
+   pieces.append(piece);
+   p = q;
+  }
+ }
+ std::sort(pieces.begin(),pieces.end());
+ edges.clear();
+ for (int i = 0; i < pieces.size(); i++)
+ {
+  const CClipEdge& e = pieces.at(i);
+  if (!edges.isEmpty() && edges.last().a==e.a && edges.last().b==e.b)
+  {
+   edges.last().count[0] += e.count[0];
+   edges.last().count[1] += e.count[1];
+  }
+  else edges.append(e);
+ }
+ int n = 0;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  if (0!=edges.at(i).count[0] || 0!=edges.at(i).count[1]) edges[n++] = edges.at(i);
+ }
+ edges.resize(n);
+}
+
+static bool inside(const int *winding, const CPolygonSet::Operation operation)
+{
+ bool a = 0!=winding[0], b = 0!=winding[1];
+ switch (operation)
+ {
+  case CPolygonSet::poUnion: return a || b;
+  case CPolygonSet::poIntersection: return a && b;
+  case CPolygonSet::poDifference: return a && !b;
+ }
+ return false;
+}
+
+// edge p-q crosses the vertical line at x above y; coordinates are scaled
+// by four, so the line never meets a point
+static bool crossesAbove(const qint64 px, const qint64 py, const qint64 qx, const qint64 qy, const qint64 x,
+                         const qint64 y)
+{
+ qint64 dx = qx - px;
+ return sign((py - y)*dx + (x - px)*(qy - py))*sign(dx) > 0;
+}
+
+// keeps the edges with the result on one side only. Winding numbers beside
+// an edge are counted from its middle along a horizontal line to the right
+// border of its grid cell and then up that border; the winding numbers of
+// every column border at the row lines are summed up beforehand from the
+// top, so only the edges of one cell are looked at per edge. Coordinates
+// are scaled by four, which puts the middles on even values and column
+// borders on odd ones between them, so all tests are exact
+static void classifyEdges(const QVector<CClipEdge>& edges, const CPolygonSet::Operation operation,
+                          QVector<CDirectedEdge>& result)
+{
+ result.clear();
+ if (edges.isEmpty()) return;
+ qint64 x1 = edges.at(0).a.x, x2 = x1, y1 = edges.at(0).a.y, y2 = y1;
+ for (int i = 0; i < edges.size(); i++)
+ {
+  const CClipEdge& e = edges.at(i);
+  x1 = std::min(x1,e.a.x);
+  x2 = std::max(x2,e.b.x);
+  y1 = std::min(y1,std::min(e.a.y,e.b.y));
+  y2 = std::max(y2,std::max(e.a.y,e.b.y));
+ }
+ x1 *= 4; x2 *= 4; y1 *= 4; y2 *= 4;
+ int n = std::min(std::max((int)sqrt((double)edges.size()),1),1024);
+ qint64 w = ((x2 - x1)/n/4 + 1)*4, h = (y2 - y1)/n + 1;
+ int columns = (int)((x2 - x1)/w) + 1, rows = (int)((y2 - y1)/h) + 1;
+ // edges by cell, column c spans x1-1+c*w to x1-1+(c+1)*w
+ QVector<int> first(columns*rows + 1,0), cells;
+ for (int pass = 0; pass < 2; pass++)
+ {
+  QVector<int> fill = first;
+  for (int i = 0; i < edges.size(); i++)
+  {
+   const CClipEdge& e = edges.at(i);
+   int c1 = (int)((4*e.a.x - x1 + 1)/w), c2 = (int)((4*e.b.x - x1 + 1)/w);
+   int r1 = (int)((4*std::min(e.a.y,e.b.y) - y1)/h), r2 = (int)((4*std::max(e.a.y,e.b.y) - y1)/h);
+   for (int r = r1; r <= r2; r++)
+   {
+    for (int c = c1; c <= c2; c++)
+    {
+     if (0==pass) first[r*columns + c + 1]++;
+     else cells[fill[r*columns + c]++] = i;
+    }
+   }
+  }
+  if (0!=pass) break;
+  for (int k = 0; k < columns*rows; k++)
+  {
+   first[k+1] += first.at(k);
+  }
+  cells.resize(first.last());
+ }
+ // winding numbers of both operands on the right border of each column at
+ // each row line, from a ray upwards
+ QVector<int> borders(2*columns*(rows + 1),0);
+ for (int c = 0; c < columns; c++)
+ {
+  qint64 x = x1 - 1 + (c + 1)*w;
+  for (int r = rows-1; r >= 0; r--)
+  {
+   int *above = &borders[2*(c*(rows + 1) + r + 1)], *below = &borders[2*(c*(rows + 1) + r)];
+   below[0] = above[0];
+   below[1] = above[1];
+   qint64 y = y1 + r*h;
+   for (int k = first.at(r*columns + c); k < first.at(r*columns + c + 1); k++)
+   {
+    const CClipEdge& f = edges.at(cells.at(k));
+    qint64 px = 4*f.a.x, py = 4*f.a.y, qx = 4*f.b.x, qy = 4*f.b.y;
+    if ((px < x)==(qx < x) || !crossesAbove(px,py,qx,qy,x,y) || crossesAbove(px,py,qx,qy,x,y + h)) continue;
+    int direction = (qx < px) ? 1 : -1;
+    below[0] += direction*f.count[0];
+    below[1] += direction*f.count[1];
+   }
+  }
+ }
+ for (int i = 0; i < edges.size(); i++)
+ {
+  const CClipEdge& e = edges.at(i);
+  qint64 mx = 2*(e.a.x + e.b.x), my = 2*(e.a.y + e.b.y);
+  int column = (int)((mx - x1 + 1)/w), row = (int)((my - y1)/h);
+  qint64 x = x1 - 1 + (column + 1)*w, top = y1 + (row + 1)*h;
+  // winding numbers just right of the middle, and above it for horizontal
+  // edges: the path runs infinitesimally above the middle's height
+  const int *border = &borders[2*(column*(rows + 1) + row + 1)];
+  int winding[2] = {border[0],border[1]};
+  int cell = row*columns + column;
+  for (int k = first.at(cell); k < first.at(cell + 1); k++)
+  {
+   const CClipEdge& f = edges.at(cells.at(k));
+   qint64 px = 4*f.a.x, py = 4*f.a.y, qx = 4*f.b.x, qy = 4*f.b.y;
+   int direction = 0;
+   if ((px < x)!=(qx < x) && crossesAbove(px,py,qx,qy,x,my) && !crossesAbove(px,py,qx,qy,x,top))
+   {
+    direction += (qx < px) ? 1 : -1;
+   }
+   if ((py <= my)!=(qy <= my))
+   {
+    // crossing between the middle and the border, one through the corner
+    // counts when it leans left, as it is left of the border just above
+    qint64 dx = qx - px, dy = qy - py;
+    int s = sign((px - mx)*dy + (my - py)*dx)*sign(dy);
+    int t = sign((px - x)*dy + (my - py)*dx)*sign(dy);
+    if (s > 0 && (t < 0 || (0==t && sign(dx)*sign(dy) < 0))) direction += (dy > 0) ? 1 : -1;
+   }
+   winding[0] += direction*f.count[0];
+   winding[1] += direction*f.count[1];
+  }
+  int left[2], right[2];
+  for (int k = 0; k < 2; k++)
+  {
+   if (e.b.y > e.a.y) { right[k] = winding[k]; left[k] = winding[k] + e.count[k]; }
+   else { left[k] = winding[k]; right[k] = winding[k] - e.count[k]; }
+  }
+  bool l = inside(left,operation), r = inside(right,operation);
+  if (l==r) continue;
+  result.append(l ? CDirectedEdge(e.a,e.b) : CDirectedEdge(e.b,e.a));
+ }
+}
+
+// chains result edges into rings, turning as far left as possible where
+// several leave one point, so areas touching at a corner stay apart
+static void linkEdges(QVector<CDirectedEdge>& edges, QVector<QVector<CGridPoint> >& rings)
+{
+ std::sort(edges.begin(),edges.end());
+ QVector<bool> used(edges.size(),false);
+ for (int s = 0; s < edges.size(); s++)
+ {
+  if (used.at(s)) continue;
+  QVector<CGridPoint> ring;
+  int e = s;
+  while (e >= 0)
+  {
+   used[e] = true;
+   ring.append(edges.at(e).from);
+   const CDirectedEdge& current = edges.at(e);
+   CDirectedEdge key(current.to,current.to);
+   QVector<CDirectedEdge>::const_iterator first = std::lower_bound(edges.constBegin(),edges.constEnd(),key);
+   double ix = current.to.x - current.from.x, iy = current.to.y - current.from.y;
+   double best = 0.0;
+   e = -1;
+   for (int k = first - edges.constBegin(); k < edges.size() && edges.at(k).from==current.to; k++)
+   {
+    if (used.at(k)) continue;
+    double ox = edges.at(k).to.x - edges.at(k).from.x, oy = edges.at(k).to.y - edges.at(k).from.y;
+    double turn = atan2(ix*oy - iy*ox,ix*ox + iy*oy);
+    if (e < 0 || turn > best)
+    {
+     best = turn;
+     e = k;
+    }
+   }
+  }
+  removeCollinear(ring);
+  if (!ring.isEmpty()) rings.append(ring);
+ }
+}
+
+// segment from a to b touches the area of the set
+static bool touches(const CPolygonSet& polygons, const CGridPoint& a, const CGridPoint& b)
+{
+ if (polygons.contains(CPolygonSet::fromGrid(a.x),CPolygonSet::fromGrid(a.y))) return true;
+ for (int i = 0; i < polygons.count(); i++)
+ {
+  const QVector<CGridPoint>& ring = polygons.ring(i);
+  for (int j = 0; j < ring.size(); j++)
+  {
+   const CGridPoint& c = ring.at(j);
+   const CGridPoint& d = ring.at((j+1) % ring.size());
+   if (std::max(c.x,d.x) < std::min(a.x,b.x) || std::min(c.x,d.x) > std::max(a.x,b.x) ||
+       std::max(c.y,d.y) < std::min(a.y,b.y) || std::min(c.y,d.y) > std::max(a.y,b.y)) continue;
+   int d1 = sign(cross(a,b,c)), d2 = sign(cross(a,b,d)), d3 = sign(cross(c,d,a)), d4 = sign(cross(c,d,b));
+   if (d1*d2 <= 0 && d3*d4 <= 0) return true;
+  }
+ }
+ return false;
+}
+
+//------------------------------------------------------------------------------
+
+CPolygonSet::CPolygonSet(const CPolygonSet& polygons)
+{
+ assign(polygons);
+}
+
+CPolygonSet::CPolygonSet(void)
+{
+ clear();
+}
+
+CPolygonSet::~CPolygonSet(void)
+{
+ //
+}
+
+qint64 CPolygonSet::toGrid(const TCoord value)
+{
+ return qRound64(value*GRID);
+}
+
+TCoord CPolygonSet::fromGrid(const qint64 value)
+{
+ return value/GRID;
+}
+
+void CPolygonSet::operator =(const CPolygonSet& polygons)
+{
+ assign(polygons);
+}
+
+void CPolygonSet::clear(void)
+{
+ m_Rings.clear();
+}
+
+void CPolygonSet::assign(const CPolygonSet& polygons)
+{
+ m_Rings = polygons.m_Rings;
+}
+
+void CPolygonSet::append(const CPolygonSet& polygons)
+{
+ m_Rings += polygons.m_Rings;
+}
+
+void CPolygonSet::addRing(const QVector<CGridPoint>& points)
+{
+ QVector<CGridPoint> ring;
+ ring.reserve(points.size());
+ for (int i = 0; i < points.size(); i++)
+ {
+  if (ring.isEmpty() || ring.last()!=points.at(i)) ring.append(points.at(i));
+ }
+ while (ring.size() > 1 && ring.first()==ring.last()) ring.removeLast();
+ if (ring.size() >= 3) m_Rings.append(ring);
+}
+
+void CPolygonSet::addRing(const QVector<CPoint>& points)
+{
+ QVector<CGridPoint> ring;
+ ring.reserve(points.size());
+ for (int i = 0; i < points.size(); i++)
+ {
+  ring.append(CGridPoint(toGrid(points.at(i).x()),toGrid(points.at(i).y())));
+ }
+ addRing(ring);
+}
+
+void CPolygonSet::addOutline(QList<CVertex*>& vertices, const TDimension tolerance)
+{
+ QVector<CPoint> ring, points;
+ for (int i = 0; i < vertices.size(); i++)
+ {
+  CVertex *a = vertices.at(i);
+  CVertex *b = vertices.at((i+1) % vertices.size());
+  flattenArc(a->x(),a->y(),b->x(),b->y(),a->curve(),tolerance,points);
+  points.removeLast();
+  ring += points;
+ }
+ // outlines are drawn either way round, overlapping ones must not cancel
+ double area = 0.0;
+ for (int i = 0; i < ring.size(); i++)
+ {
+  const CPoint& a = ring.at(i);
+  const CPoint& b = ring.at((i+1) % ring.size());
+  area += a.x()*b.y() - b.x()*a.y();
+ }
+ if (area < 0.0) std::reverse(ring.begin(),ring.end());
+ addRing(ring);
+}
+
+void CPolygonSet::addShape(const CShape& shape, const TDimension tolerance, const TDimension frame)
+{
+ TDimension r = shape.radius() + frame;
+ QVector<CGridPoint> points;
+ if (r <= 0.0)
+ {
+  for (int i = 0; i < shape.count(); i++)
+  {
+   points.append(CGridPoint(toGrid(shape.vertex(i).x()),toGrid(shape.vertex(i).y())));
+  }
+  addRing(convexHull(points));
+  return;
+ }
+ // corners of the polygon circumscribing the circle lie outside of it
+ int n = circleSteps(r,tolerance);
+ double R = r/cos(M_PI/n);
+ for (int i = 0; i < shape.count(); i++)
+ {
+  const CPoint& v = shape.vertex(i);
+  for (int k = 0; k < n; k++)
+  {
+   double a = 2.0*M_PI*k/n;
+   points.append(CGridPoint(toGrid(v.x() + R*cos(a)),toGrid(v.y() + R*sin(a))));
+  }
+ }
+ addRing(convexHull(points));
+}
+
+void CPolygonSet::addCircle(const TCoord x, const TCoord y, const TDimension radius, const TDimension tolerance)
+{
+ CShape shape;
+ shape.setCircle(x,y,radius);
+ addShape(shape,tolerance);
+}
+
+void CPolygonSet::addRectangle(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2)
+{
+ qint64 l = toGrid(std::min(x1,x2)), r = toGrid(std::max(x1,x2));
+ qint64 b = toGrid(std::min(y1,y2)), t = toGrid(std::max(y1,y2));
+ QVector<CGridPoint> ring;
+ ring.append(CGridPoint(l,b));
+ ring.append(CGridPoint(r,b));
+ ring.append(CGridPoint(r,t));
+ ring.append(CGridPoint(l,t));
+ addRing(ring);
+}
+
+void CPolygonSet::addBoundary(const CPolygonSet& polygons, const TDimension distance, const TDimension tolerance)
+{
+ if (distance <= 0.0) return;
+ for (int i = 0; i < polygons.count(); i++)
+ {
+  const QVector<CGridPoint>& ring = polygons.ring(i);
+  for (int j = 0; j < ring.size(); j++)
+  {
+   const CGridPoint& a = ring.at(j);
+   const CGridPoint& b = ring.at((j+1) % ring.size());
+   CShape shape;
+   shape.setSegment(fromGrid(a.x),fromGrid(a.y),fromGrid(b.x),fromGrid(b.y),distance);
+   addShape(shape,tolerance);
+  }
+ }
+}
+
+CPolygonSet CPolygonSet::combined(const CPolygonSet& polygons, const CPolygonSet::Operation operation) const
+{
+ CPolygonSet result;
+ if (poIntersection==operation && (isEmpty() || polygons.isEmpty())) return result;
+ if (poDifference==operation && isEmpty()) return result;
+ QVector<CClipEdge> edges;
+ collectEdges(*this,0,edges);
+ collectEdges(polygons,1,edges);
+ if (edges.isEmpty()) return result;
+ splitEdges(edges);
+ QVector<CDirectedEdge> boundary;
+ classifyEdges(edges,operation,boundary);
+ linkEdges(boundary,result.m_Rings);
+ return result;
+}
+
+CPolygonSet CPolygonSet::offset(const TDimension distance, const TDimension tolerance) const
+{
+ if (0.0==distance) return simplified();
+ CPolygonSet band;
+ band.addBoundary(*this,fabs(distance),tolerance);
+ return combined(band,(distance > 0.0) ? poUnion : poDifference);
+}
+
+CPolygonSet CPolygonSet::simplified(void) const
+{
+ return combined(CPolygonSet(),poUnion);
+}
+
+QList<CPolygonSet> CPolygonSet::islands(void) const
+{
+ QList<CPolygonSet> result;
+ QVector<int> outer;
+ QVector<double> areas;
+ for (int i = 0; i < m_Rings.size(); i++)
+ {
+  areas.append(ringArea(m_Rings.at(i)));
+  if (areas.last() > 0.0)
+  {
+   outer.append(i);
+   result.append(CPolygonSet());
+   result.last().m_Rings.append(m_Rings.at(i));
+  }
+ }
+ for (int i = 0; i < m_Rings.size(); i++)
+ {
+  if (areas.at(i) >= 0.0) continue;
+  // a point just beside the first edge on the side of the area
+  const QVector<CGridPoint>& hole = m_Rings.at(i);
+  double dx = hole.at(1).x - hole.at(0).x, dy = hole.at(1).y - hole.at(0).y;
+  double length = sqrt(dx*dx + dy*dy);
+  double x = 0.5*(hole.at(0).x + hole.at(1).x) - 0.25*dy/length;
+  double y = 0.5*(hole.at(0).y + hole.at(1).y) + 0.25*dx/length;
+  int best = -1;
+  for (int k = 0; k < outer.size(); k++)
+  {
+   if (0==ringWinding(m_Rings.at(outer.at(k)),x,y)) continue;
+   if (best < 0 || areas.at(outer.at(k)) < areas.at(outer.at(best))) best = k;
+  }
+  if (best >= 0) result[best].m_Rings.append(hole);
+ }
+ return result;
+}
+
+void CPolygonSet::fracture(void)
+{
+ QList<CPolygonSet> parts = islands();
+ m_Rings.clear();
+ for (int i = 0; i < parts.size(); i++)
+ {
+  QVector<CGridPoint> outer = parts.at(i).ring(0);
+  // holes are joined from their rightmost point, rightmost hole first, so
+  // the ray to the right only meets the outer ring or joined holes
+  QVector<QPair<CGridPoint,int> > order;
+  for (int j = 1; j < parts.at(i).count(); j++)
+  {
+   const QVector<CGridPoint>& hole = parts.at(i).ring(j);
+   int m = 0;
+   for (int k = 1; k < hole.size(); k++)
+   {
+    if (hole.at(m) < hole.at(k)) m = k;
+   }
+   order.append(qMakePair(hole.at(m),j));
+  }
+  std::sort(order.begin(),order.end());
+  for (int j = order.size()-1; j >= 0; j--)
+  {
+   const CGridPoint& h = order.at(j).first;
+   const QVector<CGridPoint>& hole = parts.at(i).ring(order.at(j).second);
+   // nearest upward edge of the outer ring crossing the ray
+   int edge = -1;
+   double hit = 0.0;
+   for (int k = 0; k < outer.size(); k++)
+   {
+    const CGridPoint& p = outer.at(k);
+    const CGridPoint& q = outer.at((k+1) % outer.size());
+    if (p.y > h.y || q.y <= h.y) continue;
+    double x = p.x + (h.y - p.y)*(double)(q.x - p.x)/(q.y - p.y);
+    if (x < h.x) continue;
+    if (edge < 0 || x < hit)
+    {
+     edge = k;
+     hit = x;
+    }
+   }
+   if (edge < 0) continue;
+   CGridPoint bridge(qRound64(hit),h.y);
+   QVector<CGridPoint> ring;
+   ring.reserve(outer.size() + hole.size() + 3);
+   for (int k = 0; k <= edge; k++)
+   {
+    ring.append(outer.at(k));
+   }
+   if (ring.last()!=bridge) ring.append(bridge);
+   int m = hole.indexOf(h);
+   for (int k = 0; k <= hole.size(); k++)
+   {
+    ring.append(hole.at((m+k) % hole.size()));
+   }
+   ring.append(bridge);
+   for (int k = edge+1; k < outer.size(); k++)
+   {
+    if (k==edge+1 && outer.at(k)==bridge) continue;
+    ring.append(outer.at(k));
+   }
+   outer = ring;
+  }
+  m_Rings.append(outer);
+ }
+}
+
+bool CPolygonSet::contains(const TCoord x, const TCoord y) const
+{
+ int winding = 0;
+ for (int i = 0; i < m_Rings.size(); i++)
+ {
+  winding += ringWinding(m_Rings.at(i),x*GRID,y*GRID);
+ }
+ return 0!=winding;
+}
+
+double CPolygonSet::area(void) const
+{
+ double result = 0.0;
+ for (int i = 0; i < m_Rings.size(); i++)
+ {
+  result += ringArea(m_Rings.at(i));
+ }
+ return 0.5*result/(GRID*GRID);
+}
+
+CBoundingBox CPolygonSet::boundingBox(void) const
+{
+ CBoundingBox result;
+ for (int i = 0; i < m_Rings.size(); i++)
+ {
+  const QVector<CGridPoint>& ring = m_Rings.at(i);
+  for (int j = 0; j < ring.size(); j++)
+  {
+   result.include(fromGrid(ring.at(j).x),fromGrid(ring.at(j).y));
+  }
+ }
+ return result;
+}
+
+QVector<CPoint> CPolygonSet::points(const int ring) const
+{
+ QVector<CPoint> result;
+ const QVector<CGridPoint>& r = m_Rings.at(ring);
+ result.reserve(r.size());
+ for (int i = 0; i < r.size(); i++)
+ {
+  result.append(CPoint(fromGrid(r.at(i).x),fromGrid(r.at(i).y)));
+ }
+ return result;
+}
+
+//------------------------------------------------------------------------------
+
+// copper a pour has to keep away from, or connect to when it is of the same
+// signal
+class CPourItem
+{
+ public:
+  enum Kind {ikWire, ikVia, ikPad, ikHole, ikCopper};
+ public:
+  CPourItem(void): layer(0), kind(ikCopper), signal(-1), signalClass(0), x(0.0), y(0.0), rotation(0.0) {}
+  CPourItem(const CShape& shape, const TLayer layer, const CPourItem::Kind kind, const int signal,
+            const TClass signalClass):
+   shape(shape), layer(layer), kind(kind), signal(signal), signalClass(signalClass), x(0.0), y(0.0),
+   rotation(0.0) {}
+ public:
+  CShape shape;
+  TLayer layer;
+  CPourItem::Kind kind;
+  int signal; // -1 for none
+  TClass signalClass;
+  TCoord x; // center of vias and pads, thermal spokes start there
+  TCoord y;
+  double rotation;
+};
+
+// everything the polygons of one rank read while they are poured
+class CPourContext
+{
+ public:
+  CPourContext(void): fills(0), tolerance(0.0), copperDimension(0.0), thermalIsolate(0.0),
+   thermalsForVias(false), maxClearance(0.0), matrix(0) {}
+ public:
+  QVector<CPourItem> items;
+  CSpatialIndex index;
+  QVector<CPolygon*> polygons;
+  QVector<TClass> classes; // of the signal of each polygon
+  QVector<int> signalIds;
+  QVector<CBoundingBox> boxes; // of the fills poured so far
+  CPolygonSet *fills;
+  QList<CPolygon*> cutouts;
+  CPolygonSet board; // inside of the outline less the copper to dimension band
+  TDimension tolerance;
+  TDimension copperDimension;
+  TDimension thermalIsolate;
+  bool thermalsForVias;
+  TDimension maxClearance;
+  const CClearanceMatrix *matrix;
+};
+
+class CPourJob: public CParallelJob
+{
+ public:
+  CPourJob(CPourContext& context, const QVector<int>& polygons): m_Context(context), m_Polygons(polygons) {}
+  virtual void execute(const int index)
+  {
+   int n = m_Polygons.at(index);
+   CPolygon *p = m_Context.polygons.at(n);
+   int signal = m_Context.signalIds.at(n);
+   TClass signalClass = m_Context.classes.at(n);
+   TLayer layer = p->layer();
+   TDimension isolate = p->isolate(), width = p->width(), tolerance = m_Context.tolerance;
+   CPolygonSet region;
+   region.addOutline(p->vertices(),tolerance);
+   if (!m_Context.board.isEmpty()) region = region.intersected(m_Context.board);
+   CPolygonSet cutouts;
+   for (int i = 0; i < m_Context.cutouts.size(); i++)
+   {
+    if (m_Context.cutouts.at(i)->layer()==layer) cutouts.addOutline(m_Context.cutouts.at(i)->vertices(),tolerance);
+   }
+   if (!cutouts.isEmpty()) region = region.subtracted(cutouts);
+   if (region.isEmpty())
+   {
+    m_Context.fills[n] = region;
+    return;
+   }
+   CBoundingBox box = region.boundingBox();
+   CBoundingBox reach = box;
+   reach.inflate(std::max(isolate,m_Context.maxClearance) + tolerance);
+   // copper of other signals, and how the own one is connected
+   CPolygonSet obstacles, gaps, spokes;
+   QVector<CGridPoint> anchors; // segments as pairs of points
+   QVector<int> near;
+   m_Context.index.query(reach,near);
+   for (int i = 0; i < near.size(); i++)
+   {
+    const CPourItem& item = m_Context.items.at(near.at(i));
+    if (item.layer!=layer) continue;
+    if (item.signal!=signal)
+    {
+     TDimension d = (CPourItem::ikHole==item.kind) ? m_Context.copperDimension :
+                    m_Context.matrix->value(signalClass,item.signalClass);
+     obstacles.addShape(item.shape,tolerance,std::max(isolate,d));
+     continue;
+    }
+    const CShape& s = item.shape;
+    if (CPourItem::ikWire==item.kind)
+    {
+     anchors.append(CGridPoint(CPolygonSet::toGrid(s.vertex(0).x()),CPolygonSet::toGrid(s.vertex(0).y())));
+     anchors.append(CGridPoint(CPolygonSet::toGrid(s.vertex(s.count()-1).x()),
+                               CPolygonSet::toGrid(s.vertex(s.count()-1).y())));
+     continue;
+    }
+    CGridPoint center(CPolygonSet::toGrid(item.x),CPolygonSet::toGrid(item.y));
+    bool thermal = p->thermals() && (CPourItem::ikPad==item.kind ||
+                                     (CPourItem::ikVia==item.kind && m_Context.thermalsForVias));
+    if (!thermal)
+    {
+     anchors.append(center);
+     anchors.append(center);
+     continue;
+    }
+    // spokes of the polygon width from the center across the gap
+    gaps.addShape(s,tolerance,m_Context.thermalIsolate);
+    TDimension length = 0.0;
+    for (int k = 0; k < s.count(); k++)
+    {
+     length = std::max(length,(TDimension)sqrt((s.vertex(k).x()-item.x)*(s.vertex(k).x()-item.x) +
+                                               (s.vertex(k).y()-item.y)*(s.vertex(k).y()-item.y)));
+    }
+    length += s.radius() + m_Context.thermalIsolate + width;
+    for (int k = 0; k < 4; k++)
+    {
+     double a = degtorad(item.rotation + 90.0*k);
+     TCoord x = item.x + length*cos(a), y = item.y + length*sin(a);
+     CShape spoke;
+     spoke.setSegment(item.x,item.y,x,y,0.5*width);
+     spokes.addShape(spoke,tolerance);
+     anchors.append(center);
+     anchors.append(CGridPoint(CPolygonSet::toGrid(x),CPolygonSet::toGrid(y)));
+    }
+   }
+   // polygons of other signals poured before, they take precedence
+   for (int i = 0; i < m_Context.polygons.size(); i++)
+   {
+    CPolygon *q = m_Context.polygons.at(i);
+    if (q->layer()!=layer || q->rank() >= p->rank() || m_Context.signalIds.at(i)==signal) continue;
+    if (!m_Context.boxes.at(i).intersects(reach)) continue;
+    const CPolygonSet& f = m_Context.fills[i];
+    obstacles.append(f);
+    obstacles.addBoundary(f,std::max(isolate,m_Context.matrix->value(signalClass,m_Context.classes.at(i))),
+                          tolerance);
+   }
+   // also turns the outline counterclockwise when nothing is in the way
+   CPolygonSet fill = region.subtracted(obstacles);
+   if (!gaps.isEmpty())
+   {
+    CPolygonSet base = fill;
+    fill = base.subtracted(gaps);
+    if (!spokes.isEmpty()) fill = fill.united(spokes.intersected(base));
+   }
+   if (!p->orphans())
+   {
+    QList<CPolygonSet> islands = fill.islands();
+    fill.clear();
+    for (int i = 0; i < islands.size(); i++)
+    {
+     for (int k = 0; k+1 < anchors.size(); k += 2)
+     {
+      if (touches(islands.at(i),anchors.at(k),anchors.at(k+1)))
+      {
+       fill.append(islands.at(i));
+       break;
+      }
+     }
+    }
+   }
+   if (CPolygon::ppHatch==p->pour() && p->spacing() > width && !fill.isEmpty())
+   {
+    // bars of the width on a grid anchored at the origin, and the border
+    CPolygonSet pattern;
+    box = fill.boundingBox();
+    TDimension spacing = p->spacing();
+    for (double x = floor(box.left()/spacing)*spacing; x <= box.right(); x += spacing)
+    {
+     pattern.addRectangle(x - 0.5*width,box.bottom(),x + 0.5*width,box.top());
+    }
+    for (double y = floor(box.bottom()/spacing)*spacing; y <= box.top(); y += spacing)
+    {
+     pattern.addRectangle(box.left(),y - 0.5*width,box.right(),y + 0.5*width);
+    }
+    pattern.addBoundary(fill,width,tolerance);
+    fill = fill.intersected(pattern);
+   }
+   m_Context.fills[n] = fill;
+  }
+ protected:
+  CPourContext& m_Context;
+  const QVector<int>& m_Polygons;
+};
+
+//------------------------------------------------------------------------------
+
+CPolygonPour::CPolygonPour(void)
+{
+ m_Tolerance = 0.005;
+ m_ThreadCount = 0;
+ clear();
+}
+
+CPolygonPour::~CPolygonPour(void)
+{
+ //
+}
+
+void CPolygonPour::clear(void)
+{
+ m_Board = 0;
+ m_Revision = -1;
+ m_Polygons.clear();
+ m_Signals.clear();
+ m_Fills.clear();
+ m_Index.clear();
+ m_PadResolver.clear();
+ m_Outline.clear();
+ m_Font.clear();
+}
+
+int CPolygonPour::compute(CBoard& board)
+{
+ if (&board==m_Board && board.revision()==m_Revision) return m_Polygons.size();
+ m_Polygons.clear();
+ m_Signals.clear();
+ m_Fills.clear();
+ m_Index.clear();
+ CPourContext context;
+ CPadRules rules(board.designRules());
+ const CDesignRuleValues& values = board.designRules().values();
+ const double mil = 0.0254;
+ context.tolerance = m_Tolerance;
+ context.copperDimension = values.dimension("mdCopperDimension",40*mil);
+ context.thermalIsolate = values.dimension("slThermalIsolate",10*mil);
+ context.thermalsForVias = 0.0!=values.number("slThermalsForVias",0.0);
+ context.matrix = &board.clearanceMatrix();
+ // signal polygons to pour and cutouts
+ QSet<TLayer> layers;
+ QList<CPolygon*>& plain = board.plain().polygons();
+ for (int i = 0; i < plain.size(); i++)
+ {
+  if (CPolygon::ppCutout==plain.at(i)->pour() && CLayer::isCopper(plain.at(i)->layer()))
+  {
+   context.cutouts.append(plain.at(i));
+  }
+ }
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  for (int j = 0; j < s->polygons().size(); j++)
+  {
+   CPolygon *p = s->polygons().at(j);
+   if (!rules.layers().contains(p->layer())) continue;
+   if (CPolygon::ppCutout==p->pour())
+   {
+    context.cutouts.append(p);
+    continue;
+   }
+   m_Index.insert(p,m_Polygons.size());
+   m_Polygons.append(p);
+   m_Signals.append(i);
+   context.classes.append(s->signalClass());
+   layers.insert(p->layer());
+  }
+ }
+ m_Board = &board;
+ m_Revision = board.revision();
+ m_Fills.resize(m_Polygons.size());
+ if (m_Polygons.isEmpty()) return 0;
+ // copper of the layers in use
+ QVector<CPourItem>& items = context.items;
+ QVector<CPoint> points;
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  CSignal *s = board.signal().at(i);
+  for (int j = 0; j < s->wires().size(); j++)
+  {
+   CWire *w = s->wires().at(j);
+   if (!layers.contains(w->layer())) continue;
+   flattenWire(*w,m_Tolerance,points);
+   for (int k = 1; k < points.size(); k++)
+   {
+    CShape shape;
+    shape.setSegment(points.at(k-1).x(),points.at(k-1).y(),points.at(k).x(),points.at(k).y(),0.5*w->width());
+    items.append(CPourItem(shape,w->layer(),CPourItem::ikWire,i,s->signalClass()));
+   }
+  }
+  for (int j = 0; j < s->vias().size(); j++)
+  {
+   CVia *v = s->vias().at(j);
+   int start, stop;
+   decodeExtent(v->extent(),start,stop);
+   for (int k = 0; k < rules.layers().size(); k++)
+   {
+    TLayer l = rules.layers().at(k);
+    if (l < start || l > stop || !layers.contains(l)) continue;
+    CShape shape;
+    rules.viaShape(*v,l,shape);
+    items.append(CPourItem(shape,l,CPourItem::ikVia,i,s->signalClass()));
+    items.last().x = v->x();
+    items.last().y = v->y();
+   }
+  }
+ }
+ const QVector<CPadInstance>& pads = m_PadResolver.resolve(board,m_ThreadCount);
+ for (int i = 0; i < pads.size(); i++)
+ {
+  const CPadInstance& pad = pads.at(i);
+  TClass signalClass = (pad.signal() >= 0) ? board.signal().at(pad.signal())->signalClass() : 0;
+  for (int k = 0; k < rules.layers().size(); k++)
+  {
+   TLayer l = rules.layers().at(k);
+   if (!layers.contains(l) || (CPadInstance::pkSMD==pad.kind() && pad.layer()!=l)) continue;
+   CShape shape;
+   rules.padShape(pad,l,shape);
+   items.append(CPourItem(shape,l,CPourItem::ikPad,pad.signal(),signalClass));
+   items.last().x = pad.x();
+   items.last().y = pad.y();
+   items.last().rotation = pad.rotation();
+  }
+ }
+ // holes of the board and of packages
+ QVector<CPoint> holes;
+ QVector<TDimension> drills;
+ for (int i = 0; i < board.plain().holes().size(); i++)
+ {
+  CHole *h = board.plain().holes().at(i);
+  holes.append(CPoint(h->x(),h->y()));
+  drills.append(h->drill());
+ }
+ for (int i = 0; i < board.elements().size(); i++)
+ {
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) continue;
+  CTransform t(*board.elements().at(i));
+  for (int j = 0; j < p->holes().size(); j++)
+  {
+   holes.append(t.map(CPoint(p->holes().at(j)->x(),p->holes().at(j)->y())));
+   drills.append(p->holes().at(j)->drill());
+  }
+ }
+ QList<TLayer> l = layers.values();
+ std::sort(l.begin(),l.end());
+ for (int i = 0; i < holes.size(); i++)
+ {
+  CShape shape;
+  shape.setCircle(holes.at(i).x(),holes.at(i).y(),0.5*drills.at(i));
+  for (int k = 0; k < l.size(); k++)
+  {
+   items.append(CPourItem(shape,l.at(k),CPourItem::ikHole,-1,0));
+  }
+ }
+ // wires and texts of the board drawn on copper
+ for (int i = 0; i < board.plain().wires().size(); i++)
+ {
+  CWire *w = board.plain().wires().at(i);
+  if (!layers.contains(w->layer())) continue;
+  flattenWire(*w,m_Tolerance,points);
+  for (int k = 1; k < points.size(); k++)
+  {
+   CShape shape;
+   shape.setSegment(points.at(k-1).x(),points.at(k-1).y(),points.at(k).x(),points.at(k).y(),0.5*w->width());
+   items.append(CPourItem(shape,w->layer(),CPourItem::ikCopper,-1,0));
+  }
+ }
+ for (int i = 0; i < board.plain().texts().size(); i++)
+ {
+  CText *x = board.plain().texts().at(i);
+  if (!layers.contains(x->layer())) continue;
+  CTextGeometry g;
+  m_Font.strokes(*x,g);
+  for (int j = 0; j < g.strokeCount(); j++)
+  {
+   for (int k = 0; k < std::max(g.count(j)-1,1); k++)
+   {
+    const CPoint& p1 = g.point(j,k);
+    const CPoint& p2 = g.point(j,std::min(k+1,g.count(j)-1));
+    CShape shape;
+    shape.setSegment(p1.x(),p1.y(),p2.x(),p2.y(),0.5*g.width());
+    items.append(CPourItem(shape,x->layer(),CPourItem::ikCopper,-1,0));
+   }
+  }
+ }
+ // largest clearance between classes bounds the search around a polygon
+ context.maxClearance = std::max(context.copperDimension,context.matrix->defaultValue());
+ for (int a = 0; a < context.matrix->size(); a++)
+ {
+  for (int b = 0; b < context.matrix->size(); b++)
+  {
+   context.maxClearance = std::max(context.maxClearance,context.matrix->value(a,b));
+  }
+ }
+ CBoundingBox extent;
+ for (int i = 0; i < items.size(); i++)
+ {
+  extent.include(items.at(i).shape.boundingBox());
+ }
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  extent.include(m_Polygons.at(i)->boundingBox());
+ }
+ double cell = std::max(extent.width(),extent.height())/ceil(sqrt((double)std::max(items.size(),1)));
+ context.index.reset(extent,std::max(cell,0.1));
+ for (int i = 0; i < items.size(); i++)
+ {
+  context.index.insert(i,items.at(i).shape.boundingBox());
+ }
+ // inside of the board outline away from the dimension lines
+ if (m_Outline.build(board) > 0)
+ {
+  CPolygonSet outline;
+  for (int i = 0; i < m_Outline.contours().size(); i++)
+  {
+   outline.addRing(m_Outline.contours().at(i).points());
+  }
+  CPolygonSet band;
+  band.addBoundary(outline,context.copperDimension,m_Tolerance);
+  context.board = band.isEmpty() ? outline.simplified() : outline.subtracted(band);
+ }
+ // rank by rank, lower ones first
+ context.polygons = m_Polygons;
+ context.signalIds = m_Signals;
+ context.boxes.resize(m_Polygons.size());
+ context.fills = m_Fills.data();
+ QList<int> ranks;
+ for (int i = 0; i < m_Polygons.size(); i++)
+ {
+  if (!ranks.contains(m_Polygons.at(i)->rank())) ranks.append(m_Polygons.at(i)->rank());
+ }
+ std::sort(ranks.begin(),ranks.end());
+ for (int r = 0; r < ranks.size(); r++)
+ {
+  QVector<int> batch;
+  for (int i = 0; i < m_Polygons.size(); i++)
+  {
+   if (m_Polygons.at(i)->rank()==ranks.at(r)) batch.append(i);
+  }
+  CPourJob job(context,batch);
+  parallelFor(batch.size(),job,m_ThreadCount);
+  for (int i = 0; i < batch.size(); i++)
+  {
+   context.boxes[batch.at(i)] = context.fills[batch.at(i)].boundingBox();
+  }
+ }
+ return m_Polygons.size();
+}
+
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,165 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEPOLYGON_H
+#define QEAGLEPOLYGON_H
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QList>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+#include "QEagleFont.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements boolean operations on polygons and the pouring of
+signal polygons
+*/
+
+namespace Eagle
+{
+
+// point on the integer grid of CPolygonSet
+class CGridPoint
+{
+ public:
+  CGridPoint(void): x(0), y(0) {}
+  CGridPoint(const qint64 x, const qint64 y): x(x), y(y) {}
+ public:
+  bool operator ==(const CGridPoint& point) const { return x==point.x && y==point.y; }
+  bool operator !=(const CGridPoint& point) const { return x!=point.x || y!=point.y; }
+  bool operator <(const CGridPoint& point) const { return x < point.x || (x==point.x && y < point.y); }
+ public:
+  qint64 x;
+  qint64 y;
+};
+
+// area bounded by rings of points on a grid of 0.1 um, filled by the nonzero
+// rule, so rings may overlap: outer rings of results run counterclockwise and
+// holes clockwise. Boolean operations split all edges at their crossings with
+// exact integer tests, keep the pieces that separate inside from outside and
+// link them into rings again; edges are looked up in a spatial index, so the
+// cost grows with the number of edges and crossings, not with its square
+class CPolygonSet
+{
+ public:
+  enum Operation {poUnion, poIntersection, poDifference};
+ public:
+  CPolygonSet(const CPolygonSet& polygons);
+  CPolygonSet(void);
+  virtual ~CPolygonSet(void);
+ public:
+  // grid steps of millimeters and back
+  static qint64 toGrid(const TCoord value);
+  static TCoord fromGrid(const qint64 value);
+ public:
+  void operator =(const CPolygonSet& polygons);
+  void clear(void);
+  void assign(const CPolygonSet& polygons);
+  void append(const CPolygonSet& polygons);
+  void addRing(const QVector<CGridPoint>& points);
+  void addRing(const QVector<CPoint>& points);
+  // vertices with the curve of the line to the next one, as in <polygon>,
+  // added counterclockwise whichever way they run
+  void addOutline(QList<CVertex*>& vertices, const TDimension tolerance);
+  // a shape grown by frame is covered completely, arcs by polygons around them
+  void addShape(const CShape& shape, const TDimension tolerance, const TDimension frame = 0.0);
+  void addCircle(const TCoord x, const TCoord y, const TDimension radius, const TDimension tolerance);
+  void addRectangle(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2);
+  // edges grown by distance, a band around the boundary
+  void addBoundary(const CPolygonSet& polygons, const TDimension distance, const TDimension tolerance);
+  CPolygonSet combined(const CPolygonSet& polygons, const CPolygonSet::Operation operation) const;
+  CPolygonSet united(const CPolygonSet& polygons) const { return combined(polygons,poUnion); }
+  CPolygonSet intersected(const CPolygonSet& polygons) const { return combined(polygons,poIntersection); }
+  CPolygonSet subtracted(const CPolygonSet& polygons) const { return combined(polygons,poDifference); }
+  // grown by positive and shrunk by negative distances, corners get rounded
+  CPolygonSet offset(const TDimension distance, const TDimension tolerance) const;
+  // overlapping rings merged into the outer rings and holes of the area
+  CPolygonSet simplified(void) const;
+  // outer rings each with the holes inside them, of a set as the boolean
+  // operations return it
+  QList<CPolygonSet> islands(void) const;
+  // holes joined to their outer ring by cut lines, for outputs without holes
+  void fracture(void);
+  bool contains(const TCoord x, const TCoord y) const;
+  double area(void) const;
+  CBoundingBox boundingBox(void) const;
+  QVector<CPoint> points(const int ring) const;
+ public:
+  // getters
+  int count(void) const { return m_Rings.size(); }
+  const QVector<CGridPoint>& ring(const int index) const { return m_Rings.at(index); }
+  bool isEmpty(void) const { return m_Rings.isEmpty(); }
+ protected:
+  QVector<QVector<CGridPoint> > m_Rings;
+};
+
+// copper of the signal polygons of a board: a polygon fills its outline on
+// the board less everything of other signals grown by its isolate distance or
+// the clearance of the net classes, whichever is larger, less the dimension
+// lines grown by the copper to dimension distance and less cutout polygons.
+// Pads of its own signal get thermal reliefs when asked for, vias only if
+// the design rules say so. Polygons are poured rank by rank, each seeing the
+// results of lower ranks of other signals as obstacles; polygons of one rank
+// are poured in parallel. Islands touching no copper of the signal are
+// dropped unless orphans are kept, hatched polygons keep a border of their
+// width and a grid of bars of their width every spacing. Fills are the
+// areas themselves, the outline width does not round their corners
+class CPolygonPour
+{
+ public:
+  CPolygonPour(void);
+  virtual ~CPolygonPour(void);
+ public:
+  void clear(void);
+  // returns the number of signal polygons on copper, results are kept until
+  // the board changes
+  int compute(CBoard& board);
+  // index of a computed polygon, -1 when it is none of them
+  int indexOf(CPolygon *polygon) const { return m_Index.value(polygon,-1); }
+ public:
+  // getters
+  int count(void) const { return m_Polygons.size(); }
+  CPolygon *polygon(const int index) const { return m_Polygons.at(index); }
+  int signal(const int index) const { return m_Signals.at(index); }
+  const CPolygonSet& fill(const int index) const { return m_Fills.at(index); }
+  TDimension tolerance(void) const { return m_Tolerance; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setTolerance(const TDimension value) { m_Tolerance = value; m_Board = 0; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  CBoard *m_Board;
+  int m_Revision;
+  TDimension m_Tolerance; // default = 0.005 mm, arcs deviate less
+  int m_ThreadCount; // default = 0, ideal thread count
+  QVector<CPolygon*> m_Polygons; // in signal order
+  QVector<int> m_Signals; // index into board signals
+  QVector<CPolygonSet> m_Fills;
+  QHash<CPolygon*,int> m_Index;
+  CPadResolver m_PadResolver;
+  CBoardOutline m_Outline;
+  CVectorFont m_Font;
+};
+
+}
+
+#endif // QEAGLEPOLYGON_H
+//------------------------------------------------------------------------------
@@ -0,0 +1,1778 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+//------------------------------------------------------------------------------
+#include "QEagleRender.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+// convex shape or, if outline is not empty, polygon filled even-odd
+class CRasterItem
+{
+ public:
+  CRasterItem(void): color(0), order(0) {}
+ public:
+  CShape shape;
+  QVector<CPoint> outline;
+  CBoundingBox box;
+  QRgb color;
+  int order; // position of the layer in the requested list
+};
+
+static bool lessByOrder(const CRasterItem& a, const CRasterItem& b)
+{
+ return a.order < b.order;
+}
+
+// reduces drawing objects to raster items of the requested layers
+class CRasterScene
+{
+ public:
+  CRasterScene(const QList<TLayer>& layers, const QHash<TLayer,QRgb>& colors, const QRgb background,
+               const double resolution, CVectorFont& font, QVector<CRasterItem>& items):
+   m_Background(background), m_Font(font), m_Items(items)
+  {
+   for (int i = 0; i < layers.size(); i++)
+   {
+    m_Order.insert(layers.at(i),i);
+   }
+   m_Colors = colors;
+   // thinner lines would fall between pixel centers
+   m_MinWidth = 1.0/resolution;
+   m_Tolerance = 0.25/resolution;
+  }
+  bool visible(const TLayer layer) const
+  {
+   return m_Order.contains(layer);
+  }
+  void addShape(const CShape& shape, const TLayer layer, const bool hole = false)
+  {
+   CRasterItem item;
+   item.shape = shape;
+   item.box = shape.boundingBox();
+   item.color = hole ? m_Background : m_Colors.value(layer,qRgb(200,200,200));
+   item.order = m_Order.value(layer);
+   m_Items.append(item);
+  }
+  void addHole(const TCoord x, const TCoord y, const TDimension drill, const TLayer layer)
+  {
+   CShape shape;
+   shape.setCircle(x,y,0.5*drill);
+   addShape(shape,layer,true);
+  }
+  void addWire(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2, const double curve,
+               const TDimension width, const bool flat, const TLayer layer)
+  {
+   if (!visible(layer)) return;
+   TDimension w = std::max(width,m_MinWidth);
+   QVector<CPoint> points;
+   flattenArc(x1,y1,x2,y2,curve,m_Tolerance,points);
+   for (int i = 1; i < points.size(); i++)
+   {
+    const CPoint& a = points.at(i-1);
+    const CPoint& b = points.at(i);
+    CShape shape;
+    if (flat)
+    {
+     // flat ends, joints of arcs stay round
+     double length = sqrt((b.x()-a.x())*(b.x()-a.x()) + (b.y()-a.y())*(b.y()-a.y()));
+     double angle = radtodeg(atan2(b.y()-a.y(),b.x()-a.x()));
+     shape.setRectangle(0.5*(a.x()+b.x()),0.5*(a.y()+b.y()),length,w,angle);
+     addShape(shape,layer);
+     if (i+1 < points.size())
+     {
+      shape.setCircle(b.x(),b.y(),0.5*w);
+      addShape(shape,layer);
+     }
+    }
+    else
+    {
+     shape.setSegment(a.x(),a.y(),b.x(),b.y(),0.5*w);
+     addShape(shape,layer);
+    }
+   }
+  }
+  void addCircle(const TCoord x, const TCoord y, const TDimension radius, const TDimension width,
+                 const TLayer layer)
+  {
+   if (!visible(layer)) return;
+   if (width <= 0.0)
+   {
+    CShape shape;
+    shape.setCircle(x,y,radius);
+    addShape(shape,layer);
+    return;
+   }
+   addWire(x+radius,y,x-radius,y,180.0,width,false,layer);
+   addWire(x-radius,y,x+radius,y,180.0,width,false,layer);
+  }
+  void addRectangle(CRectangle& r, const CTransform& t)
+  {
+   TLayer layer = t.mapLayer(r.layer());
+   if (!visible(layer)) return;
+   CPoint c = t.map(CPoint(0.5*(r.x1()+r.x2()),0.5*(r.y1()+r.y2())));
+   CShape shape;
+   shape.setRectangle(c.x(),c.y(),fabs(r.x2()-r.x1()),fabs(r.y2()-r.y1()),t.mapAngle(r.rotation()));
+   addShape(shape,layer);
+  }
+  void addPolygon(CPolygon& p, const CTransform& t, const bool fill)
+  {
+   TLayer layer = t.mapLayer(p.layer());
+   if (!visible(layer) || p.vertices().size() < 2) return;
+   CRasterItem item;
+   QVector<CPoint> points;
+   for (int i = 0; i < p.vertices().size(); i++)
+   {
+    CVertex *a = p.vertices().at(i);
+    CVertex *b = p.vertices().at((i+1) % p.vertices().size());
+    CPoint pa = t.map(CPoint(a->x(),a->y())), pb = t.map(CPoint(b->x(),b->y()));
+    flattenArc(pa.x(),pa.y(),pb.x(),pb.y(),t.mapCurve(a->curve()),m_Tolerance,points);
+    points.removeLast();
+    item.outline += points;
+    if (p.width() > 0.0 || !fill)
+    {
+     addWire(pa.x(),pa.y(),pb.x(),pb.y(),t.mapCurve(a->curve()),p.width(),false,layer);
+    }
+   }
+   if (!fill) return;
+   for (int i = 0; i < item.outline.size(); i++)
+   {
+    item.box.include(item.outline.at(i).x(),item.outline.at(i).y());
+   }
+   item.color = m_Colors.value(layer,qRgb(200,200,200));
+   item.order = m_Order.value(layer);
+   m_Items.append(item);
+  }
+  void addGraphics(QList<CWire*>& wires, QList<CCircle*>& circles, QList<CRectangle*>& rectangles,
+                   QList<CPolygon*>& polygons, const CTransform& t, const bool copperPolygons)
+  {
+   for (int i = 0; i < wires.size(); i++)
+   {
+    CWire *w = wires.at(i);
+    CPoint a = t.map(CPoint(w->x1(),w->y1())), b = t.map(CPoint(w->x2(),w->y2()));
+    addWire(a.x(),a.y(),b.x(),b.y(),t.mapCurve(w->curve()),w->width(),CWire::wcFlat==w->cap(),
+            t.mapLayer(w->layer()));
+   }
+   for (int i = 0; i < circles.size(); i++)
+   {
+    CCircle *c = circles.at(i);
+    CPoint p = t.map(CPoint(c->x(),c->y()));
+    addCircle(p.x(),p.y(),c->radius(),c->width(),t.mapLayer(c->layer()));
+   }
+   for (int i = 0; i < rectangles.size(); i++)
+   {
+    addRectangle(*rectangles.at(i),t);
+   }
+   for (int i = 0; i < polygons.size(); i++)
+   {
+    CPolygon *p = polygons.at(i);
+    addPolygon(*p,t,copperPolygons || !CLayer::isCopper(t.mapLayer(p->layer())));
+   }
+  }
+  void addStrokes(const CTextGeometry& text, const TLayer layer)
+  {
+   for (int i = 0; i < text.strokeCount(); i++)
+   {
+    // a stroke of one point is a dot
+    if (1==text.count(i))
+    {
+     const CPoint& p = text.point(i,0);
+     addWire(p.x(),p.y(),p.x(),p.y(),0.0,text.width(),false,layer);
+    }
+    for (int k = 1; k < text.count(i); k++)
+    {
+     const CPoint& a = text.point(i,k-1);
+     const CPoint& b = text.point(i,k);
+     addWire(a.x(),a.y(),b.x(),b.y(),0.0,text.width(),false,layer);
+    }
+   }
+  }
+  void addTexts(QList<CText*>& texts, const CTransform& t, const QString& name, const QString& value,
+                const bool smashed)
+  {
+   for (int i = 0; i < texts.size(); i++)
+   {
+    CText *x = texts.at(i);
+    TLayer layer = t.mapLayer(x->layer());
+    if (!visible(layer) || (smashed && CVectorFont::isPartPlaceholder(x->text()))) continue;
+    CTextGeometry g;
+    m_Font.strokes(*x,t,name,value,g);
+    addStrokes(g,layer);
+   }
+  }
+  void addAttributes(QList<CAttribute*>& attributes, const QString& name, const QString& value)
+  {
+   for (int i = 0; i < attributes.size(); i++)
+   {
+    CAttribute *a = attributes.at(i);
+    if (!visible(a->layer())) continue;
+    CTextGeometry g;
+    m_Font.strokes(*a,CVectorFont::attributeValue(*a,name,value),g);
+    addStrokes(g,a->layer());
+   }
+  }
+  void addLabels(QList<CLabel*>& labels, const QString& name)
+  {
+   for (int i = 0; i < labels.size(); i++)
+   {
+    CLabel *l = labels.at(i);
+    if (!visible(l->layer())) continue;
+    CTextGeometry g;
+    m_Font.strokes(name,l->x(),l->y(),l->size(),l->ratio(),l->rotation(),false,false,CText::taBottomLeft,
+                   CText::DEFAULT_DISTANCE,g);
+    addStrokes(g,l->layer());
+   }
+  }
+  void addHoles(QList<CHole*>& holes, const CTransform& t)
+  {
+   if (!visible(CLayer::LAYER_HOLES)) return;
+   for (int i = 0; i < holes.size(); i++)
+   {
+    CHole *h = holes.at(i);
+    CPoint p = t.map(CPoint(h->x(),h->y()));
+    CShape shape;
+    shape.setCircle(p.x(),p.y(),0.5*h->drill());
+    addShape(shape,CLayer::LAYER_HOLES);
+   }
+  }
+ protected:
+  QHash<TLayer,int> m_Order;
+  QHash<TLayer,QRgb> m_Colors;
+  QRgb m_Background;
+  TDimension m_MinWidth;
+  TDimension m_Tolerance;
+  CVectorFont& m_Font;
+  QVector<CRasterItem>& m_Items;
+};
+
+// interval of a row covered by a convex core grown by its radius: the
+// boundary consists of the core edges shifted outwards and the circles
+// around the vertices, extreme crossings of any of these bound the span
+static bool shapeSpan(const CShape& shape, const TDimension r, const double y, double& x1, double& x2)
+{
+ x1 = std::numeric_limits<double>::max();
+ x2 = -x1;
+ int n = shape.count();
+ for (int i = 0; i < n; i++)
+ {
+  const CPoint& v = shape.vertex(i);
+  double dy = y - v.y();
+  if (fabs(dy) <= r)
+  {
+   double h = sqrt(r*r - dy*dy);
+   x1 = std::min(x1,v.x()-h);
+   x2 = std::max(x2,v.x()+h);
+  }
+ }
+ int edges = (n > 2) ? n : n-1;
+ for (int i = 0; i < edges; i++)
+ {
+  const CPoint& a = shape.vertex(i);
+  const CPoint& b = shape.vertex((i+1) % n);
+  double dx = b.x()-a.x(), dy = b.y()-a.y();
+  double length = sqrt(dx*dx + dy*dy);
+  if (length <= 0.0) continue;
+  double nx = dy/length, ny = -dx/length;
+  for (int k = -1; k <= 1; k++)
+  {
+   double ax = a.x() + k*r*nx, ay = a.y() + k*r*ny;
+   double by = b.y() + k*r*ny, bx = b.x() + k*r*nx;
+   if ((ay-y)*(by-y) > 0.0 || ay==by) continue;
+   double x = ax + (y-ay)*(bx-ax)/(by-ay);
+   x1 = std::min(x1,x);
+   x2 = std::max(x2,x);
+  }
+ }
+ return x1 <= x2;
+}
+
+static inline void fillSpan(QRgb *row, const int x1, const int x2, const QRgb color)
+{
+ // a span is at most one tile wide and bound by memory bandwidth; the
+ // stores of one 32 bit value are turned into full width vector stores by
+ // the compiler, so there is no instruction set specific code to keep
+ std::fill(row + x1,row + x2 + 1,color);
+}
+
+class CRasterTileJob: public CParallelJob
+{
+ public:
+  CRasterTileJob(const QVector<CRasterItem>& items, const CSpatialIndex& index, const CBoundingBox& area,
+                 const double resolution, const int tileSize, const int width, const int height,
+                 uchar *bits, const int bytesPerLine):
+   m_Items(items), m_Index(index), m_Area(area), m_Resolution(resolution), m_TileSize(tileSize),
+   m_Width(width), m_Height(height), m_Bits(bits), m_BytesPerLine(bytesPerLine)
+  {
+   m_Columns = (width + tileSize - 1)/tileSize;
+  }
+  virtual void execute(const int index)
+  {
+   int px0 = (index % m_Columns)*m_TileSize, py0 = (index / m_Columns)*m_TileSize;
+   int px1 = std::min(px0 + m_TileSize,m_Width) - 1, py1 = std::min(py0 + m_TileSize,m_Height) - 1;
+   CBoundingBox tile(m_Area.left() + px0/m_Resolution,m_Area.top() - (py1+1)/m_Resolution,
+                     m_Area.left() + (px1+1)/m_Resolution,m_Area.top() - py0/m_Resolution);
+   QVector<int> ids;
+   m_Index.query(tile,ids);
+   QVector<double> crossings;
+   for (int i = 0; i < ids.size(); i++)
+   {
+    const CRasterItem& item = m_Items.at(ids.at(i));
+    // rounded shapes keep at least one pixel when drawn coarser than they
+    // were collected for, as wires do at full resolution
+    TDimension radius = item.shape.radius();
+    if (radius > 0.0) radius = std::max(radius,0.5/m_Resolution);
+    int ya = std::max(py0,(int)floor((m_Area.top() - item.box.top())*m_Resolution - 0.5));
+    int yb = std::min(py1,(int)ceil((m_Area.top() - item.box.bottom())*m_Resolution - 0.5));
+    for (int py = ya; py <= yb; py++)
+    {
+     double y = m_Area.top() - (py + 0.5)/m_Resolution;
+     QRgb *row = (QRgb*)(m_Bits + py*m_BytesPerLine);
+     if (item.outline.isEmpty())
+     {
+      double x1, x2;
+      if (shapeSpan(item.shape,radius,y,x1,x2)) fill(row,x1,x2,px0,px1,item.color);
+      continue;
+     }
+     crossings.clear();
+     int n = item.outline.size();
+     for (int k = 0; k < n; k++)
+     {
+      const CPoint& a = item.outline.at(k);
+      const CPoint& b = item.outline.at((k+1) % n);
+      if ((a.y() > y) != (b.y() > y))
+      {
+       crossings.append(a.x() + (y-a.y())*(b.x()-a.x())/(b.y()-a.y()));
+      }
+     }
+     std::sort(crossings.begin(),crossings.end());
+     for (int k = 0; k+1 < crossings.size(); k += 2)
+     {
+      fill(row,crossings.at(k),crossings.at(k+1),px0,px1,item.color);
+     }
+    }
+   }
+  }
+ protected:
+  void fill(QRgb *row, const double x1, const double x2, const int px0, const int px1, const QRgb color)
+  {
+   // pixels whose centers lie within the span
+   int a = std::max(px0,(int)ceil((x1 - m_Area.left())*m_Resolution - 0.5));
+   int b = std::min(px1,(int)floor((x2 - m_Area.left())*m_Resolution - 0.5));
+   if (a <= b) fillSpan(row,a,b,color);
+  }
+ protected:
+  const QVector<CRasterItem>& m_Items;
+  const CSpatialIndex& m_Index;
+  CBoundingBox m_Area;
+  double m_Resolution;
+  int m_TileSize;
+  int m_Width;
+  int m_Height;
+  int m_Columns;
+  uchar *m_Bits;
+  int m_BytesPerLine;
+};
+
+static void addCoord(CContentHash& hash, const double value)
+{
+ quint64 bits;
+ memcpy(&bits,&value,sizeof(bits));
+ hash.add(bits);
+}
+
+static quint64 itemHash(const CRasterItem& item)
+{
+ CContentHash hash;
+ hash.add((quint64)item.color);
+ hash.add((quint64)item.order);
+ hash.add((quint64)item.shape.count());
+ for (int i = 0; i < item.shape.count(); i++)
+ {
+  addCoord(hash,item.shape.vertex(i).x());
+  addCoord(hash,item.shape.vertex(i).y());
+ }
+ addCoord(hash,item.shape.radius());
+ for (int i = 0; i < item.outline.size(); i++)
+ {
+  addCoord(hash,item.outline.at(i).x());
+  addCoord(hash,item.outline.at(i).y());
+ }
+ return hash.value();
+}
+
+// items of a coarser level of a tile layer: those smaller than one of its
+// pixels are reduced to a pixel sized square per pixel they fall in
+class CTileLevel
+{
+ public:
+  QVector<CRasterItem> items;
+  CSpatialIndex index;
+};
+
+// raster items of one board layer at the state of the cached hash
+class CTileLayer
+{
+ public:
+  QVector<CRasterItem> items;
+  QVector<int> first; // per source, index of its first item and the item count
+  CSpatialIndex index;
+  QMap<int,CTileLevel> levels; // built when first asked for
+};
+
+static void changedItems(const QVector<CRasterItem>& previous, const QVector<CRasterItem>& current,
+                         QList<CBoundingBox>& changed)
+{
+ // items present in only one of the states are the edited ones
+ QVector<QPair<quint64,int> > a(previous.size()), b(current.size());
+ for (int i = 0; i < previous.size(); i++)
+ {
+  a[i] = qMakePair(itemHash(previous.at(i)),i);
+ }
+ for (int i = 0; i < current.size(); i++)
+ {
+  b[i] = qMakePair(itemHash(current.at(i)),i);
+ }
+ std::sort(a.begin(),a.end());
+ std::sort(b.begin(),b.end());
+ int i = 0, j = 0;
+ while (i < a.size() || j < b.size())
+ {
+  if (j >= b.size() || (i < a.size() && a.at(i).first < b.at(j).first))
+  {
+   changed.append(previous.at(a.at(i++).second).box);
+  }
+  else if (i >= a.size() || b.at(j).first < a.at(i).first)
+  {
+   changed.append(current.at(b.at(j++).second).box);
+  }
+  else
+  {
+   i++;
+   j++;
+  }
+ }
+}
+
+static void buildLevel(const CTileLayer& layer, const TDimension pixel, const TDimension cellSize,
+                       const QRgb background, CTileLevel& result)
+{
+ // a pixel takes the color of the last item falling in it, drills smaller
+ // than a pixel are not drawn at all
+ QHash<qint64,int> dots;
+ CBoundingBox extent;
+ for (int i = 0; i < layer.items.size(); i++)
+ {
+  const CRasterItem& item = layer.items.at(i);
+  extent.include(item.box);
+  if (item.box.width() >= pixel || item.box.height() >= pixel)
+  {
+   result.items.append(item);
+   continue;
+  }
+  if (item.color==background) continue;
+  qint64 px = (qint64)floor(0.5*(item.box.left()+item.box.right())/pixel);
+  qint64 py = (qint64)floor(0.5*(item.box.bottom()+item.box.top())/pixel);
+  qint64 key = (qint64)(((quint64)px << 32) ^ ((quint64)py & 0xFFFFFFFFu));
+  QHash<qint64,int>::const_iterator d = dots.constFind(key);
+  if (d!=dots.constEnd())
+  {
+   result.items[d.value()].color = item.color;
+   continue;
+  }
+  CRasterItem dot;
+  dot.shape.setRectangle((px+0.5)*pixel,(py+0.5)*pixel,pixel,pixel,0.0);
+  dot.box = dot.shape.boundingBox();
+  dot.color = item.color;
+  dot.order = item.order;
+  dots.insert(key,result.items.size());
+  result.items.append(dot);
+ }
+ result.index.reset(extent,cellSize);
+ for (int i = 0; i < result.items.size(); i++)
+ {
+  result.index.insert(i,result.items.at(i).box);
+ }
+}
+
+static QString svgNumber(const double value)
+{
+ QString result = QString::number(value,'f',4);
+ // trailing zeros only make large drawings larger
+ while (result.endsWith('0')) result.chop(1);
+ if (result.endsWith('.')) result.chop(1);
+ if (result=="-0") result = "0";
+ return result;
+}
+
+static QString svgPoint(const TCoord x, const TCoord y)
+{
+ return svgNumber(x) + " " + svgNumber(-y);
+}
+
+static QString svgColor(const QRgb color)
+{
+ return QString("#%1").arg(color & 0xFFFFFF,6,16,QChar('0'));
+}
+
+// path step from the current point to x2,y2, arcs stay arcs; Eagle's
+// counterclockwise curve turns clockwise once the Y axis points down
+static QString svgStep(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2, const double curve)
+{
+ TCoord cx, cy;
+ if (0.0==curve || !arcCenter(x1,y1,x2,y2,curve,cx,cy)) return " L" + svgPoint(x2,y2);
+ TDimension r = sqrt((x1-cx)*(x1-cx) + (y1-cy)*(y1-cy));
+ return QString(" A%1 %1 0 %2 %3 ").arg(svgNumber(r)).arg(fabs(curve) > 180.0 ? 1 : 0).arg(curve > 0.0 ? 0 : 1) +
+        svgPoint(x2,y2);
+}
+
+// SVG body generator, run once without a stream to find the layers in use
+// and the extent of the drawing, then once per layer group
+class CSvgWriter
+{
+ public:
+  CSvgWriter(const QRgb background, CVectorFont& font):
+   m_Background(background), m_Font(font), m_Out(0), m_Layer(CLayer::LAYER__INVALID),
+   m_Board(0), m_Resolver(0), m_Rules(0), m_Schematic(0), m_Sheet(0), m_Parts(0), m_Symbol(0), m_Package(0) {}
+  void setBoard(CBoard& board, const CPadResolver& resolver, const CPadRules& rules)
+  {
+   m_Board = &board;
+   m_Resolver = &resolver;
+   m_Rules = &rules;
+  }
+  void setSheet(CSchematic& schematic, CSheet& sheet, const QHash<QString,CPart*>& parts)
+  {
+   m_Schematic = &schematic;
+   m_Sheet = &sheet;
+   m_Parts = &parts;
+  }
+  void setSymbol(CSymbol& symbol) { m_Symbol = &symbol; }
+  void setPackage(CPackage& package, const CPadRules& rules)
+  {
+   m_Package = &package;
+   m_Rules = &rules;
+  }
+  // an empty list draws all layers in use in ascending order
+  void write(QTextStream& out, const QList<TLayer>& layers, const QHash<TLayer,QRgb>& colors)
+  {
+   m_Out = 0;
+   body();
+   QList<TLayer> order = layers;
+   if (order.isEmpty())
+   {
+    order = m_Layers.values();
+    std::sort(order.begin(),order.end());
+   }
+   if (!m_Extent.isValid()) m_Extent.include(0.0,0.0);
+   m_Extent.inflate(1.0);
+   out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+   out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << svgNumber(m_Extent.width()) <<
+          "mm\" height=\"" << svgNumber(m_Extent.height()) << "mm\" viewBox=\"" <<
+          svgPoint(m_Extent.left(),m_Extent.top()) << " " << svgNumber(m_Extent.width()) << " " <<
+          svgNumber(m_Extent.height()) << "\">\n";
+   out << "<rect x=\"" << svgNumber(m_Extent.left()) << "\" y=\"" << svgNumber(-m_Extent.top()) <<
+          "\" width=\"" << svgNumber(m_Extent.width()) << "\" height=\"" << svgNumber(m_Extent.height()) <<
+          "\" fill=\"" << svgColor(m_Background) << "\"/>\n";
+   m_Out = &out;
+   for (int i = 0; i < order.size(); i++)
+   {
+    m_Layer = order.at(i);
+    if (!m_Layers.contains(m_Layer)) continue;
+    QString color = svgColor(colors.value(m_Layer,CSvgExport::paletteColor(7)));
+    out << "<g id=\"layer" << m_Layer << "\" fill=\"" << color << "\" stroke=\"" << color <<
+           "\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n";
+    body();
+    out << "</g>\n";
+   }
+   out << "</svg>\n";
+  }
+ protected:
+  bool accept(const TLayer layer)
+  {
+   if (0!=m_Out) return layer==m_Layer;
+   m_Layers.insert(layer);
+   return true;
+  }
+  bool measuring(void) const { return 0==m_Out; }
+  QString strokeWidth(const TDimension width) const
+  {
+   // zero width is Eagle's thinnest line, a hairline in any zoom
+   if (width <= 0.0) return "stroke-width=\"1\" vector-effect=\"non-scaling-stroke\"";
+   return "stroke-width=\"" + svgNumber(width) + "\"";
+  }
+  void wire(const TCoord x1, const TCoord y1, const TCoord x2, const TCoord y2, const double curve,
+            const TDimension width, const bool flat, const TLayer layer)
+  {
+   if (!accept(layer)) return;
+   if (measuring())
+   {
+    QVector<CPoint> points;
+    flattenArc(x1,y1,x2,y2,curve,0.05,points);
+    for (int i = 0; i < points.size(); i++)
+    {
+     m_Extent.include(points.at(i).x(),points.at(i).y(),0.5*width);
+    }
+    return;
+   }
+   *m_Out << "<path d=\"M" << svgPoint(x1,y1) << svgStep(x1,y1,x2,y2,curve) << "\" fill=\"none\" " <<
+             strokeWidth(width) << (flat ? " stroke-linecap=\"butt\"" : "") << "/>\n";
+  }
+  void circle(const TCoord x, const TCoord y, const TDimension radius, const TDimension width,
+              const TLayer layer, const bool hole = false)
+  {
+   if (!accept(layer)) return;
+   if (measuring())
+   {
+    m_Extent.include(x,y,radius + 0.5*width);
+    return;
+   }
+   *m_Out << "<circle cx=\"" << svgNumber(x) << "\" cy=\"" << svgNumber(-y) << "\" r=\"" << svgNumber(radius) << "\" ";
+   if (hole) *m_Out << "fill=\"" << svgColor(m_Background) << "\" stroke=\"none\"/>\n";
+   else if (width <= 0.0) *m_Out << "stroke=\"none\"/>\n";
+   else *m_Out << "fill=\"none\" " << strokeWidth(width) << "/>\n";
+  }
+  // filled convex shape grown by its radius, which is what a round joined
+  // stroke of twice the radius adds to the core
+  void shape(const CShape& shape, const TLayer layer)
+  {
+   if (1==shape.count())
+   {
+    circle(shape.vertex(0).x(),shape.vertex(0).y(),shape.radius(),0.0,layer);
+    return;
+   }
+   if (!accept(layer)) return;
+   if (measuring())
+   {
+    m_Extent.include(shape.boundingBox());
+    return;
+   }
+   *m_Out << "<path d=\"M" << svgPoint(shape.vertex(0).x(),shape.vertex(0).y());
+   for (int i = 1; i < shape.count(); i++)
+   {
+    *m_Out << " L" << svgPoint(shape.vertex(i).x(),shape.vertex(i).y());
+   }
+   if (shape.count() > 2) *m_Out << " Z";
+   if (shape.radius() > 0.0) *m_Out << "\" stroke-width=\"" << svgNumber(2.0*shape.radius()) << "\"/>\n";
+   else *m_Out << "\" stroke=\"none\"/>\n";
+  }
+  void rectangle(CRectangle& r, const CTransform& t)
+  {
+   TLayer layer = t.mapLayer(r.layer());
+   if (!accept(layer)) return;
+   CPoint c = t.map(CPoint(0.5*(r.x1()+r.x2()),0.5*(r.y1()+r.y2())));
+   CShape s;
+   s.setRectangle(c.x(),c.y(),fabs(r.x2()-r.x1()),fabs(r.y2()-r.y1()),t.mapAngle(r.rotation()));
+   shape(s,layer);
+  }
+  void polygon(CPolygon& p, const CTransform& t, const bool fill)
+  {
+   TLayer layer = t.mapLayer(p.layer());
+   if (!accept(layer) || p.vertices().isEmpty()) return;
+   int n = p.vertices().size();
+   if (measuring())
+   {
+    for (int i = 0; i < n; i++)
+    {
+     CPoint a = t.map(CPoint(p.vertices().at(i)->x(),p.vertices().at(i)->y()));
+     CPoint b = t.map(CPoint(p.vertices().at((i+1) % n)->x(),p.vertices().at((i+1) % n)->y()));
+     wire(a.x(),a.y(),b.x(),b.y(),t.mapCurve(p.vertices().at(i)->curve()),p.width(),false,layer);
+    }
+    return;
+   }
+   CPoint first = t.map(CPoint(p.vertices().at(0)->x(),p.vertices().at(0)->y()));
+   *m_Out << "<path d=\"M" << svgPoint(first.x(),first.y());
+   for (int i = 0; i < n; i++)
+   {
+    CPoint a = t.map(CPoint(p.vertices().at(i)->x(),p.vertices().at(i)->y()));
+    CPoint b = t.map(CPoint(p.vertices().at((i+1) % n)->x(),p.vertices().at((i+1) % n)->y()));
+    *m_Out << svgStep(a.x(),a.y(),b.x(),b.y(),t.mapCurve(p.vertices().at(i)->curve()));
+   }
+   *m_Out << " Z\"" << (fill ? " fill-rule=\"evenodd\" " : " fill=\"none\" ") << strokeWidth(p.width()) << "/>\n";
+  }
+  // one path of all strokes of a text
+  void strokes(const CTextGeometry& text, const TLayer layer)
+  {
+   if (0==text.strokeCount() || !accept(layer)) return;
+   if (measuring())
+   {
+    m_Extent.include(text.boundingBox());
+    return;
+   }
+   *m_Out << "<path d=\"";
+   for (int i = 0; i < text.strokeCount(); i++)
+   {
+    const CPoint& p = text.point(i,0);
+    *m_Out << (i ? " M" : "M") << svgPoint(p.x(),p.y());
+    // dots are zero length lines, drawn by their round caps
+    if (1==text.count(i)) *m_Out << " L" << svgPoint(p.x(),p.y());
+    for (int k = 1; k < text.count(i); k++)
+    {
+     *m_Out << " L" << svgPoint(text.point(i,k).x(),text.point(i,k).y());
+    }
+   }
+   *m_Out << "\" fill=\"none\" " << strokeWidth(text.width()) << "/>\n";
+  }
+  void texts(QList<CText*>& texts, const CTransform& t, const QString& name, const QString& value, const bool smashed)
+  {
+   for (int i = 0; i < texts.size(); i++)
+   {
+    CText *x = texts.at(i);
+    TLayer layer = t.mapLayer(x->layer());
+    if (!accept(layer) || (smashed && CVectorFont::isPartPlaceholder(x->text()))) continue;
+    CTextGeometry g;
+    m_Font.strokes(*x,t,name,value,g);
+    strokes(g,layer);
+   }
+  }
+  void attributes(QList<CAttribute*>& attributes, const QString& name, const QString& value)
+  {
+   for (int i = 0; i < attributes.size(); i++)
+   {
+    CAttribute *a = attributes.at(i);
+    if (!accept(a->layer())) continue;
+    CTextGeometry g;
+    m_Font.strokes(*a,CVectorFont::attributeValue(*a,name,value),g);
+    strokes(g,a->layer());
+   }
+  }
+  void graphics(QList<CWire*>& wires, QList<CCircle*>& circles, QList<CRectangle*>& rectangles,
+                QList<CPolygon*>& polygons, const CTransform& t, const bool copperPolygons)
+  {
+   for (int i = 0; i < wires.size(); i++)
+   {
+    CWire *w = wires.at(i);
+    CPoint a = t.map(CPoint(w->x1(),w->y1())), b = t.map(CPoint(w->x2(),w->y2()));
+    wire(a.x(),a.y(),b.x(),b.y(),t.mapCurve(w->curve()),w->width(),CWire::wcFlat==w->cap(),
+         t.mapLayer(w->layer()));
+   }
+   for (int i = 0; i < circles.size(); i++)
+   {
+    CCircle *c = circles.at(i);
+    CPoint p = t.map(CPoint(c->x(),c->y()));
+    circle(p.x(),p.y(),c->radius(),c->width(),t.mapLayer(c->layer()));
+   }
+   for (int i = 0; i < rectangles.size(); i++)
+   {
+    rectangle(*rectangles.at(i),t);
+   }
+   for (int i = 0; i < polygons.size(); i++)
+   {
+    CPolygon *p = polygons.at(i);
+    polygon(*p,t,copperPolygons || !CLayer::isCopper(t.mapLayer(p->layer())));
+   }
+  }
+  void holes(QList<CHole*>& holes, const CTransform& t)
+  {
+   for (int i = 0; i < holes.size(); i++)
+   {
+    CHole *h = holes.at(i);
+    CPoint p = t.map(CPoint(h->x(),h->y()));
+    circle(p.x(),p.y(),0.5*h->drill(),0.0,CLayer::LAYER_HOLES);
+   }
+  }
+  void pad(const CPadInstance& p)
+  {
+   TLayer layer = (CPadInstance::pkPad==p.kind()) ? CLayer::LAYER_PADS : p.layer();
+   if (!accept(layer)) return;
+   CShape s;
+   m_Rules->padShape(p,(CPadInstance::pkPad==p.kind()) ? CLayer::LAYER_TOP : layer,s);
+   shape(s,layer);
+   if (CPadInstance::pkPad==p.kind()) circle(p.x(),p.y(),0.5*p.drill(),0.0,layer,true);
+  }
+  void pins(CSymbol& symbol, const CTransform& t)
+  {
+   // pins are drawn from their connection point towards the symbol body
+   static const TDimension lengths[] = {0.0, 2.54, 5.08, 7.62};
+   for (int i = 0; i < symbol.pins().size(); i++)
+   {
+    CPin *p = symbol.pins().at(i);
+    TDimension length = lengths[p->length()];
+    if (length <= 0.0) continue;
+    CPoint a = t.map(CPoint(p->x(),p->y()));
+    double angle = degtorad(t.mapAngle(p->rotation()));
+    wire(a.x(),a.y(),a.x() + length*cos(angle),a.y() + length*sin(angle),0.0,0.1524,false,CLayer::LAYER_SYMBOLS);
+   }
+  }
+  void body(void)
+  {
+   if (0!=m_Board) board();
+   if (0!=m_Sheet) sheet();
+   if (0!=m_Symbol)
+   {
+    CTransform identity;
+    graphics(m_Symbol->wires(),m_Symbol->circles(),m_Symbol->rectangles(),m_Symbol->polygons(),identity,true);
+    texts(m_Symbol->texts(),identity,QString(),QString(),false);
+    pins(*m_Symbol,identity);
+   }
+   if (0!=m_Package)
+   {
+    CTransform identity;
+    graphics(m_Package->wires(),m_Package->circles(),m_Package->rectangles(),m_Package->polygons(),identity,true);
+    texts(m_Package->texts(),identity,QString(),QString(),false);
+    holes(m_Package->holes(),identity);
+    CPadInstance p;
+    for (int i = 0; i < m_Package->pads().size(); i++)
+    {
+     p.assign(*m_Package->pads().at(i),identity);
+     pad(p);
+    }
+    for (int i = 0; i < m_Package->smds().size(); i++)
+    {
+     p.assign(*m_Package->smds().at(i),identity);
+     pad(p);
+    }
+   }
+  }
+  void board(void)
+  {
+   CTransform identity;
+   CPlain& plain = m_Board->plain();
+   graphics(plain.wires(),plain.circles(),plain.rectangles(),plain.polygons(),identity,false);
+   texts(plain.texts(),identity,QString(),QString(),false);
+   holes(plain.holes(),identity);
+   for (int i = 0; i < m_Board->elements().size(); i++)
+   {
+    CElement *e = m_Board->elements().at(i);
+    CPackage *p = m_Resolver->package(i);
+    if (0==p) continue;
+    CTransform t(*e);
+    graphics(p->wires(),p->circles(),p->rectangles(),p->polygons(),t,true);
+    texts(p->texts(),t,e->name(),e->value(),e->smashed());
+    holes(p->holes(),t);
+    if (e->smashed()) attributes(e->attributes(),e->name(),e->value());
+   }
+   for (int i = 0; i < m_Board->signal().size(); i++)
+   {
+    CSignal *s = m_Board->signal().at(i);
+    QList<CCircle*> circles;
+    QList<CRectangle*> rectangles;
+    graphics(s->wires(),circles,rectangles,s->polygons(),identity,false);
+    for (int j = 0; j < s->vias().size(); j++)
+    {
+     CVia *v = s->vias().at(j);
+     CShape via;
+     m_Rules->viaShape(*v,CLayer::LAYER_TOP,via);
+     shape(via,CLayer::LAYER_VIAS);
+     circle(v->x(),v->y(),0.5*v->drill(),0.0,CLayer::LAYER_VIAS,true);
+    }
+   }
+   const QVector<CPadInstance>& pads = m_Resolver->pads();
+   for (int i = 0; i < pads.size(); i++)
+   {
+    pad(pads.at(i));
+   }
+  }
+  void sheet(void)
+  {
+   CTransform identity;
+   CPlain& plain = m_Sheet->plain();
+   graphics(plain.wires(),plain.circles(),plain.rectangles(),plain.polygons(),identity,true);
+   texts(plain.texts(),identity,QString(),QString(),false);
+   QList<CCircle*> circles;
+   QList<CRectangle*> rectangles;
+   QList<CPolygon*> polygons;
+   for (int i = 0; i < m_Sheet->nets().size() + m_Sheet->busses().size(); i++)
+   {
+    bool net = i < m_Sheet->nets().size();
+    QList<CSegment*>& segments = net ? m_Sheet->nets().at(i)->segments() :
+                                       m_Sheet->busses().at(i - m_Sheet->nets().size())->segments();
+    QString name = net ? m_Sheet->nets().at(i)->name() : m_Sheet->busses().at(i - m_Sheet->nets().size())->name();
+    for (int j = 0; j < segments.size(); j++)
+    {
+     CSegment *g = segments.at(j);
+     graphics(g->wires(),circles,rectangles,polygons,identity,true);
+     for (int k = 0; k < g->junctions().size(); k++)
+     {
+      // Eagle's junction dot of 40 mil
+      circle(g->junctions().at(k)->x(),g->junctions().at(k)->y(),0.508,0.0,CLayer::LAYER_NETS);
+     }
+     for (int k = 0; k < g->labels().size(); k++)
+     {
+      CLabel *l = g->labels().at(k);
+      if (!accept(l->layer())) continue;
+      CTextGeometry g;
+      m_Font.strokes(name,l->x(),l->y(),l->size(),l->ratio(),l->rotation(),false,false,CText::taBottomLeft,
+                     CText::DEFAULT_DISTANCE,g);
+      strokes(g,l->layer());
+     }
+    }
+   }
+   for (int i = 0; i < m_Sheet->instances().size(); i++)
+   {
+    CInstance *n = m_Sheet->instances().at(i);
+    CPart *part = m_Parts->value(n->part(),0);
+    CLibrary *library = (0!=part) ? m_Schematic->findLibraryByName(part->library()) : 0;
+    CDeviceSet *ds = (0!=library) ? library->findDeviceSetByName(part->deviceSet()) : 0;
+    CGate *gate = (0!=ds) ? ds->findGateByName(n->gate()) : 0;
+    CSymbol *symbol = (0!=gate) ? library->findSymbolByName(gate->symbol()) : 0;
+    if (0==symbol) continue;
+    CTransform t(n->x(),n->y(),n->rotation(),n->reflection());
+    graphics(symbol->wires(),symbol->circles(),symbol->rectangles(),symbol->polygons(),t,true);
+    texts(symbol->texts(),t,part->name(),part->value(),n->smashed());
+    pins(*symbol,t);
+    if (n->smashed()) attributes(n->attributes(),part->name(),part->value());
+   }
+  }
+ protected:
+  QRgb m_Background;
+  CVectorFont& m_Font;
+  QTextStream *m_Out; // 0 while measuring
+  TLayer m_Layer;
+  QSet<TLayer> m_Layers;
+  CBoundingBox m_Extent;
+  CBoard *m_Board;
+  const CPadResolver *m_Resolver;
+  const CPadRules *m_Rules;
+  CSchematic *m_Schematic;
+  CSheet *m_Sheet;
+  const QHash<QString,CPart*> *m_Parts;
+  CSymbol *m_Symbol;
+  CPackage *m_Package;
+};
+
+static void partTable(CSchematic& schematic, QHash<QString,CPart*>& parts)
+{
+ parts.clear();
+ for (int i = 0; i < schematic.parts().size(); i++)
+ {
+  parts.insert(schematic.parts().at(i)->name(),schematic.parts().at(i));
+ }
+}
+
+class CSvgSheetJob: public CParallelJob
+{
+ public:
+  CSvgSheetJob(CSchematic& schematic, const QHash<QString,CPart*>& parts, const QHash<TLayer,QRgb>& colors,
+               const QRgb background, CVectorFont& font, const QString& baseName, bool *results):
+   m_Schematic(schematic), m_Parts(parts), m_Colors(colors), m_Background(background), m_Font(font),
+   m_BaseName(baseName), m_Results(results) {}
+  virtual void execute(const int index)
+  {
+   QFile file(QString("%1_%2.svg").arg(m_BaseName).arg(index+1));
+   m_Results[index] = false;
+   if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+   {
+    QTextStream ts(&file);
+    CSvgWriter writer(m_Background,m_Font);
+    writer.setSheet(m_Schematic,*m_Schematic.sheets().at(index),m_Parts);
+    writer.write(ts,QList<TLayer>(),m_Colors);
+    file.close();
+    m_Results[index] = true;
+   }
+  }
+ protected:
+  CSchematic& m_Schematic;
+  const QHash<QString,CPart*>& m_Parts;
+  const QHash<TLayer,QRgb>& m_Colors;
+  QRgb m_Background;
+  CVectorFont& m_Font; // layouts are shared by all sheets
+  QString m_BaseName;
+  bool *m_Results;
+};
+
+//------------------------------------------------------------------------------
+
+CRasterizer::CRasterizer(void)
+{
+ clear();
+}
+
+CRasterizer::~CRasterizer(void)
+{
+ //
+}
+
+void CRasterizer::clear(void)
+{
+ // colors close to Eagle's on black
+ m_Colors.clear();
+ m_Colors.insert(CLayer::LAYER_TOP,qRgb(180,50,50));
+ for (TLayer l = CLayer::LAYER_LAYER2; l < CLayer::LAYER_BOTTOM; l++)
+ {
+  m_Colors.insert(l,qRgb(150,150,50));
+ }
+ m_Colors.insert(CLayer::LAYER_BOTTOM,qRgb(50,50,200));
+ m_Colors.insert(CLayer::LAYER_PADS,qRgb(50,160,50));
+ m_Colors.insert(CLayer::LAYER_VIAS,qRgb(50,160,50));
+ m_Colors.insert(CLayer::LAYER_DIMENSION,qRgb(200,200,200));
+ m_Colors.insert(CLayer::LAYER_TPLACE,qRgb(200,200,200));
+ m_Colors.insert(CLayer::LAYER_BPLACE,qRgb(150,150,150));
+ m_Colors.insert(CLayer::LAYER_TSTOP,qRgb(150,120,60));
+ m_Colors.insert(CLayer::LAYER_BSTOP,qRgb(60,120,150));
+ m_Colors.insert(CLayer::LAYER_TCREAM,qRgb(160,160,160));
+ m_Colors.insert(CLayer::LAYER_BCREAM,qRgb(120,120,120));
+ m_Colors.insert(CLayer::LAYER_HOLES,qRgb(200,200,200));
+ m_Colors.insert(CLayer::LAYER_NETS,qRgb(50,160,50));
+ m_Colors.insert(CLayer::LAYER_BUSSES,qRgb(50,50,200));
+ m_Colors.insert(CLayer::LAYER_PINS,qRgb(50,160,50));
+ m_Colors.insert(CLayer::LAYER_SYMBOLS,qRgb(180,50,50));
+ m_Resolution = 10.0;
+ m_Background = qRgb(0,0,0);
+ m_TileSize = 256;
+ m_ThreadCount = 0;
+ m_PadResolver.clear();
+ m_Font.clear();
+}
+
+QRgb CRasterizer::color(const TLayer layer) const
+{
+ return m_Colors.value(layer,qRgb(200,200,200));
+}
+
+void CRasterizer::setColor(const TLayer layer, const QRgb color)
+{
+ m_Colors.insert(layer,color);
+}
+
+int CRasterizer::sourceCount(CBoard& board)
+{
+ return 1 + 2*board.elements().size() + board.signal().size();
+}
+
+void CRasterizer::collect(CBoard& board, const QList<TLayer>& layers, QVector<CRasterItem>& items)
+{
+ QVector<int> first;
+ collect(board,layers,QVector<int>(),items,first);
+ std::stable_sort(items.begin(),items.end(),lessByOrder);
+}
+
+void CRasterizer::collect(CBoard& board, const QList<TLayer>& layers, const QVector<int>& sources,
+                          QVector<CRasterItem>& items, QVector<int>& first)
+{
+ // cached data of the board is prepared here, tiles only read items
+ items.clear();
+ first.clear();
+ CRasterScene scene(layers,m_Colors,m_Background,m_Resolution,m_Font,items);
+ CPadRules rules(board.designRules());
+ m_PadResolver.resolve(board,m_ThreadCount);
+ int count = sources.isEmpty() ? sourceCount(board) : sources.size();
+ for (int i = 0; i < count; i++)
+ {
+  first.append(items.size());
+  collect(scene,board,rules,sources.isEmpty() ? i : sources.at(i));
+ }
+ first.append(items.size());
+}
+
+void CRasterizer::collect(CRasterScene& scene, CBoard& board, const CPadRules& rules, const int source)
+{
+ CTransform identity;
+ int elements = board.elements().size();
+ int first_pad = 1 + elements + board.signal().size();
+ if (0==source)
+ {
+  scene.addGraphics(board.plain().wires(),board.plain().circles(),board.plain().rectangles(),
+                    board.plain().polygons(),identity,false);
+  scene.addTexts(board.plain().texts(),identity,QString(),QString(),false);
+  scene.addHoles(board.plain().holes(),identity);
+ }
+ else if (source <= elements)
+ {
+  int i = source - 1;
+  CElement *e = board.elements().at(i);
+  CPackage *p = m_PadResolver.package(i);
+  if (0==p) return;
+  CTransform t(*e);
+  scene.addGraphics(p->wires(),p->circles(),p->rectangles(),p->polygons(),t,true);
+  scene.addTexts(p->texts(),t,e->name(),e->value(),e->smashed());
+  if (e->smashed()) scene.addAttributes(e->attributes(),e->name(),e->value());
+  scene.addHoles(p->holes(),t);
+ }
+ else if (source < first_pad)
+ {
+  CSignal *s = board.signal().at(source - 1 - elements);
+  QList<CCircle*> circles;
+  QList<CRectangle*> rectangles;
+  scene.addGraphics(s->wires(),circles,rectangles,s->polygons(),identity,false);
+  if (!scene.visible(CLayer::LAYER_VIAS)) return;
+  for (int j = 0; j < s->vias().size(); j++)
+  {
+   CVia *v = s->vias().at(j);
+   CShape shape;
+   rules.viaShape(*v,CLayer::LAYER_TOP,shape);
+   scene.addShape(shape,CLayer::LAYER_VIAS);
+   scene.addHole(v->x(),v->y(),v->drill(),CLayer::LAYER_VIAS);
+  }
+ }
+ else
+ {
+  // pads come last so that their drills stay open
+  int i = source - first_pad;
+  const QVector<CPadInstance>& pads = m_PadResolver.pads();
+  for (int j = m_PadResolver.first(i); j < m_PadResolver.first(i) + m_PadResolver.count(i); j++)
+  {
+   const CPadInstance& p = pads.at(j);
+   TLayer layer = (CPadInstance::pkPad==p.kind()) ? CLayer::LAYER_PADS : p.layer();
+   if (!scene.visible(layer)) continue;
+   CShape shape;
+   rules.padShape(p,(CPadInstance::pkPad==p.kind()) ? CLayer::LAYER_TOP : layer,shape);
+   scene.addShape(shape,layer);
+   if (CPadInstance::pkPad==p.kind()) scene.addHole(p.x(),p.y(),p.drill(),layer);
+  }
+ }
+}
+
+void CRasterizer::collect(CSchematic& schematic, const int sheet, const QList<TLayer>& layers,
+                          QVector<CRasterItem>& items)
+{
+ items.clear();
+ if (sheet < 0 || sheet >= schematic.sheets().size()) return;
+ CSheet *s = schematic.sheets().at(sheet);
+ CRasterScene scene(layers,m_Colors,m_Background,m_Resolution,m_Font,items);
+ CTransform identity;
+ scene.addGraphics(s->plain().wires(),s->plain().circles(),s->plain().rectangles(),
+                   s->plain().polygons(),identity,true);
+ scene.addTexts(s->plain().texts(),identity,QString(),QString(),false);
+ QList<CCircle*> circles;
+ QList<CRectangle*> rectangles;
+ QList<CPolygon*> polygons;
+ for (int i = 0; i < s->nets().size(); i++)
+ {
+  CNet *n = s->nets().at(i);
+  for (int j = 0; j < n->segments().size(); j++)
+  {
+   CSegment *g = n->segments().at(j);
+   scene.addGraphics(g->wires(),circles,rectangles,polygons,identity,true);
+   scene.addLabels(g->labels(),n->name());
+   if (!scene.visible(CLayer::LAYER_NETS)) continue;
+   for (int k = 0; k < g->junctions().size(); k++)
+   {
+    // Eagle's junction dot of 40 mil
+    CShape shape;
+    shape.setCircle(g->junctions().at(k)->x(),g->junctions().at(k)->y(),0.508);
+    scene.addShape(shape,CLayer::LAYER_NETS);
+   }
+  }
+ }
+ for (int i = 0; i < s->busses().size(); i++)
+ {
+  CBus *b = s->busses().at(i);
+  for (int j = 0; j < b->segments().size(); j++)
+  {
+   scene.addGraphics(b->segments().at(j)->wires(),circles,rectangles,polygons,identity,true);
+   scene.addLabels(b->segments().at(j)->labels(),b->name());
+  }
+ }
+ for (int i = 0; i < s->instances().size(); i++)
+ {
+  CInstance *n = s->instances().at(i);
+  CPart *part = schematic.findPartByName(n->part());
+  CLibrary *library = (0!=part) ? schematic.findLibraryByName(part->library()) : 0;
+  CDeviceSet *ds = (0!=library) ? library->findDeviceSetByName(part->deviceSet()) : 0;
+  CGate *gate = (0!=ds) ? ds->findGateByName(n->gate()) : 0;
+  CSymbol *symbol = (0!=gate) ? library->findSymbolByName(gate->symbol()) : 0;
+  if (0==symbol) continue;
+  CTransform t(n->x(),n->y(),n->rotation(),n->reflection());
+  scene.addGraphics(symbol->wires(),symbol->circles(),symbol->rectangles(),symbol->polygons(),t,true);
+  scene.addTexts(symbol->texts(),t,part->name(),part->value(),n->smashed());
+  if (n->smashed()) scene.addAttributes(n->attributes(),part->name(),part->value());
+  // pins are drawn from their connection point towards the symbol body
+  for (int j = 0; j < symbol->pins().size(); j++)
+  {
+   CPin *p = symbol->pins().at(j);
+   static const TDimension lengths[] = {0.0, 2.54, 5.08, 7.62};
+   TDimension length = lengths[p->length()];
+   if (length <= 0.0) continue;
+   CPoint a = t.map(CPoint(p->x(),p->y()));
+   double angle = degtorad(t.mapAngle(p->rotation()));
+   scene.addWire(a.x(),a.y(),a.x() + length*cos(angle),a.y() + length*sin(angle),0.0,0.1524,false,
+                 CLayer::LAYER_SYMBOLS);
+  }
+ }
+ std::stable_sort(items.begin(),items.end(),lessByOrder);
+}
+
+QImage CRasterizer::createImage(const QVector<CRasterItem>& items, CBoundingBox& area) const
+{
+ area.clear();
+ for (int i = 0; i < items.size(); i++)
+ {
+  area.include(items.at(i).box);
+ }
+ if (!area.isValid()) return QImage();
+ area.inflate(1.0);
+ int width = std::max((int)ceil(area.width()*m_Resolution),1);
+ int height = std::max((int)ceil(area.height()*m_Resolution),1);
+ return QImage(width,height,QImage::Format_RGB32);
+}
+
+void CRasterizer::rasterize(QVector<CRasterItem>& items, const CBoundingBox& area, QImage& image)
+{
+ if (image.isNull() || !area.isValid()) return;
+ double resolution = std::min(image.width()/area.width(),image.height()/area.height());
+ CSpatialIndex index(area,std::max(m_TileSize,16)/resolution);
+ for (int i = 0; i < items.size(); i++)
+ {
+  index.insert(i,items.at(i).box);
+ }
+ rasterize(items,index,area,image);
+}
+
+void CRasterizer::rasterize(const QVector<CRasterItem>& items, const CSpatialIndex& index,
+                            const CBoundingBox& area, QImage& image)
+{
+ if (image.isNull() || !area.isValid()) return;
+ image.fill(m_Background);
+ int width = image.width(), height = image.height();
+ double resolution = std::min(width/area.width(),height/area.height());
+ int tile = std::max(m_TileSize,16);
+ // detached once here, tiles write disjoint pixels of the same buffer
+ uchar *bits = image.bits();
+ CRasterTileJob job(items,index,area,resolution,tile,width,height,bits,image.bytesPerLine());
+ int tiles = ((width + tile - 1)/tile)*((height + tile - 1)/tile);
+ parallelFor(tiles,job,m_ThreadCount);
+}
+
+QImage CRasterizer::render(CBoard& board, const QList<TLayer>& layers)
+{
+ QVector<CRasterItem> items;
+ collect(board,layers,items);
+ CBoundingBox area;
+ QImage result = createImage(items,area);
+ rasterize(items,area,result);
+ return result;
+}
+
+QImage CRasterizer::render(CSchematic& schematic, const int sheet, const QList<TLayer>& layers)
+{
+ QVector<CRasterItem> items;
+ collect(schematic,sheet,layers,items);
+ CBoundingBox area;
+ QImage result = createImage(items,area);
+ rasterize(items,area,result);
+ return result;
+}
+
+void CRasterizer::render(CBoard& board, const QList<TLayer>& layers, const CBoundingBox& area, QImage& image)
+{
+ QVector<CRasterItem> items;
+ collect(board,layers,items);
+ rasterize(items,area,image);
+}
+
+void CRasterizer::render(CSchematic& schematic, const int sheet, const QList<TLayer>& layers,
+                         const CBoundingBox& area, QImage& image)
+{
+ QVector<CRasterItem> items;
+ collect(schematic,sheet,layers,items);
+ rasterize(items,area,image);
+}
+
+//------------------------------------------------------------------------------
+
+CTileCache::CTileCache(void)
+{
+ m_Hash = 0;
+ m_Settings = 0;
+ m_Valid = false;
+ m_Board = 0;
+ m_Revision = 0;
+ m_RulesRevision = 0;
+ m_ElementCount = 0;
+}
+
+CTileCache::~CTileCache(void)
+{
+ clear();
+}
+
+void CTileCache::clear(void)
+{
+ CRasterizer::clear();
+ QList<CTileLayer*> layers = m_Layers.values();
+ for (int i = 0; i < layers.size(); i++)
+ {
+  delete layers.at(i);
+ }
+ m_Layers.clear();
+ m_Hash = 0;
+ m_Settings = 0;
+ m_Valid = false;
+ m_Board = 0;
+ m_Revision = 0;
+ m_RulesRevision = 0;
+ m_ElementCount = 0;
+ m_Sources.clear();
+}
+
+quint64 CTileCache::settingsHash(void) const
+{
+ CContentHash hash;
+ hash.add(QString::number(m_Resolution,'g',12));
+ hash.add((quint64)m_TileSize);
+ hash.add((quint64)m_Background);
+ QList<TLayer> layers = m_Colors.keys();
+ std::sort(layers.begin(),layers.end());
+ for (int i = 0; i < layers.size(); i++)
+ {
+  hash.add((quint64)layers.at(i));
+  hash.add((quint64)m_Colors.value(layers.at(i)));
+ }
+ return hash.value();
+}
+
+QString CTileCache::hashPath(const quint64 hash, const quint64 settings) const
+{
+ return QDir(m_Directory).filePath(CContentHash::toString(hash) + "-" + CContentHash::toString(settings));
+}
+
+QString CTileCache::tilePath(const TLayer layer, const int level, const int column, const int row) const
+{
+ return hashPath(m_Hash,m_Settings) + QString("/%1/%2/%3_%4.png").arg(layer).arg(level).arg(column).arg(row);
+}
+
+CBoundingBox CTileCache::tileArea(const int level, const int column, const int row) const
+{
+ TDimension size = std::max(m_TileSize,16)*pow(2.0,level)/m_Resolution;
+ return CBoundingBox(column*size,-(row+1)*size,(column+1)*size,-row*size);
+}
+
+void CTileCache::tileRange(const CBoundingBox& area, const int level, int& column1, int& row1,
+                           int& column2, int& row2) const
+{
+ TDimension size = std::max(m_TileSize,16)*pow(2.0,level)/m_Resolution;
+ column1 = (int)floor(area.left()/size);
+ column2 = (int)ceil(area.right()/size) - 1;
+ row1 = (int)floor(-area.top()/size);
+ row2 = (int)ceil(-area.bottom()/size) - 1;
+}
+
+void CTileCache::sourceRevisions(CBoard& board, QVector<quint64>& result) const
+{
+ // elements count with the package they place, in the order of
+ // CRasterizer::sourceCount()
+ int elements = board.elements().size();
+ result.resize(sourceCount(board));
+ result[0] = (quint64)board.plain().revision();
+ for (int i = 0; i < elements; i++)
+ {
+  CElement *e = board.elements().at(i);
+  CPackage *p = board.findPackage(e->library(),e->package());
+  quint64 r = ((quint64)(quint32)e->revision() << 32) | (quint32)((0!=p) ? p->revision() : 0);
+  result[1 + i] = r;
+  result[result.size() - elements + i] = r;
+ }
+ for (int i = 0; i < board.signal().size(); i++)
+ {
+  result[1 + elements + i] = (quint64)board.signal().at(i)->revision();
+ }
+}
+
+void CTileCache::index(CTileLayer& data)
+{
+ // cells of a level 0 tile, coarser levels have their own index
+ CBoundingBox extent;
+ for (int i = 0; i < data.items.size(); i++)
+ {
+  extent.include(data.items.at(i).box);
+ }
+ data.index.reset(extent,std::max(m_TileSize,16)/m_Resolution);
+ for (int i = 0; i < data.items.size(); i++)
+ {
+  data.index.insert(i,data.items.at(i).box);
+ }
+ data.levels.clear();
+}
+
+void CTileCache::build(CBoard& board, const TLayer layer, CTileLayer& data)
+{
+ QList<TLayer> layers;
+ layers.append(layer);
+ collect(board,layers,QVector<int>(),data.items,data.first);
+ index(data);
+}
+
+void CTileCache::refresh(CBoard& board, const TLayer layer, CTileLayer& data, const QVector<int>& sources,
+                         QList<CBoundingBox>& changed)
+{
+ // items of the edited sources are collected again and spliced in, both
+ // their old and their new ones mark the tiles to draw again
+ QList<TLayer> layers;
+ layers.append(layer);
+ QVector<CRasterItem> fresh;
+ QVector<int> first;
+ collect(board,layers,sources,fresh,first);
+ QVector<CRasterItem> items;
+ QVector<int> starts;
+ items.reserve(data.items.size() + fresh.size());
+ for (int s = 0, k = 0; s+1 < data.first.size(); s++)
+ {
+  starts.append(items.size());
+  if (k < sources.size() && sources.at(k)==s)
+  {
+   for (int i = data.first.at(s); i < data.first.at(s+1); i++)
+   {
+    changed.append(data.items.at(i).box);
+   }
+   for (int i = first.at(k); i < first.at(k+1); i++)
+   {
+    changed.append(fresh.at(i).box);
+    items.append(fresh.at(i));
+   }
+   k++;
+  }
+  else
+  {
+   for (int i = data.first.at(s); i < data.first.at(s+1); i++)
+   {
+    items.append(data.items.at(i));
+   }
+  }
+ }
+ starts.append(items.size());
+ data.items = items;
+ data.first = starts;
+ index(data);
+}
+
+void CTileCache::carryOver(const TLayer layer, const QList<CBoundingBox>& changed, const QString& from,
+                           const QString& to)
+{
+ CBoundingBox extent;
+ for (int k = 0; k < changed.size(); k++)
+ {
+  extent.include(changed.at(k));
+ }
+ CSpatialIndex index(extent,std::max(m_TileSize,16)/m_Resolution);
+ for (int k = 0; k < changed.size(); k++)
+ {
+  index.insert(k,changed.at(k));
+ }
+ QVector<int> ids;
+ QString layerPath = QString("/%1/").arg(layer);
+ for (int level = 0; QDir(from + layerPath + QString::number(level)).exists(); level++)
+ {
+  QString source = from + layerPath + QString::number(level);
+  QString target = to + layerPath + QString::number(level);
+  QStringList files = QDir(source).entryList(QStringList("*.png"),QDir::Files);
+  QDir().mkpath(target);
+  for (int k = 0; k < files.size(); k++)
+  {
+   QStringList position = QFileInfo(files.at(k)).completeBaseName().split('_');
+   if (position.size()!=2) continue;
+   CBoundingBox area = tileArea(level,position.at(0).toInt(),position.at(1).toInt());
+   index.query(area,ids);
+   bool clean = true;
+   for (int m = 0; clean && m < ids.size(); m++)
+   {
+    clean = !changed.at(ids.at(m)).intersects(area);
+   }
+   if (clean) QFile::rename(source + "/" + files.at(k),target + "/" + files.at(k));
+  }
+ }
+}
+
+void CTileCache::update(CBoard& board)
+{
+ quint64 settings = settingsHash();
+ bool same = m_Valid && &board==m_Board && settings==m_Settings;
+ if (same && board.revision()==m_Revision) return;
+ QVector<quint64> sources;
+ sourceRevisions(board,sources);
+ // new or removed objects and other design rules draw everything again
+ bool incremental = same && board.elements().size()==m_ElementCount && sources.size()==m_Sources.size() &&
+                    board.designRules().revision()==m_RulesRevision;
+ QVector<int> edited;
+ QList<int> elements, signalIndices;
+ for (int i = 0; incremental && i < sources.size(); i++)
+ {
+  if (sources.at(i)==m_Sources.at(i)) continue;
+  edited.append(i);
+  if (i >= 1 && i <= m_ElementCount) elements.append(i - 1);
+  else if (i > m_ElementCount && i <= m_ElementCount + board.signal().size()) signalIndices.append(i - 1 - m_ElementCount);
+ }
+ // hashed from the cached hashes of everything not edited
+ quint64 hash = board.contentHash();
+ QString from = hashPath(m_Hash,m_Settings);
+ QString to = hashPath(hash,settings);
+ bool carry = m_Valid && settings==m_Settings && !m_Directory.isEmpty() && from!=to;
+ if (incremental) m_PadResolver.update(board,elements,signalIndices,m_ThreadCount);
+ QList<TLayer> layers = m_Layers.keys();
+ for (int i = 0; i < layers.size(); i++)
+ {
+  CTileLayer *data = m_Layers.value(layers.at(i));
+  QList<CBoundingBox> changed;
+  if (incremental)
+  {
+   if (!edited.isEmpty()) refresh(board,layers.at(i),*data,edited,changed);
+  }
+  else
+  {
+   CTileLayer *current = new CTileLayer();
+   build(board,layers.at(i),*current);
+   if (carry) changedItems(data->items,current->items,changed);
+   delete data;
+   data = current;
+   m_Layers.insert(layers.at(i),current);
+  }
+  if (carry) carryOver(layers.at(i),changed,from,to);
+ }
+ // tiles left behind were touched by the edit
+ if (carry) QDir(from).removeRecursively();
+ m_Hash = hash;
+ m_Settings = settings;
+ m_Valid = true;
+ m_Board = &board;
+ m_Revision = board.revision();
+ m_RulesRevision = board.designRules().revision();
+ m_ElementCount = board.elements().size();
+ m_Sources = sources;
+}
+
+CTileLayer *CTileCache::layer(CBoard& board, const TLayer layer)
+{
+ CTileLayer *result = m_Layers.value(layer,0);
+ if (0==result)
+ {
+  result = new CTileLayer();
+  build(board,layer,*result);
+  m_Layers.insert(layer,result);
+ }
+ return result;
+}
+
+QImage CTileCache::tile(CBoard& board, const TLayer layer, const int level, const int column, const int row)
+{
+ update(board);
+ CTileLayer *data = this->layer(board,layer);
+ int size = std::max(m_TileSize,16);
+ QString fileName = tilePath(layer,level,column,row);
+ QImage result;
+ if (!m_Directory.isEmpty() && result.load(fileName) && result.width()==size && result.height()==size)
+ {
+  return result;
+ }
+ result = QImage(size,size,QImage::Format_RGB32);
+ CBoundingBox area = tileArea(level,column,row);
+ const QVector<CRasterItem> *items = &data->items;
+ const CSpatialIndex *index = &data->index;
+ if (level > 0)
+ {
+  if (!data->levels.contains(level))
+  {
+   TDimension pixel = pow(2.0,level)/m_Resolution;
+   buildLevel(*data,pixel,size*pixel,m_Background,data->levels[level]);
+  }
+  const CTileLevel& l = data->levels[level];
+  items = &l.items;
+  index = &l.index;
+ }
+ QVector<int> ids;
+ index->query(area,ids);
+ if (ids.isEmpty())
+ {
+  // empty tiles are not worth a file
+  result.fill(m_Background);
+  return result;
+ }
+ rasterize(*items,*index,area,result);
+ if (!m_Directory.isEmpty())
+ {
+  QDir().mkpath(QFileInfo(fileName).path());
+  result.save(fileName,"PNG");
+ }
+ return result;
+}
+
+//------------------------------------------------------------------------------
+
+CSvgExport::CSvgExport(void)
+{
+ clear();
+}
+
+CSvgExport::~CSvgExport(void)
+{
+ //
+}
+
+QRgb CSvgExport::paletteColor(const int index)
+{
+ static const QRgb palette[] = {
+  qRgb(0,0,0), qRgb(50,50,200), qRgb(50,200,50), qRgb(50,200,200),
+  qRgb(200,50,50), qRgb(200,50,200), qRgb(200,200,50), qRgb(200,200,200),
+  qRgb(100,100,100), qRgb(0,0,255), qRgb(0,255,0), qRgb(0,255,255),
+  qRgb(255,0,0), qRgb(255,0,255), qRgb(255,255,0), qRgb(255,255,255)};
+ // user defined entries are not stored in the file
+ if (index < 0 || index >= 16) return palette[7];
+ return palette[index];
+}
+
+void CSvgExport::clear(void)
+{
+ // layer colors of a new Eagle drawing
+ m_Colors.clear();
+ m_Colors.insert(CLayer::LAYER_TOP,paletteColor(4));
+ for (TLayer l = CLayer::LAYER_LAYER2; l < CLayer::LAYER_BOTTOM; l++)
+ {
+  m_Colors.insert(l,paletteColor(6));
+ }
+ m_Colors.insert(CLayer::LAYER_BOTTOM,paletteColor(1));
+ m_Colors.insert(CLayer::LAYER_PADS,paletteColor(2));
+ m_Colors.insert(CLayer::LAYER_VIAS,paletteColor(2));
+ m_Colors.insert(CLayer::LAYER_NETS,paletteColor(2));
+ m_Colors.insert(CLayer::LAYER_BUSSES,paletteColor(1));
+ m_Colors.insert(CLayer::LAYER_PINS,paletteColor(2));
+ m_Colors.insert(CLayer::LAYER_SYMBOLS,paletteColor(4));
+ m_Background = qRgb(0,0,0);
+ m_ThreadCount = 0;
+ m_PadResolver.clear();
+ m_Font.clear();
+}
+
+void CSvgExport::setLayers(QList<CLayer*>& layers)
+{
+ for (int i = 0; i < layers.size(); i++)
+ {
+  m_Colors.insert(layers.at(i)->layer(),paletteColor(layers.at(i)->color()));
+ }
+}
+
+QRgb CSvgExport::color(const TLayer layer) const
+{
+ return m_Colors.value(layer,paletteColor(7));
+}
+
+void CSvgExport::setColor(const TLayer layer, const QRgb color)
+{
+ m_Colors.insert(layer,color);
+}
+
+bool CSvgExport::write(CBoard& board, const QList<TLayer>& layers, QTextStream& out)
+{
+ // cached data of the board is prepared up front, the writer only reads
+ m_PadResolver.resolve(board,m_ThreadCount);
+ CPadRules rules(board.designRules());
+ CSvgWriter writer(m_Background,m_Font);
+ writer.setBoard(board,m_PadResolver,rules);
+ writer.write(out,layers,m_Colors);
+ return true;
+}
+
+bool CSvgExport::write(CSchematic& schematic, const int sheet, QTextStream& out)
+{
+ if (sheet < 0 || sheet >= schematic.sheets().size()) return false;
+ QHash<QString,CPart*> parts;
+ partTable(schematic,parts);
+ CSvgWriter writer(m_Background,m_Font);
+ writer.setSheet(schematic,*schematic.sheets().at(sheet),parts);
+ writer.write(out,QList<TLayer>(),m_Colors);
+ return true;
+}
+
+bool CSvgExport::write(CSymbol& symbol, QTextStream& out)
+{
+ CSvgWriter writer(m_Background,m_Font);
+ writer.setSymbol(symbol);
+ writer.write(out,QList<TLayer>(),m_Colors);
+ return true;
+}
+
+bool CSvgExport::write(CPackage& package, QTextStream& out)
+{
+ // pads of a package alone are sized by the default design rules
+ CPadRules rules;
+ CSvgWriter writer(m_Background,m_Font);
+ writer.setPackage(package,rules);
+ writer.write(out,QList<TLayer>(),m_Colors);
+ return true;
+}
+
+bool CSvgExport::saveToFile(CBoard& board, const QList<TLayer>& layers, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(board,layers,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+bool CSvgExport::saveToFile(CSchematic& schematic, const int sheet, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(schematic,sheet,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+bool CSvgExport::saveToFile(CSymbol& symbol, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(symbol,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+bool CSvgExport::saveToFile(CPackage& package, const QString& fileName)
+{
+ QFile f(fileName);
+ if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+ {
+  QTextStream ts(&f);
+  bool result = write(package,ts);
+  f.close();
+  return result;
+ }
+ return false;
+}
+
+int CSvgExport::saveToFiles(CSchematic& schematic, const QString& baseName)
+{
+ QHash<QString,CPart*> parts;
+ partTable(schematic,parts);
+ int count = schematic.sheets().size();
+ QVector<bool> results(count,false);
+ bool *written = results.data();
+ CSvgSheetJob job(schematic,parts,m_Colors,m_Background,m_Font,baseName,written);
+ parallelFor(count,job,m_ThreadCount);
+ int result = 0;
+ for (int i = 0; i < count; i++)
+ {
+  if (written[i]) result++;
+ }
+ return result;
+}
+
+}
+//------------------------------------------------------------------------------
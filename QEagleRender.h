@@ -0,0 +1,206 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLERENDER_H
+#define QEAGLERENDER_H
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+#include "QEagleGeometry.h"
+#include "QEagleFont.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements rendering of boards and schematic sheets to images
+*/
+
+namespace Eagle
+{
+
+class CRasterItem;
+class CRasterScene;
+class CTileLayer;
+
+// paints the given layers of a board or a schematic sheet into an RGB32
+// image without any GUI: drawing objects are reduced to convex shapes and
+// polygons, which are filled scanline by scanline in tiles processed on the
+// global thread pool. Layers are painted in list order, the last one on top.
+// Texts are stroked with the vector font, signal and board polygons on
+// copper are outlined
+class CRasterizer
+{
+ public:
+  CRasterizer(void);
+  virtual ~CRasterizer(void);
+ public:
+  void clear(void);
+  QImage render(CBoard& board, const QList<TLayer>& layers);
+  QImage render(CSchematic& schematic, const int sheet, const QList<TLayer>& layers);
+  // area is mapped onto the whole image, which may wrap a caller's buffer
+  // and has to be of Format_RGB32 or Format_ARGB32
+  void render(CBoard& board, const QList<TLayer>& layers, const CBoundingBox& area, QImage& image);
+  void render(CSchematic& schematic, const int sheet, const QList<TLayer>& layers,
+              const CBoundingBox& area, QImage& image);
+  QRgb color(const TLayer layer) const;
+  void setColor(const TLayer layer, const QRgb color);
+ public:
+  // getters
+  double resolution(void) const { return m_Resolution; }
+  QRgb background(void) const { return m_Background; }
+  int tileSize(void) const { return m_TileSize; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setResolution(const double value) { m_Resolution = value; }
+  void setBackground(const QRgb value) { m_Background = value; }
+  void setTileSize(const int value) { m_TileSize = value; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  // objects a board is drawn from in drawing order: the plain, the graphics
+  // of every element, every signal and the pads of every element
+  static int sourceCount(CBoard& board);
+  void collect(CBoard& board, const QList<TLayer>& layers, QVector<CRasterItem>& items);
+  // items of the listed sources only, of all for an empty list; first gets
+  // the index of the first item of each source and the item count
+  void collect(CBoard& board, const QList<TLayer>& layers, const QVector<int>& sources,
+               QVector<CRasterItem>& items, QVector<int>& first);
+  void collect(CRasterScene& scene, CBoard& board, const CPadRules& rules, const int source);
+  void collect(CSchematic& schematic, const int sheet, const QList<TLayer>& layers,
+               QVector<CRasterItem>& items);
+  QImage createImage(const QVector<CRasterItem>& items, CBoundingBox& area) const;
+  void rasterize(QVector<CRasterItem>& items, const CBoundingBox& area, QImage& image);
+  void rasterize(const QVector<CRasterItem>& items, const CSpatialIndex& index, const CBoundingBox& area,
+                 QImage& image);
+ protected:
+  QHash<TLayer,QRgb> m_Colors;
+  double m_Resolution; // default = 10, pixels per millimeter
+  QRgb m_Background; // default = black
+  int m_TileSize; // default = 256 pixels
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+  CVectorFont m_Font;
+};
+
+// pyramid of square tiles of single board layers kept on disk for viewers:
+// level 0 is drawn at the rasterizer's resolution, each further level at half
+// the resolution of the previous one, tiles are anchored at the board origin
+// with rows growing downwards. Tiles are stored under the content hash of the
+// board and the drawing settings, so a cache directory stays valid between
+// sessions. Edits are found by the revisions of the plain, the elements with
+// their packages and the signals: only the objects changed are collected
+// again and tiles of layers in use they do not touch are carried over to the
+// directory of the new hash. Coarser levels draw objects smaller than one of
+// their pixels as a single pixel
+class CTileCache: public CRasterizer
+{
+ public:
+  CTileCache(void);
+  virtual ~CTileCache(void);
+ public:
+  void clear(void);
+  void update(CBoard& board);
+  QImage tile(CBoard& board, const TLayer layer, const int level, const int column, const int row);
+  CBoundingBox tileArea(const int level, const int column, const int row) const;
+  // tiles covering the area at the given level
+  void tileRange(const CBoundingBox& area, const int level, int& column1, int& row1,
+                 int& column2, int& row2) const;
+  QString tilePath(const TLayer layer, const int level, const int column, const int row) const;
+ public:
+  // getters
+  const QString& directory(void) const { return m_Directory; }
+  quint64 hash(void) const { return m_Hash; }
+  // setters
+  void setDirectory(const QString& value) { m_Directory = value; }
+ protected:
+  quint64 settingsHash(void) const;
+  QString hashPath(const quint64 hash, const quint64 settings) const;
+  void sourceRevisions(CBoard& board, QVector<quint64>& result) const;
+  CTileLayer *layer(CBoard& board, const TLayer layer);
+  void build(CBoard& board, const TLayer layer, CTileLayer& data);
+  void refresh(CBoard& board, const TLayer layer, CTileLayer& data, const QVector<int>& sources,
+               QList<CBoundingBox>& changed);
+  void index(CTileLayer& data);
+  void carryOver(const TLayer layer, const QList<CBoundingBox>& changed, const QString& from,
+                 const QString& to);
+ protected:
+  QString m_Directory;
+  quint64 m_Hash; // content hash of the board the tiles belong to
+  quint64 m_Settings; // hash of resolution, tile size and colors
+  bool m_Valid; // hashes refer to a board
+  CBoard *m_Board;
+  int m_Revision; // of the board the layers were collected at
+  int m_RulesRevision; // of its design rules
+  int m_ElementCount;
+  QVector<quint64> m_Sources; // revisions of the sources the layers were collected at
+  QHash<TLayer,CTileLayer*> m_Layers; // layers asked for since the last clear()
+};
+
+// SVG drawings of boards, schematic sheets, symbols and packages streamed
+// straight to the output, one group per layer in millimeters with the Y axis
+// pointing down; wires and polygon edges keep their arcs, pads, smds and
+// vias are exact outlines, texts are stroked with the vector font. Layer
+// colors follow the layer table of the drawing when given
+class CSvgExport
+{
+ public:
+  CSvgExport(void);
+  virtual ~CSvgExport(void);
+ public:
+  // colors of Eagle's default palette on black
+  static QRgb paletteColor(const int index);
+ public:
+  void clear(void);
+  void setLayers(QList<CLayer*>& layers);
+  QRgb color(const TLayer layer) const;
+  void setColor(const TLayer layer, const QRgb color);
+  // board layers are drawn in list order, the last one on top
+  bool write(CBoard& board, const QList<TLayer>& layers, QTextStream& out);
+  bool write(CSchematic& schematic, const int sheet, QTextStream& out);
+  bool write(CSymbol& symbol, QTextStream& out);
+  bool write(CPackage& package, QTextStream& out);
+  bool saveToFile(CBoard& board, const QList<TLayer>& layers, const QString& fileName);
+  bool saveToFile(CSchematic& schematic, const int sheet, const QString& fileName);
+  bool saveToFile(CSymbol& symbol, const QString& fileName);
+  bool saveToFile(CPackage& package, const QString& fileName);
+  // every sheet to baseName_1.svg onwards, in parallel; returns the number
+  // of files written
+  int saveToFiles(CSchematic& schematic, const QString& baseName);
+ public:
+  // getters
+  QRgb background(void) const { return m_Background; }
+  int threadCount(void) const { return m_ThreadCount; }
+  // setters
+  void setBackground(const QRgb value) { m_Background = value; }
+  void setThreadCount(const int value) { m_ThreadCount = value; }
+ protected:
+  QHash<TLayer,QRgb> m_Colors;
+  QRgb m_Background; // default = black
+  int m_ThreadCount; // default = 0, ideal thread count
+  CPadResolver m_PadResolver;
+  CVectorFont m_Font;
+};
+
+}
+
+#endif // QEAGLERENDER_H
+//------------------------------------------------------------------------------
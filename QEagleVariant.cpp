@@ -0,0 +1,152 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#include "QEagleVariant.h"
+//------------------------------------------------------------------------------
+
+namespace Eagle
+{
+
+CVariantView::CVariantView(void)
+{
+ clear();
+}
+
+CVariantView::~CVariantView(void)
+{
+ clear();
+}
+
+QString CVariantView::currentVariant(QList<CVariantDef*>& variantDefs)
+{
+ for (int i = 0; i < variantDefs.size(); i++)
+ {
+  if (variantDefs.at(i)->current()) return variantDefs.at(i)->name();
+ }
+ return "";
+}
+
+void CVariantView::clear(void)
+{
+ m_Document = 0;
+ m_Revision = 0;
+ m_Parts.clear();
+ m_Elements.clear();
+ m_Index.clear();
+ m_Variants.clear();
+ m_Current.clear();
+ m_Overrides.clear();
+ m_Variant.clear();
+ m_Selected.clear();
+}
+
+void CVariantView::index(const int part, QList<CVariant*>& variants)
+{
+ for (int i = 0; i < variants.size(); i++)
+ {
+  QHash<QString,QVector<CVariant*> >::iterator v = m_Overrides.find(variants.at(i)->name());
+  // overrides of variants missing from <variantdefs> are kept all the same
+  if (v==m_Overrides.end()) v = m_Overrides.insert(variants.at(i)->name(),QVector<CVariant*>(count(),0));
+  v.value()[part] = variants.at(i);
+ }
+}
+
+void CVariantView::update(CSchematic& schematic)
+{
+ if (&schematic==m_Document && schematic.revision()==m_Revision) return;
+ QString variant = m_Variant;
+ clear();
+ m_Document = &schematic;
+ m_Revision = schematic.revision();
+ m_Parts = schematic.parts().toVector();
+ for (int i = 0; i < schematic.variantDefs().size(); i++)
+ {
+  m_Variants.append(schematic.variantDefs().at(i)->name());
+  m_Overrides.insert(m_Variants.last(),QVector<CVariant*>(count(),0));
+ }
+ m_Current = currentVariant(schematic.variantDefs());
+ for (int i = 0; i < m_Parts.size(); i++)
+ {
+  m_Index.insert(m_Parts.at(i)->name(),i);
+  index(i,m_Parts.at(i)->variants());
+ }
+ select(variant);
+}
+
+void CVariantView::update(CBoard& board)
+{
+ if (&board==m_Document && board.revision()==m_Revision) return;
+ QString variant = m_Variant;
+ clear();
+ m_Document = &board;
+ m_Revision = board.revision();
+ m_Elements = board.elements().toVector();
+ for (int i = 0; i < board.variantDefs().size(); i++)
+ {
+  m_Variants.append(board.variantDefs().at(i)->name());
+  m_Overrides.insert(m_Variants.last(),QVector<CVariant*>(count(),0));
+ }
+ m_Current = currentVariant(board.variantDefs());
+ for (int i = 0; i < m_Elements.size(); i++)
+ {
+  m_Index.insert(m_Elements.at(i)->name(),i);
+  index(i,m_Elements.at(i)->variants());
+ }
+ select(variant);
+}
+
+bool CVariantView::select(const QString& variant)
+{
+ m_Variant = variant.isNull() ? m_Current : variant;
+ m_Selected.clear();
+ if (m_Variant.isEmpty()) return true;
+ QHash<QString,QVector<CVariant*> >::const_iterator v = m_Overrides.constFind(m_Variant);
+ if (v==m_Overrides.constEnd()) return false;
+ m_Selected = v.value();
+ return true;
+}
+
+QString CVariantView::name(const int index) const
+{
+ return (0!=part(index)) ? part(index)->name() : element(index)->name();
+}
+
+bool CVariantView::populate(const int index) const
+{
+ CVariant *v = variant(index);
+ if (0!=v) return v->populate();
+ return (0!=part(index)) ? true : element(index)->populate();
+}
+
+QString CVariantView::value(const int index) const
+{
+ CVariant *v = variant(index);
+ if (0!=v && !v->value().isEmpty()) return v->value();
+ return (0!=part(index)) ? part(index)->value() : element(index)->value();
+}
+
+QString CVariantView::technology(const int index) const
+{
+ CVariant *v = variant(index);
+ if (0!=v && !v->technology().isEmpty()) return v->technology();
+ // elements of a board carry no technology
+ return (0!=part(index)) ? part(index)->technology() : QString();
+}
+
+}
+//------------------------------------------------------------------------------
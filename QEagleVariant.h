@@ -0,0 +1,92 @@
+/*
+    QEagleLib * Qt based library for managing Eagle CAD XML files
+    Copyright (C) 2012-2021 Mirai Computing (mirai.computing@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//------------------------------------------------------------------------------
+#ifndef QEAGLEVARIANT_H
+#define QEAGLEVARIANT_H
+//------------------------------------------------------------------------------
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+//------------------------------------------------------------------------------
+#include "QEagleLib.h"
+//------------------------------------------------------------------------------
+
+/*
+This file implements read access to assembly variants of a document
+*/
+
+namespace Eagle
+{
+
+// parts of a schematic or elements of a board as an assembly variant sees
+// them, without copying or editing the document: the <variant> overrides of
+// every part are indexed once per variant name, selecting a variant only
+// swaps the table, and populate, value and technology are read through it.
+// The index refers to the entities of the document and is built again by
+// update() once anything in the document has changed
+class CVariantView
+{
+ public:
+  CVariantView(void);
+  virtual ~CVariantView(void);
+ public:
+  // the variant marked current in the list, or an empty string
+  static QString currentVariant(QList<CVariantDef*>& variantDefs);
+ public:
+  void clear(void);
+  void update(CSchematic& schematic);
+  void update(CBoard& board);
+  // null selects the current variant of the document, empty none; false when
+  // the document defines no such variant, which then shows the plain parts
+  bool select(const QString& variant);
+  int indexOf(const QString& name) const { return m_Index.value(name,-1); }
+  // part i as seen by the selected variant
+  QString name(const int index) const;
+  bool populate(const int index) const;
+  QString value(const int index) const;
+  QString technology(const int index) const;
+  // override of part i, 0 when the variant keeps it as is
+  CVariant *variant(const int index) const { return m_Selected.isEmpty() ? 0 : m_Selected.at(index); }
+ public:
+  // getters
+  int count(void) const { return m_Parts.size() + m_Elements.size(); }
+  // 0 unless the view is on a schematic, respectively a board
+  CPart *part(const int index) const { return m_Parts.value(index,0); }
+  CElement *element(const int index) const { return m_Elements.value(index,0); }
+  const QStringList& variants(void) const { return m_Variants; }
+  const QString& selected(void) const { return m_Variant; }
+ protected:
+  void index(const int part, QList<CVariant*>& variants);
+ protected:
+  CEntity *m_Document; // schematic or board the view was built for
+  int m_Revision;
+  QVector<CPart*> m_Parts;
+  QVector<CElement*> m_Elements;
+  QHash<QString,int> m_Index; // part name, index
+  QStringList m_Variants; // <variantdef> names in document order
+  QString m_Current; // variant marked current in the document
+  QHash<QString,QVector<CVariant*> > m_Overrides; // per variant, one entry per part
+  QString m_Variant; // selected variant
+  QVector<CVariant*> m_Selected; // overrides of the selected variant, empty for none
+};
+
+}
+
+#endif // QEAGLEVARIANT_H
+//------------------------------------------------------------------------------